@@ -0,0 +1,55 @@
+// Slicing a small part at fine layers over the whole build volume versus over its bounds.
+// usage: bench_bounds [torus_rings]   (default 100 -> 20k triangles, 8 mm tall)
+// Peak RSS only grows, so the bounded run goes first.
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/workers/path_plan.hpp"
+
+#include <cstdio>
+#include <sys/resource.h>
+
+
+namespace {
+
+double peak_rss_mb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const std::size_t rings = bench::arg_or(argc, argv, 1, 100);
+    auto path = bench::temp_path("torus_bounds.bin.stl");
+    bench::write_binary_stl(path, bench::make_torus(rings, rings, 10.0f, 4.0f));
+
+    PathPlanner planner;
+    planner.set_cad(path);
+    const auto& bounds = planner.get_bounds();
+    std::printf("torus: %zu triangles, z %.1f-%.1f mm, build volume %.0f mm\n", 2 * rings * rings,
+                bounds.min.z, bounds.max.z, MAX_PART_HEIGHT_MM);
+    std::printf("  %6s %-8s %10s %10s %16s %14s\n", "height", "range", "planes", "layers", "slice_planar ms", "peak rss MB");
+
+    for (float layer_height : {0.2f, 0.1f, 0.05f}) {
+        auto run = [&](const char* name, const LayerSchedule& schedule) {
+            double ms = bench::best_of_ms(3, [&] {
+                planner.clear_slice_cache();
+                planner.slice_planar(schedule, 2.0f);
+            });
+            std::printf("  %6.2f %-8s %10zu %10zu %16.1f %14.1f\n", layer_height, name, schedule.layer_count(),
+                        planner.layer_count(), ms, peak_rss_mb());
+            return planner.layer_count();
+        };
+        auto part_layers = run("part", LayerSchedule::uniform(layer_height, bounds.min.z, bounds.max.z));
+        auto volume_layers = run("volume", LayerSchedule::uniform(layer_height));
+        if (part_layers != volume_layers) {
+            std::printf("  MISMATCH\n");
+            return 1;
+        }
+    }
+
+    std::filesystem::remove(path);
+    return 0;
+}
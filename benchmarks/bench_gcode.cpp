@@ -0,0 +1,94 @@
+// G-code output throughput: a sliced torus written by GcodeWriter to /dev/null (formatting
+// alone) and to a file through save_gcode, against the same moves printed with fprintf.
+// usage: bench_gcode [torus_rings] [passes]   (default 200 -> 80k triangles, 20 passes)
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/workers/path_plan.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+
+
+namespace {
+
+constexpr float kLayerHeight = 0.2f;  // uniform, so every layer is this thick
+
+// The plan written `passes` times over, as the baseline writes it.
+std::size_t write_with_writer(const PathPlanner& planner, int fd, std::size_t passes, GcodeStats& stats) {
+    GcodeWriter writer(fd);
+    for (std::size_t pass = 0; pass < passes; ++pass) {
+        for (const auto& layer : planner.get_plan()) writer.add_layer(layer.z, kLayerHeight, layer.paths);
+    }
+    writer.finish();
+    stats = writer.stats();
+    return stats.bytes;
+}
+
+// Every vertex as its own move through stdio, with printf's float formatting.
+std::size_t write_with_fprintf(const PathPlanner& planner, std::FILE* out, std::size_t passes) {
+    const GcodeOptions options;
+    const double e_per_mm = extrusion_per_mm(options, kLayerHeight);
+    std::size_t bytes = 0;
+    for (std::size_t pass = 0; pass < passes; ++pass) {
+        for (const auto& layer : planner.get_plan()) {
+            double e = 0.0;
+            bytes += static_cast<std::size_t>(std::fprintf(out, "G92 E0\nG0 Z%.3f\n", layer.z));
+            for (std::size_t p = 0; p < layer.paths.path_count(); ++p) {
+                const auto path = layer.paths.path(p);
+                if (path.role == PathRole::OpenChain) continue;
+                bytes += static_cast<std::size_t>(std::fprintf(out, "G0 X%.3f Y%.3f\n", path.points[0].x, path.points[0].y));
+                for (std::size_t k = 1; k < path.points.size(); ++k) {
+                    e += std::hypot(path.points[k].x - path.points[k - 1].x, path.points[k].y - path.points[k - 1].y) * e_per_mm;
+                    bytes += static_cast<std::size_t>(
+                        std::fprintf(out, "G1 X%.3f Y%.3f E%.5f\n", path.points[k].x, path.points[k].y, e));
+                }
+            }
+        }
+    }
+    std::fflush(out);
+    return bytes;
+}
+
+double mb_per_s(std::size_t bytes, double ms) { return static_cast<double>(bytes) / 1.0e6 / (ms / 1000.0); }
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const std::size_t rings = bench::arg_or(argc, argv, 1, 200);
+    const std::size_t passes = bench::arg_or(argc, argv, 2, 20);
+    auto stl_path = bench::temp_path("torus_gcode.bin.stl");
+    bench::write_binary_stl(stl_path, bench::make_torus(rings, rings));
+    PathPlanner planner;
+    planner.set_cad(stl_path);
+    planner.slice_planar(kLayerHeight, 1.0f);
+    std::size_t segments = 0;
+    for (const auto& layer : planner.get_plan()) segments += layer.paths.segment_count();
+    std::printf("torus: %zu triangles, %zu layers, %zu segments, plan written %zu times\n", 2 * rings * rings,
+                planner.get_plan().size(), segments, passes);
+
+    GcodeStats stats;
+    std::size_t bytes = 0;
+    const int null_fd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+    double ms = bench::best_of_ms(3, [&] { bytes = write_with_writer(planner, null_fd, passes, stats); });
+    ::close(null_fd);
+    std::printf("  %-26s %9.1f MB %9.1f ms %8.1f MB/s  (%zu lines, %zu moves merged, %zu retractions)\n",
+                "GcodeWriter -> /dev/null", bytes / 1.0e6, ms, mb_per_s(bytes, ms), stats.lines, stats.merged,
+                stats.retractions);
+
+    std::FILE* null_file = std::fopen("/dev/null", "w");
+    ms = bench::best_of_ms(3, [&] { bytes = write_with_fprintf(planner, null_file, passes); });
+    std::fclose(null_file);
+    std::printf("  %-26s %9.1f MB %9.1f ms %8.1f MB/s\n", "fprintf -> /dev/null", bytes / 1.0e6, ms, mb_per_s(bytes, ms));
+
+    auto gcode_path = bench::temp_path("torus.gcode");
+    ms = bench::best_of_ms(3, [&] { stats = planner.save_gcode(gcode_path); });
+    std::printf("  %-26s %9.1f MB %9.1f ms %8.1f MB/s  (one pass)\n", "save_gcode -> file", stats.bytes / 1.0e6, ms,
+                mb_per_s(stats.bytes, ms));
+
+    std::filesystem::remove(gcode_path);
+    std::filesystem::remove(stl_path);
+    return 0;
+}
@@ -0,0 +1,85 @@
+// Honeycomb infill over every layer of a 150 mm square part with four round holes, clipped from
+// one cached lattice versus laying the lattice out again for each layer; then the planner's infill
+// metrics on a torus.
+// usage: bench_honeycomb [layers] [torus_rings]   (default 1500 layers, 200 rings)
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/workers/path_plan.hpp"
+
+#include <cstdio>
+
+
+namespace {
+
+polygon_t circle(float cx, float cy, float radius, std::size_t points, bool ccw) {
+    polygon_t loop;
+    for (std::size_t k = 0; k < points; ++k) {
+        float a = (ccw ? 1.0f : -1.0f) * 6.2831853f * static_cast<float>(k) / static_cast<float>(points);
+        loop.push_back({cx + radius * std::cos(a), cy + radius * std::sin(a), 0.0f});
+    }
+    loop.push_back(loop.front());
+    return loop;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const std::size_t layers = bench::arg_or(argc, argv, 1, 1500);
+    const std::size_t rings = bench::arg_or(argc, argv, 2, 200);
+    const polygon_t outer{{0, 0, 0}, {150, 0, 0}, {150, 150, 0}, {0, 150, 0}, {0, 0, 0}};
+    const std::vector<polygon_t> holes{circle(40, 40, 15, 64, false), circle(110, 40, 15, 64, false),
+                                       circle(40, 110, 15, 64, false), circle(110, 110, 15, 64, false)};
+    const InfillOptions options{InfillPattern::Honeycomb, 0.0f};
+
+    std::printf("part: 150 x 150 mm, 4 holes, %zu layers\n", layers);
+    std::printf("  %9s %10s %14s %16s %12s %14s\n", "spacing", "lattice ms", "lattice edges", "segments/layer",
+                "cached ms/l", "per-layer ms/l");
+    for (float spacing : {4.0f, 2.0f, 1.0f, 0.5f}) {
+        std::optional<HoneycombLattice> lattice;
+        double build_ms = bench::best_of_ms(3, [&] { lattice.emplace(spacing, 0.0f, bounds_for_polygon(outer)); });
+        std::size_t segments = 0;
+        double cached_ms = bench::best_of_ms(1, [&] {
+            segments = 0;
+            for (std::size_t l = 0; l < layers; ++l) segments += lattice->clip(outer, holes, 0.2f * static_cast<float>(l)).size();
+        });
+        std::size_t fresh_segments = 0;
+        double fresh_ms = bench::best_of_ms(1, [&] {
+            fresh_segments = 0;
+            for (std::size_t l = 0; l < layers; ++l) {
+                fresh_segments += pattern_infill(outer, holes, spacing, options, l, 0.2f * static_cast<float>(l)).size();
+            }
+        });
+        if (fresh_segments != segments) {
+            std::printf("  MISMATCH\n");
+            return 1;
+        }
+        std::printf("  %9.2f %10.3f %14zu %16zu %12.3f %14.3f\n", spacing, build_ms, lattice->segment_count(),
+                    segments / layers, cached_ms / static_cast<double>(layers), fresh_ms / static_cast<double>(layers));
+    }
+
+    auto path = bench::temp_path("torus_honeycomb.bin.stl");
+    bench::write_binary_stl(path, bench::make_torus(rings, rings));
+    PathPlanner planner;
+    planner.set_cad(path);
+    planner.set_infill_options(options);
+    planner.slice_planar(0.2f, 1.0f);
+    const auto& metrics = planner.infill_metrics();
+    std::size_t segments = 0, busiest = 0;
+    double ms = 0.0, slowest = 0.0;
+    for (const auto& layer : metrics.layers) {
+        segments += layer.segments;
+        ms += layer.ms;
+        busiest = std::max(busiest, layer.segments);
+        slowest = std::max(slowest, layer.ms);
+    }
+    const auto count = static_cast<double>(std::max<std::size_t>(metrics.layers.size(), 1));
+    std::printf("torus: %zu triangles, %zu layers at 0.2 mm, 1 mm spacing\n", 2 * rings * rings, metrics.layers.size());
+    std::printf("  lattice: %zu builds, %.3f ms, %zu edges\n", metrics.lattice_builds, metrics.lattice_ms,
+                metrics.lattice_segments);
+    std::printf("  per layer: %.0f segments mean, %zu max; %.3f ms mean, %.3f ms max\n", static_cast<double>(segments) / count,
+                busiest, ms / count, slowest);
+
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Infill clipping on one detailed island: the per-line scan that intersects every loop with
+// every scanline versus the active edge table, then the edge table at other angles and in each
+// multi-direction pattern.
+// usage: bench_infill [outer_points] [holes]   (default 20000-point outline, 400 holes)
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/planning/infill.hpp"
+#include "include/planning/polygon_ops.hpp"
+#include "include/planning/scanline.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+
+namespace {
+
+std::vector<Span> spans_per_line(const polygon_t& poly, float y_line) {
+    std::vector<float> intersections;
+    if (poly.size() < 2) return {};
+    const bool closed = poly.front() == poly.back();
+    const std::size_t limit = closed && poly.size() > 1 ? poly.size() - 1 : poly.size();
+    for (std::size_t i = 0; i < limit; ++i) {
+        const auto& p0 = poly[i];
+        const auto& p1 = poly[(i + 1) % limit];
+        if (std::abs(p0.y - p1.y) < kMinSpan) continue;
+        bool crosses = (p0.y <= y_line && p1.y > y_line) || (p1.y <= y_line && p0.y > y_line);
+        if (!crosses) continue;
+        float t = (y_line - p0.y) / (p1.y - p0.y);
+        intersections.push_back(p0.x + t * (p1.x - p0.x));
+    }
+    std::sort(intersections.begin(), intersections.end());
+    std::vector<Span> spans;
+    for (std::size_t i = 0; i + 1 < intersections.size(); i += 2) {
+        if (intersections[i + 1] - intersections[i] >= kMinSpan) spans.emplace_back(intersections[i], intersections[i + 1]);
+    }
+    return spans;
+}
+
+std::vector<segment_t> clip_infill_per_line(const polygon_t& outer, const std::vector<polygon_t>& holes, float spacing, float z) {
+    std::vector<segment_t> infill;
+    Bounds bounds = bounds_for_polygon(outer);
+    for (float y = bounds.min_y; y <= bounds.max_y + kSnapEps; y += spacing) {
+        auto spans = spans_per_line(outer, y);
+        for (const auto& hole : holes) {
+            if (spans.empty()) break;
+            spans = subtract_spans(std::move(spans), spans_per_line(hole, y));
+        }
+        for (const auto& span : spans) infill.push_back({{span.first, y, z}, {span.second, y, z}});
+    }
+    return infill;
+}
+
+// a wavy disc of radius ~100 mm
+polygon_t wavy_outline(std::size_t points) {
+    polygon_t poly;
+    for (std::size_t i = 0; i < points; ++i) {
+        float a = 6.2831853f * static_cast<float>(i) / static_cast<float>(points);
+        float r = 100.0f + 3.0f * std::sin(37.0f * a) + std::sin(301.0f * a);
+        poly.push_back({r * std::cos(a), r * std::sin(a), 0.0f});
+    }
+    poly.push_back(poly.front());
+    return poly;
+}
+
+// round holes on a square lattice inside the outline
+std::vector<polygon_t> hole_lattice(std::size_t count) {
+    std::vector<polygon_t> holes;
+    const auto side = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+    const float pitch = 120.0f / static_cast<float>(side);
+    for (std::size_t i = 0; i < count; ++i) {
+        float cx = -60.0f + pitch * (static_cast<float>(i % side) + 0.5f);
+        float cy = -60.0f + pitch * (static_cast<float>(i / side) + 0.5f);
+        polygon_t hole;
+        for (int k = 0; k < 32; ++k) {
+            float a = -6.2831853f * static_cast<float>(k) / 32.0f;
+            hole.push_back({cx + 0.3f * pitch * std::cos(a), cy + 0.3f * pitch * std::sin(a), 0.0f});
+        }
+        holes.push_back(std::move(hole));
+    }
+    return holes;
+}
+
+bool same_segments(const std::vector<segment_t>& a, const std::vector<segment_t>& b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (!(a[i].first == b[i].first) || !(a[i].second == b[i].second)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const std::size_t points = bench::arg_or(argc, argv, 1, 20000);
+    const std::size_t hole_count = bench::arg_or(argc, argv, 2, 400);
+    const polygon_t outer = wavy_outline(points);
+    const auto holes = hole_lattice(hole_count);
+
+    std::printf("island: %zu outline points, %zu holes of 32 points\n", points, holes.size());
+    std::printf("  %8s %10s %14s %14s %8s\n", "spacing", "segments", "per-line ms", "edge table ms", "speedup");
+    for (float spacing : {2.0f, 0.8f, 0.4f, 0.2f}) {
+        std::vector<segment_t> legacy, table;
+        double legacy_ms = bench::best_of_ms(3, [&] { legacy = clip_infill_per_line(outer, holes, spacing, 0.0f); });
+        double table_ms = bench::best_of_ms(3, [&] { table = clip_infill(outer, holes, spacing, 0.0f); });
+        std::printf("  %8.2f %10zu %14.2f %14.2f %7.1fx\n", spacing, table.size(), legacy_ms, table_ms, legacy_ms / table_ms);
+        if (!same_segments(legacy, table)) {
+            std::printf("  MISMATCH\n");
+            return 1;
+        }
+    }
+
+    const float spacing = 0.4f;
+    std::printf("  %8s %10s %14s\n", "angle", "segments", "ms");
+    for (float angle : {0.0f, 45.0f, 90.0f, 117.0f}) {
+        std::vector<segment_t> lines;
+        double ms = bench::best_of_ms(3, [&] { lines = clip_infill(outer, holes, spacing, angle, LineAnchor::Island, 0.0f); });
+        std::printf("  %8.0f %10zu %14.2f\n", angle, lines.size(), ms);
+    }
+    std::printf("  %-12s %10s %14s %12s\n", "pattern", "segments", "ms", "length m");
+    const std::pair<const char*, InfillPattern> patterns[] = {{"rectilinear", InfillPattern::Rectilinear},
+                                                              {"crosshatch", InfillPattern::Crosshatch},
+                                                              {"grid", InfillPattern::Grid},
+                                                              {"triangles", InfillPattern::Triangles}};
+    for (const auto& [name, pattern] : patterns) {
+        std::vector<segment_t> lines;
+        double ms = bench::best_of_ms(3, [&] { lines = pattern_infill(outer, holes, spacing, {pattern, 45.0f}, 1, 0.0f); });
+        double length = 0.0;
+        for (const auto& seg : lines) length += (seg.second - seg.first).norm();
+        std::printf("  %-12s %10zu %14.2f %12.2f\n", name, lines.size(), ms, length / 1000.0);
+    }
+    return 0;
+}
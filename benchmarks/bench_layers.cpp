@@ -0,0 +1,114 @@
+// Uniform versus adaptive layer schedules on a torus: layer count, slicing time and the worst
+// stair step any layer leaves on a sloped facet.
+// usage: bench_layers [resolution]   (default 200 -> 80k torus triangles)
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/planning/sweep_slicer.hpp"
+#include "include/workers/path_plan.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+
+namespace {
+
+// largest thickness * |n.z| over the sloped facets each layer crosses
+float worst_cusp(const std::vector<Mesh>& meshes, const LayerSchedule& schedule) {
+    float worst = 0.0f;
+    for (const auto& mesh : meshes) {
+        for (const auto& tri : mesh.triangles) {
+            const auto& a = mesh.points[tri.vertices[0]];
+            const auto& b = mesh.points[tri.vertices[1]];
+            const auto& c = mesh.points[tri.vertices[2]];
+            vec3_t n = (b - a).cross(c - a);
+            if (!(n.norm() > 0.0f)) continue;
+            float nz = std::abs(n.z) / n.norm();
+            if (nz > 0.9998f) continue;
+            // layer l spans (z(l - 1), z(l)]: from the first plane above the facet's bottom to
+            // the first plane above its top
+            auto [first, below_top] = schedule.layers_within(std::min({a.z, b.z, c.z}), std::max({a.z, b.z, c.z}));
+            const int last = std::min(below_top + 1, static_cast<int>(schedule.layer_count()) - 1);
+            for (int l = std::max(first, 1); l <= last; ++l) {
+                worst = std::max(worst, schedule.thickness(static_cast<std::size_t>(l)) * nz);
+            }
+        }
+    }
+    return worst;
+}
+
+// A vertical-walled cylinder between two hemispherical caps: thin layers only pay off on the caps.
+std::vector<std::array<vec3_t, 3>> make_capsule(std::size_t segments, float radius, float wall_height) {
+    const float pi = 3.14159265359f;
+    const std::size_t rows = segments / 2;  // latitude rows per cap
+    std::vector<std::vector<vec3_t>> rings;
+    for (std::size_t r = 0; r <= 2 * rows + 1; ++r) {
+        // bottom cap rows, then the top cap rows lifted by the wall height
+        const bool top_cap = r > rows;
+        const std::size_t k = top_cap ? r - 1 : r;
+        float phi = -0.5f * pi + pi * static_cast<float>(k) / static_cast<float>(2 * rows);
+        float z = radius + radius * std::sin(phi) + (top_cap ? wall_height : 0.0f);
+        float ring_radius = radius * std::cos(phi);
+        std::vector<vec3_t> ring;
+        for (std::size_t i = 0; i < segments; ++i) {
+            float u = 2.0f * pi * static_cast<float>(i) / static_cast<float>(segments);
+            ring.push_back({radius + ring_radius * std::cos(u), radius + ring_radius * std::sin(u), z});
+        }
+        rings.push_back(std::move(ring));
+    }
+    std::vector<std::array<vec3_t, 3>> tris;
+    for (std::size_t r = 0; r + 1 < rings.size(); ++r) {
+        for (std::size_t i = 0; i < segments; ++i) {
+            std::size_t j = (i + 1) % segments;
+            tris.push_back({rings[r][i], rings[r][j], rings[r + 1][j]});
+            tris.push_back({rings[r][i], rings[r + 1][j], rings[r + 1][i]});
+        }
+    }
+    return tris;
+}
+
+void run(const char* shape, const std::vector<std::array<vec3_t, 3>>& tris, const AdaptiveLayerOptions& options) {
+    auto path = bench::temp_path("layers.bin.stl");
+    bench::write_binary_stl(path, tris);
+    PathPlanner planner;
+    planner.set_cad(path);
+    const auto& meshes = planner.get_meshes();
+    const float top = planner.get_bounds().max.z;
+
+    LayerSchedule adaptive;
+    double schedule_ms = bench::best_of_ms(3, [&] { adaptive = LayerSchedule::adaptive(meshes, options); });
+    struct Case {
+        const char* name;
+        LayerSchedule schedule;
+    };
+    std::vector<Case> cases = {
+        {"uniform min", LayerSchedule::uniform(options.min_height, planner.get_bounds().min.z, top)},
+        {"uniform max", LayerSchedule::uniform(options.max_height, planner.get_bounds().min.z, top)},
+        {"adaptive", adaptive},
+    };
+
+    std::printf("%s: %zu triangles, %.1f mm tall; adaptive %.2f-%.2f mm, cusp %.2f mm (schedule %.1f ms)\n",
+                shape, tris.size(), top, options.min_height, options.max_height, options.max_cusp, schedule_ms);
+    std::printf("  %-12s %12s %10s %16s %11s\n", "schedule", "part layers", "sweep ms", "slice_planar ms", "worst cusp");
+    for (const auto& c : cases) {
+        auto [first, last] = c.schedule.layers_within(planner.get_bounds().min.z, top);
+        double sweep_ms = bench::best_of_ms(3, [&] { sweep_slice(meshes, c.schedule); });
+        double plan_ms = bench::best_of_ms(1, [&] {
+            planner.clear_slice_cache();
+            planner.slice_planar(c.schedule, 2.0f);
+        });
+        std::printf("  %-12s %12d %10.1f %16.1f %11.4f\n", c.name, last - first + 1, sweep_ms, plan_ms,
+                    worst_cusp(meshes, c.schedule));
+    }
+    std::filesystem::remove(path);
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const std::size_t resolution = bench::arg_or(argc, argv, 1, 200);
+    AdaptiveLayerOptions options{0.05f, 0.3f, 0.02f};
+    run("torus", bench::make_torus(resolution, resolution), options);
+    run("capsule", make_capsule(resolution, 15.0f, 60.0f), options);
+    return 0;
+}
@@ -0,0 +1,85 @@
+// Binary motion commands against ASCII G-code for the same sliced torus: bytes per move, the
+// move rate each sustains over the 115200-baud UART, and encode/decode speed on the host.
+// usage: bench_motion_codec [torus_rings]   (default 200 -> 80k triangles)
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/planning/motion_encoder.hpp"
+#include "include/workers/path_plan.hpp"
+
+#include <cstdio>
+
+
+namespace {
+
+constexpr double kUartBytesPerSecond = 115200.0 / 10.0;  // 8N1: ten bit times per byte
+constexpr float kLayerHeight = 0.2f;  // uniform, so every layer is this thick
+
+std::vector<uint8_t> encode_plan(const PathPlanner& planner, const GcodeOptions& options, MotionStats& stats) {
+    std::vector<uint8_t> stream;
+    MotionEncoder encoder([&](std::span<const uint8_t> frame) { stream.insert(stream.end(), frame.begin(), frame.end()); },
+                          options);
+    for (const auto& layer : planner.get_plan()) encoder.add_layer(layer.z, kLayerHeight, layer.paths);
+    encoder.finish();
+    stats = encoder.stats();
+    return stream;
+}
+
+void report(const char* name, std::size_t bytes, std::size_t moves) {
+    const double per_move = static_cast<double>(bytes) / static_cast<double>(moves);
+    std::printf("  %-28s %10zu %10zu %9.2f %12.0f %10.1f\n", name, bytes, moves, per_move, kUartBytesPerSecond / per_move,
+                static_cast<double>(bytes) / kUartBytesPerSecond / 60.0);
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const std::size_t rings = bench::arg_or(argc, argv, 1, 200);
+    auto stl_path = bench::temp_path("torus_motion.bin.stl");
+    bench::write_binary_stl(stl_path, bench::make_torus(rings, rings));
+    PathPlanner planner;
+    planner.set_cad(stl_path);
+    planner.slice_planar(kLayerHeight, 1.0f);
+    std::printf("torus: %zu triangles, %zu layers\n", 2 * rings * rings, planner.get_plan().size());
+
+    auto gcode_path = bench::temp_path("torus_motion.gcode");
+    GcodeOptions unmerged;
+    unmerged.merge_tolerance = 0.0f;
+    const auto gcode = planner.save_gcode(gcode_path, unmerged);
+    const auto merged_gcode = planner.save_gcode(gcode_path);
+    std::filesystem::remove(gcode_path);
+
+    MotionStats stats;
+    std::vector<uint8_t> stream;
+    const double encode_ms = bench::best_of_ms(3, [&] { stream = encode_plan(planner, unmerged, stats); });
+
+    motion_decoder_t dec;
+    std::size_t decoded_moves = 0;
+    const double decode_ms = bench::best_of_ms(3, [&] {
+        motion_decoder_init(&dec);
+        decoded_moves = 0;
+        motion_cmd_t cmd;
+        for (uint8_t byte : stream) {
+            if (!motion_decoder_push(&dec, byte)) continue;
+            while (motion_decoder_next(&dec, &cmd) == 1) decoded_moves += cmd.kind == MOTION_CMD_MOVE || cmd.kind == MOTION_CMD_TRAVEL;
+        }
+    });
+    if (decoded_moves != stats.moves + stats.travels || dec.crc_errors + dec.sequence_errors + dec.format_errors != 0) {
+        std::printf("loopback mismatch: %zu moves decoded of %zu\n", decoded_moves, stats.moves + stats.travels);
+        return 1;
+    }
+
+    // moves are extrusions and travels; retractions ride along in both formats
+    std::printf("  %-28s %10s %10s %9s %12s %10s\n", "format", "bytes", "moves", "B/move", "moves/s@UART", "UART min");
+    report("G-code, every vertex", gcode.bytes, gcode.extrusions + gcode.travels);
+    report("G-code, collinear merged", merged_gcode.bytes, merged_gcode.extrusions + merged_gcode.travels);
+    report("binary, every vertex", stats.bytes, stats.moves + stats.travels);
+    std::printf("  binary is %.1fx smaller than unmerged G-code (%zu frames, %zu retractions)\n",
+                static_cast<double>(gcode.bytes) / static_cast<double>(stats.bytes), stats.frames, stats.retractions);
+    std::printf("  encode %.1f ms (%.0f MB/s), loopback decode %.1f ms (%.1f M moves/s)\n", encode_ms,
+                static_cast<double>(stats.bytes) / 1.0e3 / encode_ms, decode_ms,
+                static_cast<double>(decoded_moves) / 1.0e3 / decode_ms);
+
+    std::filesystem::remove(stl_path);
+    return 0;
+}
@@ -0,0 +1,83 @@
+// Perimeter offsetting: time to build 1..8 walls on a gear-like island (teeth plus a ring of
+// bolt holes), then a single inset on the same outline at growing vertex counts.
+// usage: bench_offset [teeth] [join: miter|round]   (default 2000 teeth -> 8000 outline vertices)
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/planning/polygon_offset.hpp"
+#include "include/planning/polygon_ops.hpp"
+
+#include <cstdio>
+#include <string>
+
+
+namespace {
+
+// CCW gear outline with `teeth` trapezoid teeth, and CW 24-gon holes spaced around its hub
+std::vector<polygon_t> gear(std::size_t teeth) {
+    const float two_pi = 6.28318530718f;
+    const float root = 0.5f * static_cast<float>(teeth) / 3.0f;  // ~1 mm pitch at the root
+    const float tip = root + 1.5f;
+    std::vector<polygon_t> polys(1);
+    auto at = [&](float radius, float angle) { return vec3_t{radius * std::cos(angle), radius * std::sin(angle), 0.0f}; };
+    for (std::size_t t = 0; t < teeth; ++t) {
+        float a = two_pi * static_cast<float>(t) / static_cast<float>(teeth);
+        float step = two_pi / static_cast<float>(teeth);
+        polys[0].push_back(at(root, a));
+        polys[0].push_back(at(tip, a + 0.3f * step));
+        polys[0].push_back(at(tip, a + 0.5f * step));
+        polys[0].push_back(at(root, a + 0.8f * step));
+    }
+    const std::size_t holes = std::max<std::size_t>(4, teeth / 100);
+    for (std::size_t h = 0; h < holes; ++h) {
+        float a = two_pi * static_cast<float>(h) / static_cast<float>(holes);
+        vec3_t c = at(root * 0.6f, a);
+        polygon_t hole;
+        for (int k = 0; k < 24; ++k) {
+            float b = -two_pi * static_cast<float>(k) / 24.0f;
+            hole.push_back({c.x + 1.2f * std::cos(b), c.y + 1.2f * std::sin(b), 0.0f});
+        }
+        polys.push_back(ensure_closed(hole));
+    }
+    polys[0] = ensure_closed(polys[0]);
+    return polys;
+}
+
+std::size_t vertex_count(const std::vector<polygon_t>& polys) {
+    std::size_t n = 0;
+    for (const auto& p : polys) n += p.size() - 1;
+    return n;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const std::size_t teeth = bench::arg_or(argc, argv, 1, 2000);
+    OffsetOptions options;
+    if (argc > 2 && std::string(argv[2]) == "round") options.join = JoinType::Round;
+    const float shell_width = 0.45f;
+
+    auto part = gear(teeth);
+    std::printf("gear: %zu vertices, %s joins, %.2f mm walls\n", vertex_count(part),
+                options.join == JoinType::Round ? "round" : "miter", shell_width);
+    std::printf("%10s %12s %12s %14s\n", "perimeters", "total ms", "ms / inset", "wall vertices");
+    for (int count = 1; count <= 8; ++count) {
+        std::size_t wall_vertices = 0;
+        double ms = bench::best_of_ms(3, [&] {
+            wall_vertices = vertex_count(part);
+            for (int p = 1; p < count; ++p) {
+                wall_vertices += vertex_count(offset_polygons(part, -shell_width * static_cast<float>(p), options));
+            }
+        });
+        std::printf("%10d %12.2f %12.2f %14zu\n", count, ms, count > 1 ? ms / (count - 1) : 0.0, wall_vertices);
+    }
+
+    std::printf("\nsingle %.2f mm inset against outline size\n", shell_width);
+    std::printf("%10s %12s %14s\n", "vertices", "ms", "ns / vertex");
+    for (std::size_t t = 250; t <= teeth * 8; t *= 2) {
+        auto outline = gear(t);
+        double ms = bench::best_of_ms(3, [&] { (void)offset_polygons(outline, -shell_width, options); });
+        std::printf("%10zu %12.2f %14.1f\n", vertex_count(outline), ms, 1e6 * ms / static_cast<double>(vertex_count(outline)));
+    }
+    return 0;
+}
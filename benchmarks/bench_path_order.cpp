@@ -0,0 +1,61 @@
+// Travel before and after ordering, and the ordering's own cost as the segment count grows:
+// shuffled rectilinear and honeycomb infill over a grid of square islands, then a sliced torus.
+// usage: bench_path_order [torus_rings]   (default 200 -> 80k triangles)
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/planning/path_order.hpp"
+#include "include/workers/path_plan.hpp"
+
+#include <cstdio>
+#include <random>
+
+
+int main(int argc, char** argv) {
+    const std::size_t rings = bench::arg_or(argc, argv, 1, 200);
+    std::mt19937 rng(7);
+
+    std::printf("islands of 20 mm squares, infill shuffled:\n");
+    std::printf("  %-11s %8s %10s %14s %14s %10s %12s\n", "pattern", "islands", "segments", "travel before", "travel after",
+                "order ms", "ns/segment");
+    for (auto [name, pattern] : {std::pair{"rectilinear", InfillPattern::Rectilinear}, std::pair{"honeycomb", InfillPattern::Honeycomb}}) {
+        for (std::size_t side : {4, 16, 64}) {
+            std::vector<segment_t> infill;
+            for (std::size_t i = 0; i < side * side; ++i) {
+                const float x = 25.0f * static_cast<float>(i % side), y = 25.0f * static_cast<float>(i / side);
+                const polygon_t square{{x, y, 0}, {x + 20, y, 0}, {x + 20, y + 20, 0}, {x, y + 20, 0}, {x, y, 0}};
+                auto part = pattern_infill(square, {}, 0.8f, {pattern, 45.0f}, 0, 0.0f);
+                infill.insert(infill.end(), part.begin(), part.end());
+            }
+            std::shuffle(infill.begin(), infill.end(), rng);
+            const vec3_t start = infill.front().first;
+            std::vector<segment_t> ordered;
+            double ms = bench::best_of_ms(3, [&] {
+                vec3_t cursor = start;
+                ordered = order_paths(infill, cursor);
+            });
+            std::printf("  %-11s %8zu %10zu %14.0f %14.0f %10.2f %12.0f\n", name, side * side, infill.size(),
+                        travel_distance(infill, start), travel_distance(ordered, start), ms,
+                        ms * 1e6 / static_cast<double>(infill.size()));
+        }
+    }
+
+    auto path = bench::temp_path("torus_path_order.bin.stl");
+    bench::write_binary_stl(path, bench::make_torus(rings, rings));
+    PathPlanner planner;
+    planner.set_cad(path);
+    std::printf("torus: %zu triangles, 0.2 mm layers, 1 mm spacing\n", 2 * rings * rings);
+    std::printf("  %-11s %8s %16s %16s %10s %12s\n", "pattern", "layers", "travel before mm", "travel after mm", "order ms",
+                "infill ms");
+    for (auto [name, pattern] : {std::pair{"rectilinear", InfillPattern::Rectilinear}, std::pair{"grid", InfillPattern::Grid},
+                                 std::pair{"honeycomb", InfillPattern::Honeycomb}, std::pair{"gyroid", InfillPattern::Gyroid}}) {
+        planner.set_infill_options({pattern, 0.0f});
+        const double infill_before = planner.slice_cache_stats().infill_ms;
+        planner.slice_planar(0.2f, 1.0f);
+        const auto& stats = planner.path_order_stats();
+        std::printf("  %-11s %8zu %16.0f %16.0f %10.1f %12.1f\n", name, planner.layer_count(), stats.travel_before_mm,
+                    stats.travel_after_mm, stats.ms, planner.slice_cache_stats().infill_ms - infill_before);
+    }
+
+    std::filesystem::remove(path);
+    return 0;
+}
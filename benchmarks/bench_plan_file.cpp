@@ -0,0 +1,85 @@
+// Opening a saved plan: mapping the plan file versus reading every layer into memory.
+// usage: bench_plan_file [layers] [segments_per_layer]   (default 10000 x 400)
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/containers/plan_file.hpp"
+
+#include <cstdio>
+#include <unistd.h>
+
+
+namespace {
+
+double current_rss_mb() {
+    long pages = 0;
+    if (std::FILE* f = std::fopen("/proc/self/statm", "r")) {
+        long total = 0;
+        if (std::fscanf(f, "%ld %ld", &total, &pages) != 2) pages = 0;
+        std::fclose(f);
+    }
+    return static_cast<double>(pages) * static_cast<double>(::sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+}
+
+// a ring of `count` chords per layer, turning slowly with z
+std::vector<segment_t> layer_segments(std::size_t layer, std::size_t count) {
+    std::vector<segment_t> segments;
+    segments.reserve(count);
+    const float z = 0.2f * static_cast<float>(layer);
+    for (std::size_t i = 0; i < count; ++i) {
+        float a0 = 6.2831853f * static_cast<float>(i) / static_cast<float>(count) + 0.001f * static_cast<float>(layer);
+        float a1 = a0 + 6.2831853f / static_cast<float>(count);
+        segments.push_back({{100.0f + 80.0f * std::cos(a0), 100.0f + 80.0f * std::sin(a0), z},
+                            {100.0f + 80.0f * std::cos(a1), 100.0f + 80.0f * std::sin(a1), z}});
+    }
+    return segments;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const std::size_t layers = bench::arg_or(argc, argv, 1, 10000);
+    const std::size_t per_layer = bench::arg_or(argc, argv, 2, 400);
+    auto path = bench::temp_path("plan.bin");
+
+    double write_ms = bench::best_of_ms(1, [&] {
+        PlanFileWriter writer(path);
+        for (std::size_t l = 0; l < layers; ++l) {
+            auto segments = layer_segments(l, per_layer);
+            writer.add_layer(0.2f * static_cast<float>(l), 0.2f, segments, {}, {});
+        }
+        writer.finish();
+    });
+    const double file_mb = static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+    const double raw_mb = static_cast<double>(layers * per_layer * sizeof(segment_t)) / (1024.0 * 1024.0);
+
+    // open + one layer, the server's access pattern
+    const double rss_before = current_rss_mb();
+    std::size_t touched = 0;
+    double open_ms = bench::best_of_ms(1, [&] {
+        PlanFile plan(path.string());
+        auto layer = plan.layer(plan.layer_count() / 2);
+        touched = layer.contours.to_vector().size();
+    });
+    PlanFile plan(path.string());
+    auto middle = plan.layer(layers / 2).contours.to_vector();
+    const double mapped_rss = current_rss_mb() - rss_before;
+
+    // decoding every layer into vectors, what an eager loader would hold
+    std::vector<std::vector<segment_t>> eager;
+    double eager_ms = bench::best_of_ms(1, [&] {
+        eager.reserve(plan.layer_count());
+        for (std::size_t l = 0; l < plan.layer_count(); ++l) {
+            eager.push_back(plan.layer(l).contours.to_vector());
+        }
+    });
+    const double eager_rss = current_rss_mb() - rss_before;
+
+    std::printf("plan: %zu layers x %zu segments, file %.1f MB (%.1f MB as segment_t), written in %.1f ms\n",
+                layers, per_layer, file_mb, raw_mb, write_ms);
+    std::printf("  open + read one layer   %9.3f ms  rss +%7.1f MB  %zu segments\n", open_ms, mapped_rss, touched);
+    std::printf("  decode every layer      %9.1f ms  rss +%7.1f MB\n", eager_ms, eager_rss);
+
+    std::filesystem::remove(path);
+    return middle.size() == per_layer && eager.size() == layers ? 0 : 1;
+}
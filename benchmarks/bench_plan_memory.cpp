@@ -0,0 +1,59 @@
+// Plan memory as role-tagged polylines versus the segment_t pairs they replace, split into
+// walls and infill, for each infill pattern on a sliced torus; and the cost of copying a
+// layer back out as segments.
+// usage: bench_plan_memory [torus_rings]   (default 200 -> 80k triangles)
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/workers/path_plan.hpp"
+
+#include <cstdio>
+
+
+int main(int argc, char** argv) {
+    const std::size_t rings = bench::arg_or(argc, argv, 1, 200);
+    auto path = bench::temp_path("torus_plan_memory.bin.stl");
+    bench::write_binary_stl(path, bench::make_torus(rings, rings));
+    PathPlanner planner;
+    planner.set_cad(path);
+    std::printf("torus: %zu triangles, 0.2 mm layers, 1 mm spacing, 2 perimeters\n", 2 * rings * rings);
+    std::printf("  %-11s %10s %10s %12s %12s %8s %12s %12s %12s\n", "pattern", "segments", "paths", "pairs MB",
+                "paths MB", "ratio", "wall B/seg", "infill B/seg", "copy-out ms");
+    for (auto [name, pattern] : {std::pair{"rectilinear", InfillPattern::Rectilinear}, std::pair{"grid", InfillPattern::Grid},
+                                 std::pair{"honeycomb", InfillPattern::Honeycomb}, std::pair{"gyroid", InfillPattern::Gyroid}}) {
+        planner.set_infill_options({pattern, 0.0f});
+        planner.slice_planar(0.2f, 1.0f);
+        std::size_t segments = 0, paths = 0, bytes = 0;
+        std::size_t wall_segments = 0, wall_bytes = 0, infill_segments = 0, infill_bytes = 0;
+        for (const auto& layer : planner.get_plan()) {
+            segments += layer.paths.segment_count();
+            paths += layer.paths.path_count();
+            bytes += layer.paths.memory_bytes();
+            // a path's share: its vertices, offset and role tag
+            for (std::size_t p = 0; p < layer.paths.path_count(); ++p) {
+                const auto path = layer.paths.path(p);
+                const std::size_t share = path.points.size() * sizeof(vec2_t) + sizeof(uint32_t) + sizeof(PathRole);
+                if (is_wall(path.role)) {
+                    wall_segments += path.segment_count();
+                    wall_bytes += share;
+                } else if (path.role == PathRole::Infill) {
+                    infill_segments += path.segment_count();
+                    infill_bytes += share;
+                }
+            }
+        }
+        std::size_t copied = 0;
+        double copy_ms = bench::best_of_ms(3, [&] {
+            copied = 0;
+            for (const auto& layer : planner.get_plan()) copied += layer.contours().size() + layer.infill().size();
+        });
+        const double pair_bytes = static_cast<double>(segments * sizeof(segment_t));
+        std::printf("  %-11s %10zu %10zu %12.2f %12.2f %8.2f %12.1f %12.1f %12.2f\n", name, segments, paths, pair_bytes / 1e6,
+                    static_cast<double>(bytes) / 1e6, static_cast<double>(bytes) / pair_bytes,
+                    static_cast<double>(wall_bytes) / static_cast<double>(std::max<std::size_t>(wall_segments, 1)),
+                    static_cast<double>(infill_bytes) / static_cast<double>(std::max<std::size_t>(infill_segments, 1)), copy_ms);
+        if (copied > segments) return 1;
+    }
+
+    std::filesystem::remove(path);
+    return 0;
+}
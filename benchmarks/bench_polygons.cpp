@@ -0,0 +1,122 @@
+// Polygon nesting scaling: the all-pairs classify_polygons/build_islands against the grid
+// indexed versions on one layer holding a frame and a lattice of rings (outer loop + hole).
+// usage: bench_polygons [max_loops] [legacy_max_loops]   (default 100000, 10000)
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/planning/polygon_ops.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+
+namespace {
+
+// the all-pairs classification and hole assignment used before BoxGridIndex
+std::vector<ClassifiedPolygon> legacy_classify(std::vector<polygon_t> polys) {
+    std::vector<polygon_t> closed;
+    closed.reserve(polys.size());
+    for (auto& poly : polys) closed.push_back(ensure_closed(std::move(poly)));
+
+    std::vector<ClassifiedPolygon> result;
+    std::vector<std::optional<vec3_t>> interior_pts(closed.size());
+    for (std::size_t i = 0; i < closed.size(); ++i) {
+        interior_pts[i] = interior_point(closed[i]);
+        if (!interior_pts[i].has_value()) interior_pts[i] = polygon_centroid(closed[i]);
+    }
+    for (std::size_t i = 0; i < closed.size(); ++i) {
+        int depth = 0;
+        for (std::size_t j = 0; j < closed.size(); ++j) {
+            if (i != j && point_in_polygon(closed[j], *interior_pts[i])) depth++;
+        }
+        float area = signed_area(closed[i]);
+        bool is_hole = (depth % 2) == 1;
+        polygon_t oriented = closed[i];
+        if ((is_hole && area > 0.0f) || (!is_hole && area < 0.0f)) {
+            std::reverse(oriented.begin(), oriented.end());
+            area = -area;
+        }
+        result.push_back({std::move(oriented), area, depth, is_hole});
+    }
+    std::sort(result.begin(), result.end(), [](const ClassifiedPolygon& a, const ClassifiedPolygon& b) {
+        return std::abs(a.area) > std::abs(b.area);
+    });
+    return result;
+}
+
+std::vector<Island> legacy_islands(const std::vector<ClassifiedPolygon>& polys) {
+    std::vector<Island> islands;
+    std::vector<bool> hole_used(polys.size(), false);
+    for (std::size_t i = 0; i < polys.size(); ++i) {
+        if (polys[i].is_hole) continue;
+        Island island;
+        island.outer = polys[i].poly;
+        for (std::size_t h = 0; h < polys.size(); ++h) {
+            if (!polys[h].is_hole || hole_used[h]) continue;
+            if (point_in_polygon(island.outer, polygon_centroid(polys[h].poly))) {
+                island.holes.push_back(polys[h].poly);
+                hole_used[h] = true;
+            }
+        }
+        islands.push_back(std::move(island));
+    }
+    return islands;
+}
+
+polygon_t circle_loop(float cx, float cy, float r, bool ccw) {
+    constexpr int kSides = 16;
+    polygon_t poly;
+    for (int k = 0; k < kSides; ++k) {
+        float a = 6.2831853f * static_cast<float>(ccw ? k : kSides - k) / kSides;
+        poly.push_back({cx + r * std::cos(a), cy + r * std::sin(a), 0.0f});
+    }
+    return poly;
+}
+
+// a square frame around a side x side lattice of rings; each ring is two loops
+std::vector<polygon_t> ring_lattice(std::size_t loops) {
+    const std::size_t rings = std::max<std::size_t>(1, (loops - 1) / 2);
+    const auto side = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(rings))));
+    const float pitch = 4.0f;
+    const float extent = pitch * static_cast<float>(side) + pitch;
+    std::vector<polygon_t> polys{{{-pitch, -pitch, 0.0f}, {extent, -pitch, 0.0f}, {extent, extent, 0.0f}, {-pitch, extent, 0.0f}}};
+    for (std::size_t r = 0; r < rings; ++r) {
+        float cx = pitch * static_cast<float>(r % side);
+        float cy = pitch * static_cast<float>(r / side);
+        polys.push_back(circle_loop(cx, cy, 1.5f, true));
+        polys.push_back(circle_loop(cx, cy, 1.0f, false));
+    }
+    return polys;
+}
+
+bool same_islands(const std::vector<Island>& a, const std::vector<Island>& b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (!(a[i].outer == b[i].outer) || !(a[i].holes == b[i].holes)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const std::size_t max_loops = bench::arg_or(argc, argv, 1, 100000);
+    const std::size_t legacy_max = bench::arg_or(argc, argv, 2, 10000);
+
+    std::printf("%10s %14s %14s %9s\n", "loops", "all-pairs ms", "grid ms", "speedup");
+    for (std::size_t loops = 10; loops <= max_loops; loops *= 10) {
+        const auto polys = ring_lattice(loops);
+        std::vector<Island> grid;
+        double grid_ms = bench::best_of_ms(3, [&] { grid = build_islands(classify_polygons(polys)); });
+
+        if (polys.size() > legacy_max) {
+            std::printf("%10zu %14s %14.2f %9s\n", polys.size(), "skipped", grid_ms, "-");
+            continue;
+        }
+        std::vector<Island> legacy;
+        double legacy_ms = bench::best_of_ms(3, [&] { legacy = legacy_islands(legacy_classify(polys)); });
+        std::printf("%10zu %14.2f %14.2f %8.1fx%s\n", polys.size(), legacy_ms, grid_ms, legacy_ms / grid_ms,
+                    same_islands(legacy, grid) ? "" : "  MISMATCH");
+    }
+    return 0;
+}
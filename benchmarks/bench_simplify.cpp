@@ -0,0 +1,41 @@
+// Contour simplification on a finely tessellated torus: loop vertices left, loops kept whole
+// for topology, and the end-to-end slice time (every stage rebuilt) against no simplification.
+// usage: bench_simplify [torus_rings]   (default 600 -> 720k triangles)
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/workers/path_plan.hpp"
+
+#include <cstdio>
+
+
+int main(int argc, char** argv) {
+    const std::size_t rings = bench::arg_or(argc, argv, 1, 600);
+    auto path = bench::temp_path("torus_simplify.bin.stl");
+    bench::write_binary_stl(path, bench::make_torus(rings, rings));
+    PathPlanner planner;
+    planner.set_cad(path);
+    std::printf("torus: %zu triangles, 0.2 mm layers, 1 mm spacing, 2 perimeters\n", 2 * rings * rings);
+    std::printf("  %9s %10s %10s %7s %10s %10s %10s %10s %10s %10s %10s %8s\n", "tolerance", "vertices", "left", "ratio",
+                "loops kept", "island ms", "wall ms", "infill ms", "order ms", "slice ms", "segments", "speedup");
+    double baseline_ms = 0.0;
+    for (float tolerance : {0.0f, 0.001f, 0.005f, 0.01f, 0.05f}) {
+        planner.set_contour_tolerance(tolerance);
+        const auto before = planner.slice_cache_stats();
+        double ms = bench::best_of_ms(3, [&] {
+            planner.clear_slice_cache();
+            planner.slice_planar(0.2f, 1.0f);
+        });
+        const auto& after = planner.slice_cache_stats();
+        const auto& stats = planner.simplify_stats();
+        std::size_t segments = 0;
+        for (const auto& layer : planner.get_plan()) segments += layer.paths.segment_count();
+        if (tolerance == 0.0f) baseline_ms = ms;
+        std::printf("  %9.3f %10zu %10zu %7.3f %10zu %10.1f %10.1f %10.1f %10.1f %10.1f %10zu %7.2fx\n", tolerance,
+                    stats.vertices_before, stats.vertices_after, stats.reduction(), stats.loops_kept,
+                    (after.island_ms - before.island_ms) / 3.0, (after.wall_ms - before.wall_ms) / 3.0,
+                    (after.infill_ms - before.infill_ms) / 3.0, planner.path_order_stats().ms, ms, segments, baseline_ms / ms);
+    }
+
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,157 @@
+// Layer slicing benchmark: the per-triangle layer loop slice_planar used to run against
+// sweep_slice on indexed meshes and on MeshSoA, for layer heights from 1 mm down to 0.05 mm,
+// then the intersection kernels alone.
+// usage: bench_slice [torus_rings]   (default 300 -> 180k triangles)
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/planning/intersect_kernel.hpp"
+#include "include/planning/sweep_slicer.hpp"
+#include "include/stl_helpers.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <utility>
+
+
+namespace {
+
+// Layers a triangle spanning [min_z, max_z] can touch, clamped to [0, num_layers). The range is
+// empty when first > last.
+std::pair<int, int> layer_span(float min_z, float max_z, float layer_height, std::size_t num_layers) {
+    auto start_layer = static_cast<int>(std::floor(min_z / layer_height));
+    auto end_layer = static_cast<int>(std::ceil(max_z / layer_height));
+    return {std::max(0, start_layer), std::min(static_cast<int>(num_layers) - 1, end_layer)};
+}
+
+std::size_t layer_count_for(float layer_height) {
+    return static_cast<std::size_t>(MAX_PART_HEIGHT_MM / layer_height);
+}
+
+// one std::vector per intersection, three inside each call: the allocation pattern being replaced
+std::vector<std::vector<segment_t>> slice_per_triangle(const std::vector<Mesh>& meshes, float layer_height) {
+    std::size_t num_layers = layer_count_for(layer_height);
+    std::vector<std::vector<segment_t>> layers(num_layers);
+    for (const auto& mesh : meshes) {
+        for (const auto& tri : mesh.triangles) {
+            float z0 = mesh.points[tri.vertices[0]].z;
+            float z1 = mesh.points[tri.vertices[1]].z;
+            float z2 = mesh.points[tri.vertices[2]].z;
+            auto [first, last] = layer_span(std::min({z0, z1, z2}), std::max({z0, z1, z2}), layer_height, num_layers);
+            for (int l = first; l <= last; ++l) {
+                auto segs = mesh.intersect_triangle_with_plane(tri, static_cast<float>(l) * layer_height);
+                auto& layer = layers[static_cast<std::size_t>(l)];
+                layer.insert(layer.end(), segs.begin(), segs.end());
+            }
+        }
+    }
+    return layers;
+}
+
+bool same_layers(const std::vector<std::vector<segment_t>>& expected, const LayerSegments& swept) {
+    if (expected.size() != swept.layer_count()) return false;
+    for (std::size_t l = 0; l < expected.size(); ++l) {
+        auto layer = swept.layer(l);
+        if (layer.size() != expected[l].size()) return false;
+        for (std::size_t i = 0; i < layer.size(); ++i) {
+            if (!(layer[i].first == expected[l][i].first) || !(layer[i].second == expected[l][i].second)) return false;
+        }
+    }
+    return true;
+}
+
+// every triangle against `planes` planes through the part, one intersect_block call per plane
+bool kernel_benchmark(const Mesh& mesh, std::size_t planes) {
+    std::vector<float> coords[9];
+    float min_z = std::numeric_limits<float>::max();
+    float max_z = std::numeric_limits<float>::lowest();
+    for (const auto& tri : mesh.triangles) {
+        for (int k = 0; k < 3; ++k) {
+            const vec3_t& p = mesh.points[tri.vertices[k]];
+            coords[k].push_back(p.x);
+            coords[3 + k].push_back(p.y);
+            coords[6 + k].push_back(p.z);
+            min_z = std::min(min_z, p.z);
+            max_z = std::max(max_z, p.z);
+        }
+    }
+    TriangleBlock block{{coords[0].data(), coords[1].data(), coords[2].data()},
+                        {coords[3].data(), coords[4].data(), coords[5].data()},
+                        {coords[6].data(), coords[7].data(), coords[8].data()},
+                        mesh.triangles.size()};
+
+    std::vector<segment_t> out(block.count * kMaxTriangleSegments);
+    std::vector<uint8_t> counts(block.count);
+    std::vector<uint8_t> scalar_counts;
+    std::printf("intersect_block: %zu triangles x %zu planes\n", block.count, planes);
+    double scalar_ms = 0.0;
+    bool same = true;
+    for (auto kernel : {IntersectKernel::Scalar, IntersectKernel::Avx2, IntersectKernel::Neon}) {
+        if (!intersect_kernel_supported(kernel)) continue;
+        std::size_t segments = 0;
+        double ms = bench::best_of_ms(3, [&] {
+            segments = 0;
+            for (std::size_t p = 0; p < planes; ++p) {
+                float z = min_z + (max_z - min_z) * (static_cast<float>(p) + 0.5f) / static_cast<float>(planes);
+                intersect_block(kernel, block, z, out.data(), counts.data());
+                for (auto c : counts) segments += c;
+            }
+        });
+        if (kernel == IntersectKernel::Scalar) {
+            scalar_ms = ms;
+            scalar_counts = counts;
+        }
+        same = same && counts == scalar_counts;
+        std::printf("  %-8s %9.1f ms  %8.1f Mtri-planes/s  %zu segments  (%.2fx)%s\n", intersect_kernel_name(kernel), ms,
+                    static_cast<double>(block.count * planes) / (ms * 1000.0), segments, scalar_ms / ms,
+                    kernel == active_intersect_kernel() ? "  active" : "");
+    }
+    return same;
+}
+
+
+
+bool layer_benchmark(const char* name, const std::vector<Mesh>& meshes) {
+    std::vector<MeshSoA> soa;
+    double soa_build_ms = bench::best_of_ms(3, [&] { soa = std::vector<MeshSoA>(meshes.begin(), meshes.end()); });
+
+    std::printf("%s: %zu triangles, MeshSoA build %.1f ms\n", name, meshes.front().triangles.size(), soa_build_ms);
+    std::printf("  layer mm   layers   segments   per-triangle ms   sweep ms   speedup   sweep SoA ms   speedup\n");
+    bool all_same = true;
+    for (float layer_height : {1.0f, 0.5f, 0.25f, 0.1f, 0.05f}) {
+        std::vector<std::vector<segment_t>> expected;
+        LayerSegments swept, swept_soa;
+        double legacy_ms = bench::best_of_ms(5, [&] { expected = slice_per_triangle(meshes, layer_height); });
+        double sweep_ms = bench::best_of_ms(5, [&] { swept = sweep_slice(meshes, layer_height); });
+        double soa_ms = bench::best_of_ms(5, [&] { swept_soa = sweep_slice(soa, layer_height); });
+        bool same = same_layers(expected, swept) && same_layers(expected, swept_soa);
+        all_same = all_same && same;
+        std::printf("  %8.2f %8zu %10zu %17.1f %10.1f %8.2fx %14.1f %8.2fx%s\n", layer_height, swept.layer_count(),
+                    swept.segments.size(), legacy_ms, sweep_ms, legacy_ms / sweep_ms, soa_ms, legacy_ms / soa_ms,
+                    same ? "" : "  MISMATCH");
+    }
+    return all_same;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const std::size_t rings = bench::arg_or(argc, argv, 1, 300);
+    auto path = bench::temp_path("torus_slice.bin.stl");
+    bench::write_binary_stl(path, bench::make_torus(rings, rings));
+    std::vector<Mesh> meshes{read_stl_binary_mapped(path.string())};
+    std::filesystem::remove(path);
+
+    bool all_same = layer_benchmark("torus", meshes);
+
+    // exported STLs rarely list triangles spatially; shuffled order is where gathers hurt
+    std::vector<Mesh> shuffled = meshes;
+    std::shuffle(shuffled.front().triangles.begin(), shuffled.front().triangles.end(), std::mt19937(11));
+    all_same = layer_benchmark("torus, shuffled triangles", shuffled) && all_same;
+
+    all_same = kernel_benchmark(meshes.front(), 50) && all_same;
+    return all_same ? 0 : 1;
+}
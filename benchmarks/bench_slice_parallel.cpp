@@ -0,0 +1,52 @@
+// slice_planar thread sweep on a tall part: the benchmark torus stood on its rim, so there are
+// ~130 layers at 1 mm and their cost varies with the cross-section.
+// usage: bench_slice_parallel [torus_rings] [max_threads] [infill_spacing]   (default 200, hw threads, 0.5)
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/planning/work_stealing.hpp"
+#include "include/workers/path_plan.hpp"
+
+#include <cstdio>
+#include <string>
+
+
+int main(int argc, char** argv) {
+    const std::size_t rings = bench::arg_or(argc, argv, 1, 200);
+    const std::size_t max_threads = bench::arg_or(argc, argv, 2, resolve_thread_count(0));
+    const float infill_spacing = argc > 3 ? std::stof(argv[3]) : 0.5f;
+
+    auto tris = bench::make_torus(rings, rings);
+    for (auto& tri : tris) {
+        for (auto& pt : tri) std::swap(pt.y, pt.z);
+    }
+    auto path = bench::temp_path("torus_upright.bin.stl");
+    bench::write_binary_stl(path, tris);
+
+    PathPlanner planner;
+    planner.set_cad(path);
+    std::vector<PathPlanner::LayerPlan> reference;
+    std::printf("upright torus: %zu triangles, infill spacing %.2f mm\n", tris.size(), infill_spacing);
+
+    bool same = true;
+    double single_ms = 0.0;
+    for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+        planner.set_thread_count(threads);
+        double ms = bench::best_of_ms(3, [&] { planner.slice_planar(1, infill_spacing); });
+        if (threads == 1) {
+            single_ms = ms;
+            reference = planner.get_plan();
+        }
+        bool stable = planner.layer_count() == reference.size();
+        for (std::size_t l = 0; stable && l < planner.layer_count(); ++l) {
+            stable = planner.get_layer(l).contours.size() == reference[l].contours().size() &&
+                planner.get_layer(l).infill.size() == reference[l].infill().size();
+        }
+        same = same && stable;
+        std::printf("  %2zu threads  %9.1f ms  %4zu layers  speedup %.2fx%s\n",
+                    threads, ms, planner.layer_count(), single_ms / ms, stable ? "" : "  MISMATCH");
+        if (threads < max_threads && threads * 2 > max_threads) threads = max_threads / 2; // always end on max_threads
+    }
+
+    std::filesystem::remove(path);
+    return same ? 0 : 1;
+}
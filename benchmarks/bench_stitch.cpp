@@ -0,0 +1,170 @@
+// Contour stitching: the unordered_map/unordered_set graph build_polygons_from_segments used
+// against stitch_contours, on a layer of many small loops with the segments shuffled, and on
+// the same layer with every endpoint jittered by up to half the snap distance.
+// usage: bench_stitch [loops]   (default 20000 loops of 24 segments)
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/planning/contour_stitch.hpp"
+#include "include/planning/polygon_ops.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <optional>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+
+
+namespace {
+
+struct GraphEdge {
+    std::size_t a;
+    std::size_t b;
+    bool used = false;
+};
+
+struct EdgeKey {
+    std::size_t a;
+    std::size_t b;
+};
+
+struct EdgeKeyHash {
+    std::size_t operator()(const EdgeKey& key) const {
+        return (key.a * 73856093u) ^ (key.b * 19349663u);
+    }
+};
+
+struct EdgeKeyEq {
+    bool operator()(const EdgeKey& lhs, const EdgeKey& rhs) const {
+        return lhs.a == rhs.a && lhs.b == rhs.b;
+    }
+};
+
+// build_polygons_from_segments as it was before stitch_contours
+std::vector<polygon_t> legacy_stitch(const std::vector<segment_t>& segments, float eps) {
+    std::vector<vec3_t> nodes;
+    std::unordered_map<long long, std::vector<std::size_t>> buckets;
+    std::vector<GraphEdge> edges;
+    edges.reserve(segments.size());
+    std::unordered_set<EdgeKey, EdgeKeyHash, EdgeKeyEq> seen_edges;
+
+    auto add_node = [&](const vec3_t& p) -> std::size_t {
+        long long hash = std::llround(p.x / eps) * 73856093LL ^ std::llround(p.y / eps) * 19349663LL;
+        auto& bucket = buckets[hash];
+        for (auto idx : bucket) {
+            if (close2d(nodes[idx], p, eps)) return idx;
+        }
+        nodes.push_back(p);
+        bucket.push_back(nodes.size() - 1);
+        return nodes.size() - 1;
+    };
+
+    for (const auto& seg : segments) {
+        auto a_idx = add_node(seg.first);
+        auto b_idx = add_node(seg.second);
+        if (a_idx == b_idx) continue;
+        EdgeKey key{std::min(a_idx, b_idx), std::max(a_idx, b_idx)};
+        if (seen_edges.find(key) != seen_edges.end()) continue;
+        seen_edges.insert(key);
+        edges.push_back({a_idx, b_idx, false});
+    }
+
+    std::vector<std::vector<std::size_t>> adjacency(nodes.size());
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        adjacency[edges[i].a].push_back(i);
+        adjacency[edges[i].b].push_back(i);
+    }
+
+    auto choose_next_edge = [&](std::size_t vertex, std::size_t prev_vertex) -> std::optional<std::size_t> {
+        std::optional<std::size_t> fallback;
+        for (auto edge_idx : adjacency[vertex]) {
+            if (edges[edge_idx].used) continue;
+            std::size_t other = edges[edge_idx].a == vertex ? edges[edge_idx].b : edges[edge_idx].a;
+            if (other != prev_vertex) return edge_idx;
+            fallback = edge_idx;
+        }
+        return fallback;
+    };
+
+    std::vector<polygon_t> polygons;
+    for (std::size_t start_edge = 0; start_edge < edges.size(); ++start_edge) {
+        if (edges[start_edge].used) continue;
+        polygon_t poly;
+        edges[start_edge].used = true;
+        std::size_t start = edges[start_edge].a;
+        std::size_t current = edges[start_edge].b;
+        std::size_t prev_vertex = start;
+        poly.push_back(nodes[start]);
+        poly.push_back(nodes[current]);
+
+        std::size_t guard = 0;
+        while (guard++ < edges.size() * 2) {
+            auto next_edge_idx = choose_next_edge(current, prev_vertex);
+            if (!next_edge_idx.has_value()) break;
+            auto& edge = edges[*next_edge_idx];
+            edge.used = true;
+            std::size_t next_vertex = edge.a == current ? edge.b : edge.a;
+            if (next_vertex == start) {
+                poly.push_back(nodes[start]);
+                break;
+            }
+            prev_vertex = current;
+            current = next_vertex;
+            poly.push_back(nodes[current]);
+        }
+        if (poly.size() >= 4 && poly.front() == poly.back()) polygons.push_back(std::move(poly));
+    }
+    return polygons;
+}
+
+// `loops` 24-gons on a lattice, as a slicer would emit them: each edge once, in shuffled order
+std::vector<segment_t> loop_lattice(std::size_t loops, std::mt19937& rng) {
+    constexpr int kSides = 24;
+    const auto side = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(loops))));
+    std::vector<segment_t> segments;
+    for (std::size_t l = 0; l < loops; ++l) {
+        float cx = 3.0f * static_cast<float>(l % side);
+        float cy = 3.0f * static_cast<float>(l / side);
+        auto corner = [&](int k) {
+            float a = 6.2831853f * static_cast<float>(k % kSides) / kSides;
+            return vec3_t{cx + std::cos(a), cy + std::sin(a), 1.0f};
+        };
+        for (int k = 0; k < kSides; ++k) segments.push_back({corner(k), corner(k + 1)});
+    }
+    std::shuffle(segments.begin(), segments.end(), rng);
+    return segments;
+}
+
+void run_case(const char* name, const std::vector<segment_t>& segments) {
+    std::vector<polygon_t> legacy;
+    StitchResult stitched;
+    double legacy_ms = bench::best_of_ms(3, [&] { legacy = legacy_stitch(segments, kSnapEps); });
+    double stitch_ms = bench::best_of_ms(3, [&] { stitched = stitch_contours(segments, kSnapEps); });
+    std::printf("%s: %zu segments\n", name, segments.size());
+    std::printf("  unordered_map graph   %8.2f ms  %7zu loops\n", legacy_ms, legacy.size());
+    std::printf("  stitch_contours       %8.2f ms  %7zu loops  %zu open  (%.2fx)%s\n", stitch_ms,
+                stitched.loops.size(), stitched.open_chains.size(), legacy_ms / stitch_ms,
+                stitched.loops == legacy ? "  same loops" : "");
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const std::size_t loops = bench::arg_or(argc, argv, 1, 20000);
+    std::mt19937 rng(3);
+
+    auto segments = loop_lattice(loops, rng);
+    run_case("shuffled loop lattice", segments);
+
+    // each copy of an endpoint moves independently, so copies often land in different cells
+    std::uniform_real_distribution<float> jitter(-0.35f * kSnapEps, 0.35f * kSnapEps);
+    for (auto& seg : segments) {
+        seg.first.x += jitter(rng);
+        seg.first.y += jitter(rng);
+        seg.second.x += jitter(rng);
+        seg.second.y += jitter(rng);
+    }
+    run_case("jittered endpoints", segments);
+    return 0;
+}
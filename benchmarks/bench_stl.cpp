@@ -0,0 +1,101 @@
+// STL ingestion benchmarks.
+// usage: bench_stl [torus_rings] [max_threads] [ascii_copies]
+//   torus_rings:  2 * rings * rings triangles, default 1000 -> 2M
+//   max_threads:  upper end of the read_stl_binary_parallel sweep, default hardware_concurrency
+//   ascii_copies: number of tests/data/torus_ascii.stl solids concatenated for the ASCII run
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/stl_helpers.hpp"
+
+#include <cstdio>
+#include <iterator>
+#include <thread>
+
+
+namespace {
+
+bool ascii_benchmark(std::size_t copies) {
+    auto source = std::filesystem::path(__FILE__).parent_path().parent_path() / "tests" / "data" / "torus_ascii.stl";
+    std::ifstream in(source);
+    std::string solid((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    auto path = bench::temp_path("torus_scaled.ascii.stl");
+    {
+        std::ofstream out(path);
+        for (std::size_t i = 0; i < copies; ++i) out << solid;
+    }
+    const double file_mb = static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+
+    std::vector<Mesh> reference;
+    double stream_ms = bench::best_of_ms(3, [&] { reference = read_stl_ascii(path.string()); });
+    std::vector<Mesh> mapped;
+    double mapped_ms = bench::best_of_ms(3, [&] { mapped = read_stl_ascii_mapped(path.string()); });
+
+    bool same = reference.size() == mapped.size();
+    for (std::size_t s = 0; same && s < reference.size(); ++s) {
+        same = reference[s].points.size() == mapped[s].points.size() &&
+            reference[s].triangles.size() == mapped[s].triangles.size();
+        for (std::size_t i = 0; same && i < reference[s].triangles.size(); ++i) {
+            same = reference[s].triangles[i].vertices == mapped[s].triangles[i].vertices;
+        }
+    }
+
+    std::printf("ascii stl: %zu x torus_ascii.stl, %.1f MB\n", copies, file_mb);
+    std::printf("  read_stl_ascii          %9.1f ms  %8.1f MB/s\n", stream_ms, file_mb / (stream_ms / 1000.0));
+    std::printf("  read_stl_ascii_mapped   %9.1f ms  %8.1f MB/s  (%.2fx)\n",
+                mapped_ms, file_mb / (mapped_ms / 1000.0), stream_ms / mapped_ms);
+    std::printf("  identical meshes: %s\n", same ? "yes" : "NO");
+
+    std::filesystem::remove(path);
+    return same;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const std::size_t rings = bench::arg_or(argc, argv, 1, 1000);
+    auto path = bench::temp_path("torus.bin.stl");
+    bench::write_binary_stl(path, bench::make_torus(rings, rings));
+    const double file_mb = static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+
+    Mesh reference;
+    double stream_ms = bench::best_of_ms(3, [&] { reference = read_stl_binary(path.string()); });
+    Mesh mapped;
+    double mapped_ms = bench::best_of_ms(3, [&] { mapped = read_stl_binary_mapped(path.string()); });
+
+    bool same = reference.points.size() == mapped.points.size() &&
+        reference.triangles.size() == mapped.triangles.size();
+    for (std::size_t i = 0; same && i < reference.triangles.size(); ++i) {
+        same = reference.triangles[i].vertices == mapped.triangles[i].vertices;
+    }
+
+    std::printf("binary stl: %zu triangles, %zu points, %.1f MB\n",
+                reference.triangles.size(), reference.points.size(), file_mb);
+    std::printf("  read_stl_binary         %9.1f ms  %8.1f MB/s\n", stream_ms, file_mb / (stream_ms / 1000.0));
+    std::printf("  read_stl_binary_mapped  %9.1f ms  %8.1f MB/s  (%.2fx)\n",
+                mapped_ms, file_mb / (mapped_ms / 1000.0), stream_ms / mapped_ms);
+    std::printf("  identical mesh: %s\n", same ? "yes" : "NO");
+
+    const std::size_t max_threads = bench::arg_or(argc, argv, 2, std::max(1u, std::thread::hardware_concurrency()));
+    std::printf("read_stl_binary_parallel thread sweep:\n");
+    double single_ms = 0.0;
+    for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+        Mesh parallel;
+        double ms = bench::best_of_ms(3, [&] { parallel = read_stl_binary_parallel(path.string(), threads); });
+        if (threads == 1) single_ms = ms;
+        bool stable = parallel.points.size() == reference.points.size();
+        for (std::size_t i = 0; stable && i < reference.triangles.size(); ++i) {
+            stable = reference.triangles[i].vertices == parallel.triangles[i].vertices;
+        }
+        same = same && stable;
+        std::printf("  %2zu threads  %9.1f ms  %8.1f MB/s  speedup %.2fx  %s\n",
+                    threads, ms, file_mb / (ms / 1000.0), single_ms / ms, stable ? "" : "MISMATCH");
+        if (threads < max_threads && threads * 2 > max_threads) threads = max_threads / 2; // always end on max_threads
+    }
+
+    std::filesystem::remove(path);
+
+    same = ascii_benchmark(bench::arg_or(argc, argv, 3, 50)) && same;
+    return same ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+// Peak-RSS comparison between set_cad + slice_planar and slice_planar_streaming.
+// usage: bench_streaming [torus_rings] [budget_mb]   (default 1000 -> 2M triangles, 16 MB)
+// Peak RSS only grows, so the streaming run goes first and the in-memory run second.
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/workers/path_plan.hpp"
+
+#include <cstdio>
+#include <sys/resource.h>
+
+
+namespace {
+
+double peak_rss_mb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const std::size_t rings = bench::arg_or(argc, argv, 1, 1000);
+    const std::size_t budget_mb = bench::arg_or(argc, argv, 2, 16);
+    auto path = bench::temp_path("torus_streaming.bin.stl");
+    bench::write_binary_stl(path, bench::make_torus(rings, rings));
+    const double file_mb = static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+    const double baseline_mb = peak_rss_mb();
+
+    std::size_t streamed_layers = 0;
+    PathPlanner streaming;
+    double stream_ms = bench::best_of_ms(1, [&] {
+        streaming.slice_planar_streaming(path, 1, 2.0f, budget_mb << 20,
+                                         [&](const PathPlanner::LayerPlan&) { streamed_layers++; });
+    });
+    const double stream_rss_mb = peak_rss_mb();
+
+    PathPlanner in_memory;
+    double memory_ms = bench::best_of_ms(1, [&] {
+        in_memory.set_cad(path);
+        in_memory.slice_planar(1, 2.0f);
+    });
+    const double memory_rss_mb = peak_rss_mb();
+
+    std::printf("binary stl: %zu triangles, %.1f MB, budget %zu MB, baseline rss %.1f MB\n",
+                2 * rings * rings, file_mb, budget_mb, baseline_mb);
+    std::printf("  slice_planar_streaming   %9.1f ms  peak rss %8.1f MB  %zu layers\n",
+                stream_ms, stream_rss_mb, streamed_layers);
+    std::printf("  set_cad + slice_planar   %9.1f ms  peak rss %8.1f MB  %zu layers\n",
+                memory_ms, memory_rss_mb, in_memory.layer_count());
+
+    std::filesystem::remove(path);
+    return streamed_layers == in_memory.layer_count() ? 0 : 1;
+}
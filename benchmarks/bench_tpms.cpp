@@ -0,0 +1,70 @@
+// Gyroid and Schwarz infill on every layer of a 300 mm tall part with a 150 mm square footprint
+// and four round holes, at several densities (0.4 mm lines), on one thread; then the field rows
+// alone per kernel.
+// usage: bench_tpms [layers]   (default 1500 -> 0.2 mm layers)
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/planning/tpms.hpp"
+
+#include <cstdio>
+
+
+namespace {
+
+polygon_t circle(float cx, float cy, float radius, std::size_t points, bool ccw) {
+    polygon_t loop;
+    for (std::size_t k = 0; k < points; ++k) {
+        float a = (ccw ? 1.0f : -1.0f) * 6.2831853f * static_cast<float>(k) / static_cast<float>(points);
+        loop.push_back({cx + radius * std::cos(a), cy + radius * std::sin(a), 0.0f});
+    }
+    loop.push_back(loop.front());
+    return loop;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const std::size_t layers = bench::arg_or(argc, argv, 1, 1500);
+    const float height = 300.0f;
+    const polygon_t outer{{0, 0, 0}, {150, 0, 0}, {150, 150, 0}, {0, 150, 0}, {0, 0, 0}};
+    const std::vector<polygon_t> holes{circle(40, 40, 15, 64, false), circle(110, 40, 15, 64, false),
+                                       circle(40, 110, 15, 64, false), circle(110, 110, 15, 64, false)};
+
+    std::printf("part: 150 x 150 x %.0f mm, 4 holes, %zu layers, kernel %s\n", height, layers,
+                intersect_kernel_name(active_intersect_kernel()));
+    std::printf("  %-9s %8s %9s %10s %14s %12s %12s\n", "surface", "density", "spacing", "period", "segments/layer",
+                "total s", "ms/layer");
+    const std::pair<const char*, TpmsSurface> surfaces[] = {
+        {"gyroid", TpmsSurface::Gyroid}, {"schwarz-p", TpmsSurface::SchwarzP}, {"schwarz-d", TpmsSurface::SchwarzD}};
+    for (const auto& [name, surface] : surfaces) {
+        for (float density : {0.05f, 0.1f, 0.2f, 0.4f}) {
+            const float spacing = 0.4f / density;
+            std::size_t segments = 0;
+            double ms = bench::best_of_ms(1, [&] {
+                segments = 0;
+                for (std::size_t l = 0; l < layers; ++l) {
+                    float z = height * static_cast<float>(l + 1) / static_cast<float>(layers);
+                    segments += tpms_infill(outer, holes, surface, spacing, z).size();
+                }
+            });
+            std::printf("  %-9s %7.0f%% %9.2f %10.2f %14zu %12.2f %12.2f\n", name, density * 100.0f, spacing,
+                        tpms_period_for_spacing(surface, spacing), segments / layers, ms / 1000.0,
+                        ms / static_cast<double>(layers));
+        }
+    }
+
+    // rows of a 0.1 mm grid over the footprint, 200 layers' worth
+    const std::size_t nx = 1500;
+    std::vector<float> row(nx);
+    std::printf("  field rows (%zu samples):\n", nx);
+    for (auto kernel : {IntersectKernel::Scalar, IntersectKernel::Avx2, IntersectKernel::Neon}) {
+        if (!intersect_kernel_supported(kernel)) continue;
+        TpmsLayerField field(TpmsSurface::Gyroid, 2.5f, 10.0f, 0.0f, 0.1f, nx);
+        double ms = bench::best_of_ms(3, [&] {
+            for (int r = 0; r < 1500 * 200; ++r) field.row(kernel, 0.1f * static_cast<float>(r % 1500), row.data());
+        });
+        std::printf("    %-8s %10.1f ns/row\n", intersect_kernel_name(kernel), ms * 1e6 / (1500.0 * 200.0));
+    }
+    return 0;
+}
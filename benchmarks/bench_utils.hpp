@@ -0,0 +1,91 @@
+#pragma once
+
+#include "include/containers/printer_types.hpp"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+namespace bench {
+
+// Runs `fn` `repeats` times and returns the best wall-clock time in milliseconds.
+template <typename Fn>
+double best_of_ms(int repeats, Fn&& fn) {
+    double best = 0.0;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto stop = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+        if (i == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+inline std::filesystem::path temp_path(const std::string& name) {
+    return std::filesystem::temp_directory_path() / ("printer_bench_" + name);
+}
+
+// Closed torus tessellated into 2 * rings * sides triangles, sitting on z = 0.
+inline std::vector<std::array<vec3_t, 3>> make_torus(std::size_t rings, std::size_t sides,
+                                                     float major_radius = 50.0f, float minor_radius = 15.0f) {
+    const float two_pi = 6.28318530718f;
+    auto point = [&](std::size_t i, std::size_t j) {
+        float u = two_pi * static_cast<float>(i % rings) / static_cast<float>(rings);
+        float v = two_pi * static_cast<float>(j % sides) / static_cast<float>(sides);
+        float r = major_radius + minor_radius * std::cos(v);
+        return vec3_t{
+            major_radius + minor_radius + r * std::cos(u),
+            major_radius + minor_radius + r * std::sin(u),
+            minor_radius + minor_radius * std::sin(v)
+        };
+    };
+
+    std::vector<std::array<vec3_t, 3>> tris;
+    tris.reserve(2 * rings * sides);
+    for (std::size_t i = 0; i < rings; ++i) {
+        for (std::size_t j = 0; j < sides; ++j) {
+            auto a = point(i, j);
+            auto b = point(i + 1, j);
+            auto c = point(i + 1, j + 1);
+            auto d = point(i, j + 1);
+            tris.push_back({a, b, c});
+            tris.push_back({a, c, d});
+        }
+    }
+    return tris;
+}
+
+inline void write_binary_stl(const std::filesystem::path& path, const std::vector<std::array<vec3_t, 3>>& tris) {
+    std::ofstream out(path, std::ios::binary);
+    char header[80] = {0};
+    out.write(header, sizeof(header));
+    auto count = static_cast<uint32_t>(tris.size());
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (const auto& tri : tris) {
+        vec3_t normal = (tri[1] - tri[0]).cross(tri[2] - tri[0]).normalize();
+        float record[12] = {
+            normal.x, normal.y, normal.z,
+            tri[0].x, tri[0].y, tri[0].z,
+            tri[1].x, tri[1].y, tri[1].z,
+            tri[2].x, tri[2].y, tri[2].z
+        };
+        uint16_t attribute_byte_count = 0;
+        out.write(reinterpret_cast<const char*>(record), sizeof(record));
+        out.write(reinterpret_cast<const char*>(&attribute_byte_count), sizeof(attribute_byte_count));
+    }
+}
+
+inline std::size_t arg_or(int argc, char** argv, int idx, std::size_t fallback) {
+    if (argc > idx) return static_cast<std::size_t>(std::stoull(argv[idx]));
+    return fallback;
+}
+
+} // namespace bench
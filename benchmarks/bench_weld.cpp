@@ -0,0 +1,97 @@
+// Vertex welding microbenchmark: the previous hash-only std::unordered_map scheme against
+// VertexWeldTable and the bulk weld used by the mapped readers.
+// usage: bench_weld [torus_rings]   (default 500 -> 1.5M corners)
+
+#include "benchmarks/bench_utils.hpp"
+#include "include/stl_helpers.hpp"
+
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+
+
+namespace {
+
+// the scheme both readers used before VertexWeldTable: keyed by hash only, find + operator[]
+std::size_t legacy_weld(const std::vector<vec3_t>& corners, std::vector<uint32_t>& indices) {
+    std::unordered_map<std::size_t, std::pair<vec3_t, uint32_t>> point_set;
+    boost::hash<vec3_t> point_hasher;
+    std::size_t points = 0;
+    indices.resize(corners.size());
+    for (std::size_t i = 0; i < corners.size(); ++i) {
+        const vec3_t& vertex = corners[i];
+        auto point_hash = point_hasher(vertex);
+        if (point_set.find(point_hash) != point_set.end() && point_set[point_hash].first == vertex) {
+            indices[i] = point_set[point_hash].second;
+        } else {
+            indices[i] = static_cast<uint32_t>(points);
+            point_set[point_hash] = {vertex, static_cast<uint32_t>(points)};
+            points++;
+        }
+    }
+    return points;
+}
+
+std::size_t table_weld(const std::vector<vec3_t>& corners, std::vector<uint32_t>& indices) {
+    VertexWeldTable table(PT_EQUAL_THRESH, corners.size() / 4);
+    uint32_t points = 0;
+    indices.resize(corners.size());
+    for (std::size_t i = 0; i < corners.size(); ++i) {
+        auto [idx, is_new] = table.insert(corners[i], points);
+        points += is_new;
+        indices[i] = idx;
+    }
+    return points;
+}
+
+void run_case(const char* name, const std::vector<vec3_t>& corners) {
+    std::vector<uint32_t> legacy_indices, table_indices, bulk_indices;
+    std::size_t legacy_points = 0, table_points = 0;
+    std::vector<vec3_t> bulk_points;
+
+    double legacy_ms = bench::best_of_ms(3, [&] { legacy_points = legacy_weld(corners, legacy_indices); });
+    double table_ms = bench::best_of_ms(3, [&] { table_points = table_weld(corners, table_indices); });
+    double bulk_ms = bench::best_of_ms(3, [&] { bulk_indices = stl_detail::weld_vertices_bulk(corners, bulk_points); });
+
+    std::printf("%s: %zu corners\n", name, corners.size());
+    std::printf("  unordered_map + boost::hash  %8.1f ms  %8zu points%s\n", legacy_ms, legacy_points,
+                legacy_indices == table_indices ? "" : "  (differs from exact weld)");
+    std::printf("  VertexWeldTable              %8.1f ms  %8zu points  (%.2fx)\n", table_ms, table_points, legacy_ms / table_ms);
+    std::printf("  weld_vertices_bulk           %8.1f ms  %8zu points  (%.2fx)%s\n", bulk_ms, bulk_points.size(),
+                legacy_ms / bulk_ms, bulk_indices == table_indices ? "" : "  MISMATCH");
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    const std::size_t rings = bench::arg_or(argc, argv, 1, 500);
+
+    std::vector<vec3_t> torus;
+    for (const auto& tri : bench::make_torus(rings, rings)) {
+        torus.insert(torus.end(), tri.begin(), tri.end());
+    }
+    run_case("torus mesh corners", torus);
+
+    // collision-heavy: a small alphabet of coordinates in every permutation and sign, so hash
+    // combiners that mix axes weakly pile up in the same buckets
+    std::vector<vec3_t> lattice;
+    const std::size_t side = std::max<std::size_t>(8, static_cast<std::size_t>(std::cbrt(static_cast<double>(torus.size()) / 4.0)));
+    for (std::size_t i = 0; i < side; ++i) {
+        for (std::size_t j = 0; j < side; ++j) {
+            for (std::size_t k = 0; k < side; ++k) {
+                float x = static_cast<float>(i) * 0.25f;
+                float y = static_cast<float>(j) * 0.25f;
+                float z = static_cast<float>(k) * 0.25f;
+                lattice.push_back({x, y, z});
+                lattice.push_back({-y, x, -z});
+            }
+        }
+    }
+    std::mt19937 rng(7);
+    std::vector<vec3_t> collision_heavy = lattice;
+    std::uniform_int_distribution<std::size_t> pick(0, lattice.size() - 1);
+    for (std::size_t i = 0; i < lattice.size(); ++i) collision_heavy.push_back(lattice[pick(rng)]);
+    run_case("collision-heavy lattice", collision_heavy);
+    return 0;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "include/containers/printer_types.hpp"
+
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+
+// Per-layer segment buckets with a memory budget. When the resident buckets outgrow the
+// budget they are appended to an anonymous temp file and released; take_layer() hands back a
+// layer's segments in append order, reading its spilled runs back from disk.
+class LayerSpillBuffer
+{
+public:
+    LayerSpillBuffer(std::size_t num_layers, std::size_t memory_budget_bytes)
+        : _resident(num_layers), _spilled(num_layers), _budget(memory_budget_bytes) {}
+
+    void append(std::size_t layer, const segment_t* segments, std::size_t count)
+    {
+        auto& bucket = _resident.at(layer);
+        const std::size_t old_capacity = bucket.capacity();
+        bucket.insert(bucket.end(), segments, segments + count);
+        _resident_bytes += (bucket.capacity() - old_capacity) * sizeof(segment_t);
+        if (_resident_bytes > _budget) {
+            spill();
+        }
+    }
+
+    // Moves every resident bucket to the spill file and frees its memory.
+    void spill()
+    {
+        if (!_file) {
+            _file.reset(std::tmpfile());
+            if (!_file) throw std::runtime_error("Failed to create slice spill file");
+        }
+        for (std::size_t layer = 0; layer < _resident.size(); ++layer) {
+            auto& bucket = _resident[layer];
+            if (bucket.empty()) continue;
+            if (std::fseek(_file.get(), 0, SEEK_END) != 0) throw std::runtime_error("Failed to seek slice spill file");
+            long offset = std::ftell(_file.get());
+            if (std::fwrite(bucket.data(), sizeof(segment_t), bucket.size(), _file.get()) != bucket.size()) {
+                throw std::runtime_error("Failed to write slice spill file");
+            }
+            _spilled[layer].push_back({offset, bucket.size()});
+            _spilled_bytes += bucket.size() * sizeof(segment_t);
+            std::vector<segment_t>().swap(bucket);
+        }
+        _resident_bytes = 0;
+        _spill_count++;
+    }
+
+    // Returns the layer's segments (spilled runs first, then the resident tail) and drops them.
+    std::vector<segment_t> take_layer(std::size_t layer)
+    {
+        std::vector<segment_t> segments;
+        std::size_t total = _resident.at(layer).size();
+        for (const auto& run : _spilled[layer]) total += run.count;
+        segments.reserve(total);
+
+        for (const auto& run : _spilled[layer]) {
+            std::size_t start = segments.size();
+            segments.resize(start + run.count);
+            if (std::fseek(_file.get(), run.offset, SEEK_SET) != 0 ||
+                std::fread(segments.data() + start, sizeof(segment_t), run.count, _file.get()) != run.count) {
+                throw std::runtime_error("Failed to read slice spill file");
+            }
+        }
+        std::vector<SpillRun>().swap(_spilled[layer]);
+
+        auto& bucket = _resident[layer];
+        segments.insert(segments.end(), bucket.begin(), bucket.end());
+        _resident_bytes -= bucket.capacity() * sizeof(segment_t);
+        std::vector<segment_t>().swap(bucket);
+        return segments;
+    }
+
+    std::size_t layer_count() const { return _resident.size(); }
+    std::size_t resident_bytes() const { return _resident_bytes; }
+    std::size_t spilled_bytes() const { return _spilled_bytes; }
+    std::size_t spill_count() const { return _spill_count; }
+
+private:
+    struct SpillRun {
+        long offset;
+        std::size_t count;
+    };
+
+    struct FileCloser {
+        void operator()(std::FILE* f) const { std::fclose(f); }
+    };
+
+    std::vector<std::vector<segment_t>> _resident;
+    std::vector<std::vector<SpillRun>> _spilled;
+    std::unique_ptr<std::FILE, FileCloser> _file;
+    std::size_t _budget;
+    std::size_t _resident_bytes = 0;
+    std::size_t _spilled_bytes = 0;
+    std::size_t _spill_count = 0;
+};
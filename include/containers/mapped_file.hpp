@@ -0,0 +1,91 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+
+// Read-only, whole-file memory mapping. Owns the mapping and unmaps on destruction.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string& filename)
+    {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open file for mapping: " + filename);
+        }
+
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to stat file for mapping: " + filename);
+        }
+
+        _size = static_cast<std::size_t>(st.st_size);
+        if (_size > 0) {
+            void* addr = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Failed to map file: " + filename);
+            }
+            _data = static_cast<const char*>(addr);
+        }
+        ::close(fd); // mapping stays valid after close
+    }
+
+    ~MappedFile()
+    {
+        unmap();
+    }
+
+    MappedFile(MappedFile&& other) noexcept
+        : _data(std::exchange(other._data, nullptr)), _size(std::exchange(other._size, 0)) {}
+
+    MappedFile& operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other) {
+            unmap();
+            _data = std::exchange(other._data, nullptr);
+            _size = std::exchange(other._size, 0);
+        }
+        return *this;
+    }
+
+    // delete copy and copy assignment constructors
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // hint the kernel about the upcoming access pattern (MADV_SEQUENTIAL, MADV_WILLNEED, ...)
+    void advise(int advice) const
+    {
+        if (_data != nullptr) {
+            ::madvise(const_cast<char*>(_data), _size, advice);
+        }
+    }
+
+    const char* data() const { return _data; }
+    std::size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+private:
+    void unmap()
+    {
+        if (_data != nullptr) {
+            ::munmap(const_cast<char*>(_data), _size);
+            _data = nullptr;
+            _size = 0;
+        }
+    }
+
+    const char* _data = nullptr;
+    std::size_t _size = 0;
+};
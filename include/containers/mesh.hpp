@@ -15,8 +15,23 @@ public:
     // Planar, cartesian
     std::vector<vec3_t> points;
     std::vector<triangle_t> triangles; // sorted by layer max z-vals
+    // bounds of `points`: filled by the STL readers, kept current by translate(); anything
+    // else that moves points calls update_bounds()
+    bbox_t bounds;
+
+    void update_bounds();
+    void translate(const vec3_t& offset);
 
     std::vector<segment_t> intersect_triangle_with_plane(const triangle_t& tri, float z_plane) const;
-    void populate_layer_lists(int layer_height_mm);
+    void populate_layer_lists(float layer_height_mm);  // planes within bounds only
 
 };
+
+// Same intersection as Mesh::intersect_triangle_with_plane, on corners given directly.
+std::vector<segment_t> intersect_triangle_with_plane(const vec3_t& v0, const vec3_t& v1, const vec3_t& v2, float z_plane);
+
+// A triangle cut by a plane yields at most three segments (all edges coplanar).
+constexpr std::size_t kMaxTriangleSegments = 3;
+
+// Allocation-free form: writes up to kMaxTriangleSegments segments to `out`, returns the count.
+std::size_t intersect_triangle_into(const vec3_t& v0, const vec3_t& v1, const vec3_t& v2, float z_plane, segment_t* out);
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "include/containers/mesh.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+
+// Structure-of-arrays copy of a Mesh for slicing passes. Each triangle corner's x, y and z
+// live in their own arrays, every triangle's z-range is precomputed, and triangles are ordered
+// by z_min (ties keep mesh order). Range checks and the sweep's entry scan therefore read
+// contiguous floats front to back, instead of gathering three points per 40-byte triangle_t.
+// source_triangle maps back to the index in Mesh::triangles; the slicer uses it to keep the
+// mesh's segment order.
+class MeshSoA
+{
+public:
+    MeshSoA() = default;
+
+    explicit MeshSoA(const Mesh& mesh)
+    {
+        const std::size_t count = mesh.triangles.size();
+        std::vector<float> unsorted_min(count), unsorted_max(count);
+        for (std::size_t t = 0; t < count; ++t) {
+            const auto& v = mesh.triangles[t].vertices;
+            float z0 = mesh.points[v[0]].z;
+            float z1 = mesh.points[v[1]].z;
+            float z2 = mesh.points[v[2]].z;
+            unsorted_min[t] = std::min({z0, z1, z2});
+            unsorted_max[t] = std::max({z0, z1, z2});
+        }
+
+        source_triangle.resize(count);
+        std::iota(source_triangle.begin(), source_triangle.end(), uint32_t{0});
+        std::stable_sort(source_triangle.begin(), source_triangle.end(),
+                         [&](uint32_t a, uint32_t b) { return unsorted_min[a] < unsorted_min[b]; });
+
+        for (int k = 0; k < 3; ++k) {
+            x[k].resize(count);
+            y[k].resize(count);
+            z[k].resize(count);
+        }
+        z_min.resize(count);
+        z_max.resize(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            const uint32_t t = source_triangle[i];
+            for (int k = 0; k < 3; ++k) {
+                const vec3_t& p = mesh.points[mesh.triangles[t].vertices[k]];
+                x[k][i] = p.x;
+                y[k][i] = p.y;
+                z[k][i] = p.z;
+            }
+            z_min[i] = unsorted_min[t];
+            z_max[i] = unsorted_max[t];
+        }
+    }
+
+    std::size_t triangle_count() const { return z_min.size(); }
+
+    // corner k (0..2) of the i-th triangle in z_min order
+    vec3_t corner(std::size_t i, int k) const { return {x[k][i], y[k][i], z[k][i]}; }
+
+    std::array<std::vector<float>, 3> x, y, z; // [corner][triangle], z_min order
+    std::vector<float> z_min, z_max;           // per triangle, z_min order
+    std::vector<uint32_t> source_triangle;     // index into Mesh::triangles
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "include/containers/printer_types.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+
+enum class PathRole : uint8_t {
+    OuterWall,  // an island's sliced outline: its outer boundary or a hole
+    InnerWall,  // an inset of the outline
+    Infill,
+    OpenChain,  // cut edges that did not close into a contour; not meant to be printed
+};
+
+inline bool is_wall(PathRole role) { return role == PathRole::OuterWall || role == PathRole::InnerWall; }
+
+struct PathRange {
+    std::size_t first = 0;
+    std::size_t last = 0;  // one past the final path
+};
+
+
+// One layer's toolpaths as connected polylines. Every path's x/y vertices sit back to back in
+// one array, path p owning [offsets[p], offsets[p + 1]), and z belongs to whoever holds the set.
+// A path of k vertices is k - 1 segments; closed paths repeat their first vertex at the end.
+// Each segment costs one vertex rather than two full points, so connected walls take about a
+// third of the memory of segment_t pairs, and the connections survive for motion planning.
+class PathSet
+{
+public:
+    struct Path {
+        PathRole role;
+        std::span<const vec2_t> points;
+
+        std::size_t segment_count() const { return points.empty() ? 0 : points.size() - 1; }
+        bool closed() const { return points.size() > 2 && points.front() == points.back(); }
+    };
+
+    // The loop's segments as polygon_to_segments makes them: closed whether or not the loop
+    // repeats its first point.
+    void add_loop(const polygon_t& loop, PathRole role)
+    {
+        if (loop.size() < 2) return;
+        const bool closed = loop.front() == loop.back();
+        const std::size_t limit = closed ? loop.size() - 1 : loop.size();
+        start_path(role);
+        for (std::size_t i = 0; i < limit; ++i) _points.push_back({loop[i].x, loop[i].y});
+        _points.push_back({loop[0].x, loop[0].y});
+        end_path();
+    }
+
+    void add_polyline(std::span<const vec2_t> points, PathRole role)
+    {
+        if (points.size() < 2) return;
+        start_path(role);
+        _points.insert(_points.end(), points.begin(), points.end());
+        end_path();
+    }
+
+    // Continues the last path when the segment starts exactly where it ends with the same role,
+    // and starts a new one otherwise, so segments(...) gives back exactly what went in.
+    void append_segment(const segment_t& seg, PathRole role)
+    {
+        const vec2_t a{seg.first.x, seg.first.y}, b{seg.second.x, seg.second.y};
+        if (_roles.empty() || _roles.back() != role || !(_points.back() == a)) {
+            start_path(role);
+            _points.push_back(a);
+        }
+        _points.push_back(b);
+        end_path();
+    }
+
+    void append_segments(std::span<const segment_t> segments, PathRole role)
+    {
+        for (const auto& seg : segments) append_segment(seg, role);
+    }
+
+    void clear()
+    {
+        _points.clear();
+        _offsets.assign(1, 0);
+        _roles.clear();
+    }
+
+    // Drops the slack growth left behind, for sets that are done being built.
+    void shrink_to_fit()
+    {
+        _points.shrink_to_fit();
+        _offsets.shrink_to_fit();
+        _roles.shrink_to_fit();
+    }
+
+    bool empty() const { return _roles.empty(); }
+    std::size_t path_count() const { return _roles.size(); }
+    std::size_t vertex_count() const { return _points.size(); }
+    std::size_t segment_count(PathRange range) const
+    {
+        return (_offsets[range.last] - _offsets[range.first]) - (range.last - range.first);
+    }
+    std::size_t segment_count() const { return segment_count({0, path_count()}); }
+
+    Path path(std::size_t idx) const
+    {
+        if (idx >= path_count()) throw std::out_of_range("PathSet path index out of range");
+        return {_roles[idx], std::span<const vec2_t>(_points).subspan(_offsets[idx], _offsets[idx + 1] - _offsets[idx])};
+    }
+
+    std::span<const vec2_t> points() const { return _points; }
+    std::span<const uint32_t> offsets() const { return _offsets; }
+    std::span<const PathRole> roles() const { return _roles; }
+
+    // The first run of consecutive paths whose role passes `pred`; empty (at the end) if none.
+    template <typename Pred>
+    PathRange find_run(Pred&& pred) const
+    {
+        std::size_t first = 0;
+        while (first < _roles.size() && !pred(_roles[first])) ++first;
+        std::size_t last = first;
+        while (last < _roles.size() && pred(_roles[last])) ++last;
+        return {first, last};
+    }
+
+    std::vector<segment_t> segments(float z, PathRange range) const
+    {
+        std::vector<segment_t> out;
+        out.reserve(segment_count(range));
+        for (std::size_t p = range.first; p < range.last; ++p) {
+            for (uint32_t v = _offsets[p]; v + 1 < _offsets[p + 1]; ++v) {
+                out.push_back({{_points[v].x, _points[v].y, z}, {_points[v + 1].x, _points[v + 1].y, z}});
+            }
+        }
+        return out;
+    }
+    std::vector<segment_t> segments(float z) const { return segments(z, {0, path_count()}); }
+
+    std::size_t memory_bytes() const
+    {
+        return _points.capacity() * sizeof(vec2_t) + _offsets.capacity() * sizeof(uint32_t) +
+               _roles.capacity() * sizeof(PathRole);
+    }
+
+    bool operator==(const PathSet& other) const = default;
+
+private:
+    void start_path(PathRole role)
+    {
+        _roles.push_back(role);
+        _offsets.push_back(_offsets.back());
+    }
+
+    void end_path()
+    {
+        if (_points.size() > std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("Too many path vertices in one layer");
+        }
+        _offsets.back() = static_cast<uint32_t>(_points.size());
+    }
+
+    std::vector<vec2_t> _points;
+    std::vector<uint32_t> _offsets{0};
+    std::vector<PathRole> _roles;
+};
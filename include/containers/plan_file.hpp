@@ -0,0 +1,322 @@
+#pragma once
+
+#include "include/containers/mapped_file.hpp"
+#include "include/containers/path_set.hpp"
+#include "include/containers/printer_types.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+// On-disk slice plan. Little-endian, laid out as
+//
+//   PlanFileHeader                      magic, version, quantization, layer table location
+//   QuantizedSegment[]                  every layer's contours, then infill, then open chains
+//   PlanLayerEntry[layer_count]         z, thickness, the three segment counts and where they start
+//
+// Segments keep only x/y, as int32 multiples of 1 / units_per_mm mm; z is stored once per
+// layer. The table sits at the end so layers can be written as they are produced. Opening a
+// file maps it and checks the header and table only; segment pages are faulted in when a
+// layer is read.
+
+constexpr char kPlanFileMagic[8] = {'P', 'R', 'N', 'T', 'P', 'L', 'A', 'N'};
+constexpr uint32_t kPlanFileVersion = 2;  // 2 adds the layer thickness
+constexpr double kPlanUnitsPerMm = 1e3;  // 1 um; int32 then covers +-2 km
+
+struct PlanFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_bytes;
+    double units_per_mm;
+    uint64_t layer_count;
+    uint64_t table_offset;
+    uint64_t file_bytes;
+};
+
+struct PlanLayerEntry {
+    float z;
+    float thickness;  // mm the layer is extruded for
+    uint32_t contour_count;
+    uint32_t infill_count;
+    uint32_t open_chain_count;
+    uint32_t reserved;  // zero
+    uint64_t segment_offset;
+};
+
+struct QuantizedSegment {
+    int32_t x0, y0, x1, y1;
+};
+
+static_assert(sizeof(PlanFileHeader) == 48 && sizeof(PlanLayerEntry) == 32 && sizeof(QuantizedSegment) == 16,
+              "plan file records must match the on-disk layout");
+
+
+// Read-only, random-access view of a layer's segments: a span of segment_t in memory, a run of
+// paths in a PathSet, or a run of quantized records in a mapped plan file, dequantized on access.
+// Copying a view never copies segments; it is valid as long as the storage it points into.
+class SegmentView
+{
+public:
+    class iterator
+    {
+    public:
+        using value_type = segment_t;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        iterator(const SegmentView* view, std::size_t idx) : _view(view), _idx(idx) {}
+
+        segment_t operator*() const { return (*_view)[_idx]; }
+        iterator& operator++() { ++_idx; return *this; }
+        iterator operator++(int) { iterator old = *this; ++_idx; return old; }
+        bool operator==(const iterator& other) const { return _idx == other._idx; }
+
+    private:
+        const SegmentView* _view = nullptr;
+        std::size_t _idx = 0;
+    };
+
+    SegmentView() = default;
+    SegmentView(std::span<const segment_t> segments) : _segments(segments.data()), _size(segments.size()) {}
+    SegmentView(const std::vector<segment_t>& segments) : SegmentView(std::span<const segment_t>(segments)) {}
+    SegmentView(const PathSet& paths, PathRange range, float z)
+        : _paths(&paths), _range(range), _size(paths.segment_count(range)), _z(z) {}
+    SegmentView(const char* packed, std::size_t count, float z, double mm_per_unit)
+        : _packed(packed), _size(count), _z(z), _mm_per_unit(mm_per_unit) {}
+
+    segment_t operator[](std::size_t idx) const
+    {
+        if (_segments != nullptr) return _segments[idx];
+        if (_paths != nullptr) return path_segment(idx);
+        QuantizedSegment q;
+        std::memcpy(&q, _packed + idx * sizeof(QuantizedSegment), sizeof(q));
+        return {{dequantize(q.x0), dequantize(q.y0), _z}, {dequantize(q.x1), dequantize(q.y1), _z}};
+    }
+
+    segment_t at(std::size_t idx) const
+    {
+        if (idx >= _size) throw std::out_of_range("SegmentView index out of range");
+        return (*this)[idx];
+    }
+
+    std::size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    bool is_mapped() const { return _packed != nullptr; }
+    iterator begin() const { return {this, 0}; }
+    iterator end() const { return {this, _size}; }
+
+    std::vector<segment_t> to_vector() const
+    {
+        if (_segments != nullptr) return {_segments, _segments + _size};
+        if (_paths != nullptr) return _paths->segments(_z, _range);
+        std::vector<segment_t> out;
+        out.reserve(_size);
+        for (std::size_t i = 0; i < _size; ++i) out.push_back((*this)[i]);
+        return out;
+    }
+
+private:
+    float dequantize(int32_t v) const { return static_cast<float>(static_cast<double>(v) * _mm_per_unit); }
+
+    // Path p starts at segment offsets[p] - p of the set, so the path holding a segment is the
+    // last one in the range starting at or before it.
+    segment_t path_segment(std::size_t idx) const
+    {
+        const auto offsets = _paths->offsets();
+        const std::size_t target = offsets[_range.first] - _range.first + idx;
+        std::size_t lo = _range.first, hi = _range.last;
+        while (hi - lo > 1) {
+            const std::size_t mid = lo + (hi - lo) / 2;
+            if (offsets[mid] - mid <= target) lo = mid;
+            else hi = mid;
+        }
+        const std::size_t v = offsets[lo] + (target - (offsets[lo] - lo));
+        const auto points = _paths->points();
+        return {{points[v].x, points[v].y, _z}, {points[v + 1].x, points[v + 1].y, _z}};
+    }
+
+    const segment_t* _segments = nullptr;
+    const PathSet* _paths = nullptr;
+    PathRange _range;
+    const char* _packed = nullptr;
+    std::size_t _size = 0;
+    float _z = 0.0f;
+    double _mm_per_unit = 0.0;
+};
+
+struct LayerView {
+    float z = 0.0f;
+    float thickness = 0.0f;
+    SegmentView contours;
+    SegmentView infill;
+    SegmentView open_chains;
+    const PathSet* paths = nullptr;  // the connected paths behind the views, when in memory
+};
+
+
+// Streams layers into a plan file. Segments go out as each layer is added; finish() appends
+// the layer table and patches the header. A writer destroyed before finish() leaves a file
+// that PlanFile rejects.
+class PlanFileWriter
+{
+public:
+    explicit PlanFileWriter(const std::filesystem::path& path, double units_per_mm = kPlanUnitsPerMm)
+        : _out(path, std::ios::binary | std::ios::trunc), _units_per_mm(units_per_mm)
+    {
+        if (!_out) throw std::runtime_error("Failed to open plan file for writing: " + path.string());
+        if (!(units_per_mm > 0.0) || !std::isfinite(units_per_mm)) {
+            throw std::runtime_error("Plan file quantization must be positive");
+        }
+        PlanFileHeader blank{};
+        write_raw(&blank, sizeof(blank));
+        _offset = sizeof(blank);
+    }
+
+    void add_layer(float z, float thickness, std::span<const segment_t> contours, std::span<const segment_t> infill,
+                   std::span<const segment_t> open_chains)
+    {
+        if (!(thickness > 0.0f) || !std::isfinite(thickness)) throw std::runtime_error("Plan layer thickness must be positive");
+        PlanLayerEntry entry{z, thickness, count_of(contours), count_of(infill), count_of(open_chains), 0, _offset};
+        for (auto segments : {contours, infill, open_chains}) {
+            _packed.clear();
+            _packed.reserve(segments.size());
+            for (const auto& seg : segments) {
+                _packed.push_back({quantize(seg.first.x), quantize(seg.first.y),
+                                   quantize(seg.second.x), quantize(seg.second.y)});
+            }
+            write_raw(_packed.data(), _packed.size() * sizeof(QuantizedSegment));
+            _offset += _packed.size() * sizeof(QuantizedSegment);
+        }
+        _table.push_back(entry);
+    }
+
+    void finish()
+    {
+        PlanFileHeader header{};
+        std::memcpy(header.magic, kPlanFileMagic, sizeof(header.magic));
+        header.version = kPlanFileVersion;
+        header.header_bytes = sizeof(PlanFileHeader);
+        header.units_per_mm = _units_per_mm;
+        header.layer_count = _table.size();
+        header.table_offset = _offset;
+        header.file_bytes = _offset + _table.size() * sizeof(PlanLayerEntry);
+
+        write_raw(_table.data(), _table.size() * sizeof(PlanLayerEntry));
+        _out.seekp(0);
+        write_raw(&header, sizeof(header));
+        _out.close();
+        if (!_out) throw std::runtime_error("Failed to finish plan file");
+    }
+
+private:
+    void write_raw(const void* data, std::size_t bytes)
+    {
+        _out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        if (!_out) throw std::runtime_error("Failed to write plan file");
+    }
+
+    int32_t quantize(float v) const
+    {
+        double scaled = std::round(static_cast<double>(v) * _units_per_mm);
+        if (!(scaled >= std::numeric_limits<int32_t>::min() && scaled <= std::numeric_limits<int32_t>::max())) {
+            throw std::runtime_error("Plan coordinate out of range for plan file quantization");
+        }
+        return static_cast<int32_t>(scaled);
+    }
+
+    static uint32_t count_of(std::span<const segment_t> segments)
+    {
+        if (segments.size() > std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("Too many segments in one plan layer");
+        }
+        return static_cast<uint32_t>(segments.size());
+    }
+
+    std::ofstream _out;
+    double _units_per_mm;
+    uint64_t _offset = 0;
+    std::vector<PlanLayerEntry> _table;
+    std::vector<QuantizedSegment> _packed;
+};
+
+
+// A mapped plan file. Construction validates the header and every table entry against the
+// file size, so layer() can hand out views without further checks.
+class PlanFile
+{
+public:
+    explicit PlanFile(const std::string& filename) : _file(filename)
+    {
+        if (_file.size() < sizeof(PlanFileHeader)) throw std::runtime_error("Plan file too small: " + filename);
+        PlanFileHeader header;
+        std::memcpy(&header, _file.data(), sizeof(header));
+        if (std::memcmp(header.magic, kPlanFileMagic, sizeof(header.magic)) != 0) {
+            throw std::runtime_error("Not a plan file: " + filename);
+        }
+        if (header.version != kPlanFileVersion) {
+            throw std::runtime_error("Unsupported plan file version " + std::to_string(header.version) + ": " + filename);
+        }
+        if (header.header_bytes != sizeof(PlanFileHeader) || header.file_bytes != _file.size() ||
+            header.table_offset < sizeof(PlanFileHeader) || header.table_offset > _file.size() ||
+            (_file.size() - header.table_offset) / sizeof(PlanLayerEntry) != header.layer_count ||
+            (_file.size() - header.table_offset) % sizeof(PlanLayerEntry) != 0 ||
+            !(header.units_per_mm > 0.0) || !std::isfinite(header.units_per_mm)) {
+            throw std::runtime_error("Corrupt plan file header: " + filename);
+        }
+
+        _layer_count = static_cast<std::size_t>(header.layer_count);
+        _table = _file.data() + header.table_offset;
+        _mm_per_unit = 1.0 / header.units_per_mm;
+        for (std::size_t l = 0; l < _layer_count; ++l) {
+            PlanLayerEntry entry = entry_at(l);
+            uint64_t count = uint64_t{entry.contour_count} + entry.infill_count + entry.open_chain_count;
+            if (!(entry.thickness > 0.0f) || !std::isfinite(entry.thickness) ||
+                entry.segment_offset < sizeof(PlanFileHeader) || entry.segment_offset > header.table_offset ||
+                count > (header.table_offset - entry.segment_offset) / sizeof(QuantizedSegment)) {
+                throw std::runtime_error("Corrupt plan file layer table: " + filename);
+            }
+        }
+        // layers are usually read one at a time, out of order
+        _file.advise(MADV_RANDOM);
+    }
+
+    std::size_t layer_count() const { return _layer_count; }
+    double units_per_mm() const { return 1.0 / _mm_per_unit; }
+
+    LayerView layer(std::size_t idx) const
+    {
+        if (idx >= _layer_count) throw std::out_of_range("Plan file layer index out of range");
+        PlanLayerEntry entry = entry_at(idx);
+        const char* contours = _file.data() + entry.segment_offset;
+        const char* infill = contours + std::size_t{entry.contour_count} * sizeof(QuantizedSegment);
+        const char* open_chains = infill + std::size_t{entry.infill_count} * sizeof(QuantizedSegment);
+        return {
+            entry.z,
+            entry.thickness,
+            SegmentView(contours, entry.contour_count, entry.z, _mm_per_unit),
+            SegmentView(infill, entry.infill_count, entry.z, _mm_per_unit),
+            SegmentView(open_chains, entry.open_chain_count, entry.z, _mm_per_unit),
+        };
+    }
+
+private:
+    PlanLayerEntry entry_at(std::size_t idx) const
+    {
+        PlanLayerEntry entry;
+        std::memcpy(&entry, _table + idx * sizeof(PlanLayerEntry), sizeof(entry));
+        return entry;
+    }
+
+    MappedFile _file;
+    const char* _table = nullptr;
+    std::size_t _layer_count = 0;
+    double _mm_per_unit = 1.0;
+};
@@ -4,7 +4,9 @@
 
 #include <vector>
 #include <iostream>
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <utility>
 
 
@@ -97,6 +99,14 @@ struct vec3_t {
 };
 
 
+// Point in a layer's plane, for paths that store their z once per layer; compared exactly
+
+struct vec2_t {
+    float x, y;
+
+    bool operator==(const vec2_t& other) const { return x == other.x && y == other.y; }
+};
+
 
 // Triangle
 
@@ -123,5 +133,25 @@ struct triangle_t {
     }
 };
 
+// Axis-aligned box; empty until a point is added
+
+struct bbox_t {
+    vec3_t min{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()};
+    vec3_t max{std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()};
+
+    bool empty() const { return min.x > max.x; }
+
+    void expand(const vec3_t& p) {
+        min = {std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z)};
+        max = {std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z)};
+    }
+
+    void expand(const bbox_t& other) {
+        if (other.empty()) return;
+        expand(other.min);
+        expand(other.max);
+    }
+};
+
 using segment_t = std::pair<vec3_t, vec3_t>;
 using polygon_t = std::vector<vec3_t>;
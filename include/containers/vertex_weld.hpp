@@ -0,0 +1,138 @@
+#pragma once
+
+#include "include/containers/printer_types.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+
+// Vertex position snapped to a grid of `tolerance` sized cells. Two vertices weld when they
+// land in the same cell, so the key is exact and comparisons never depend on hash quality.
+struct QuantizedVertex {
+    int64_t x, y, z;
+
+    bool operator==(const QuantizedVertex& other) const {
+        return x == other.x && y == other.y && z == other.z;
+    }
+};
+
+// Snaps one coordinate. -0 and +0 share a cell; values too large for the grid (or inf/nan)
+// fall back to their bit pattern pushed outside the range a finite cell index can reach.
+inline int64_t quantize_coordinate(float v, double inv_tolerance) {
+    double scaled = static_cast<double>(v) * inv_tolerance;
+    if (std::abs(scaled) < 4.0e18) {
+        // std::llround semantics (half away from zero) without the libm call
+        auto rounded = static_cast<int64_t>(scaled);
+        double frac = scaled - static_cast<double>(rounded);
+        rounded += (frac >= 0.5) - (frac <= -0.5);
+        return rounded;
+    }
+    uint32_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return std::numeric_limits<int64_t>::min() + static_cast<int64_t>(bits);
+}
+
+inline QuantizedVertex quantize_vertex(const vec3_t& p, double inv_tolerance) {
+    return {
+        quantize_coordinate(p.x, inv_tolerance),
+        quantize_coordinate(p.y, inv_tolerance),
+        quantize_coordinate(p.z, inv_tolerance)
+    };
+}
+
+inline uint64_t hash_quantized_vertex(const QuantizedVertex& q) {
+    // splitmix64-style finalizer over a multiply-xor combine; grid neighbours spread out
+    uint64_t h = static_cast<uint64_t>(q.x) * 0x9E3779B97F4A7C15ULL;
+    h ^= static_cast<uint64_t>(q.y) * 0xC2B2AE3D27D4EB4FULL + (h >> 32);
+    h ^= static_cast<uint64_t>(q.z) * 0x165667B19E3779F9ULL + (h >> 29);
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBULL;
+    return h ^ (h >> 31);
+}
+
+
+// Open-addressing (linear probing) table from quantized vertex to point index. insert() is a
+// single probe sequence that either finds the welded point or claims an empty slot.
+class VertexWeldTable
+{
+public:
+    explicit VertexWeldTable(double tolerance = PT_EQUAL_THRESH, std::size_t expected_vertices = 0)
+        : _inv_tolerance(1.0 / tolerance), _tolerance(tolerance)
+    {
+        reserve(expected_vertices);
+    }
+
+    // Returns {index of the welded point, true if `p` was new and got `new_index`}.
+    std::pair<uint32_t, bool> insert(const vec3_t& p, uint32_t new_index)
+    {
+        if ((_size + 1) * 2 > _slots.size()) {
+            rehash(std::max<std::size_t>(16, _slots.size() * 2));
+        }
+
+        const QuantizedVertex key = quantize_vertex(p, _inv_tolerance);
+        std::size_t slot = static_cast<std::size_t>(hash_quantized_vertex(key)) & _mask;
+        while (true) {
+            Slot& s = _slots[slot];
+            if (s.index == kEmpty) {
+                s.key = key;
+                s.index = new_index;
+                _size++;
+                return {new_index, true};
+            }
+            if (s.key == key) {
+                return {s.index, false};
+            }
+            slot = (slot + 1) & _mask;
+        }
+    }
+
+    void reserve(std::size_t expected_vertices)
+    {
+        std::size_t wanted = 16;
+        while (wanted < expected_vertices * 2) wanted <<= 1;
+        if (wanted > _slots.size()) rehash(wanted);
+    }
+
+    void clear()
+    {
+        for (auto& s : _slots) s.index = kEmpty;
+        _size = 0;
+    }
+
+    std::size_t size() const { return _size; }
+    double tolerance() const { return _tolerance; }
+
+private:
+    static constexpr uint32_t kEmpty = std::numeric_limits<uint32_t>::max();
+
+    struct Slot {
+        QuantizedVertex key;
+        uint32_t index = kEmpty;
+    };
+
+    void rehash(std::size_t new_capacity)
+    {
+        std::vector<Slot> old;
+        old.swap(_slots);
+        _slots.assign(new_capacity, Slot{});
+        _mask = new_capacity - 1;
+        for (const auto& s : old) {
+            if (s.index == kEmpty) continue;
+            std::size_t slot = static_cast<std::size_t>(hash_quantized_vertex(s.key)) & _mask;
+            while (_slots[slot].index != kEmpty) slot = (slot + 1) & _mask;
+            _slots[slot] = s;
+        }
+    }
+
+    std::vector<Slot> _slots;
+    std::size_t _mask = 0;
+    std::size_t _size = 0;
+    double _inv_tolerance;
+    double _tolerance;
+};
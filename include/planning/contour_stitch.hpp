@@ -0,0 +1,21 @@
+#pragma once
+
+#include "include/containers/printer_types.hpp"
+
+#include <span>
+#include <vector>
+
+
+struct StitchResult {
+    std::vector<polygon_t> loops;        // closed: front() == back(), at least 4 points
+    std::vector<polygon_t> open_chains;  // walks that dead-ended, end to end, not closed
+};
+
+// Joins a layer's cut segments into contours. Endpoints within `eps` of each other (in xy)
+// become one node: each endpoint is snapped to an eps grid, looked up in a flat open-addressing
+// table, and merged with the earliest node within eps in its own or a neighbouring cell.
+// Zero-length and repeated edges are dropped. Edges are walked from an unused start edge in
+// input order, always taking the first unused edge at each node that does not lead straight
+// back; walks that return to their start are loops, the rest are extended backwards from the
+// start and reported as open chains. Runs in time linear in the segment count.
+StitchResult stitch_contours(std::span<const segment_t> segments, float eps);
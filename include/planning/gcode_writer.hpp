@@ -0,0 +1,111 @@
+#pragma once
+
+#include "include/containers/path_set.hpp"
+#include "include/containers/plan_file.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+
+// Streams a plan out as G-code: absolute XY in mm (G90, G21) and absolute E (M82), reset to 0
+// with G92 at each layer. Moves are formatted with std::to_chars into a fixed buffer that is
+// written out whenever it fills, so only the buffer and the current move are ever held.
+
+struct GcodeOptions {
+    float line_width = 0.45f;         // mm
+    float filament_diameter = 1.75f;  // mm
+    float extrusion_multiplier = 1.0f;
+    float print_speed = 40.0f;        // mm/s
+    float travel_speed = 150.0f;
+    float retract_length = 0.8f;      // mm of filament; 0 turns retraction off
+    float retract_speed = 35.0f;
+    float retract_min_travel = 1.5f;  // shorter travels do not retract
+    // Extrusions continuing within this many mm of the line their run started along are merged
+    // into one move; 0 merges only exactly collinear ones.
+    float merge_tolerance = 0.005f;
+    std::string start_gcode;  // written verbatim after the setup lines
+    std::string end_gcode;    // written verbatim by finish()
+};
+
+struct GcodeStats {
+    std::size_t layers = 0;
+    std::size_t lines = 0;
+    std::size_t bytes = 0;
+    std::size_t extrusions = 0;  // G1 moves written, after merging
+    std::size_t merged = 0;      // extrusions folded into the move before them
+    std::size_t travels = 0;
+    std::size_t retractions = 0;
+    double extruded_mm = 0.0;    // path length printed
+    double travel_mm = 0.0;
+    double filament_mm = 0.0;    // E fed, retractions not counted
+};
+
+// Throws std::runtime_error unless widths and speeds are positive and retraction and merge
+// tolerance are not negative.
+void check_gcode_options(const GcodeOptions& options);
+
+// Filament fed per mm of path for a bead of `line_width` on a layer of `height`: Slic3r's
+// rounded rectangle, (width - height) * height plus a height-wide circle, over the filament's
+// cross-section.
+double extrusion_per_mm(const GcodeOptions& options, float height);
+
+class GcodeWriter
+{
+public:
+    static constexpr std::size_t kBufferBytes = std::size_t{1} << 20;
+
+    // Creates (or truncates) `path`; the file is closed by finish() or the destructor.
+    explicit GcodeWriter(const std::filesystem::path& path, const GcodeOptions& options = {});
+    // Writes to an already open descriptor, which is left open.
+    explicit GcodeWriter(int fd, const GcodeOptions& options = {});
+    // Output not yet flushed by finish() is dropped, so an unfinished program stays visibly cut.
+    ~GcodeWriter();
+    GcodeWriter(const GcodeWriter&) = delete;
+    GcodeWriter& operator=(const GcodeWriter&) = delete;
+
+    // A layer's walls and then its infill, in the order the paths are stored; open chains are
+    // not printed. `height` is the layer's thickness, which sets how much each mm extrudes.
+    void add_layer(float z, float height, const PathSet& paths);
+    // The same for segment views, as from a mapped plan file: a segment that starts exactly
+    // where the previous one ended continues the path, any other starts after a travel.
+    void add_layer(float z, float height, const SegmentView& walls, const SegmentView& infill);
+
+    // Writes the pending move and end_gcode, flushes, and closes a file the writer opened.
+    void finish();
+    const GcodeStats& stats() const { return _stats; }
+
+private:
+    void begin_layer(float z, float height);
+    void travel_to(float x, float y);
+    void extrude_to(float x, float y);
+    void flush_extrusion();
+
+    void put(const char* text, std::size_t length);
+    void put(const std::string& text) { put(text.data(), text.size()); }
+    void put_feed(float mm_per_s);
+    void put_value(char axis, double value, int decimals);
+    void end_line();
+    void flush_buffer();
+
+    GcodeOptions _options;
+    int _fd = -1;
+    bool _owns_fd = false;
+    bool _finished = false;
+    std::unique_ptr<char[]> _buffer;
+    std::size_t _used = 0;
+    GcodeStats _stats;
+
+    float _z = 0.0f;
+    bool _z_pending = false;  // the layer's z is written with its first travel
+    double _e = 0.0;  // absolute E within the layer
+    double _e_per_mm = 0.0;
+    float _feed = -1.0f;
+    bool _has_position = false;
+    float _x = 0.0f, _y = 0.0f;  // where the last move, pending or written, ends
+    // the extrusion not yet written: where its run started and the direction it started in
+    bool _pending = false;
+    float _run_x = 0.0f, _run_y = 0.0f;
+    double _dir_x = 0.0, _dir_y = 0.0;
+};
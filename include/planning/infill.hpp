@@ -0,0 +1,96 @@
+#pragma once
+
+#include "include/containers/printer_types.hpp"
+#include "include/planning/scanline.hpp"
+
+#include <cstddef>
+#include <vector>
+
+
+// Infill lines for one island: scanlines along x every `spacing` mm from the outer loop's
+// lowest y, clipped to the outer loop minus its holes. One edge table serves the whole island,
+// so the cost grows with lines + edges rather than lines x edges.
+std::vector<segment_t> clip_infill(const polygon_t& outer, const std::vector<polygon_t>& holes, float spacing, float z);
+
+// Where a family of lines starts across its direction.
+enum class LineAnchor {
+    Island,   // at the island's lowest point in the rotated frame, like clip_infill
+    Lattice,  // at multiples of the spacing, shared by every island and layer
+};
+
+// The same clipping for lines at `angle_deg` from +x: the loops are rotated into a frame where
+// the lines run along x, scanned by the same edge table, and the spans rotated back, so any
+// angle costs one pass over the vertices more than an axis-aligned fill. An angle of 0 with
+// LineAnchor::Island is clip_infill.
+std::vector<segment_t> clip_infill(const polygon_t& outer, const std::vector<polygon_t>& holes, float spacing,
+                                   float angle_deg, LineAnchor anchor, float z);
+
+enum class InfillPattern {
+    Rectilinear,  // one direction on every layer
+    Crosshatch,   // one direction, turned 90 degrees on every other layer
+    Grid,         // two directions 90 degrees apart on every layer
+    Triangles,    // three directions 60 degrees apart on every layer
+    // layer curves of a triply periodic surface (see tpms.hpp); angle_deg is unused
+    Gyroid,
+    SchwarzP,
+    SchwarzD,
+    Honeycomb,    // regular hexagons, the same on every layer (see HoneycombLattice)
+};
+
+struct InfillOptions {
+    InfillPattern pattern = InfillPattern::Rectilinear;
+    float angle_deg = 0.0f;  // direction of the first family of lines, from +x
+
+    bool operator==(const InfillOptions&) const = default;
+};
+
+// Directions the pattern lays on the layer cut by `plane` (see LayerSchedule::plane); none for
+// the surface patterns.
+std::vector<float> infill_angles(const InfillOptions& options, std::size_t plane);
+
+// Regular hexagons with side 2 * spacing / sqrt(3), which put down the length per area of
+// straight lines `spacing` apart. Every hexagon edge lies on one of three families of lines
+// `spacing` apart, 60 degrees from each other, and covers a third of its line as dashes that
+// alternate between two rows along the line. The dash rows and line ranges are laid out once
+// over a footprint; clip() scans an island along each family with the infill edge table and
+// keeps the parts of the dashes inside its spans, so a print generates the lattice once and
+// each layer only pays for its own edges and lines.
+class HoneycombLattice
+{
+public:
+    // `angle_deg` turns the whole lattice about the origin; 0 gives edges along y.
+    HoneycombLattice(float spacing, float angle_deg, const Bounds& footprint);
+
+    float spacing() const { return _spacing; }
+    float angle_deg() const { return _angle_deg; }
+    // Whether islands within `bounds` lie on the laid-out lattice.
+    bool covers(const Bounds& bounds) const;
+    // Hexagon edges laid out over the footprint, which each family covers with some margin.
+    std::size_t segment_count() const { return _segment_count; }
+
+    // The lattice clipped to `outer` minus `holes`; parts outside the footprint are dropped.
+    std::vector<segment_t> clip(const polygon_t& outer, const std::vector<polygon_t>& holes, float z) const;
+
+private:
+    struct Family {
+        float angle_deg;
+        long first_line, last_line;  // lines at k * spacing across the family
+    };
+
+    float _spacing;
+    float _angle_deg;
+    Bounds _footprint;
+    Family _families[3];
+    std::vector<Span> _rows[2];  // dashes along lines with even and odd k, in order
+    std::size_t _segment_count = 0;
+};
+
+// Infill for one island on one layer. `spacing` is the mean distance between lines, so every
+// pattern puts down about the same length per area: each of an n-direction pattern's families
+// is n * spacing apart, and the surface and honeycomb patterns pick their size the same way.
+// Single-direction patterns start at the island like clip_infill; the families of Grid and
+// Triangles sit on the shared lattice so they cross at common points. Honeycomb lays out a
+// lattice over the island for the call; planners filling many layers keep a HoneycombLattice
+// instead.
+std::vector<segment_t> pattern_infill(const polygon_t& outer, const std::vector<polygon_t>& holes, float spacing,
+                                      const InfillOptions& options, std::size_t plane, float z);
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "include/containers/mesh.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+
+// Distance under which a vertex counts as lying on the slicing plane.
+constexpr float kPlaneEps = 1e-5f;
+
+
+// Structure-of-arrays view of a block of triangles: corner k of triangle i is
+// (x[k][i], y[k][i], z[k][i]).
+struct TriangleBlock {
+    std::array<const float*, 3> x;
+    std::array<const float*, 3> y;
+    std::array<const float*, 3> z;
+    std::size_t count = 0;
+};
+
+// Fixed-capacity SoA staging buffer for callers that gather triangles one at a time.
+struct TriangleBlockStorage {
+    static constexpr std::size_t kCapacity = 256;
+
+    alignas(32) float coords[9][kCapacity];
+    std::size_t count = 0;
+
+    bool full() const { return count == kCapacity; }
+
+    void push(const vec3_t& v0, const vec3_t& v1, const vec3_t& v2) {
+        const vec3_t* corners[3] = {&v0, &v1, &v2};
+        for (int k = 0; k < 3; ++k) {
+            coords[k][count] = corners[k]->x;
+            coords[3 + k][count] = corners[k]->y;
+            coords[6 + k][count] = corners[k]->z;
+        }
+        count++;
+    }
+
+    TriangleBlock view() const {
+        return {{coords[0], coords[1], coords[2]}, {coords[3], coords[4], coords[5]}, {coords[6], coords[7], coords[8]}, count};
+    }
+};
+
+
+enum class IntersectKernel {
+    Scalar,
+    Avx2,
+    Neon,
+};
+
+bool intersect_kernel_supported(IntersectKernel kernel);
+const char* intersect_kernel_name(IntersectKernel kernel);
+
+// Widest kernel the running CPU supports, detected once.
+IntersectKernel active_intersect_kernel();
+
+// Intersects every triangle of `block` with the plane z = z_plane. Triangle i's segments go to
+// out[i * kMaxTriangleSegments, ...) and their number to counts[i]; values and order match
+// intersect_triangle_into for every kernel. Lanes with a vertex on the plane take the scalar
+// path, so the vector kernels only evaluate the plain two-crossing case.
+void intersect_block(const TriangleBlock& block, float z_plane, segment_t* out, uint8_t* counts);
+void intersect_block(IntersectKernel kernel, const TriangleBlock& block, float z_plane, segment_t* out, uint8_t* counts);
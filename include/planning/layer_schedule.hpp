@@ -0,0 +1,60 @@
+#pragma once
+
+#include "include/containers/mesh.hpp"
+
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+
+
+struct AdaptiveLayerOptions {
+    float min_height = 0.05f;  // mm; also the resolution thickness is chosen at
+    float max_height = 0.3f;
+    float max_cusp = 0.05f;    // mm of stair-step a sloped surface may show on one layer
+};
+
+// The heights a part is sliced at: layer l cuts the plane z(l), and z increases with l. A
+// uniform schedule puts its planes at k * height, exactly the planes the integer-height slicer
+// used, across the build volume or only over a part's z-range. An adaptive schedule picks each
+// layer's thickness from the surfaces it crosses: a facet with unit normal n leaves a stair
+// step of thickness * |n.z|, so thickness is capped at max_cusp / |n.z| for every facet the
+// layer overlaps, clamped to [min_height, max_height]. Vertical walls impose no cap, shallow
+// slopes drive it to min_height, and exactly flat facets are skipped since a plane on them
+// leaves no step.
+class LayerSchedule
+{
+public:
+    LayerSchedule() = default;
+
+    static LayerSchedule uniform(float layer_height);
+    // Planes k * layer_height from the one at or below min_z to the one at or above max_z,
+    // clipped to the build volume.
+    static LayerSchedule uniform(float layer_height, float min_z, float max_z);
+    // Planes from the lowest mesh bound up past the highest; reads Mesh::bounds.
+    static LayerSchedule adaptive(const std::vector<Mesh>& meshes, const AdaptiveLayerOptions& options = {});
+
+    std::size_t layer_count() const { return _z.size(); }
+    bool empty() const { return _z.empty(); }
+    float z(std::size_t l) const { return _z[l]; }
+    std::span<const float> heights() const { return _z; }
+    // Distance down to the previous plane; the first layer is as thick as the nominal height.
+    float thickness(std::size_t l) const { return l == 0 ? _nominal_height : _z[l] - _z[l - 1]; }
+    // Layer l's plane counted up from the build plate: uniform schedules number planes the
+    // same however their range is bounded, adaptive ones count from their first layer.
+    std::size_t plane(std::size_t l) const { return _first_plane + l; }
+    // The thickest layer.
+    float nominal_height() const { return _nominal_height; }
+    bool is_uniform() const { return _uniform; }
+
+    // Layers whose plane lies in [min_z, max_z]; empty when first > last.
+    std::pair<int, int> layers_within(float min_z, float max_z) const;
+
+    bool operator==(const LayerSchedule& other) const { return _z == other._z; }
+
+private:
+    std::vector<float> _z;
+    float _nominal_height = 0.0f;
+    bool _uniform = false;
+    std::size_t _first_plane = 0;  // uniform: z(l) = (_first_plane + l) * height
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "include/containers/path_set.hpp"
+#include "include/planning/gcode_writer.hpp"
+#include "kernel/include/motion_codec.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+
+
+// Host side of the binary motion link (kernel/include/motion_codec.h): turns layer paths into
+// CRC-framed commands for the kernel's decoder. Positions are quantized once, as absolute um and
+// 0.1 um of filament, and only the differences are sent, so rounding never accumulates.
+
+struct MotionStats {
+    std::size_t layers = 0;
+    std::size_t frames = 0;
+    std::size_t bytes = 0;  // framing included
+    std::size_t moves = 0;  // extruding
+    std::size_t travels = 0;
+    std::size_t retractions = 0;
+    std::size_t feed_entries = 0;  // feed slots sent
+
+    double bytes_per_move() const {
+        const std::size_t count = moves + travels;
+        return count == 0 ? 0.0 : static_cast<double>(bytes) / static_cast<double>(count);
+    }
+};
+
+class MotionEncoder
+{
+public:
+    // Called with each finished frame, sync byte to CRC; the span is only valid during the call.
+    using FrameSink = std::function<void(std::span<const uint8_t>)>;
+
+    // Extrusion, speeds and retraction follow `options` as GcodeWriter does; merge_tolerance
+    // does not apply, each plan vertex is one move.
+    explicit MotionEncoder(FrameSink sink, const GcodeOptions& options = {});
+
+    // A layer's walls and then its infill; open chains are not printed.
+    void add_layer(float z, float height, const PathSet& paths);
+
+    // Sends the end command and the last partial frame.
+    void finish();
+    const MotionStats& stats() const { return _stats; }
+
+private:
+    void travel_to(int32_t x, int32_t y);
+    void extrude_to(int32_t x, int32_t y);
+    void move_extruder(int32_t de, float mm_per_s);
+    uint8_t feed_slot(float mm_per_s);
+
+    void put_command(const uint8_t* bytes, std::size_t length);
+    void flush_frame();
+
+    FrameSink _sink;
+    GcodeOptions _options;
+    bool _finished = false;
+    std::array<uint8_t, MOTION_FRAME_OVERHEAD + MOTION_MAX_PAYLOAD> _frame{};
+    std::size_t _payload = 0;
+    uint8_t _sequence = 0;
+    MotionStats _stats;
+
+    std::array<uint16_t, MOTION_FEED_SLOTS> _feeds{};  // mm/min per slot; 0 is unset
+    std::size_t _next_slot = 0;  // reused round-robin once every slot is taken
+
+    int32_t _z = 0;
+    bool _z_pending = false;
+    double _e_exact = 0.0;  // mm of filament within the layer
+    int32_t _e = 0;         // what the decoder holds
+    double _e_per_mm = 0.0;
+    bool _has_position = false;
+    int32_t _x = 0, _y = 0;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "include/containers/path_set.hpp"
+#include "include/containers/printer_types.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+
+// Non-extruding travel (mm) of printing `path` in order from `from`: the moves to each
+// segment's start from wherever the previous one ended.
+double travel_distance(std::span<const segment_t> path, const vec3_t& from);
+
+// Reorders segments to cut travel, starting from `cursor` and leaving it where the last one
+// ends. Segments are only reordered and turned around, never moved or dropped: they are first
+// chained into polylines wherever one ends exactly where another starts. Then:
+// - polylines are taken nearest-first from a k-d tree over their possible entry points, whose
+//   nodes count the entries left below them so used-up subtrees are skipped;
+// - open polylines may be entered from either end, so parallel infill comes out serpentine;
+// - closed ones are entered, and left, at their nearest vertex and keep their direction;
+// - a 2-opt pass over a window of kPathOrderWindow following polylines then reverses any run
+//   whose reversal shortens the moves around it.
+// Runs in O(n log n) for n segments.
+constexpr std::size_t kPathOrderWindow = 16;
+std::vector<segment_t> order_paths(std::span<const segment_t> segments, vec3_t& cursor);
+
+struct TravelStats {
+    double before_mm = 0.0;
+    double after_mm = 0.0;
+
+    TravelStats& operator+=(const TravelStats& other) {
+        before_mm += other.before_mm;
+        after_mm += other.after_mm;
+        return *this;
+    }
+};
+
+// Puts one layer's paths in print order: the walls, then the infill from where the walls end,
+// starting at the first wall segment (or infill segment, when there are no walls); any other
+// paths follow unchanged. Travel is measured over the walls and infill before and after.
+TravelStats order_layer_paths(PathSet& paths);
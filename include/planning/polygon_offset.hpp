@@ -0,0 +1,55 @@
+#pragma once
+
+#include "include/containers/printer_types.hpp"
+
+#include <cstdint>
+#include <vector>
+
+
+// Polygon offsetting on a fixed-point grid. Loops are offset edge by edge with joins at the
+// corners, then the raw result is split at its self-intersections and only the boundary of the
+// positive-winding region is kept, so concave corners, thin walls and loops that grow into
+// each other come out as clean, non-overlapping contours.
+
+// Fixed-point units per mm; 0.1 um keeps snapping well below kSnapEps.
+constexpr double kOffsetScale = 1e4;
+
+// Rounds of splitting union_loops runs before it stops waiting for the crossings to settle.
+constexpr int kUnionPasses = 8;
+
+enum class JoinType {
+    Miter,  // sharp corners, bevelled once the miter would reach past miter_limit * |delta|
+    Round,  // arcs within arc_tolerance of the true offset
+};
+
+struct OffsetOptions {
+    JoinType join = JoinType::Miter;
+    double miter_limit = 2.0;
+    float arc_tolerance = 0.01f;
+};
+
+struct FixedPoint {
+    int64_t x, y;
+
+    bool operator==(const FixedPoint& other) const { return x == other.x && y == other.y; }
+    bool operator<(const FixedPoint& other) const { return x < other.x || (x == other.x && y < other.y); }
+};
+
+using FixedLoop = std::vector<FixedPoint>;  // implicitly closed: the last point joins the first
+
+FixedLoop to_fixed(const polygon_t& poly);
+polygon_t from_fixed(const FixedLoop& loop, float z);
+
+// Boundary loops of the region where the loops' winding number is positive: outers CCW, holes
+// CW, no self-intersections, collinear points removed. Crossings are rounded to the grid, which
+// can make new ones; if edges still cross after `max_passes` rounds of splitting, the loops are
+// traced from them as they stand and `settled`, when given, is set to false.
+std::vector<FixedLoop> union_loops(const std::vector<FixedLoop>& loops, int max_passes = kUnionPasses,
+                                   bool* settled = nullptr);
+
+// Offsets the region bounded by `polys` (outers CCW, holes CW, as classify_polygons orients
+// them) by `delta` mm: positive grows it, negative shrinks it. Returns closed loops at the
+// input z; empty when the region vanishes. Cost grows linearly with the vertex count for
+// typical layers (grid-indexed intersection and winding queries). `settled` is union_loops'.
+std::vector<polygon_t> offset_polygons(const std::vector<polygon_t>& polys, float delta,
+                                       const OffsetOptions& options = {}, bool* settled = nullptr);
@@ -0,0 +1,129 @@
+#pragma once
+
+#include "include/containers/printer_types.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+
+// Per-layer polygon helpers shared by the planar slicer stages.
+
+constexpr float kSnapEps = 1e-4f;
+constexpr float kMinSpan = 1e-6f;
+
+inline float dist2d_sq(const vec3_t& a, const vec3_t& b) {
+    float dx = a.x - b.x;
+    float dy = a.y - b.y;
+    return dx * dx + dy * dy;
+}
+
+inline bool close2d(const vec3_t& a, const vec3_t& b, float eps = kSnapEps) {
+    return dist2d_sq(a, b) <= eps * eps;
+}
+
+float signed_area(const polygon_t& poly);
+vec3_t polygon_centroid(const polygon_t& poly);
+bool point_in_polygon(const polygon_t& poly, const vec3_t& p);
+polygon_t ensure_closed(polygon_t poly);
+std::optional<vec3_t> interior_point(const polygon_t& poly);
+std::vector<segment_t> polygon_to_segments(const polygon_t& poly, float z);
+
+
+struct Bounds {
+    float min_x = std::numeric_limits<float>::max();
+    float max_x = std::numeric_limits<float>::lowest();
+    float min_y = std::numeric_limits<float>::max();
+    float max_y = std::numeric_limits<float>::lowest();
+
+    bool empty() const { return min_x > max_x; }
+
+    bool contains(const vec3_t& p) const {
+        return p.x >= min_x && p.x <= max_x && p.y >= min_y && p.y <= max_y;
+    }
+};
+
+Bounds bounds_for_polygon(const polygon_t& poly);
+
+// Bounds grown so that point_in_polygon is false for every point outside them: the crossing
+// test is exact in y, and the margin covers float rounding of the crossing x.
+Bounds containment_bounds(const polygon_t& poly);
+
+
+// Uniform grid over a set of boxes, sized to about one cell per box. Each box is listed in
+// every cell it overlaps (CSR layout), so a point query only sees boxes near the point. Boxes
+// spanning more than kMaxCellsPerBox cells go to a side list that every query reports, which
+// keeps memory linear when many boxes are nested around each other.
+class BoxGridIndex
+{
+public:
+    explicit BoxGridIndex(const std::vector<Bounds>& boxes);
+
+    static constexpr std::size_t kMaxCellsPerBox = 64;
+
+    // Calls fn(box index) once for every box that may contain `p`. Candidates still need an
+    // exact test; every box that contains `p` is reported.
+    template <typename Fn>
+    void for_each_candidate(const vec3_t& p, Fn&& fn) const {
+        for (uint32_t w : _wide) fn(w);
+        if (_cell_starts.empty()) return;
+        const std::size_t cell = cell_y(p.y) * _nx + cell_x(p.x);
+        for (uint32_t i = _cell_starts[cell]; i < _cell_starts[cell + 1]; ++i) fn(_items[i]);
+    }
+
+    // Calls fn(box index) for every box listed in a cell overlapping `rect`. A box spanning
+    // several of those cells may be reported more than once.
+    template <typename Fn>
+    void for_each_in_rect(const Bounds& rect, Fn&& fn) const {
+        for (uint32_t w : _wide) fn(w);
+        if (_cell_starts.empty()) return;
+        const std::size_t x0 = cell_x(rect.min_x), x1 = cell_x(rect.max_x);
+        const std::size_t y0 = cell_y(rect.min_y), y1 = cell_y(rect.max_y);
+        for (std::size_t cy = y0; cy <= y1; ++cy) {
+            for (std::size_t cx = x0; cx <= x1; ++cx) {
+                const std::size_t cell = cy * _nx + cx;
+                for (uint32_t i = _cell_starts[cell]; i < _cell_starts[cell + 1]; ++i) fn(_items[i]);
+            }
+        }
+    }
+
+private:
+    std::size_t cell_x(float x) const { return clamp_cell((x - _extent.min_x) * _inv_cell_w, _nx); }
+    std::size_t cell_y(float y) const { return clamp_cell((y - _extent.min_y) * _inv_cell_h, _ny); }
+
+    static std::size_t clamp_cell(float scaled, std::size_t n) {
+        if (!(scaled > 0.0f)) return 0;
+        if (!(scaled < static_cast<float>(n))) return n - 1;
+        return std::min(static_cast<std::size_t>(scaled), n - 1);
+    }
+
+    Bounds _extent;
+    std::size_t _nx = 1, _ny = 1;
+    float _inv_cell_w = 0.0f, _inv_cell_h = 0.0f;
+    std::vector<uint32_t> _cell_starts;
+    std::vector<uint32_t> _items;
+    std::vector<uint32_t> _wide;
+};
+
+
+struct ClassifiedPolygon {
+    polygon_t poly;
+    float area = 0.0f;
+    int depth = 0;
+    bool is_hole = false;
+};
+
+// Closes every polygon, counts how many others contain its interior point (odd depth = hole),
+// orients outers CCW and holes CW, and sorts by decreasing |area|.
+std::vector<ClassifiedPolygon> classify_polygons(std::vector<polygon_t> polys);
+
+struct Island {
+    polygon_t outer;
+    std::vector<polygon_t> holes;
+};
+
+// Walks the outers in classify order; each one takes the unclaimed holes whose centroid it
+// contains, in hole order.
+std::vector<Island> build_islands(const std::vector<ClassifiedPolygon>& polys);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "include/containers/printer_types.hpp"
+#include "include/planning/polygon_ops.hpp"
+
+#include <cstddef>
+#include <vector>
+
+
+// Douglas-Peucker simplification of a closed loop: every dropped vertex lies within `tolerance`
+// mm of the edge that replaces it. The split is greedy, so fewer vertices may exist that also
+// stay within tolerance. The first vertex is always kept. Returns the loop unchanged when fewer
+// than three vertices would remain.
+polygon_t simplify_loop(const polygon_t& loop, float tolerance);
+
+struct SimplifyStats {
+    std::size_t loops = 0;
+    std::size_t vertices_before = 0;  // not counting the repeated closing vertex
+    std::size_t vertices_after = 0;
+    std::size_t loops_kept = 0;  // left at full detail so the layer's topology holds
+
+    double reduction() const {
+        return vertices_before == 0 ? 1.0 : static_cast<double>(vertices_after) / static_cast<double>(vertices_before);
+    }
+    SimplifyStats& operator+=(const SimplifyStats& other) {
+        loops += other.loops;
+        vertices_before += other.vertices_before;
+        vertices_after += other.vertices_after;
+        loops_kept += other.loops_kept;
+        return *this;
+    }
+};
+
+// Simplifies every outer and hole of one layer's islands, keeping their topology: a simplified
+// loop is put back to its sliced form if it would cross itself or any other loop, turn around,
+// or end up on the other side of a loop it was inside (or outside) of. Crossings are found with
+// a BoxGridIndex over the edges and the check repeats until nothing more is put back, so the
+// cost stays about linear in the layer's vertex count.
+SimplifyStats simplify_islands(std::vector<Island>& islands, float tolerance);
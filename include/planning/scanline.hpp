@@ -0,0 +1,78 @@
+#pragma once
+
+#include "include/containers/printer_types.hpp"
+#include "include/planning/polygon_ops.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+
+// Active-edge-table scanline core shared by the infill patterns.
+
+using Span = std::pair<float, float>;  // [x0, x1] along a scanline
+
+enum class FillRule {
+    EvenOdd,  // inside where an odd number of loops wind around the point
+    NonZero,  // inside where the loops' winding number is not zero
+};
+
+struct LoopSpan {
+    uint32_t loop;
+    float x0, x1;
+};
+
+// Edges of a set of closed loops, sorted once by their low y. The scanline walks up in y; each
+// advance() admits the edges it has reached, retires the ones it has passed, and re-sorts the
+// active edges by crossing x, which is an insertion sort over an already nearly sorted list.
+// An edge crosses y when y_lo <= y < y_hi, edges flatter than kMinSpan never cross, and each
+// crossing x is interpolated from the edge's own endpoints exactly as a full scan of the loop
+// would, so spans match a per-line polygon scan bit for bit.
+class ScanlineEdgeTable
+{
+public:
+    // Loops may repeat their first point at the end. Returns the loop's index.
+    uint32_t add_loop(const polygon_t& loop);
+
+    // Moves the scanline to y; y must not decrease between calls.
+    void advance(float y);
+    float y() const { return _y; }
+    bool done() const { return _active.empty() && _next == _edges.size(); }
+
+    // Each loop's own spans at the current y: its crossings in x order, paired first with
+    // second, third with fourth, and so on; pairs closer than kMinSpan are dropped. Grouped by
+    // loop index, in x order within a loop.
+    const std::vector<LoopSpan>& loop_spans();
+
+    // Spans of the region all loops enclose under `rule`, in x order. Spans shorter than
+    // kMinSpan are dropped.
+    std::vector<Span> fill_spans(FillRule rule) const;
+
+private:
+    struct Edge {
+        float y_lo, y_hi;
+        float x0, y0, x1, y1;  // endpoints in loop order
+        uint32_t loop;
+        int winding;           // +1 upwards, -1 downwards
+    };
+    struct Crossing {
+        float x;
+        uint32_t edge;
+    };
+
+    void sort_edges();
+
+    std::vector<Edge> _edges;
+    bool _sorted = true;
+    std::size_t _next = 0;              // first edge not yet admitted
+    std::vector<Crossing> _active;      // x order at the current y
+    std::vector<LoopSpan> _loop_spans;
+    std::vector<uint8_t> _open;         // per loop: a crossing is waiting for its pair
+    std::vector<float> _open_x;
+    uint32_t _loop_count = 0;
+    float _y = std::numeric_limits<float>::lowest();
+};
+
+// Removes `cuts` (any order) from `base` (x order); pieces shorter than kMinSpan are dropped.
+std::vector<Span> subtract_spans(std::vector<Span> base, const std::vector<Span>& cuts);
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "include/containers/mesh.hpp"
+#include "include/containers/mesh_soa.hpp"
+#include "include/planning/layer_schedule.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+
+// Segments of every layer in one arena: layer l owns segments[offsets[l], offsets[l + 1]).
+struct LayerSegments {
+    std::vector<segment_t> segments;
+    std::vector<std::size_t> offsets;
+
+    std::size_t layer_count() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+    std::span<const segment_t> layer(std::size_t l) const {
+        return {segments.data() + offsets.at(l), offsets.at(l + 1) - offsets[l]};
+    }
+};
+
+
+// Event-driven plane sweep: triangles are bucketed once by their first layer, enter the active
+// list there and leave after their last layer, so each layer only visits the triangles that can
+// cut it. Segments go straight into one arena, layer after layer. The active list stays in
+// (mesh, triangle) order, which makes every layer identical, values and order, to intersecting
+// each mesh's triangles one by one and concatenating the meshes.
+LayerSegments sweep_slice(const std::vector<Mesh>& meshes, const LayerSchedule& schedule);
+
+// Same layers from the SoA layout: entries come from a forward scan of the z_min-sorted
+// triangles instead of an event sort, and z-ranges are read from the precomputed arrays.
+LayerSegments sweep_slice(const std::vector<MeshSoA>& meshes, const LayerSchedule& schedule);
+
+// Uniform layers at l * layer_height across the build volume.
+inline LayerSegments sweep_slice(const std::vector<Mesh>& meshes, float layer_height) {
+    return sweep_slice(meshes, LayerSchedule::uniform(layer_height));
+}
+inline LayerSegments sweep_slice(const std::vector<MeshSoA>& meshes, float layer_height) {
+    return sweep_slice(meshes, LayerSchedule::uniform(layer_height));
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "include/containers/printer_types.hpp"
+#include "include/planning/intersect_kernel.hpp"
+
+#include <cstddef>
+#include <vector>
+
+
+// Triply periodic minimal surfaces used as infill: each layer prints the zero set of the
+// surface's implicit field in its plane, so the walls continue from layer to layer and the
+// infill is about as stiff in z as in x and y.
+enum class TpmsSurface {
+    Gyroid,    // sin x cos y + sin y cos z + sin z cos x
+    SchwarzP,  // cos x + cos y + cos z
+    SchwarzD,  // diamond: sin x sin y sin z + sin x cos y cos z + cos x sin y cos z + cos x cos y sin z
+};
+
+// Period (mm) at which a surface's layer curves have the length per area of straight lines
+// `spacing` apart, averaged over z.
+float tpms_period_for_spacing(TpmsSurface surface, float spacing);
+
+// One layer of a surface's field sampled along rows of a grid: x0 + i * step for i < nx. At a
+// fixed z and y every surface reduces to f = a(x) * p + b(x) * q + r, so the column terms are
+// tabulated once and a row is two multiplies and two adds per sample.
+class TpmsLayerField
+{
+public:
+    TpmsLayerField(TpmsSurface surface, float period, float z, float x0, float step, std::size_t nx);
+
+    std::size_t size() const { return _a.size(); }
+
+    // Field values at height y into out[0, nx). Every kernel rounds like the scalar one.
+    void row(float y, float* out) const;
+    void row(IntersectKernel kernel, float y, float* out) const;
+
+    // The field at one point, for tests and checks.
+    static float at(TpmsSurface surface, float period, const vec3_t& p);
+
+private:
+    TpmsSurface _surface;
+    float _k;  // 2 pi / period
+    float _sin_z, _cos_z;
+    std::vector<float> _a, _b;
+};
+
+// The surface's curves on the layer at z, clipped to `outer` minus `holes`: the field is sampled
+// on a grid (shared by every island and layer) of period / kTpmsSamplesPerPeriod cells over the
+// island, contoured with marching squares, and each piece kept where it lies inside. Cells away
+// from the island's edges are kept or dropped whole; the rest clip against the loop edges that
+// pass through them.
+constexpr std::size_t kTpmsSamplesPerPeriod = 16;
+std::vector<segment_t> tpms_infill(const polygon_t& outer, const std::vector<polygon_t>& holes, TpmsSurface surface,
+                                   float spacing, float z);
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// 0 means one thread per hardware thread.
+inline std::size_t resolve_thread_count(std::size_t num_threads) {
+    if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+    return std::max<std::size_t>(1, num_threads);
+}
+
+
+// Calls fn(i) for every i in [0, count) across `num_threads` threads. Each worker starts with
+// a contiguous share of the indices and consumes it from the front; a worker that runs dry
+// steals the back half of another worker's remaining range, so uneven per-index cost (thin
+// and thick layers of one part) still balances. The first exception thrown by `fn` is
+// rethrown once every worker has stopped.
+template <typename Fn>
+void for_each_stealing(std::size_t count, std::size_t num_threads, Fn&& fn) {
+    const std::size_t workers = std::min(resolve_thread_count(num_threads), count);
+    if (workers <= 1) {
+        for (std::size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    struct alignas(64) Range {
+        std::mutex lock;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+    };
+    std::vector<Range> ranges(workers);
+    for (std::size_t w = 0; w < workers; ++w) {
+        ranges[w].begin = count * w / workers;
+        ranges[w].end = count * (w + 1) / workers;
+    }
+
+    std::mutex error_lock;
+    std::exception_ptr error;
+
+    auto pop_own = [&](std::size_t self, std::size_t& index) {
+        std::lock_guard<std::mutex> guard(ranges[self].lock);
+        if (ranges[self].begin == ranges[self].end) return false;
+        index = ranges[self].begin++;
+        return true;
+    };
+
+    auto steal = [&](std::size_t self) {
+        for (std::size_t offset = 1; offset < workers; ++offset) {
+            Range& victim = ranges[(self + offset) % workers];
+            std::size_t begin, end;
+            {
+                std::lock_guard<std::mutex> guard(victim.lock);
+                std::size_t remaining = victim.end - victim.begin;
+                if (remaining == 0) continue;
+                end = victim.end;
+                begin = victim.end - (remaining + 1) / 2;
+                victim.end = begin;
+            }
+            std::lock_guard<std::mutex> guard(ranges[self].lock);
+            ranges[self].begin = begin;
+            ranges[self].end = end;
+            return true;
+        }
+        return false;
+    };
+
+    auto work = [&](std::size_t self) {
+        try {
+            std::size_t index;
+            while (pop_own(self, index) || (steal(self) && pop_own(self, index))) {
+                fn(index);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(error_lock);
+            if (!error) error = std::current_exception();
+            // drain the remaining work so the other workers stop early
+            for (auto& range : ranges) {
+                std::lock_guard<std::mutex> range_guard(range.lock);
+                range.begin = range.end;
+            }
+        }
+    };
+
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(workers - 1);
+        for (std::size_t w = 1; w < workers; ++w) {
+            threads.emplace_back(work, w);
+        }
+        work(0);
+        // jthreads join on destruction
+    }
+    if (error) std::rethrow_exception(error);
+}
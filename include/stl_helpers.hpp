@@ -2,6 +2,8 @@
 
 #include "include/containers/printer_types.hpp"
 #include "include/containers/mesh.hpp"
+#include "include/containers/mapped_file.hpp"
+#include "include/containers/vertex_weld.hpp"
 
 #include <fstream>
 #include <string>
@@ -14,8 +16,11 @@
 #include <array>
 #include <vector>
 #include <exception>
-#include <unordered_map>
 #include <memory>
+#include <cstring>
+#include <thread>
+#include <charconv>
+#include <string_view>
 
 
 inline bool is_stl_ascii(const std::string filename)
@@ -45,11 +50,8 @@ inline std::vector<Mesh> read_stl_ascii(const std::string filename) {
 	int triangle_vertex_idx = 0;
 	std::unique_ptr<Mesh> last_solid;
 
-	// maps point hash -> pair(point value, point idx)
-	std::unordered_map< std::size_t, std::pair<vec3_t, int> > point_set;
-	uint32_t point_idx = 0;
-
-	boost::hash<vec3_t> point_hasher;
+	// welds vertices of the current solid to point indices
+	VertexWeldTable point_set;
 
 	while (std::getline(input, line_string)) {
 		int idx = 0;
@@ -89,14 +91,8 @@ inline std::vector<Mesh> read_stl_ascii(const std::string filename) {
 			};
 			current_vertices[triangle_vertex_idx] = vertex;
 			
-			// check hash, and if collision check point val
-			auto point_hash = point_hasher(vertex);
-			if (point_set.find(point_hash) != point_set.end()
-				&& point_set[point_hash].first == vertex) {
-				point_idx = point_set[point_hash].second;
-			} else {
-				point_idx = last_solid->points.size();
-				point_set[point_hash] = {vertex, point_idx};
+			auto [point_idx, is_new] = point_set.insert(vertex, static_cast<uint32_t>(last_solid->points.size()));
+			if (is_new) {
 				last_solid->points.push_back(vertex);
 			}
 			last_triangle->vertices[triangle_vertex_idx++] = point_idx;
@@ -105,6 +101,7 @@ inline std::vector<Mesh> read_stl_ascii(const std::string filename) {
 		}
 	}
 
+	for (auto& solid : solids) solid.update_bounds();
 	return solids;
 }
 
@@ -128,8 +125,7 @@ inline Mesh read_stl_binary(const std::string filename) {
 	}
 
 	Mesh mesh;
-	std::unordered_map<std::size_t, std::pair<vec3_t, uint32_t>> point_set;
-	boost::hash<vec3_t> point_hasher;
+	VertexWeldTable point_set(PT_EQUAL_THRESH, static_cast<std::size_t>(triangle_count) / 2);
 	std::array<vec3_t, 3> current_vertices;
 
 	for (uint32_t i = 0; i < triangle_count; ++i) {
@@ -147,16 +143,11 @@ inline Mesh read_stl_binary(const std::string filename) {
 			vec3_t vertex{vertex_vals[0], vertex_vals[1], vertex_vals[2]};
 			current_vertices[v] = vertex;
 
-			auto point_hash = point_hasher(vertex);
-			auto found = point_set.find(point_hash);
-			if (found != point_set.end() && found->second.first == vertex) {
-				tri.vertices[v] = found->second.second;
-			} else {
-				uint32_t idx = static_cast<uint32_t>(mesh.points.size());
-				point_set[point_hash] = {vertex, idx};
+			auto [point_idx, is_new] = point_set.insert(vertex, static_cast<uint32_t>(mesh.points.size()));
+			if (is_new) {
 				mesh.points.push_back(vertex);
-				tri.vertices[v] = idx;
 			}
+			tri.vertices[v] = point_idx;
 		}
 
 		// skip attribute byte count
@@ -173,5 +164,554 @@ inline Mesh read_stl_binary(const std::string filename) {
 		mesh.triangles.push_back(tri);
 	}
 
+	mesh.update_bounds();
 	return mesh;
 }
+
+
+namespace stl_detail {
+
+// binary STL layout: [80 byte header][uint32 num_triangles][num_triangles * 50 byte records]
+// record: normal (3 floats), 3 vertices (9 floats), uint16 attribute byte count
+constexpr std::size_t kBinaryHeaderSize = 80;
+constexpr std::size_t kBinaryPreambleSize = kBinaryHeaderSize + sizeof(uint32_t);
+constexpr std::size_t kBinaryRecordSize = 50;
+
+// records are 50 bytes so floats are unaligned; memcpy compiles down to plain loads
+inline void decode_binary_normal(const char* record, vec3_t& normal) {
+	float vals[3];
+	std::memcpy(vals, record, sizeof(vals));
+	normal = {vals[0], vals[1], vals[2]};
+}
+
+inline void decode_binary_vertices(const char* record, vec3_t* corners) {
+	float vals[9];
+	std::memcpy(vals, record + 3 * sizeof(float), sizeof(vals));
+	for (int v = 0; v < 3; ++v) {
+		corners[v] = {vals[3 * v], vals[3 * v + 1], vals[3 * v + 2]};
+	}
+}
+
+// Winding check shared by the readers: normalizes `normal` in place (the stored normal has
+// always been the normalized one) and returns true when the corners wind against it.
+inline bool winding_disagrees(vec3_t& normal, const std::array<vec3_t, 3>& corners) {
+	auto measured_normal = triangle_t{}.compute_normal(corners);
+	return normal.normalize() != measured_normal.normalize();
+}
+
+// Same winding check and centroid as the streaming readers. `vertices` must already hold
+// the welded point indices in file order.
+inline void finish_triangle(triangle_t& tri, const std::array<vec3_t, 3>& corners) {
+	if (winding_disagrees(tri.normal_vec, corners)) {
+		std::swap(tri.vertices[1], tri.vertices[2]);
+	}
+	tri.compute_centroid(corners);
+}
+
+// Bulk-weld keys. The narrow key keeps the scatter at 16 bytes per corner and covers every
+// part whose quantized coordinates fit in 32 bits (±2147 mm at the default tolerance); the
+// wide key handles everything else.
+struct NarrowWeldKey {
+	int32_t x, y, z;
+	uint32_t occurrence;
+
+	static NarrowWeldKey make(const vec3_t& c, std::size_t occurrence, double inv_tolerance) {
+		auto q = quantize_vertex(c, inv_tolerance);
+		return {static_cast<int32_t>(q.x), static_cast<int32_t>(q.y), static_cast<int32_t>(q.z), static_cast<uint32_t>(occurrence)};
+	}
+	QuantizedVertex position() const { return {x, y, z}; }
+};
+
+struct WideWeldKey {
+	QuantizedVertex cell;
+	uint32_t occurrence;
+
+	static WideWeldKey make(const vec3_t& c, std::size_t occurrence, double inv_tolerance) {
+		return {quantize_vertex(c, inv_tolerance), static_cast<uint32_t>(occurrence)};
+	}
+	QuantizedVertex position() const { return cell; }
+};
+
+inline bool fits_narrow_weld_key(const std::vector<vec3_t>& corners, double inv_tolerance) {
+	float max_abs = 0.0f;
+	for (const auto& c : corners) {
+		max_abs = std::max({max_abs, std::abs(c.x), std::abs(c.y), std::abs(c.z)});
+	}
+	return static_cast<double>(max_abs) * inv_tolerance < 2.0e9; // also false for nan/inf
+}
+
+inline std::size_t chunk_count(std::size_t num_threads, std::size_t count) {
+	return std::max<std::size_t>(1, std::min(num_threads, count));
+}
+
+// Splits [0, count) into chunk_count(num_threads, count) contiguous chunks and runs
+// fn(chunk, begin, end) on each, returning once every chunk is done. Chunk boundaries depend
+// only on the arguments, so passes over the same range line up.
+template <typename Fn>
+inline void for_each_chunk(std::size_t num_threads, std::size_t count, Fn&& fn) {
+	const std::size_t chunks = chunk_count(num_threads, count);
+	auto bound = [&](std::size_t chunk) { return count * chunk / chunks; };
+	if (chunks == 1) {
+		fn(std::size_t{0}, std::size_t{0}, count);
+		return;
+	}
+	std::vector<std::jthread> workers;
+	workers.reserve(chunks - 1);
+	for (std::size_t chunk = 1; chunk < chunks; ++chunk) {
+		workers.emplace_back([&fn, chunk, begin = bound(chunk), end = bound(chunk + 1)] {
+			fn(chunk, begin, end);
+		});
+	}
+	fn(std::size_t{0}, std::size_t{0}, bound(1));
+	// jthreads join on destruction
+}
+
+// Corners are scattered into hash buckets small enough for a per-bucket table to stay in
+// cache. The scatter is stable, so each bucket lists its corners in occurrence order.
+template <typename Key>
+struct WeldBuckets {
+	std::vector<Key> keys;           // grouped by bucket
+	std::vector<std::size_t> starts; // bucket b spans [starts[b], starts[b + 1])
+	int shift = 64;
+
+	std::size_t bucket_of(const Key& k) const {
+		return shift >= 64 ? 0 : static_cast<std::size_t>(hash_quantized_vertex(k.position()) >> shift);
+	}
+	std::size_t bucket_count() const { return starts.size() - 1; }
+};
+
+constexpr std::size_t kWeldBucketTarget = 1024;
+constexpr int kWeldMaxBucketBits = 20;
+
+template <typename Key>
+inline WeldBuckets<Key> scatter_weld_keys(const std::vector<vec3_t>& corners, std::size_t num_threads, double inv_tolerance) {
+	const std::size_t count = corners.size();
+	int bucket_bits = 0;
+	while ((kWeldBucketTarget << bucket_bits) < count && bucket_bits < kWeldMaxBucketBits) ++bucket_bits;
+
+	WeldBuckets<Key> buckets;
+	buckets.shift = 64 - bucket_bits;
+	const std::size_t bucket_count = std::size_t{1} << bucket_bits;
+	buckets.starts.assign(bucket_count + 1, 0);
+
+	// per-chunk histograms turn into per-chunk write cursors, keeping the scatter stable;
+	// keys and bucket ids are computed once so the scatter pass only copies
+	const std::size_t chunks = chunk_count(num_threads, count);
+	std::vector<std::vector<std::size_t>> cursors(chunks, std::vector<std::size_t>(bucket_count, 0));
+	std::vector<Key> ordered(count);
+	std::vector<uint32_t> bucket_ids(count);
+	for_each_chunk(num_threads, count, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+		auto& histogram = cursors[chunk];
+		for (std::size_t i = begin; i < end; ++i) {
+			ordered[i] = Key::make(corners[i], i, inv_tolerance);
+			bucket_ids[i] = static_cast<uint32_t>(buckets.bucket_of(ordered[i]));
+			histogram[bucket_ids[i]]++;
+		}
+	});
+
+	std::size_t offset = 0;
+	for (std::size_t b = 0; b < bucket_count; ++b) {
+		buckets.starts[b] = offset;
+		for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+			std::size_t n = cursors[chunk][b];
+			cursors[chunk][b] = offset;
+			offset += n;
+		}
+	}
+	buckets.starts[bucket_count] = offset;
+
+	buckets.keys.resize(count);
+	for_each_chunk(num_threads, count, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+		auto& cursor = cursors[chunk];
+		for (std::size_t i = begin; i < end; ++i) {
+			buckets.keys[cursor[bucket_ids[i]]++] = ordered[i];
+		}
+	});
+	return buckets;
+}
+
+// Welds buckets [first, last): writes, for every corner, the occurrence index of the first
+// corner in the same weld cell. `table` is scratch space reused between buckets.
+template <typename Key>
+inline void weld_bucket_range(const WeldBuckets<Key>& buckets, std::size_t first, std::size_t last,
+                              std::vector<uint32_t>& first_occurrence, std::vector<uint32_t>& table) {
+	constexpr uint32_t kEmpty = UINT32_MAX;
+	for (std::size_t b = first; b < last; ++b) {
+		const std::size_t begin = buckets.starts[b];
+		const std::size_t end = buckets.starts[b + 1];
+		if (begin == end) continue;
+
+		std::size_t table_size = 4;
+		while (table_size < 2 * (end - begin)) table_size <<= 1;
+		const std::size_t mask = table_size - 1;
+		if (table.size() < table_size) table.resize(table_size);
+		std::fill(table.begin(), table.begin() + static_cast<std::ptrdiff_t>(table_size), kEmpty);
+
+		for (std::size_t i = begin; i < end; ++i) {
+			const Key& key = buckets.keys[i];
+			const QuantizedVertex position = key.position();
+			std::size_t slot = static_cast<std::size_t>(hash_quantized_vertex(position)) & mask;
+			while (true) {
+				uint32_t held = table[slot];
+				if (held == kEmpty) {
+					table[slot] = static_cast<uint32_t>(i);
+					first_occurrence[key.occurrence] = key.occurrence;
+					break;
+				}
+				if (buckets.keys[held].position() == position) {
+					first_occurrence[key.occurrence] = buckets.keys[held].occurrence;
+					break;
+				}
+				slot = (slot + 1) & mask;
+			}
+		}
+	}
+}
+
+// Assigns point indices in first-occurrence order, matching what a per-vertex hash insert
+// produces. Each chunk numbers its own first occurrences from a prefix-summed base; duplicates
+// are resolved afterwards since their first occurrence may live in an earlier chunk.
+inline std::vector<uint32_t> assign_point_indices(const std::vector<vec3_t>& corners,
+                                                  const std::vector<uint32_t>& first_occurrence,
+                                                  std::vector<vec3_t>& points, std::size_t num_threads) {
+	const std::size_t count = corners.size();
+	std::vector<uint32_t> indices(count);
+	std::vector<std::size_t> chunk_base(chunk_count(num_threads, count) + 1, 0);
+
+	for_each_chunk(num_threads, count, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+		std::size_t unique = 0;
+		for (std::size_t i = begin; i < end; ++i) unique += (first_occurrence[i] == i);
+		chunk_base[chunk + 1] = unique;
+	});
+	for (std::size_t chunk = 1; chunk < chunk_base.size(); ++chunk) {
+		chunk_base[chunk] += chunk_base[chunk - 1];
+	}
+
+	points.resize(chunk_base.back());
+	for_each_chunk(num_threads, count, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+		auto next = static_cast<uint32_t>(chunk_base[chunk]);
+		for (std::size_t i = begin; i < end; ++i) {
+			if (first_occurrence[i] != i) continue;
+			indices[i] = next;
+			points[next++] = corners[i];
+		}
+	});
+	for_each_chunk(num_threads, count, [&](std::size_t, std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			if (first_occurrence[i] != i) indices[i] = indices[first_occurrence[i]];
+		}
+	});
+	return indices;
+}
+
+template <typename Key>
+inline std::vector<uint32_t> find_first_occurrences(const std::vector<vec3_t>& corners, std::size_t num_threads,
+                                                    double inv_tolerance) {
+	auto buckets = scatter_weld_keys<Key>(corners, num_threads, inv_tolerance);
+	std::vector<uint32_t> first_occurrence(corners.size());
+	for_each_chunk(num_threads, buckets.bucket_count(), [&](std::size_t, std::size_t first, std::size_t last) {
+		std::vector<uint32_t> table;
+		weld_bucket_range(buckets, first, last, first_occurrence, table);
+	});
+	return first_occurrence;
+}
+
+// Bulk weld with the same quantized cells as VertexWeldTable. Returns the point index of every
+// corner and fills `points` with the unique positions. The result does not depend on
+// `num_threads`.
+inline std::vector<uint32_t> weld_vertices_bulk(const std::vector<vec3_t>& corners, std::vector<vec3_t>& points,
+                                                std::size_t num_threads = 1, double tolerance = PT_EQUAL_THRESH) {
+	const double inv_tolerance = 1.0 / tolerance;
+	auto first_occurrence = fits_narrow_weld_key(corners, inv_tolerance)
+		? find_first_occurrences<NarrowWeldKey>(corners, num_threads, inv_tolerance)
+		: find_first_occurrences<WideWeldKey>(corners, num_threads, inv_tolerance);
+	return assign_point_indices(corners, first_occurrence, points, num_threads);
+}
+
+inline bool is_stl_space(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Whitespace-separated word cursor over one line of a mapped ASCII STL
+struct AsciiLine {
+	const char* pos;
+	const char* end;
+
+	void skip_space() {
+		while (pos < end && is_stl_space(*pos)) ++pos;
+	}
+
+	std::string_view next_word() {
+		skip_space();
+		const char* start = pos;
+		while (pos < end && !is_stl_space(*pos)) ++pos;
+		return {start, static_cast<std::size_t>(pos - start)};
+	}
+
+	// like std::stof: parses the longest numeric prefix of the next word, ignores the rest
+	float next_float() {
+		skip_space();
+		if (pos < end && *pos == '+') ++pos; // from_chars rejects an explicit plus sign
+		float value = 0.0f;
+		auto [ptr, ec] = std::from_chars(pos, end, value);
+		if (ec != std::errc()) {
+			throw std::runtime_error("Malformed STL number");
+		}
+		pos = ptr;
+		while (pos < end && !is_stl_space(*pos)) ++pos;
+		return value;
+	}
+};
+
+// ASCII STL keyword state machine, fed one line at a time. Shared by read_stl_ascii_mapped and
+// StlTriangleStream so both accept exactly the same grammar.
+struct AsciiFacetParser {
+	enum class Event { None, SolidBegin, SolidEnd, FacetEnd };
+
+	vec3_t normal{};
+	std::array<vec3_t, 3> vertices{};
+	int vertex_count = 0;
+	bool in_solid = false;
+
+	Event consume(AsciiLine line) {
+		std::string_view keyword = line.next_word();
+		if (keyword.empty()) return Event::None;
+
+		if (keyword == "vertex") {
+			require_solid();
+			if (vertex_count >= 3) throw std::runtime_error("Too many vertices in STL facet");
+			vec3_t& vertex = vertices[vertex_count++];
+			vertex.x = line.next_float();
+			vertex.y = line.next_float();
+			vertex.z = line.next_float();
+		} else if (keyword == "facet") {
+			require_solid();
+			line.next_word(); // "normal"
+			normal.x = line.next_float();
+			normal.y = line.next_float();
+			normal.z = line.next_float();
+			vertex_count = 0;
+		} else if (keyword == "endfacet") {
+			require_solid();
+			if (vertex_count != 3) throw std::runtime_error("STL facet without three vertices");
+			vertex_count = 0;
+			return Event::FacetEnd;
+		} else if (keyword == "solid") {
+			in_solid = true;
+			return Event::SolidBegin;
+		} else if (keyword == "endsolid") {
+			require_solid();
+			in_solid = false;
+			return Event::SolidEnd;
+		} else if (keyword != "outer" && keyword != "endloop") {
+			throw std::runtime_error(std::string("Undefined STL keyword"));
+		}
+		return Event::None;
+	}
+
+	void require_solid() const {
+		if (!in_solid) throw std::runtime_error("STL facet outside of solid");
+	}
+};
+
+} // namespace stl_detail
+
+
+// Chunked parallel binary reader. Each worker decodes a contiguous range of the mapped
+// triangle records; the weld merges all corners deterministically, so point indices are the
+// same for any thread count and match read_stl_binary. num_threads == 0 uses every core.
+inline Mesh read_stl_binary_parallel(const std::string filename, std::size_t num_threads = 0) {
+	if (num_threads == 0) {
+		num_threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	MappedFile file(filename);
+	if (file.size() < stl_detail::kBinaryPreambleSize) {
+		throw std::runtime_error("Failed to read triangle count");
+	}
+	file.advise(MADV_SEQUENTIAL);
+
+	uint32_t triangle_count = 0;
+	std::memcpy(&triangle_count, file.data() + stl_detail::kBinaryHeaderSize, sizeof(triangle_count));
+	const std::size_t payload = file.size() - stl_detail::kBinaryPreambleSize;
+	if (payload / stl_detail::kBinaryRecordSize < triangle_count) {
+		throw std::runtime_error("Unexpected EOF while reading triangles");
+	}
+
+	const char* records = file.data() + stl_detail::kBinaryPreambleSize;
+	std::vector<vec3_t> corners(static_cast<std::size_t>(triangle_count) * 3);
+	stl_detail::for_each_chunk(num_threads, triangle_count, [&](std::size_t, std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; ++i) {
+			stl_detail::decode_binary_vertices(records + i * stl_detail::kBinaryRecordSize, &corners[3 * i]);
+		}
+	});
+
+	Mesh mesh;
+	auto indices = stl_detail::weld_vertices_bulk(corners, mesh.points, num_threads);
+
+	mesh.triangles.resize(triangle_count);
+	stl_detail::for_each_chunk(num_threads, triangle_count, [&](std::size_t, std::size_t begin, std::size_t end) {
+		std::array<vec3_t, 3> current_vertices;
+		for (std::size_t i = begin; i < end; ++i) {
+			triangle_t& tri = mesh.triangles[i];
+			stl_detail::decode_binary_normal(records + i * stl_detail::kBinaryRecordSize, tri.normal_vec);
+			for (int v = 0; v < 3; ++v) {
+				tri.vertices[v] = indices[3 * i + v];
+				current_vertices[v] = corners[3 * i + v];
+			}
+			stl_detail::finish_triangle(tri, current_vertices);
+		}
+	});
+
+	mesh.update_bounds();
+	return mesh;
+}
+
+
+// Memory-mapped binary reader: decodes the 50-byte records in place and welds all vertices in
+// one bulk pass. Produces the same Mesh as read_stl_binary.
+inline Mesh read_stl_binary_mapped(const std::string filename) {
+	return read_stl_binary_parallel(filename, 1);
+}
+
+
+// Tokenizer-free ASCII reader: scans the mapped file line by line and parses numbers with
+// std::from_chars. Corners of each solid are welded in one bulk pass at `endsolid`, which
+// yields the same point order and deduplication as read_stl_ascii.
+inline std::vector<Mesh> read_stl_ascii_mapped(const std::string filename) {
+	using Event = stl_detail::AsciiFacetParser::Event;
+
+	MappedFile file(filename);
+	file.advise(MADV_SEQUENTIAL);
+
+	std::vector<Mesh> solids;
+	std::unique_ptr<Mesh> last_solid;
+	std::vector<vec3_t> corners; // every vertex of the current solid, in file order
+	stl_detail::AsciiFacetParser parser;
+
+	const char* cursor = file.data();
+	const char* file_end = cursor + file.size();
+	while (cursor < file_end) {
+		const char* line_end = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<std::size_t>(file_end - cursor)));
+		if (line_end == nullptr) line_end = file_end;
+		stl_detail::AsciiLine line{cursor, line_end};
+		cursor = line_end + 1;
+
+		switch (parser.consume(line)) {
+			case Event::FacetEnd: {
+				// corner occurrences for now, remapped to welded point indices at endsolid
+				triangle_t tri;
+				tri.normal_vec = parser.normal;
+				for (int v = 0; v < 3; ++v) {
+					tri.vertices[v] = static_cast<uint32_t>(corners.size());
+					corners.push_back(parser.vertices[v]);
+				}
+				if (stl_detail::winding_disagrees(tri.normal_vec, parser.vertices)) {
+					std::swap(tri.vertices[1], tri.vertices[2]);
+				}
+				last_solid->triangles.push_back(tri);
+			} break;
+
+			case Event::SolidBegin: {
+				last_solid = std::make_unique<Mesh>();
+				corners.clear();
+			} break;
+
+			case Event::SolidEnd: {
+				auto indices = stl_detail::weld_vertices_bulk(corners, last_solid->points);
+				for (auto& tri : last_solid->triangles) {
+					for (auto& v : tri.vertices) v = indices[v];
+				}
+				solids.emplace_back(std::move(*last_solid));
+				last_solid.reset();
+				corners.clear();
+			} break;
+
+			case Event::None:
+				break;
+		}
+	}
+
+	for (auto& solid : solids) solid.update_bounds();
+	return solids;
+}
+
+
+// Reads an STL file (ASCII or binary) in bounded chunks of raw triangles, for consumers that
+// must not materialize a whole Mesh. Corners come out with the same winding fix the readers
+// apply; vertices are not welded and solids are not separated.
+class StlTriangleStream
+{
+public:
+	explicit StlTriangleStream(const std::string& filename)
+		: _ascii(is_stl_ascii(filename)), _input(filename, std::ios::binary)
+	{
+		if (!_input) {
+			throw std::runtime_error("Failed to open STL file");
+		}
+		rewind();
+	}
+
+	// Replaces `out` with up to `max_triangles` triangles; returns false once the file is exhausted.
+	bool next_chunk(std::vector<std::array<vec3_t, 3>>& out, std::size_t max_triangles) {
+		out.clear();
+		if (_ascii) {
+			while (out.size() < max_triangles && std::getline(_input, _line)) {
+				stl_detail::AsciiLine line{_line.data(), _line.data() + _line.size()};
+				if (_parser.consume(line) == stl_detail::AsciiFacetParser::Event::FacetEnd) {
+					push_fixed(_parser.normal, _parser.vertices, out);
+				}
+			}
+			return !out.empty();
+		}
+
+		const std::size_t count = std::min<std::size_t>(max_triangles, _remaining);
+		if (count == 0) return false;
+		_buffer.resize(count * stl_detail::kBinaryRecordSize);
+		_input.read(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+		if (!_input) {
+			throw std::runtime_error("Unexpected EOF while reading triangles");
+		}
+		for (std::size_t i = 0; i < count; ++i) {
+			const char* record = _buffer.data() + i * stl_detail::kBinaryRecordSize;
+			vec3_t normal;
+			std::array<vec3_t, 3> corners;
+			stl_detail::decode_binary_normal(record, normal);
+			stl_detail::decode_binary_vertices(record, corners.data());
+			push_fixed(normal, corners, out);
+		}
+		_remaining -= static_cast<uint32_t>(count);
+		return true;
+	}
+
+	void rewind() {
+		_input.clear();
+		_input.seekg(0);
+		_parser = {};
+		if (!_ascii) {
+			char header[stl_detail::kBinaryHeaderSize];
+			_input.read(header, sizeof(header));
+			_input.read(reinterpret_cast<char*>(&_remaining), sizeof(_remaining));
+			if (!_input) {
+				throw std::runtime_error("Failed to read triangle count");
+			}
+		}
+	}
+
+	bool is_ascii() const { return _ascii; }
+
+private:
+	static void push_fixed(vec3_t normal, std::array<vec3_t, 3> corners, std::vector<std::array<vec3_t, 3>>& out) {
+		if (stl_detail::winding_disagrees(normal, corners)) {
+			std::swap(corners[1], corners[2]);
+		}
+		out.push_back(corners);
+	}
+
+	bool _ascii;
+	std::ifstream _input;
+	uint32_t _remaining = 0;
+	std::vector<char> _buffer;
+	std::string _line;
+	stl_detail::AsciiFacetParser _parser;
+};
@@ -12,13 +12,26 @@
 #pragma once
 
 #include "include/containers/mesh.hpp"
+#include "include/containers/mesh_soa.hpp"
+#include "include/containers/plan_file.hpp"
+#include "include/containers/path_set.hpp"
 #include "include/containers/worker_thread.hpp"
+#include "include/planning/gcode_writer.hpp"
+#include "include/planning/infill.hpp"
+#include "include/planning/layer_schedule.hpp"
+#include "include/planning/polygon_offset.hpp"
+#include "include/planning/polygon_simplify.hpp"
+#include "include/planning/polygon_ops.hpp"
 
 #include <filesystem>
 #include <vector>
 #include <memory>
 #include <cstddef>
+#include <cstdint>
 #include <utility>
+#include <functional>
+#include <optional>
+#include <span>
 
 class PathPlanner : public WorkerThread
 {
@@ -31,31 +44,221 @@ public:
 
     void set_cad(std::filesystem::path cad_file);
 
-    // planar-only slice + infill builder
-    void slice_planar(int layer_height_mm, float infill_spacing);
+    // planar-only slice + infill builder; layers are built in parallel, plan_ stays in z order.
+    // Stages are cached: the sweep, stitching and island nesting are reused while the mesh
+    // content and layer schedule match, the walls while the contour tolerance and perimeter
+    // settings also match, and a call with unchanged infill spacing, options and path ordering
+    // rebuilds nothing.
+    void slice_planar(const LayerSchedule& schedule, float infill_spacing);
+    // Uniform planes over the loaded part's z-range only.
+    void slice_planar(float layer_height_mm, float infill_spacing) {
+        slice_planar(LayerSchedule::uniform(layer_height_mm, bounds_.min.z, bounds_.max.z), infill_spacing);
+    }
+    // Adaptive schedule over the loaded meshes; see LayerSchedule::adaptive.
+    void slice_planar_adaptive(const AdaptiveLayerOptions& options, float infill_spacing) {
+        slice_planar(LayerSchedule::adaptive(meshes, options), infill_spacing);
+    }
+    // Planes of the last slice_planar call; get_raw_layers() is indexed like it.
+    const LayerSchedule& layer_schedule() const { return schedule_; }
 
+    struct SliceCacheStats {
+        std::size_t slices = 0;        // slice_planar calls with a mesh loaded
+        std::size_t island_hits = 0;   // sweep, stitching and nesting reused
+        std::size_t wall_hits = 0;     // perimeters reused
+        std::size_t plan_hits = 0;     // whole plan reused
+        double island_ms = 0.0;        // time spent rebuilding each stage
+        double wall_ms = 0.0;
+        double infill_ms = 0.0;
+
+        double hit_rate() const { return slices == 0 ? 0.0 : static_cast<double>(plan_hits) / static_cast<double>(slices); }
+    };
+    const SliceCacheStats& slice_cache_stats() const { return cache_stats_; }
+
+    // What the last infill rebuild put down, per layer of get_plan(), and the honeycomb lattice
+    // behind it. The lattice is laid out over the part once and kept while the spacing, angle
+    // and part footprint allow, so lattice_builds only grows when one of those changes.
+    struct InfillLayerMetrics {
+        std::size_t segments = 0;
+        double ms = 0.0;  // infill generation for the layer
+    };
+    struct InfillMetrics {
+        std::size_t lattice_builds = 0;
+        double lattice_ms = 0.0;
+        std::size_t lattice_segments = 0;  // hexagon edges in the current lattice
+        std::vector<InfillLayerMetrics> layers;
+    };
+    const InfillMetrics& infill_metrics() const { return infill_metrics_; }
+    void clear_slice_cache();
+    // Called from the slicing threads with each layer's index before slice_planar builds its
+    // walls; an exception it throws fails the slice as a failed wall build would. For tests.
+    void set_wall_hook(std::function<void(std::size_t)> hook) { wall_hook_ = std::move(hook); }
+    uint64_t mesh_hash() const { return mesh_hash_; }
+
+    // Layout slice_planar reads: the indexed meshes, or a MeshSoA copy of each (built by
+    // set_cad, or right away when meshes are already loaded). Both give the same plan.
+    enum class MeshLayout {
+        Indexed,
+        StructureOfArrays,
+    };
+    void set_mesh_layout(MeshLayout layout);
+    MeshLayout mesh_layout() const { return mesh_layout_; }
+
+    // Threads slice_planar spreads layers over; 0 (the default) uses every hardware thread.
+    void set_thread_count(std::size_t num_threads) { num_threads_ = num_threads; }
+    std::size_t thread_count() const { return num_threads_; }
+
+    // Walls per island: the sliced outline plus count - 1 insets, each shell_width further in.
+    // Insets are cleaned offsets of the whole island, so walls merge or stop where it narrows.
+    void set_perimeter_count(int count);
+    int perimeter_count() const { return perimeter_count_; }
+    void set_perimeter_join(JoinType join) { offset_options_.join = join; }
+    JoinType perimeter_join() const { return offset_options_.join; }
+    // Insets whose cleanup stopped with edges still crossing (see union_loops); they are kept as
+    // traced. Covers the last time the walls were rebuilt.
+    std::size_t unsettled_insets() const { return unsettled_insets_; }
+
+    // Island loops are simplified to within `mm` (see simplify_islands) before any wall is
+    // built, which thins out the sub-0.01 mm edges of finely tessellated parts ahead of the
+    // offsets, infill and plan; 0 (the default) keeps every sliced vertex. simplify_stats()
+    // covers the last time the walls were rebuilt.
+    void set_contour_tolerance(float mm);
+    float contour_tolerance() const { return contour_tolerance_; }
+    const SimplifyStats& simplify_stats() const { return simplify_stats_; }
+
+    // Pattern the infill regions are filled with; the infill spacing passed to slice_planar is
+    // its mean line spacing. Patterns that change per layer key on LayerSchedule::plane.
+    void set_infill_options(const InfillOptions& options) { infill_options_ = options; }
+    const InfillOptions& infill_options() const { return infill_options_; }
+
+    // Reorders each built layer's walls and then its infill to cut travel between them (see
+    // order_layer_paths); on by default. path_order_stats() covers the last plan it ordered.
+    void set_path_ordering(bool enabled) { path_ordering_ = enabled; }
+    bool path_ordering() const { return path_ordering_; }
+    struct PathOrderStats {
+        double travel_before_mm = 0.0;  // summed over the layers, as built and as ordered
+        double travel_after_mm = 0.0;
+        double ms = 0.0;
+    };
+    const PathOrderStats& path_order_stats() const { return path_order_stats_; }
+
+    // One layer as connected polylines at a single z: the walls, then the infill, then any open
+    // chains (cut edges that did not close into a contour), each in print order and tagged with
+    // its PathRole. The segment accessors copy a role's paths out as segment pairs.
     struct LayerPlan {
         float z = 0.0f;
-        std::vector<segment_t> contours;
-        std::vector<segment_t> infill;
+        float thickness = 0.0f;  // mm, LayerSchedule::thickness of the layer's plane
+        PathSet paths;
+
+        PathRange wall_paths() const { return paths.find_run(is_wall); }
+        PathRange infill_paths() const { return paths.find_run([](PathRole role) { return role == PathRole::Infill; }); }
+        PathRange open_chain_paths() const { return paths.find_run([](PathRole role) { return role == PathRole::OpenChain; }); }
+        std::vector<segment_t> contours() const { return paths.segments(z, wall_paths()); }
+        std::vector<segment_t> infill() const { return paths.segments(z, infill_paths()); }
+        std::vector<segment_t> open_chains() const { return paths.segments(z, open_chain_paths()); }
     };
 
+    using LayerCallback = std::function<void(const LayerPlan&)>;
+
+    // Slices straight from the STL file without materializing meshes or the plan: triangles are
+    // read in bounded chunks and binned per layer, per-layer segments spill to a temp file once
+    // they exceed `memory_budget_bytes`, and finished layers go to `on_layer` in z order.
+    // Produces the same layers as set_cad + slice_planar; plan_ and meshes are left untouched.
+    void slice_planar_streaming(const std::filesystem::path& cad_file, float layer_height_mm, float infill_spacing,
+                                std::size_t memory_budget_bytes, const LayerCallback& on_layer) const;
+
+    // Writes the current plan (sliced or loaded) to a plan file; see plan_file.hpp for the
+    // format. The file is written beside `path` and renamed over it, so saving over the plan
+    // that is currently loaded is safe.
+    void save_plan(const std::filesystem::path& path) const;
+    // Streams the current plan (sliced or loaded) out as G-code through a GcodeWriter, staged
+    // and renamed like save_plan; on failure the staging file is removed and `path` is left as
+    // it was. Each layer extrudes for its thickness, which plan files keep, so a plan and the
+    // same plan mapped back from a file give the same G-code.
+    GcodeStats save_gcode(const std::filesystem::path& path, const GcodeOptions& options = {}) const;
+    // Maps a plan file in place of the sliced plan: only the header and layer table are read
+    // up front and get_layer views decode segments straight from the mapping. get_plan() is
+    // empty while a file is loaded; the next slice_planar replaces it.
+    void load_plan(const std::filesystem::path& path);
+    bool plan_is_mapped() const { return plan_file_.has_value(); }
+
     const std::vector<LayerPlan>& get_plan() const { return plan_; }
-    std::size_t layer_count() const { return plan_.size(); }
-    const LayerPlan& get_layer(std::size_t idx) const { return plan_.at(idx); }
-    std::vector<segment_t> get_layer_contours(std::size_t idx) const { return plan_.at(idx).contours; }
-    std::vector<segment_t> get_layer_infill(std::size_t idx) const { return plan_.at(idx).infill; }
+    std::size_t layer_count() const { return plan_file_ ? plan_file_->layer_count() : plan_.size(); }
+    LayerView get_layer(std::size_t idx) const;
+    std::vector<segment_t> get_layer_contours(std::size_t idx) const { return get_layer(idx).contours.to_vector(); }
+    std::vector<segment_t> get_layer_infill(std::size_t idx) const { return get_layer(idx).infill.to_vector(); }
     const std::vector<Mesh>& get_meshes() const { return meshes; }
+    // Union of the meshes' bounds after they are moved onto the build plate.
+    const bbox_t& get_bounds() const { return bounds_; }
+    const std::vector<MeshSoA>& get_soa_meshes() const { return soa_meshes_; }
     const std::vector<std::vector<vec3_t>>& get_raw_layers() const { return raw_layers_; }
     std::vector<vec3_t> get_raw_layer_points(std::size_t idx) const { return raw_layers_.at(idx); }
 
     void run() override {};
 
 private:
-    std::vector<std::vector<segment_t>> populate_layer_lists(const Mesh& mesh, int layer_height_mm) const;
+    // Per-layer stages of build_layer_plan, kept apart so slice_planar can cache each one.
+    struct LayerIslands {
+        std::vector<Island> islands;
+        std::vector<segment_t> open_chains;
+    };
+    struct LayerWalls {
+        PathSet contours;  // each island's outline loops, then its insets
+        std::vector<Island> infill_regions;  // the innermost wall's islands
+        SimplifyStats simplify;
+        std::size_t unsettled_insets = 0;
+    };
+
+    LayerIslands build_layer_islands(std::span<const segment_t> segments) const;
+    LayerWalls build_layer_walls(const LayerIslands& layer, float layer_height_mm) const;
+    // `honeycomb` is the lattice to clip when the pattern is Honeycomb.
+    std::optional<LayerPlan> assemble_layer_plan(const LayerIslands& layer, const LayerWalls& walls, float z,
+                                                 float thickness, std::size_t plane, float infill_spacing,
+                                                 const HoneycombLattice* honeycomb) const;
+    std::optional<LayerPlan> build_layer_plan(std::span<const segment_t> segments, float z, float thickness,
+                                              std::size_t plane, float layer_height_mm, float infill_spacing,
+                                              const HoneycombLattice* honeycomb) const;
     void shift_meshes_to_build_plate();
+    void rebuild_soa_meshes();
 
     std::vector<Mesh> meshes;
+    bbox_t bounds_;
     std::vector<LayerPlan> plan_;
+    std::optional<PlanFile> plan_file_;
     std::vector<std::vector<vec3_t>> raw_layers_;
+    LayerSchedule schedule_;
+    std::size_t num_threads_ = 0;
+    MeshLayout mesh_layout_ = MeshLayout::Indexed;
+    std::vector<MeshSoA> soa_meshes_;
+    float contour_tolerance_ = 0.0f;
+    SimplifyStats simplify_stats_;
+    int perimeter_count_ = 2;
+    OffsetOptions offset_options_;
+    std::size_t unsettled_insets_ = 0;
+    InfillOptions infill_options_;
+    std::optional<HoneycombLattice> honeycomb_;
+    InfillMetrics infill_metrics_;
+    bool path_ordering_ = true;
+    PathOrderStats path_order_stats_;
+
+    struct SliceCache {
+        bool has_islands = false;
+        uint64_t mesh_hash = 0;
+        LayerSchedule schedule;
+        std::vector<LayerIslands> islands;  // indexed like raw_layers_
+
+        bool has_walls = false;
+        float contour_tolerance = 0.0f;
+        int perimeter_count = 0;
+        JoinType join = JoinType::Miter;
+        std::vector<LayerWalls> walls;
+
+        bool has_plan = false;
+        float infill_spacing = 0.0f;
+        InfillOptions infill;
+        bool path_ordering = false;
+    };
+    uint64_t mesh_hash_ = 0;
+    std::function<void(std::size_t)> wall_hook_;
+    SliceCache cache_;
+    SliceCacheStats cache_stats_;
 };
@@ -0,0 +1,100 @@
+// Compact binary motion commands for the Pi <-> Arduino link, in place of ASCII G-code.
+//
+// Frame:   0xA5 | sequence | length | payload (length bytes) | crc16 lo | crc16 hi
+//          CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over sequence, length and payload.
+//          Sequences count up from 0 and wrap; no command spans two frames.
+// Command: one header byte, opcode in the top 3 bits and a feed slot (or control code) in the
+//          low 5, then little-endian operands. Moves carry x/y in um and E in 0.1 um as deltas
+//          from the previous position, so a short segment costs 4 or 7 bytes.
+//
+// Decoding needs no libc, so the same file builds into the kernel and into host tests.
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum {
+    MOTION_SYNC           = 0xA5,
+    MOTION_MAX_PAYLOAD    = 255,
+    MOTION_FRAME_OVERHEAD = 5,     // sync, sequence, length, crc
+    MOTION_FEED_SLOTS     = 32,
+    MOTION_XYZ_PER_MM     = 1000,  // um
+    MOTION_E_PER_MM       = 10000  // 0.1 um of filament
+};
+
+enum {
+    MOTION_OP_MOVE8    = 0, // dx, dy, de: int8 each
+    MOTION_OP_MOVE16   = 1, // dx, dy, de: int16 each
+    MOTION_OP_MOVE32   = 2, // dx, dy, de: int32 each
+    MOTION_OP_TRAVEL16 = 3, // dx, dy: int16 each, no extrusion
+    MOTION_OP_TRAVEL32 = 4, // dx, dy: int32 each
+    MOTION_OP_EXTRUDER = 5, // de: int32, filament only (retraction)
+    MOTION_OP_Z        = 6, // z: int32, absolute
+    MOTION_OP_CONTROL  = 7  // low 5 bits pick one of MOTION_CTRL_*
+};
+
+enum {
+    MOTION_CTRL_FEED    = 0, // slot: uint8, mm/min: uint16; sets a feed slot for later commands
+    MOTION_CTRL_RESET_E = 1, // E is 0 from here on, as G92 E0
+    MOTION_CTRL_END     = 2  // end of the program
+};
+
+// What motion_decoder_next hands back, in absolute coordinates.
+enum {
+    MOTION_CMD_MOVE,     // extruding move to x, y, e
+    MOTION_CMD_TRAVEL,   // move to x, y
+    MOTION_CMD_EXTRUDER, // filament to e
+    MOTION_CMD_Z,        // to z
+    MOTION_CMD_RESET_E,
+    MOTION_CMD_END
+};
+
+typedef struct {
+    int kind;
+    int x, y, z;  // um
+    int e;        // 0.1 um
+    unsigned int feed;  // mm/min, for everything but MOTION_CMD_RESET_E and MOTION_CMD_END
+} motion_cmd_t;
+
+typedef struct {
+    // receive side: the bytes after a frame's sync byte, and ones a rescan has yet to replay
+    int state;
+    unsigned short crc;
+    unsigned int raw_length;
+    unsigned int backlog, backlog_end;
+    unsigned char raw[2 + MOTION_MAX_PAYLOAD + 2];
+
+    // the accepted frame being read, and where the machine is after its last command
+    unsigned int read;
+    unsigned int ready;
+    unsigned char sequence;  // the next frame expected
+    int x, y, z, e;
+    unsigned short feeds[MOTION_FEED_SLOTS];
+
+    unsigned int frames;           // accepted
+    unsigned int crc_errors;
+    unsigned int sequence_errors;  // good frames out of order, dropped
+    unsigned int format_errors;    // malformed commands; the rest of their frame is dropped
+} motion_decoder_t;
+
+unsigned short motion_crc16(unsigned short crc, const unsigned char* data, unsigned int length);
+
+void motion_decoder_init(motion_decoder_t* dec);
+
+// Feeds one received byte. Returns 1 once a frame has passed its CRC and come in sequence; read
+// its commands with motion_decoder_next, until it returns 0, before pushing more. A frame that
+// fails its CRC is searched for the sync byte of the next. A frame out of sequence is dropped,
+// since every later move is relative to the one missed: the sender resends from `sequence` on,
+// and keeps fewer than 256 frames unacknowledged so the 8-bit sequence cannot wrap onto them.
+int motion_decoder_push(motion_decoder_t* dec, unsigned char byte);
+
+// Writes the frame's next command to `cmd` and returns 1, or returns 0 once the frame is done
+// and -1 for a malformed command. Finishing a frame can bring in another from rescanned bytes,
+// whose commands then follow on.
+int motion_decoder_next(motion_decoder_t* dec, motion_cmd_t* cmd);
+
+#ifdef __cplusplus
+}
+#endif
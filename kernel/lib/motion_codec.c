@@ -0,0 +1,200 @@
+// Binary motion command decoder; see motion_codec.h for the format
+#include "../include/motion_codec.h"
+
+enum {
+    RX_SYNC,
+    RX_SEQUENCE,
+    RX_LENGTH,
+    RX_PAYLOAD,
+    RX_CRC_LO,
+    RX_CRC_HI
+};
+
+// CRC-16/CCITT-FALSE a nibble at a time, so the table stays 32 bytes
+static const unsigned short crc_nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+unsigned short motion_crc16(unsigned short crc, const unsigned char* data, unsigned int length) {
+    for (unsigned int i = 0; i < length; i++) {
+        crc = (unsigned short)((crc << 4) ^ crc_nibble[((crc >> 12) ^ (data[i] >> 4)) & 0x0F]);
+        crc = (unsigned short)((crc << 4) ^ crc_nibble[((crc >> 12) ^ (data[i] & 0x0F)) & 0x0F]);
+    }
+    return crc;
+}
+
+static unsigned short crc_byte(unsigned short crc, unsigned char byte) { return motion_crc16(crc, &byte, 1); }
+
+// fields set one by one: a zeroing loop over the struct can compile to a memset the kernel lacks
+void motion_decoder_init(motion_decoder_t* dec) {
+    dec->state = RX_SYNC;
+    dec->raw_length = dec->backlog = dec->backlog_end = 0;
+    dec->read = dec->ready = 0;
+    dec->sequence = 0;
+    dec->x = dec->y = dec->z = dec->e = 0;
+    for (unsigned int i = 0; i < MOTION_FEED_SLOTS; i++) dec->feeds[i] = 0;
+    dec->frames = dec->crc_errors = dec->sequence_errors = dec->format_errors = 0;
+}
+
+// After a CRC failure the bad frame's bytes may hold the start of a good one (noise that looked
+// like a header can swallow it), so they go back through the receiver from the first sync byte
+// among them, ahead of any bytes still waiting from an earlier rescan.
+static void rescan(motion_decoder_t* dec) {
+    const unsigned int length = dec->raw_length;
+    const unsigned int waiting = dec->backlog_end - dec->backlog;
+    for (unsigned int i = 0; i < waiting; i++) dec->raw[length + i] = dec->raw[dec->backlog + i];
+    unsigned int start = 0;
+    while (start < length && dec->raw[start] != MOTION_SYNC) start++;
+    dec->state = RX_SYNC;
+    dec->backlog = start;
+    dec->backlog_end = length + waiting;
+    dec->raw_length = 0;
+}
+
+// One byte through the frame state machine; 1 when it completes an accepted frame. Bytes after
+// the sync are kept in raw, which rescans replay from: the replay reads ahead of where it writes.
+static int receive(motion_decoder_t* dec, unsigned char byte) {
+    if (dec->state == RX_SYNC) {
+        if (byte == MOTION_SYNC) {
+            dec->crc = 0xFFFF;
+            dec->raw_length = 0;
+            dec->state = RX_SEQUENCE;
+        }
+        return 0;
+    }
+    dec->raw[dec->raw_length++] = byte;
+    switch (dec->state) {
+    case RX_SEQUENCE:
+        dec->crc = crc_byte(dec->crc, byte);
+        dec->state = RX_LENGTH;
+        return 0;
+    case RX_LENGTH:
+        dec->crc = crc_byte(dec->crc, byte);
+        dec->state = byte == 0 ? RX_CRC_LO : RX_PAYLOAD;
+        return 0;
+    case RX_PAYLOAD:
+        dec->crc = crc_byte(dec->crc, byte);
+        if (dec->raw_length == 2u + dec->raw[1]) dec->state = RX_CRC_LO;
+        return 0;
+    case RX_CRC_LO:
+        dec->state = RX_CRC_HI;
+        return 0;
+    default:
+        dec->state = RX_SYNC;
+        if ((unsigned short)(dec->raw[dec->raw_length - 2] | (byte << 8)) != dec->crc) {
+            dec->crc_errors++;
+            rescan(dec);
+            return 0;
+        }
+        if (dec->raw[0] != dec->sequence) {
+            dec->sequence_errors++;
+            return 0;
+        }
+        dec->sequence++;
+        dec->frames++;
+        dec->read = 0;
+        dec->ready = dec->raw[1];
+        return 1;
+    }
+}
+
+static int replay(motion_decoder_t* dec) {
+    while (dec->backlog < dec->backlog_end) {
+        if (receive(dec, dec->raw[dec->backlog++])) return 1;
+    }
+    dec->backlog = dec->backlog_end = 0;
+    return 0;
+}
+
+int motion_decoder_push(motion_decoder_t* dec, unsigned char byte) {
+    return receive(dec, byte) || replay(dec);
+}
+
+static int read_i8(const unsigned char* p) { return (signed char)p[0]; }
+static int read_i16(const unsigned char* p) { return (short)(unsigned short)(p[0] | (p[1] << 8)); }
+static int read_i32(const unsigned char* p) {
+    return (int)((unsigned int)p[0] | ((unsigned int)p[1] << 8) | ((unsigned int)p[2] << 16) | ((unsigned int)p[3] << 24));
+}
+
+// operand bytes after each opcode's header
+static const unsigned char operand_bytes[8] = {3, 6, 12, 4, 8, 4, 4, 0};
+
+static int drop_frame(motion_decoder_t* dec) {
+    dec->format_errors++;
+    dec->read = dec->ready;
+    return -1;
+}
+
+int motion_decoder_next(motion_decoder_t* dec, motion_cmd_t* cmd) {
+    unsigned int op, low;
+    const unsigned char* p;
+    // feed slot updates are applied here rather than handed back
+    for (;;) {
+        if (dec->read >= dec->ready) {
+            // done with this frame; any rescanned bytes left may hold the next one
+            dec->read = dec->ready = 0;
+            if (!replay(dec)) return 0;
+        }
+        const unsigned char* payload = dec->raw + 2;
+        const unsigned char header = payload[dec->read];
+        op = header >> 5;
+        low = header & 0x1F;
+        const unsigned int size = op == MOTION_OP_CONTROL && low == MOTION_CTRL_FEED ? 3 : operand_bytes[op];
+        if (dec->read + 1 + size > dec->ready || (op == MOTION_OP_CONTROL && low > MOTION_CTRL_END)) return drop_frame(dec);
+        p = payload + dec->read + 1;
+        dec->read += 1 + size;
+        if (op != MOTION_OP_CONTROL || low != MOTION_CTRL_FEED) break;
+        if (p[0] >= MOTION_FEED_SLOTS) return drop_frame(dec);
+        dec->feeds[p[0]] = (unsigned short)(p[1] | (p[2] << 8));
+    }
+
+    switch (op) {
+    case MOTION_OP_MOVE8:
+        dec->x += read_i8(p);
+        dec->y += read_i8(p + 1);
+        dec->e += read_i8(p + 2);
+        cmd->kind = MOTION_CMD_MOVE;
+        break;
+    case MOTION_OP_MOVE16:
+        dec->x += read_i16(p);
+        dec->y += read_i16(p + 2);
+        dec->e += read_i16(p + 4);
+        cmd->kind = MOTION_CMD_MOVE;
+        break;
+    case MOTION_OP_MOVE32:
+        dec->x += read_i32(p);
+        dec->y += read_i32(p + 4);
+        dec->e += read_i32(p + 8);
+        cmd->kind = MOTION_CMD_MOVE;
+        break;
+    case MOTION_OP_TRAVEL16:
+        dec->x += read_i16(p);
+        dec->y += read_i16(p + 2);
+        cmd->kind = MOTION_CMD_TRAVEL;
+        break;
+    case MOTION_OP_TRAVEL32:
+        dec->x += read_i32(p);
+        dec->y += read_i32(p + 4);
+        cmd->kind = MOTION_CMD_TRAVEL;
+        break;
+    case MOTION_OP_EXTRUDER:
+        dec->e += read_i32(p);
+        cmd->kind = MOTION_CMD_EXTRUDER;
+        break;
+    case MOTION_OP_Z:
+        dec->z = read_i32(p);
+        cmd->kind = MOTION_CMD_Z;
+        break;
+    default:
+        if (low == MOTION_CTRL_RESET_E) dec->e = 0;
+        cmd->kind = low == MOTION_CTRL_RESET_E ? MOTION_CMD_RESET_E : MOTION_CMD_END;
+        break;
+    }
+    cmd->x = dec->x;
+    cmd->y = dec->y;
+    cmd->z = dec->z;
+    cmd->e = dec->e;
+    cmd->feed = op == MOTION_OP_CONTROL ? 0 : dec->feeds[low];
+    return 1;
+}
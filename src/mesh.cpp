@@ -3,4 +3,23 @@
 
 Mesh::Mesh(const std::string cad_filepath) {
     // initialize data structures
-}
\ No newline at end of file
+}
+
+
+void Mesh::update_bounds() {
+    bounds = {};
+    for (const auto& pt : points) {
+        bounds.expand(pt);
+    }
+}
+
+
+void Mesh::translate(const vec3_t& offset) {
+    for (auto& pt : points) {
+        pt = pt + offset;
+    }
+    if (!bounds.empty()) {
+        bounds.min = bounds.min + offset;
+        bounds.max = bounds.max + offset;
+    }
+}
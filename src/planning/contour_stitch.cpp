@@ -0,0 +1,229 @@
+#include "include/planning/contour_stitch.hpp"
+#include "include/planning/polygon_ops.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+
+namespace {
+
+constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+std::size_t table_size_for(std::size_t keys) {
+    std::size_t size = 16;
+    while (size < keys * 2) size <<= 1;
+    return size;
+}
+
+uint64_t mix64(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBULL;
+    return h ^ (h >> 31);
+}
+
+// eps-sized grid cell -> head of the chain of nodes in that cell
+class EndpointTable
+{
+public:
+    EndpointTable(std::size_t max_nodes, float eps)
+        : _slots(table_size_for(max_nodes)), _mask(_slots.size() - 1), _inv_eps(1.0 / eps), _eps(eps)
+    {
+        _nodes.reserve(max_nodes);
+        _next_in_cell.reserve(max_nodes);
+    }
+
+    // Returns the node `p` welds to, adding it if nothing within eps exists.
+    uint32_t insert(const vec3_t& p)
+    {
+        const int64_t cx = cell_of(p.x), cy = cell_of(p.y);
+        uint32_t best = kNone;
+        for (int64_t dy = -1; dy <= 1; ++dy) {
+            for (int64_t dx = -1; dx <= 1; ++dx) {
+                const Slot* s = find(cx + dx, cy + dy);
+                if (!s) continue;
+                for (uint32_t n = s->head; n != kNone; n = _next_in_cell[n]) {
+                    if (n < best && close2d(_nodes[n], p, _eps)) best = n;
+                }
+            }
+        }
+        if (best != kNone) return best;
+
+        const auto index = static_cast<uint32_t>(_nodes.size());
+        _nodes.push_back(p);
+        Slot& s = claim(cx, cy);
+        _next_in_cell.push_back(s.head);
+        s.head = index;
+        return index;
+    }
+
+    const std::vector<vec3_t>& nodes() const { return _nodes; }
+
+private:
+    struct Slot {
+        int64_t x = 0, y = 0;
+        uint32_t head = kNone;
+    };
+
+    int64_t cell_of(float v) const {
+        double scaled = std::floor(static_cast<double>(v) * _inv_eps);
+        // out-of-range and non-finite coordinates share the extreme cells; close2d still decides
+        if (!(scaled > -4.0e18)) return -(int64_t{1} << 62);
+        if (!(scaled < 4.0e18)) return int64_t{1} << 62;
+        return static_cast<int64_t>(scaled);
+    }
+
+    std::size_t slot_for(int64_t x, int64_t y) const {
+        return static_cast<std::size_t>(mix64(static_cast<uint64_t>(x) * 0x9E3779B97F4A7C15ULL ^ static_cast<uint64_t>(y))) & _mask;
+    }
+
+    const Slot* find(int64_t x, int64_t y) const {
+        for (std::size_t i = slot_for(x, y);; i = (i + 1) & _mask) {
+            const Slot& s = _slots[i];
+            if (s.head == kNone) return nullptr;
+            if (s.x == x && s.y == y) return &s;
+        }
+    }
+
+    Slot& claim(int64_t x, int64_t y) {
+        for (std::size_t i = slot_for(x, y);; i = (i + 1) & _mask) {
+            Slot& s = _slots[i];
+            if (s.head == kNone) {
+                s.x = x;
+                s.y = y;
+                return s;
+            }
+            if (s.x == x && s.y == y) return s;
+        }
+    }
+
+    std::vector<Slot> _slots;
+    std::size_t _mask;
+    std::vector<vec3_t> _nodes;
+    std::vector<uint32_t> _next_in_cell;
+    double _inv_eps;
+    float _eps;
+};
+
+// undirected node pair set for dropping repeated edges
+class EdgeSet
+{
+public:
+    explicit EdgeSet(std::size_t max_edges) : _slots(table_size_for(max_edges), kEmpty), _mask(_slots.size() - 1) {}
+
+    bool insert(uint32_t a, uint32_t b)
+    {
+        const uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+        for (std::size_t i = static_cast<std::size_t>(mix64(key)) & _mask;; i = (i + 1) & _mask) {
+            if (_slots[i] == kEmpty) {
+                _slots[i] = key;
+                return true;
+            }
+            if (_slots[i] == key) return false;
+        }
+    }
+
+private:
+    // a == b never reaches the set, so the all-ones pair is free to mark empty slots
+    static constexpr uint64_t kEmpty = std::numeric_limits<uint64_t>::max();
+
+    std::vector<uint64_t> _slots;
+    std::size_t _mask;
+};
+
+} // namespace
+
+
+StitchResult stitch_contours(std::span<const segment_t> segments, float eps) {
+    StitchResult result;
+    if (segments.empty()) return result;
+
+    EndpointTable table(2 * segments.size(), eps);
+    EdgeSet seen(segments.size());
+    std::vector<uint32_t> edge_a, edge_b;
+    edge_a.reserve(segments.size());
+    edge_b.reserve(segments.size());
+    for (const auto& seg : segments) {
+        uint32_t a = table.insert(seg.first);
+        uint32_t b = table.insert(seg.second);
+        if (a == b || !seen.insert(a, b)) continue;
+        edge_a.push_back(a);
+        edge_b.push_back(b);
+    }
+    const auto& nodes = table.nodes();
+    const std::size_t num_edges = edge_a.size();
+
+    // CSR adjacency, each node's edges in input order
+    std::vector<uint32_t> adj_start(nodes.size() + 1, 0);
+    for (std::size_t e = 0; e < num_edges; ++e) {
+        adj_start[edge_a[e] + 1]++;
+        adj_start[edge_b[e] + 1]++;
+    }
+    for (std::size_t n = 1; n < adj_start.size(); ++n) adj_start[n] += adj_start[n - 1];
+    std::vector<uint32_t> adj_edges(adj_start.back());
+    std::vector<uint32_t> fill(adj_start.begin(), adj_start.end() - 1);
+    for (std::size_t e = 0; e < num_edges; ++e) {
+        adj_edges[fill[edge_a[e]]++] = static_cast<uint32_t>(e);
+        adj_edges[fill[edge_b[e]]++] = static_cast<uint32_t>(e);
+    }
+
+    // `fill` becomes each node's first possibly-unused adjacency slot; used edges at the front of
+    // a node's list are skipped once, which keeps the whole walk linear
+    std::copy(adj_start.begin(), adj_start.end() - 1, fill.begin());
+    std::vector<bool> used(num_edges, false);
+    auto other_end = [&](uint32_t e, uint32_t n) { return edge_a[e] == n ? edge_b[e] : edge_a[e]; };
+    auto choose_next_edge = [&](uint32_t vertex, uint32_t prev_vertex) {
+        uint32_t& first = fill[vertex];
+        while (first < adj_start[vertex + 1] && used[adj_edges[first]]) ++first;
+        uint32_t fallback = kNone;
+        for (uint32_t i = first; i < adj_start[vertex + 1]; ++i) {
+            uint32_t e = adj_edges[i];
+            if (used[e]) continue;
+            if (other_end(e, vertex) != prev_vertex) return e;
+            fallback = e;
+        }
+        return fallback;
+    };
+    // walks from `current` until a dead end or `stop`; returns true when it reached `stop`
+    auto walk = [&](std::vector<uint32_t>& path, uint32_t prev_vertex, uint32_t current, uint32_t stop) {
+        while (true) {
+            uint32_t e = choose_next_edge(current, prev_vertex);
+            if (e == kNone) return false;
+            used[e] = true;
+            uint32_t next_vertex = other_end(e, current);
+            path.push_back(next_vertex);
+            if (next_vertex == stop) return true;
+            prev_vertex = current;
+            current = next_vertex;
+        }
+    };
+
+    std::vector<uint32_t> path, back;
+    for (std::size_t start_edge = 0; start_edge < num_edges; ++start_edge) {
+        if (used[start_edge]) continue;
+        used[start_edge] = true;
+        const uint32_t start = edge_a[start_edge];
+        path.assign({start, edge_b[start_edge]});
+
+        if (walk(path, start, path.back(), start)) {
+            if (path.size() >= 4) {
+                polygon_t& loop = result.loops.emplace_back();
+                loop.reserve(path.size());
+                for (uint32_t n : path) loop.push_back(nodes[n]);
+            }
+            continue;
+        }
+
+        // open: pick up whatever hangs off the start too, then report the chain end to end
+        back.clear();
+        walk(back, path[1], start, kNone);
+        polygon_t& chain = result.open_chains.emplace_back();
+        chain.reserve(back.size() + path.size());
+        for (auto it = back.rbegin(); it != back.rend(); ++it) chain.push_back(nodes[*it]);
+        for (uint32_t n : path) chain.push_back(nodes[n]);
+    }
+
+    return result;
+}
@@ -0,0 +1,261 @@
+#include "include/planning/gcode_writer.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr std::size_t kMaxLineBytes = 256;  // a move line stays well under this
+constexpr int kXyDecimals = 3;  // 1 um, the plan file's resolution
+constexpr int kEDecimals = 5;
+constexpr int64_t kPow10[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+constexpr char kSetup[] = "; generated by the printer path planner\nG21\nG90\nM82\nG92 E0\n";
+
+} // namespace
+
+
+void check_gcode_options(const GcodeOptions& options) {
+    auto positive = [](float v) { return v > 0.0f && std::isfinite(v); };
+    if (!positive(options.line_width) || !positive(options.filament_diameter) || !positive(options.extrusion_multiplier) ||
+        !positive(options.print_speed) || !positive(options.travel_speed) || !positive(options.retract_speed)) {
+        throw std::runtime_error("G-code widths, speeds and extrusion multiplier must be positive");
+    }
+    if (!(options.retract_length >= 0.0f) || !(options.retract_min_travel >= 0.0f) || !(options.merge_tolerance >= 0.0f)) {
+        throw std::runtime_error("G-code retraction and merge tolerance must not be negative");
+    }
+}
+
+double extrusion_per_mm(const GcodeOptions& options, float height) {
+    if (!(height > 0.0f)) return 0.0;
+    const double w = options.line_width, h = height;
+    const double bead = h < w ? (w - h) * h + kPi * h * h / 4.0 : w * h;
+    const double filament = kPi * options.filament_diameter * options.filament_diameter / 4.0;
+    return bead / filament * options.extrusion_multiplier;
+}
+
+GcodeWriter::GcodeWriter(const std::filesystem::path& path, const GcodeOptions& options)
+    : _options(options), _buffer(new char[kBufferBytes])
+{
+    check_gcode_options(options);
+    _fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (_fd < 0) throw std::runtime_error("Failed to open G-code file for writing: " + path.string());
+    _owns_fd = true;
+    put(kSetup, sizeof(kSetup) - 1);
+    put(_options.start_gcode);
+}
+
+GcodeWriter::GcodeWriter(int fd, const GcodeOptions& options)
+    : _options(options), _fd(fd), _buffer(new char[kBufferBytes])
+{
+    check_gcode_options(options);
+    if (fd < 0) throw std::runtime_error("Invalid descriptor for G-code output");
+    put(kSetup, sizeof(kSetup) - 1);
+    put(_options.start_gcode);
+}
+
+GcodeWriter::~GcodeWriter() {
+    if (_owns_fd && _fd >= 0) ::close(_fd);
+}
+
+void GcodeWriter::add_layer(float z, float height, const PathSet& paths) {
+    begin_layer(z, height);
+    for (std::size_t p = 0; p < paths.path_count(); ++p) {
+        const auto path = paths.path(p);
+        if (path.role == PathRole::OpenChain) continue;
+        travel_to(path.points[0].x, path.points[0].y);
+        for (std::size_t k = 1; k < path.points.size(); ++k) extrude_to(path.points[k].x, path.points[k].y);
+    }
+}
+
+void GcodeWriter::add_layer(float z, float height, const SegmentView& walls, const SegmentView& infill) {
+    begin_layer(z, height);
+    for (const SegmentView* view : {&walls, &infill}) {
+        for (std::size_t i = 0; i < view->size(); ++i) {
+            const segment_t seg = (*view)[i];
+            travel_to(seg.first.x, seg.first.y);
+            extrude_to(seg.second.x, seg.second.y);
+        }
+    }
+}
+
+void GcodeWriter::finish() {
+    if (_finished) return;
+    flush_extrusion();
+    put(_options.end_gcode);
+    flush_buffer();
+    _finished = true;
+    if (_owns_fd) {
+        const int fd = _fd;
+        _fd = -1;
+        if (::close(fd) != 0) throw std::runtime_error("Failed to close G-code file");
+    }
+}
+
+void GcodeWriter::begin_layer(float z, float height) {
+    if (_finished) throw std::runtime_error("G-code writer already finished");
+    flush_extrusion();
+    static constexpr char kLayer[] = ";LAYER:";
+    put(kLayer, sizeof(kLayer) - 1);
+    char digits[24];
+    put(digits, static_cast<std::size_t>(std::to_chars(digits, digits + sizeof(digits), _stats.layers).ptr - digits));
+    end_line();
+    static constexpr char kReset[] = "G92 E0";
+    put(kReset, sizeof(kReset) - 1);
+    end_line();
+    _stats.layers++;
+    _z = z;
+    _z_pending = true;
+    _e = 0.0;
+    _e_per_mm = extrusion_per_mm(_options, height);
+}
+
+// The first travel of a layer also moves to its z, retracted, as a layer change always is.
+void GcodeWriter::travel_to(float x, float y) {
+    if (_has_position && x == _x && y == _y && !_z_pending) return;
+    flush_extrusion();
+    const double distance = _has_position ? std::hypot(static_cast<double>(x) - _x, static_cast<double>(y) - _y) : 0.0;
+    const bool retract = _has_position && _options.retract_length > 0.0f &&
+                         (_z_pending || distance >= _options.retract_min_travel);
+    if (retract) {
+        put("G1", 2);
+        put_feed(_options.retract_speed);
+        put_value('E', _e - _options.retract_length, kEDecimals);
+        end_line();
+        _stats.retractions++;
+    }
+    put("G0", 2);
+    put_feed(_options.travel_speed);
+    put_value('X', x, kXyDecimals);
+    put_value('Y', y, kXyDecimals);
+    if (_z_pending) put_value('Z', _z, kXyDecimals);
+    _z_pending = false;
+    end_line();
+    if (retract) {
+        put("G1", 2);
+        put_feed(_options.retract_speed);
+        put_value('E', _e, kEDecimals);
+        end_line();
+    }
+    _stats.travels++;
+    _stats.travel_mm += distance;
+    _has_position = true;
+    _x = x;
+    _y = y;
+}
+
+void GcodeWriter::extrude_to(float x, float y) {
+    const double dx = static_cast<double>(x) - _x, dy = static_cast<double>(y) - _y;
+    const double length = std::hypot(dx, dy);
+    if (length == 0.0) return;
+    if (_pending) {
+        // off the run's line by no more than the tolerance, and still heading along it
+        const double rx = static_cast<double>(x) - _run_x, ry = static_cast<double>(y) - _run_y;
+        if (std::abs(rx * _dir_y - ry * _dir_x) <= _options.merge_tolerance && dx * _dir_x + dy * _dir_y > 0.0) {
+            _stats.merged++;
+        } else {
+            flush_extrusion();
+        }
+    }
+    if (!_pending) {
+        _pending = true;
+        _run_x = _x;
+        _run_y = _y;
+        _dir_x = dx / length;
+        _dir_y = dy / length;
+    }
+    _e += length * _e_per_mm;
+    _stats.extruded_mm += length;
+    _stats.filament_mm += length * _e_per_mm;
+    _x = x;
+    _y = y;
+}
+
+void GcodeWriter::flush_extrusion() {
+    if (!_pending) return;
+    _pending = false;
+    put("G1", 2);
+    put_feed(_options.print_speed);
+    put_value('X', _x, kXyDecimals);
+    put_value('Y', _y, kXyDecimals);
+    put_value('E', _e, kEDecimals);
+    end_line();
+    _stats.extrusions++;
+}
+
+void GcodeWriter::put(const char* text, std::size_t length) {
+    while (length > 0) {
+        if (_used == kBufferBytes) flush_buffer();
+        const std::size_t chunk = std::min(length, kBufferBytes - _used);
+        std::memcpy(_buffer.get() + _used, text, chunk);
+        _used += chunk;
+        text += chunk;
+        length -= chunk;
+    }
+    if (kBufferBytes - _used < kMaxLineBytes) flush_buffer();
+}
+
+void GcodeWriter::put_feed(float mm_per_s) {
+    if (mm_per_s == _feed) return;
+    _feed = mm_per_s;
+    put_value('F', static_cast<double>(mm_per_s) * 60.0, 0);
+}
+
+// Rounds to `decimals` places as a scaled integer, so formatting is two integer conversions;
+// trailing zeros are trimmed.
+void GcodeWriter::put_value(char axis, double value, int decimals) {
+    const double scaled = std::round(value * static_cast<double>(kPow10[decimals]));
+    if (!(std::abs(scaled) < 9e15)) throw std::runtime_error("G-code value out of range");
+    char* out = _buffer.get() + _used;
+    *out++ = ' ';
+    *out++ = axis;
+    int64_t units = static_cast<int64_t>(scaled);
+    if (units < 0) {
+        *out++ = '-';
+        units = -units;
+    }
+    out = std::to_chars(out, out + 20, units / kPow10[decimals]).ptr;
+    int64_t fraction = units % kPow10[decimals];
+    if (fraction != 0) {
+        int digits = decimals;
+        while (fraction % 10 == 0) {
+            fraction /= 10;
+            --digits;
+        }
+        *out++ = '.';
+        char* end = out + digits;
+        for (char* d = end; d != out; fraction /= 10) *--d = static_cast<char>('0' + fraction % 10);
+        out = end;
+    }
+    _used = static_cast<std::size_t>(out - _buffer.get());
+}
+
+void GcodeWriter::end_line() {
+    _buffer[_used++] = '\n';
+    _stats.lines++;
+    if (kBufferBytes - _used < kMaxLineBytes) flush_buffer();
+}
+
+void GcodeWriter::flush_buffer() {
+    std::size_t done = 0;
+    while (done < _used) {
+        const ssize_t n = ::write(_fd, _buffer.get() + done, _used - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("Failed to write G-code");
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    _stats.bytes += _used;
+    _used = 0;
+}
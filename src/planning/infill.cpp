@@ -0,0 +1,249 @@
+#include "include/planning/infill.hpp"
+#include "include/planning/polygon_ops.hpp"
+#include "include/planning/scanline.hpp"
+#include "include/planning/tpms.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+constexpr double kDegToRad = 3.14159265358979323846 / 180.0;
+
+// Points rotated by -angle: a line at `angle` from +x runs along x in this frame.
+struct LineFrame {
+    float cos_a = 1.0f;
+    float sin_a = 0.0f;
+
+    explicit LineFrame(float angle_deg) {
+        const double radians = static_cast<double>(angle_deg) * kDegToRad;
+        cos_a = static_cast<float>(std::cos(radians));
+        sin_a = static_cast<float>(std::sin(radians));
+    }
+
+    polygon_t to_local(const polygon_t& loop) const {
+        polygon_t local;
+        local.reserve(loop.size());
+        for (const auto& p : loop) local.push_back({p.x * cos_a + p.y * sin_a, p.y * cos_a - p.x * sin_a, p.z});
+        return local;
+    }
+
+    vec3_t to_world(float u, float v, float z) const {
+        return {u * cos_a - v * sin_a, u * sin_a + v * cos_a, z};
+    }
+};
+
+// Scans the island at every y `next_line` yields and hands each clipped span to `emit`.
+template <typename NextLine, typename Emit>
+void scan_island(const polygon_t& outer, const std::vector<polygon_t>& holes, NextLine&& next_line, Emit&& emit) {
+    ScanlineEdgeTable table;
+    table.add_loop(outer);  // loop 0
+    for (const auto& hole : holes) table.add_loop(hole);
+
+    std::vector<Span> spans, hole_spans;
+    for (float y; next_line(y);) {
+        table.advance(y);
+        const auto& loop_spans = table.loop_spans();
+        spans.clear();
+        std::size_t i = 0;
+        for (; i < loop_spans.size() && loop_spans[i].loop == 0; ++i) {
+            spans.emplace_back(loop_spans[i].x0, loop_spans[i].x1);
+        }
+        // holes are subtracted one at a time and in order, each with its own kMinSpan trimming
+        while (i < loop_spans.size() && !spans.empty()) {
+            const uint32_t hole = loop_spans[i].loop;
+            hole_spans.clear();
+            for (; i < loop_spans.size() && loop_spans[i].loop == hole; ++i) {
+                hole_spans.emplace_back(loop_spans[i].x0, loop_spans[i].x1);
+            }
+            spans = subtract_spans(std::move(spans), hole_spans);
+        }
+        for (const auto& span : spans) emit(span, y);
+    }
+}
+
+} // namespace
+
+
+std::vector<segment_t> clip_infill(const polygon_t& outer, const std::vector<polygon_t>& holes, float spacing, float z) {
+    return clip_infill(outer, holes, spacing, 0.0f, LineAnchor::Island, z);
+}
+
+std::vector<segment_t> clip_infill(const polygon_t& outer, const std::vector<polygon_t>& holes, float spacing,
+                                   float angle_deg, LineAnchor anchor, float z) {
+    std::vector<segment_t> infill;
+    if (outer.empty() || !(spacing > 0.0f)) return infill;
+
+    // axis-aligned lines skip the round trip through the rotated frame
+    const bool rotated = angle_deg != 0.0f;
+    const LineFrame frame(angle_deg);
+    std::vector<polygon_t> local_holes;
+    const polygon_t local_outer = rotated ? frame.to_local(outer) : polygon_t{};
+    if (rotated) {
+        local_holes.reserve(holes.size());
+        for (const auto& hole : holes) local_holes.push_back(frame.to_local(hole));
+    }
+    const polygon_t& scan_outer = rotated ? local_outer : outer;
+    const std::vector<polygon_t>& scan_holes = rotated ? local_holes : holes;
+
+    Bounds bounds = bounds_for_polygon(scan_outer);
+    if (bounds.empty()) return infill;
+
+    auto emit = [&](const Span& span, float y) {
+        if (rotated) {
+            infill.push_back({frame.to_world(span.first, y, z), frame.to_world(span.second, y, z)});
+        } else {
+            infill.push_back({{span.first, y, z}, {span.second, y, z}});
+        }
+    };
+    if (anchor == LineAnchor::Island) {
+        bool first = true;
+        float y = bounds.min_y;
+        scan_island(scan_outer, scan_holes, [&](float& line) {
+            if (!first) y += spacing;
+            first = false;
+            line = y;
+            return y <= bounds.max_y + kSnapEps;
+        }, emit);
+    } else {
+        // each line is k * spacing, never accumulated, so islands agree on where lines fall
+        auto k = static_cast<long>(std::ceil(bounds.min_y / spacing));
+        scan_island(scan_outer, scan_holes, [&](float& line) {
+            line = static_cast<float>(k++) * spacing;
+            return line <= bounds.max_y + kSnapEps;
+        }, emit);
+    }
+    return infill;
+}
+
+HoneycombLattice::HoneycombLattice(float spacing, float angle_deg, const Bounds& footprint)
+    : _spacing(spacing), _angle_deg(angle_deg), _footprint(footprint) {
+    const vec3_t corners[4] = {{footprint.min_x, footprint.min_y, 0.0f}, {footprint.max_x, footprint.min_y, 0.0f},
+                               {footprint.max_x, footprint.max_y, 0.0f}, {footprint.min_x, footprint.max_y, 0.0f}};
+    Bounds local[3];
+    for (int f = 0; f < 3; ++f) {
+        // the lattice is unchanged by a turn of 60 degrees, so each family is the first one turned
+        _families[f] = {angle_deg + 90.0f + 60.0f * static_cast<float>(f), 0, -1};
+        if (footprint.empty() || !(spacing > 0.0f)) continue;
+        const LineFrame frame(_families[f].angle_deg);
+        for (const auto& p : frame.to_local(polygon_t(corners, corners + 4))) {
+            local[f].min_x = std::min(local[f].min_x, p.x - spacing);
+            local[f].max_x = std::max(local[f].max_x, p.x + spacing);
+            local[f].min_y = std::min(local[f].min_y, p.y - spacing);
+            local[f].max_y = std::max(local[f].max_y, p.y + spacing);
+        }
+        _families[f].first_line = static_cast<long>(std::ceil(local[f].min_y / spacing));
+        _families[f].last_line = static_cast<long>(std::floor(local[f].max_y / spacing));
+    }
+    if (footprint.empty() || !(spacing > 0.0f)) return;
+
+    // along a line k, dashes of one side are centred every 3 sides, offset by 1.5 sides when k is even
+    const double side = 2.0 * static_cast<double>(spacing) / std::sqrt(3.0);
+    const double period = 3.0 * side;
+    const float u_min = std::min({local[0].min_x, local[1].min_x, local[2].min_x});
+    const float u_max = std::max({local[0].max_x, local[1].max_x, local[2].max_x});
+    for (int parity = 0; parity < 2; ++parity) {
+        const double offset = parity == 0 ? 1.5 * side : 0.0;
+        const auto first = static_cast<long>(std::floor((u_min - offset - 0.5 * side) / period));
+        const auto last = static_cast<long>(std::ceil((u_max - offset + 0.5 * side) / period));
+        _rows[parity].reserve(static_cast<std::size_t>(last - first + 1));
+        for (long m = first; m <= last; ++m) {
+            const double centre = static_cast<double>(m) * period + offset;
+            _rows[parity].emplace_back(static_cast<float>(centre - 0.5 * side), static_cast<float>(centre + 0.5 * side));
+        }
+    }
+    for (int f = 0; f < 3; ++f) {
+        for (long k = _families[f].first_line; k <= _families[f].last_line; ++k) {
+            const auto& row = _rows[k & 1];
+            auto lo = std::lower_bound(row.begin(), row.end(), local[f].min_x,
+                                       [](const Span& dash, float u) { return dash.second < u; });
+            auto hi = std::lower_bound(lo, row.end(), local[f].max_x,
+                                       [](const Span& dash, float u) { return dash.first <= u; });
+            _segment_count += static_cast<std::size_t>(hi - lo);
+        }
+    }
+}
+
+bool HoneycombLattice::covers(const Bounds& bounds) const {
+    return !_footprint.empty() && bounds.min_x >= _footprint.min_x && bounds.max_x <= _footprint.max_x &&
+           bounds.min_y >= _footprint.min_y && bounds.max_y <= _footprint.max_y;
+}
+
+std::vector<segment_t> HoneycombLattice::clip(const polygon_t& outer, const std::vector<polygon_t>& holes, float z) const {
+    std::vector<segment_t> infill;
+    if (outer.empty() || _rows[0].empty()) return infill;
+
+    std::vector<polygon_t> local_holes;
+    for (const auto& family : _families) {
+        const LineFrame frame(family.angle_deg);
+        const polygon_t local_outer = frame.to_local(outer);
+        local_holes.clear();
+        for (const auto& hole : holes) local_holes.push_back(frame.to_local(hole));
+        Bounds bounds = bounds_for_polygon(local_outer);
+        if (bounds.empty()) continue;
+
+        // lines sit at k * spacing like LineAnchor::Lattice, so each family matches clip_infill's
+        long k = std::max(static_cast<long>(std::ceil(bounds.min_y / _spacing)), family.first_line);
+        long line_k = k;
+        scan_island(local_outer, local_holes, [&](float& line) {
+            line_k = k++;
+            line = static_cast<float>(line_k) * _spacing;
+            return line_k <= family.last_line && line <= bounds.max_y + kSnapEps;
+        }, [&](const Span& span, float y) {
+            const auto& row = _rows[line_k & 1];
+            auto dash = std::lower_bound(row.begin(), row.end(), span.first,
+                                         [](const Span& d, float u) { return d.second < u; });
+            for (; dash != row.end() && dash->first < span.second; ++dash) {
+                const float u0 = std::max(dash->first, span.first);
+                const float u1 = std::min(dash->second, span.second);
+                if (u1 - u0 > kMinSpan) infill.push_back({frame.to_world(u0, y, z), frame.to_world(u1, y, z)});
+            }
+        });
+    }
+    return infill;
+}
+
+std::vector<float> infill_angles(const InfillOptions& options, std::size_t plane) {
+    const float a = options.angle_deg;
+    switch (options.pattern) {
+    case InfillPattern::Rectilinear:
+        return {a};
+    case InfillPattern::Crosshatch:
+        return {plane % 2 == 0 ? a : a + 90.0f};
+    case InfillPattern::Grid:
+        return {a, a + 90.0f};
+    case InfillPattern::Triangles:
+        return {a, a + 60.0f, a + 120.0f};
+    case InfillPattern::Gyroid:
+    case InfillPattern::SchwarzP:
+    case InfillPattern::SchwarzD:
+        return {};
+    case InfillPattern::Honeycomb:
+        return {a + 90.0f, a + 150.0f, a + 210.0f};
+    }
+    return {a};
+}
+
+std::vector<segment_t> pattern_infill(const polygon_t& outer, const std::vector<polygon_t>& holes, float spacing,
+                                      const InfillOptions& options, std::size_t plane, float z) {
+    switch (options.pattern) {
+    case InfillPattern::Gyroid: return tpms_infill(outer, holes, TpmsSurface::Gyroid, spacing, z);
+    case InfillPattern::SchwarzP: return tpms_infill(outer, holes, TpmsSurface::SchwarzP, spacing, z);
+    case InfillPattern::SchwarzD: return tpms_infill(outer, holes, TpmsSurface::SchwarzD, spacing, z);
+    case InfillPattern::Honeycomb:
+        if (outer.empty() || !(spacing > 0.0f)) return {};
+        return HoneycombLattice(spacing, options.angle_deg, bounds_for_polygon(outer)).clip(outer, holes, z);
+    default: break;
+    }
+    const auto angles = infill_angles(options, plane);
+    if (angles.size() == 1) return clip_infill(outer, holes, spacing, angles[0], LineAnchor::Island, z);
+
+    std::vector<segment_t> infill;
+    const float family_spacing = spacing * static_cast<float>(angles.size());
+    for (float angle : angles) {
+        auto lines = clip_infill(outer, holes, family_spacing, angle, LineAnchor::Lattice, z);
+        infill.insert(infill.end(), lines.begin(), lines.end());
+    }
+    return infill;
+}
@@ -0,0 +1,353 @@
+#include "include/planning/intersect_kernel.hpp"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PRINTER_HAS_AVX2_KERNEL 1
+#endif
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define PRINTER_HAS_NEON_KERNEL 1
+#endif
+
+// The vector kernels must round exactly like the scalar one, so no multiply-add fusion here.
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#endif
+
+
+namespace {
+
+float dist2d_sq(const vec3_t& a, const vec3_t& b) {
+    float dx = a.x - b.x;
+    float dy = a.y - b.y;
+    return dx * dx + dy * dy;
+}
+
+bool close2d(const vec3_t& a, const vec3_t& b, float eps) {
+    return dist2d_sq(a, b) <= eps * eps;
+}
+
+void intersect_lane(const TriangleBlock& block, std::size_t i, float z_plane, segment_t* out, uint8_t* counts) {
+    vec3_t v0{block.x[0][i], block.y[0][i], block.z[0][i]};
+    vec3_t v1{block.x[1][i], block.y[1][i], block.z[1][i]};
+    vec3_t v2{block.x[2][i], block.y[2][i], block.z[2][i]};
+    counts[i] = static_cast<uint8_t>(intersect_triangle_into(v0, v1, v2, z_plane, out + i * kMaxTriangleSegments));
+}
+
+void intersect_block_scalar(const TriangleBlock& block, float z_plane, segment_t* out, uint8_t* counts) {
+    for (std::size_t i = 0; i < block.count; ++i) {
+        intersect_lane(block, i, z_plane, out, counts);
+    }
+}
+
+// Writes one vector lane's result: the scalar path for special lanes, otherwise the joined
+// crossing points of the two edges that change sign (or nothing).
+inline void finish_lane(const TriangleBlock& block, std::size_t i, float z_plane, bool special, bool keep,
+                        float first_x, float first_y, float second_x, float second_y,
+                        segment_t* out, uint8_t* counts) {
+    if (special) {
+        intersect_lane(block, i, z_plane, out, counts);
+    } else if (keep) {
+        out[i * kMaxTriangleSegments] = {{first_x, first_y, z_plane}, {second_x, second_y, z_plane}};
+        counts[i] = 1;
+    } else {
+        counts[i] = 0;
+    }
+}
+
+#if defined(PRINTER_HAS_AVX2_KERNEL)
+// regular: clearly off the plane and finite, so only sign changes matter
+__attribute__((target("avx2")))
+inline __m256 avx2_regular(__m256 d, __m256 eps, __m256 max_finite) {
+    __m256 magnitude = _mm256_and_ps(d, _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)));
+    return _mm256_and_ps(_mm256_cmp_ps(magnitude, eps, _CMP_GE_OQ), _mm256_cmp_ps(magnitude, max_finite, _CMP_LE_OQ));
+}
+
+// same expression shape as the scalar kernel: a + t * (b - a), t = da / (da - db)
+__attribute__((target("avx2")))
+inline __m256 avx2_lerp(__m256 a, __m256 b, __m256 t) {
+    return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+}
+
+__attribute__((target("avx2")))
+void intersect_block_avx2(const TriangleBlock& block, float z_plane, segment_t* out, uint8_t* counts) {
+    const __m256 plane = _mm256_set1_ps(z_plane);
+    const __m256 eps = _mm256_set1_ps(kPlaneEps);
+    const __m256 eps_sq = _mm256_set1_ps(kPlaneEps * kPlaneEps);
+    const __m256 max_finite = _mm256_set1_ps(std::numeric_limits<float>::max());
+    const __m256 zero = _mm256_setzero_ps();
+
+    std::size_t i = 0;
+    for (; i + 8 <= block.count; i += 8) {
+        __m256 x0 = _mm256_loadu_ps(block.x[0] + i);
+        __m256 x1 = _mm256_loadu_ps(block.x[1] + i);
+        __m256 x2 = _mm256_loadu_ps(block.x[2] + i);
+        __m256 y0 = _mm256_loadu_ps(block.y[0] + i);
+        __m256 y1 = _mm256_loadu_ps(block.y[1] + i);
+        __m256 y2 = _mm256_loadu_ps(block.y[2] + i);
+        __m256 d0 = _mm256_sub_ps(_mm256_loadu_ps(block.z[0] + i), plane);
+        __m256 d1 = _mm256_sub_ps(_mm256_loadu_ps(block.z[1] + i), plane);
+        __m256 d2 = _mm256_sub_ps(_mm256_loadu_ps(block.z[2] + i), plane);
+
+        __m256 ok = _mm256_and_ps(avx2_regular(d0, eps, max_finite),
+                                  _mm256_and_ps(avx2_regular(d1, eps, max_finite), avx2_regular(d2, eps, max_finite)));
+        __m256 n0 = _mm256_cmp_ps(d0, zero, _CMP_LT_OQ);
+        __m256 n1 = _mm256_cmp_ps(d1, zero, _CMP_LT_OQ);
+        __m256 n2 = _mm256_cmp_ps(d2, zero, _CMP_LT_OQ);
+        __m256 c01 = _mm256_xor_ps(n0, n1);
+        __m256 c12 = _mm256_xor_ps(n1, n2);
+        __m256 c20 = _mm256_xor_ps(n2, n0);
+
+        __m256 t01 = _mm256_div_ps(d0, _mm256_sub_ps(d0, d1));
+        __m256 t12 = _mm256_div_ps(d1, _mm256_sub_ps(d1, d2));
+        __m256 t20 = _mm256_div_ps(d2, _mm256_sub_ps(d2, d0));
+
+        // with exactly two crossing edges the scalar kernel visits them in 01, 12, 20 order
+        __m256 p12x = avx2_lerp(x1, x2, t12);
+        __m256 p12y = avx2_lerp(y1, y2, t12);
+        __m256 first_x = _mm256_blendv_ps(p12x, avx2_lerp(x0, x1, t01), c01);
+        __m256 first_y = _mm256_blendv_ps(p12y, avx2_lerp(y0, y1, t01), c01);
+        __m256 second_x = _mm256_blendv_ps(p12x, avx2_lerp(x2, x0, t20), c20);
+        __m256 second_y = _mm256_blendv_ps(p12y, avx2_lerp(y2, y0, t20), c20);
+
+        __m256 dx = _mm256_sub_ps(first_x, second_x);
+        __m256 dy = _mm256_sub_ps(first_y, second_y);
+        __m256 close = _mm256_cmp_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), eps_sq, _CMP_LE_OQ);
+        __m256 crossing = _mm256_or_ps(c01, _mm256_or_ps(c12, c20));
+        int keep_bits = _mm256_movemask_ps(_mm256_andnot_ps(close, crossing));
+        int special_bits = ~_mm256_movemask_ps(ok) & 0xff;
+
+        alignas(32) float fx[8], fy[8], sx[8], sy[8];
+        _mm256_store_ps(fx, first_x);
+        _mm256_store_ps(fy, first_y);
+        _mm256_store_ps(sx, second_x);
+        _mm256_store_ps(sy, second_y);
+        for (std::size_t lane = 0; lane < 8; ++lane) {
+            finish_lane(block, i + lane, z_plane, (special_bits >> lane) & 1, (keep_bits >> lane) & 1,
+                        fx[lane], fy[lane], sx[lane], sy[lane], out, counts);
+        }
+    }
+    for (; i < block.count; ++i) {
+        intersect_lane(block, i, z_plane, out, counts);
+    }
+}
+#endif
+
+#if defined(PRINTER_HAS_NEON_KERNEL)
+void intersect_block_neon(const TriangleBlock& block, float z_plane, segment_t* out, uint8_t* counts) {
+    const float32x4_t plane = vdupq_n_f32(z_plane);
+    const float32x4_t eps = vdupq_n_f32(kPlaneEps);
+    const float32x4_t eps_sq = vdupq_n_f32(kPlaneEps * kPlaneEps);
+    const float32x4_t max_finite = vdupq_n_f32(std::numeric_limits<float>::max());
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+
+    auto regular = [&](float32x4_t d) {
+        float32x4_t magnitude = vabsq_f32(d);
+        return vandq_u32(vcgeq_f32(magnitude, eps), vcleq_f32(magnitude, max_finite));
+    };
+    auto lerp = [](float32x4_t a, float32x4_t b, float32x4_t t) { return vaddq_f32(a, vmulq_f32(t, vsubq_f32(b, a))); };
+
+    std::size_t i = 0;
+    for (; i + 4 <= block.count; i += 4) {
+        float32x4_t x0 = vld1q_f32(block.x[0] + i);
+        float32x4_t x1 = vld1q_f32(block.x[1] + i);
+        float32x4_t x2 = vld1q_f32(block.x[2] + i);
+        float32x4_t y0 = vld1q_f32(block.y[0] + i);
+        float32x4_t y1 = vld1q_f32(block.y[1] + i);
+        float32x4_t y2 = vld1q_f32(block.y[2] + i);
+        float32x4_t d0 = vsubq_f32(vld1q_f32(block.z[0] + i), plane);
+        float32x4_t d1 = vsubq_f32(vld1q_f32(block.z[1] + i), plane);
+        float32x4_t d2 = vsubq_f32(vld1q_f32(block.z[2] + i), plane);
+
+        uint32x4_t ok = vandq_u32(regular(d0), vandq_u32(regular(d1), regular(d2)));
+        uint32x4_t n0 = vcltq_f32(d0, zero);
+        uint32x4_t n1 = vcltq_f32(d1, zero);
+        uint32x4_t n2 = vcltq_f32(d2, zero);
+        uint32x4_t c01 = veorq_u32(n0, n1);
+        uint32x4_t c12 = veorq_u32(n1, n2);
+        uint32x4_t c20 = veorq_u32(n2, n0);
+
+        float32x4_t t01 = vdivq_f32(d0, vsubq_f32(d0, d1));
+        float32x4_t t12 = vdivq_f32(d1, vsubq_f32(d1, d2));
+        float32x4_t t20 = vdivq_f32(d2, vsubq_f32(d2, d0));
+
+        float32x4_t p12x = lerp(x1, x2, t12);
+        float32x4_t p12y = lerp(y1, y2, t12);
+        float32x4_t first_x = vbslq_f32(c01, lerp(x0, x1, t01), p12x);
+        float32x4_t first_y = vbslq_f32(c01, lerp(y0, y1, t01), p12y);
+        float32x4_t second_x = vbslq_f32(c20, lerp(x2, x0, t20), p12x);
+        float32x4_t second_y = vbslq_f32(c20, lerp(y2, y0, t20), p12y);
+
+        float32x4_t dx = vsubq_f32(first_x, second_x);
+        float32x4_t dy = vsubq_f32(first_y, second_y);
+        uint32x4_t close = vcleq_f32(vaddq_f32(vmulq_f32(dx, dx), vmulq_f32(dy, dy)), eps_sq);
+        uint32x4_t keep = vbicq_u32(vorrq_u32(c01, vorrq_u32(c12, c20)), close);
+
+        uint32_t ok_lanes[4], keep_lanes[4];
+        float fx[4], fy[4], sx[4], sy[4];
+        vst1q_u32(ok_lanes, ok);
+        vst1q_u32(keep_lanes, keep);
+        vst1q_f32(fx, first_x);
+        vst1q_f32(fy, first_y);
+        vst1q_f32(sx, second_x);
+        vst1q_f32(sy, second_y);
+        for (std::size_t lane = 0; lane < 4; ++lane) {
+            finish_lane(block, i + lane, z_plane, ok_lanes[lane] == 0, keep_lanes[lane] != 0,
+                        fx[lane], fy[lane], sx[lane], sy[lane], out, counts);
+        }
+    }
+    for (; i < block.count; ++i) {
+        intersect_lane(block, i, z_plane, out, counts);
+    }
+}
+#endif
+
+IntersectKernel detect_intersect_kernel() {
+    if (intersect_kernel_supported(IntersectKernel::Neon)) return IntersectKernel::Neon;
+    if (intersect_kernel_supported(IntersectKernel::Avx2)) return IntersectKernel::Avx2;
+    return IntersectKernel::Scalar;
+}
+
+} // namespace
+
+
+std::vector<segment_t> intersect_triangle_with_plane(const vec3_t& v0, const vec3_t& v1, const vec3_t& v2, float z_plane) {
+    segment_t out[kMaxTriangleSegments];
+    std::size_t count = intersect_triangle_into(v0, v1, v2, z_plane, out);
+    return std::vector<segment_t>(out, out + count);
+}
+
+
+std::size_t intersect_triangle_into(const vec3_t& v0, const vec3_t& v1, const vec3_t& v2, float z_plane, segment_t* out) {
+    float d0 = v0.z - z_plane;
+    float d1 = v1.z - z_plane;
+    float d2 = v2.z - z_plane;
+
+    auto on_plane = [](float d) { return std::abs(d) < kPlaneEps; };
+
+    // coplanar edges go straight to `out`; crossing points are collected and joined after
+    std::size_t count = 0;
+    vec3_t intersections[3];
+    std::size_t num_intersections = 0;
+
+    auto add_point = [&](const vec3_t& v) {
+        vec3_t p{v.x, v.y, z_plane};
+        for (std::size_t i = 0; i < num_intersections; ++i) {
+            if (close2d(intersections[i], p, kPlaneEps)) return;
+        }
+        intersections[num_intersections++] = p;
+    };
+
+    auto add_edge = [&](const vec3_t& a, const vec3_t& b) {
+        vec3_t p0{a.x, a.y, z_plane};
+        vec3_t p1{b.x, b.y, z_plane};
+        if (!close2d(p0, p1, kPlaneEps)) {
+            out[count++] = {p0, p1};
+        }
+    };
+
+    auto handle_edge = [&](const vec3_t& a, const vec3_t& b, float da, float db) {
+        if (on_plane(da) && on_plane(db)) {
+            add_edge(a, b);
+            return;
+        }
+        if (on_plane(da)) {
+            add_point(a);
+            return;
+        }
+        if (on_plane(db)) {
+            add_point(b);
+            return;
+        }
+        if ((da < 0.0f && db > 0.0f) || (da > 0.0f && db < 0.0f)) {
+            float t = da / (da - db);
+            if (t < -kPlaneEps || t > 1.0f + kPlaneEps) return;
+            vec3_t p{
+                a.x + t * (b.x - a.x),
+                a.y + t * (b.y - a.y),
+                z_plane
+            };
+            add_point(p);
+        }
+    };
+
+    handle_edge(v0, v1, d0, d1);
+    handle_edge(v1, v2, d1, d2);
+    handle_edge(v2, v0, d2, d0);
+
+    if (num_intersections == 2) {
+        out[count++] = {intersections[0], intersections[1]};
+    } else if (num_intersections == 3) {
+        out[count++] = {intersections[0], intersections[1]};
+        out[count++] = {intersections[1], intersections[2]};
+    }
+
+    return count;
+}
+
+
+bool intersect_kernel_supported(IntersectKernel kernel) {
+    switch (kernel) {
+    case IntersectKernel::Scalar:
+        return true;
+    case IntersectKernel::Avx2:
+#if defined(PRINTER_HAS_AVX2_KERNEL)
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    case IntersectKernel::Neon:
+#if defined(PRINTER_HAS_NEON_KERNEL)
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+const char* intersect_kernel_name(IntersectKernel kernel) {
+    switch (kernel) {
+    case IntersectKernel::Scalar: return "scalar";
+    case IntersectKernel::Avx2: return "avx2";
+    case IntersectKernel::Neon: return "neon";
+    }
+    return "unknown";
+}
+
+IntersectKernel active_intersect_kernel() {
+    static const IntersectKernel kernel = detect_intersect_kernel();
+    return kernel;
+}
+
+void intersect_block(const TriangleBlock& block, float z_plane, segment_t* out, uint8_t* counts) {
+    intersect_block(active_intersect_kernel(), block, z_plane, out, counts);
+}
+
+void intersect_block(IntersectKernel kernel, const TriangleBlock& block, float z_plane, segment_t* out, uint8_t* counts) {
+    if (!intersect_kernel_supported(kernel)) {
+        throw std::runtime_error(std::string("Intersect kernel not supported on this CPU: ") + intersect_kernel_name(kernel));
+    }
+    switch (kernel) {
+#if defined(PRINTER_HAS_AVX2_KERNEL)
+    case IntersectKernel::Avx2:
+        intersect_block_avx2(block, z_plane, out, counts);
+        return;
+#endif
+#if defined(PRINTER_HAS_NEON_KERNEL)
+    case IntersectKernel::Neon:
+        intersect_block_neon(block, z_plane, out, counts);
+        return;
+#endif
+    default:
+        intersect_block_scalar(block, z_plane, out, counts);
+        return;
+    }
+}
@@ -0,0 +1,122 @@
+#include "include/planning/layer_schedule.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+namespace {
+
+// |n.z| above this is a flat facet (within about a degree of horizontal)
+constexpr float kFlatFacetCos = 0.9998f;
+
+} // namespace
+
+
+LayerSchedule LayerSchedule::uniform(float layer_height) {
+    return uniform(layer_height, 0.0f, MAX_PART_HEIGHT_MM);
+}
+
+LayerSchedule LayerSchedule::uniform(float layer_height, float min_z, float max_z) {
+    LayerSchedule schedule;
+    if (!(layer_height > 0.0f) || !(min_z <= max_z)) return schedule;
+    // the build volume holds planes [0, MAX_PART_HEIGHT_MM / layer_height); the range is rounded
+    // outwards to whole layers
+    const auto volume_planes = static_cast<double>(static_cast<long>(MAX_PART_HEIGHT_MM / layer_height));
+    const auto first = static_cast<long>(std::clamp(std::floor(static_cast<double>(min_z / layer_height)), 0.0, volume_planes));
+    const auto last = static_cast<long>(std::clamp(std::ceil(static_cast<double>(max_z / layer_height)), -1.0, volume_planes - 1.0));
+    if (first > last) return schedule;
+    schedule._z.resize(static_cast<std::size_t>(last - first + 1));
+    for (std::size_t l = 0; l < schedule._z.size(); ++l) {
+        schedule._z[l] = static_cast<float>(static_cast<std::size_t>(first) + l) * layer_height;
+    }
+    schedule._nominal_height = layer_height;
+    schedule._uniform = true;
+    schedule._first_plane = static_cast<std::size_t>(first);
+    return schedule;
+}
+
+LayerSchedule LayerSchedule::adaptive(const std::vector<Mesh>& meshes, const AdaptiveLayerOptions& options) {
+    if (!(options.min_height > 0.0f) || !(options.max_height >= options.min_height) || !(options.max_cusp > 0.0f)) {
+        throw std::runtime_error("Adaptive layers need 0 < min_height <= max_height and a positive max_cusp");
+    }
+
+    bbox_t part;
+    for (const auto& mesh : meshes) part.expand(mesh.bounds);
+    LayerSchedule schedule;
+    if (part.empty()) return schedule;
+    const float bottom = std::max(0.0f, part.min.z);
+    const float top = std::min(part.max.z, MAX_PART_HEIGHT_MM);
+    if (bottom > top) return schedule;
+
+    // thickness cap per min_height-tall band of z; a facet caps every band it touches
+    const float band = options.min_height;
+    const auto num_bands = static_cast<std::size_t>(std::ceil(top / band)) + 1;
+    std::vector<float> cap(num_bands, options.max_height);
+    auto band_of = [&](float z) {
+        return std::min(num_bands - 1, static_cast<std::size_t>(std::max(0.0f, z / band)));
+    };
+    for (const auto& mesh : meshes) {
+        for (const auto& tri : mesh.triangles) {
+            const vec3_t& a = mesh.points[tri.vertices[0]];
+            const vec3_t& b = mesh.points[tri.vertices[1]];
+            const vec3_t& c = mesh.points[tri.vertices[2]];
+            vec3_t normal = (b - a).cross(c - a);
+            float length = normal.norm();
+            if (!(length > 0.0f)) continue;
+            float nz = std::abs(normal.z) / length;
+            if (nz >= kFlatFacetCos) continue;
+            float limit = options.max_cusp / nz;
+            if (!(limit < options.max_height)) continue;
+            for (std::size_t i = band_of(std::min({a.z, b.z, c.z})), last = band_of(std::max({a.z, b.z, c.z})); i <= last; ++i) {
+                cap[i] = std::min(cap[i], limit);
+            }
+        }
+    }
+    auto cap_between = [&](float lo, float hi) {
+        float result = options.max_height;
+        for (std::size_t i = band_of(lo), last = band_of(hi); i <= last; ++i) result = std::min(result, cap[i]);
+        return result;
+    };
+
+    // the first plane sits on the part's bottom face; each layer takes the largest thickness
+    // every facet it overlaps allows, so shrinking it can only relax the cap
+    float z = bottom;
+    schedule._z.push_back(z);
+    while (z < top) {
+        float height = options.max_height;
+        while (height > options.min_height) {
+            float allowed = cap_between(z, z + height);
+            if (allowed >= height) break;
+            height = std::max(allowed, options.min_height);
+        }
+        z += height;
+        schedule._z.push_back(z);
+        schedule._nominal_height = std::max(schedule._nominal_height, height);
+    }
+    return schedule;
+}
+
+std::pair<int, int> LayerSchedule::layers_within(float min_z, float max_z) const {
+    const auto n = static_cast<long>(_z.size());
+    long first = 0;
+    long last = n - 1;
+    if (_uniform) {
+        // start from the arithmetic guess and settle on the exact float planes
+        auto guess = [&](float z) {
+            double l = std::ceil(static_cast<double>(z) / static_cast<double>(_nominal_height)) - static_cast<double>(_first_plane);
+            return static_cast<long>(std::clamp(std::isnan(l) ? 0.0 : l, 0.0, static_cast<double>(n)));
+        };
+        first = guess(min_z);
+        while (first > 0 && _z[static_cast<std::size_t>(first - 1)] >= min_z) first--;
+        while (first < n && _z[static_cast<std::size_t>(first)] < min_z) first++;
+        last = guess(max_z);
+        while (last > 0 && _z[static_cast<std::size_t>(last - 1)] > max_z) last--;
+        while (last < n && _z[static_cast<std::size_t>(last)] <= max_z) last++;
+        last--;
+    } else {
+        first = std::lower_bound(_z.begin(), _z.end(), min_z) - _z.begin();
+        last = (std::upper_bound(_z.begin(), _z.end(), max_z) - _z.begin()) - 1;
+    }
+    return {static_cast<int>(first), static_cast<int>(last)};
+}
@@ -0,0 +1,192 @@
+#include "include/planning/motion_encoder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+
+namespace {
+
+constexpr std::size_t kHeaderBytes = 3;  // sync, sequence, length
+constexpr double kXyzPerMm = MOTION_XYZ_PER_MM;
+constexpr double kEPerMm = MOTION_E_PER_MM;
+
+int32_t quantize(double value, double units_per_mm) {
+    const double units = std::round(value * units_per_mm);
+    if (!(std::abs(units) <= static_cast<double>(std::numeric_limits<int32_t>::max()))) {
+        throw std::runtime_error("Motion coordinate out of range");
+    }
+    return static_cast<int32_t>(units);
+}
+
+bool fits(int64_t v, int64_t limit) { return v >= -limit - 1 && v <= limit; }
+
+// A delta between two quantized positions, which needs more than 32 bits only across 2 km.
+int32_t delta(int32_t to, int32_t from) {
+    const int64_t d = static_cast<int64_t>(to) - from;
+    if (!fits(d, INT32_MAX)) throw std::runtime_error("Motion coordinate out of range");
+    return static_cast<int32_t>(d);
+}
+
+uint8_t* put_le(uint8_t* out, int32_t value, int bytes) {
+    const auto bits = static_cast<uint32_t>(value);
+    for (int b = 0; b < bytes; ++b) *out++ = static_cast<uint8_t>(bits >> (8 * b));
+    return out;
+}
+
+uint8_t header(int op, unsigned low) { return static_cast<uint8_t>((op << 5) | low); }
+
+} // namespace
+
+
+MotionEncoder::MotionEncoder(FrameSink sink, const GcodeOptions& options)
+    : _sink(std::move(sink)), _options(options)
+{
+    check_gcode_options(options);
+    if (!_sink) throw std::runtime_error("Motion encoder needs a frame sink");
+}
+
+void MotionEncoder::add_layer(float z, float height, const PathSet& paths) {
+    if (_finished) throw std::runtime_error("Motion encoder already finished");
+    const uint8_t reset = header(MOTION_OP_CONTROL, MOTION_CTRL_RESET_E);
+    put_command(&reset, 1);
+    _stats.layers++;
+    _z = quantize(z, kXyzPerMm);
+    _z_pending = true;
+    _e_exact = 0.0;
+    _e = 0;
+    _e_per_mm = extrusion_per_mm(_options, height);
+
+    for (std::size_t p = 0; p < paths.path_count(); ++p) {
+        const auto path = paths.path(p);
+        if (path.role == PathRole::OpenChain) continue;
+        travel_to(quantize(path.points[0].x, kXyzPerMm), quantize(path.points[0].y, kXyzPerMm));
+        for (std::size_t k = 1; k < path.points.size(); ++k) {
+            extrude_to(quantize(path.points[k].x, kXyzPerMm), quantize(path.points[k].y, kXyzPerMm));
+        }
+    }
+}
+
+void MotionEncoder::finish() {
+    if (_finished) return;
+    const uint8_t end = header(MOTION_OP_CONTROL, MOTION_CTRL_END);
+    put_command(&end, 1);
+    flush_frame();
+    _finished = true;
+}
+
+// The first travel of a layer also moves to its z, retracted, as GcodeWriter does.
+void MotionEncoder::travel_to(int32_t x, int32_t y) {
+    if (_has_position && x == _x && y == _y && !_z_pending) return;
+    const int32_t dx = delta(x, _x), dy = delta(y, _y);
+    const double distance = std::hypot(static_cast<double>(dx), static_cast<double>(dy)) / kXyzPerMm;
+    const int32_t retract = quantize(_options.retract_length, kEPerMm);
+    const bool retracting = _has_position && retract > 0 && (_z_pending || distance >= _options.retract_min_travel);
+    if (retracting) {
+        move_extruder(-retract, _options.retract_speed);
+        _stats.retractions++;
+    }
+
+    const uint8_t slot = feed_slot(_options.travel_speed);
+    uint8_t command[9];
+    if (_z_pending) {
+        command[0] = header(MOTION_OP_Z, slot);
+        put_le(command + 1, _z, 4);
+        put_command(command, 5);
+        _z_pending = false;
+    }
+    // the decoder, like this encoder, starts at the origin
+    if (fits(dx, INT16_MAX) && fits(dy, INT16_MAX)) {
+        command[0] = header(MOTION_OP_TRAVEL16, slot);
+        put_le(put_le(command + 1, dx, 2), dy, 2);
+        put_command(command, 5);
+    } else {
+        command[0] = header(MOTION_OP_TRAVEL32, slot);
+        put_le(put_le(command + 1, dx, 4), dy, 4);
+        put_command(command, 9);
+    }
+    _stats.travels++;
+    _has_position = true;
+    _x = x;
+    _y = y;
+
+    if (retracting) move_extruder(retract, _options.retract_speed);
+}
+
+void MotionEncoder::extrude_to(int32_t x, int32_t y) {
+    if (x == _x && y == _y) return;
+    const int32_t dx = delta(x, _x), dy = delta(y, _y);
+    _e_exact += std::hypot(static_cast<double>(dx), static_cast<double>(dy)) / kXyzPerMm * _e_per_mm;
+    const int32_t e = quantize(_e_exact, kEPerMm);
+    const int32_t de = delta(e, _e);
+
+    const uint8_t slot = feed_slot(_options.print_speed);
+    uint8_t command[13];
+    if (fits(dx, INT8_MAX) && fits(dy, INT8_MAX) && fits(de, INT8_MAX)) {
+        command[0] = header(MOTION_OP_MOVE8, slot);
+        put_le(put_le(put_le(command + 1, dx, 1), dy, 1), de, 1);
+        put_command(command, 4);
+    } else if (fits(dx, INT16_MAX) && fits(dy, INT16_MAX) && fits(de, INT16_MAX)) {
+        command[0] = header(MOTION_OP_MOVE16, slot);
+        put_le(put_le(put_le(command + 1, dx, 2), dy, 2), de, 2);
+        put_command(command, 7);
+    } else {
+        command[0] = header(MOTION_OP_MOVE32, slot);
+        put_le(put_le(put_le(command + 1, dx, 4), dy, 4), de, 4);
+        put_command(command, 13);
+    }
+    _stats.moves++;
+    _x = x;
+    _y = y;
+    _e = e;
+}
+
+void MotionEncoder::move_extruder(int32_t de, float mm_per_s) {
+    uint8_t command[5];
+    command[0] = header(MOTION_OP_EXTRUDER, feed_slot(mm_per_s));
+    put_le(command + 1, de, 4);
+    put_command(command, 5);
+    _e += de;
+}
+
+// Slots are handed out in order and reused round-robin; the decoder applies an update in
+// stream order, so commands already sent keep the rate they were sent with.
+uint8_t MotionEncoder::feed_slot(float mm_per_s) {
+    const double per_min = std::round(static_cast<double>(mm_per_s) * 60.0);
+    if (!(per_min >= 1.0 && per_min <= 65535.0)) throw std::runtime_error("Motion feed rate must be 1 to 65535 mm/min");
+    const auto rate = static_cast<uint16_t>(per_min);
+    const auto found = std::find(_feeds.begin(), _feeds.end(), rate);
+    if (found != _feeds.end()) return static_cast<uint8_t>(found - _feeds.begin());
+
+    const auto slot = static_cast<uint8_t>(_next_slot++ % MOTION_FEED_SLOTS);
+    _feeds[slot] = rate;
+    const uint8_t command[4] = {header(MOTION_OP_CONTROL, MOTION_CTRL_FEED), slot, static_cast<uint8_t>(rate & 0xFF),
+                                static_cast<uint8_t>(rate >> 8)};
+    put_command(command, sizeof(command));
+    _stats.feed_entries++;
+    return slot;
+}
+
+void MotionEncoder::put_command(const uint8_t* bytes, std::size_t length) {
+    if (_payload + length > MOTION_MAX_PAYLOAD) flush_frame();
+    std::memcpy(_frame.data() + kHeaderBytes + _payload, bytes, length);
+    _payload += length;
+}
+
+void MotionEncoder::flush_frame() {
+    if (_payload == 0) return;
+    _frame[0] = MOTION_SYNC;
+    _frame[1] = _sequence++;
+    _frame[2] = static_cast<uint8_t>(_payload);
+    const uint16_t crc = motion_crc16(0xFFFF, _frame.data() + 1, static_cast<unsigned>(2 + _payload));
+    _frame[kHeaderBytes + _payload] = static_cast<uint8_t>(crc & 0xFF);
+    _frame[kHeaderBytes + _payload + 1] = static_cast<uint8_t>(crc >> 8);
+    const std::size_t size = kHeaderBytes + _payload + 2;
+    _sink(std::span<const uint8_t>(_frame.data(), size));
+    _stats.frames++;
+    _stats.bytes += size;
+    _payload = 0;
+}
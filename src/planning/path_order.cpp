@@ -0,0 +1,408 @@
+#include "include/planning/path_order.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+
+namespace {
+
+constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+constexpr int kTwoOptPasses = 2;
+
+double distance(const vec3_t& a, const vec3_t& b) {
+    const double dx = static_cast<double>(a.x) - b.x;
+    const double dy = static_cast<double>(a.y) - b.y;
+    const double dz = static_cast<double>(a.z) - b.z;
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+struct Entry {
+    float x, y;
+    uint32_t path;
+    uint32_t vertex;
+};
+
+// Static k-d tree over entry points whose nodes count the entries still alive below them, so a
+// nearest query skips used-up subtrees and a removal only walks one root-to-node path. Nodes
+// are implicit: the subtree over [lo, hi) is rooted at its middle element.
+class EntryTree
+{
+public:
+    explicit EntryTree(std::vector<Entry> entries) : _entries(std::move(entries)), _nodes(_entries.size()) {
+        build(0, static_cast<uint32_t>(_entries.size()));
+    }
+
+    const std::vector<Entry>& entries() const { return _entries; }
+
+    uint32_t nearest(const vec3_t& p) const {
+        uint32_t best = kNone;
+        float best_d2 = std::numeric_limits<float>::infinity();
+        search(0, static_cast<uint32_t>(_entries.size()), p.x, p.y, best, best_d2);
+        return best;
+    }
+
+    void remove(uint32_t index) {
+        uint32_t lo = 0, hi = static_cast<uint32_t>(_entries.size());
+        while (lo < hi) {
+            const uint32_t mid = lo + (hi - lo) / 2;
+            _nodes[mid].alive--;
+            if (mid == index) {
+                _nodes[mid].self_alive = false;
+                return;
+            }
+            if (index < mid) hi = mid;
+            else lo = mid + 1;
+        }
+    }
+
+private:
+    struct Node {
+        float min_x, min_y, max_x, max_y;
+        uint32_t alive;
+        bool split_x;
+        bool self_alive;
+    };
+
+    void build(uint32_t lo, uint32_t hi) {
+        if (lo >= hi) return;
+        Node node{std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                  std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(), hi - lo, true, true};
+        for (uint32_t i = lo; i < hi; ++i) {
+            node.min_x = std::min(node.min_x, _entries[i].x);
+            node.max_x = std::max(node.max_x, _entries[i].x);
+            node.min_y = std::min(node.min_y, _entries[i].y);
+            node.max_y = std::max(node.max_y, _entries[i].y);
+        }
+        node.split_x = node.max_x - node.min_x >= node.max_y - node.min_y;
+        const uint32_t mid = lo + (hi - lo) / 2;
+        std::nth_element(_entries.begin() + lo, _entries.begin() + mid, _entries.begin() + hi,
+                         [&](const Entry& a, const Entry& b) { return node.split_x ? a.x < b.x : a.y < b.y; });
+        _nodes[mid] = node;
+        build(lo, mid);
+        build(mid + 1, hi);
+    }
+
+    void search(uint32_t lo, uint32_t hi, float x, float y, uint32_t& best, float& best_d2) const {
+        if (lo >= hi) return;
+        const uint32_t mid = lo + (hi - lo) / 2;
+        const Node& node = _nodes[mid];
+        if (node.alive == 0) return;
+        const float bx = std::max({node.min_x - x, 0.0f, x - node.max_x});
+        const float by = std::max({node.min_y - y, 0.0f, y - node.max_y});
+        if (bx * bx + by * by >= best_d2) return;
+
+        const Entry& e = _entries[mid];
+        if (node.self_alive) {
+            const float dx = e.x - x, dy = e.y - y;
+            const float d2 = dx * dx + dy * dy;
+            // ties go to the lower path so the order does not depend on the tree's layout
+            if (d2 < best_d2 || (d2 == best_d2 && best != kNone && e.path < _entries[best].path)) {
+                best = mid;
+                best_d2 = d2;
+            }
+        }
+        const bool left_first = node.split_x ? x < e.x : y < e.y;
+        if (left_first) {
+            search(lo, mid, x, y, best, best_d2);
+            search(mid + 1, hi, x, y, best, best_d2);
+        } else {
+            search(mid + 1, hi, x, y, best, best_d2);
+            search(lo, mid, x, y, best, best_d2);
+        }
+    }
+
+    std::vector<Entry> _entries;
+    std::vector<Node> _nodes;  // indexed like _entries
+};
+
+// Polylines as runs of segments, each walked forwards or backwards, in one flat array.
+struct Chains {
+    struct Step {
+        uint32_t segment;
+        bool reversed;
+    };
+    std::vector<Step> steps;
+    std::vector<uint32_t> starts{0};  // chain c is steps[starts[c], starts[c + 1])
+    std::vector<uint8_t> closed;
+
+    std::size_t size() const { return closed.size(); }
+    uint32_t length(uint32_t c) const { return starts[c + 1] - starts[c]; }
+};
+
+// Joins segments where one ends exactly where another begins. At a node every unused segment
+// leaving it is taken before one arriving, so loops keep the direction they were built in.
+Chains chain_segments(std::span<const segment_t> segments) {
+    const auto count = static_cast<uint32_t>(segments.size());
+    // endpoint 2s is segments[s].first, 2s + 1 its second; equal points share a node
+    auto key = [&](uint32_t end) {
+        const vec3_t& p = end % 2 == 0 ? segments[end / 2].first : segments[end / 2].second;
+        uint32_t bits[3];
+        const float coords[3] = {p.x + 0.0f, p.y + 0.0f, p.z + 0.0f};  // -0 and 0 are one point
+        std::memcpy(bits, coords, sizeof(bits));
+        return std::array<uint32_t, 3>{bits[0], bits[1], bits[2]};
+    };
+    std::vector<uint32_t> ends(2 * static_cast<std::size_t>(count));
+    for (uint32_t e = 0; e < ends.size(); ++e) ends[e] = e;
+    std::vector<std::array<uint32_t, 3>> keys(ends.size());
+    for (uint32_t e = 0; e < ends.size(); ++e) keys[e] = key(e);
+    std::sort(ends.begin(), ends.end(), [&](uint32_t a, uint32_t b) { return keys[a] < keys[b] || (keys[a] == keys[b] && a < b); });
+    std::vector<uint32_t> node_of(ends.size()), node_start;
+    for (uint32_t i = 0; i < ends.size(); ++i) {
+        if (i == 0 || keys[ends[i]] != keys[ends[i - 1]]) node_start.push_back(i);
+        node_of[ends[i]] = static_cast<uint32_t>(node_start.size() - 1);
+    }
+    node_start.push_back(static_cast<uint32_t>(ends.size()));
+    const std::size_t nodes = node_start.size() - 1;
+
+    // per node: ends leaving it (a segment's first point) before ends arriving, each run walked
+    // by its own cursor past segments already used
+    std::vector<uint32_t> leaving(nodes), arriving(nodes), arriving_start(nodes);
+    for (std::size_t n = 0; n < nodes; ++n) {
+        auto mid = std::stable_partition(ends.begin() + node_start[n], ends.begin() + node_start[n + 1],
+                                         [](uint32_t e) { return e % 2 == 0; });
+        leaving[n] = node_start[n];
+        arriving[n] = arriving_start[n] = static_cast<uint32_t>(mid - ends.begin());
+    }
+    std::vector<uint8_t> used(count, 0);
+    auto next_unused = [&](uint32_t& i, uint32_t end) {
+        while (i < end && used[ends[i] / 2]) ++i;
+        return i < end ? ends[i] : kNone;
+    };
+    // an unused end at `node`, from the preferred run when it has one
+    auto take = [&](uint32_t node, bool prefer_leaving) {
+        uint32_t out = next_unused(leaving[node], arriving_start[node]);
+        uint32_t in = next_unused(arriving[node], node_start[node + 1]);
+        uint32_t pick = prefer_leaving ? (out != kNone ? out : in) : (in != kNone ? in : out);
+        if (pick != kNone) used[pick / 2] = 1;
+        return pick;
+    };
+
+    Chains chains;
+    chains.steps.reserve(count);
+    std::vector<Chains::Step> back;
+    for (uint32_t s = 0; s < count; ++s) {
+        if (used[s]) continue;
+        used[s] = 1;
+        const std::size_t first = chains.steps.size();
+        chains.steps.push_back({s, false});
+        // forwards from the end: a segment reached at its second point is walked backwards
+        uint32_t at = node_of[2 * s + 1];
+        for (uint32_t end = take(at, true); end != kNone; end = take(at, true)) {
+            chains.steps.push_back({end / 2, end % 2 == 1});
+            at = node_of[end ^ 1];
+        }
+        const uint32_t head = node_of[2 * s];
+        const bool closed = at == head;
+        if (!closed) {
+            // backwards from the start: a segment reached at its first point is walked backwards
+            back.clear();
+            for (uint32_t from = head, end = take(from, false); end != kNone; end = take(from, false)) {
+                back.push_back({end / 2, end % 2 == 0});
+                from = node_of[end ^ 1];
+            }
+            chains.steps.insert(chains.steps.begin() + static_cast<std::ptrdiff_t>(first), back.rbegin(), back.rend());
+        }
+        chains.starts.push_back(static_cast<uint32_t>(chains.steps.size()));
+        chains.closed.push_back(closed ? 1 : 0);
+    }
+    return chains;
+}
+
+// A chain in the tour and the position it is entered at: a step index, or for open chains 0 or
+// the chain's length (walked backwards). Closed chains are left where they are entered.
+struct Visit {
+    uint32_t chain;
+    uint32_t entry;
+};
+
+} // namespace
+
+
+double travel_distance(std::span<const segment_t> path, const vec3_t& from) {
+    double travel = 0.0;
+    vec3_t at = from;
+    for (const auto& seg : path) {
+        travel += distance(at, seg.first);
+        at = seg.second;
+    }
+    return travel;
+}
+
+namespace {
+
+// A segment of the input in print order, and whether it is walked second point first.
+struct OrderStep {
+    uint32_t segment;
+    bool reversed;
+};
+
+std::vector<OrderStep> order_steps(std::span<const segment_t> segments, vec3_t& cursor) {
+    if (segments.empty()) return {};
+    const Chains chains = chain_segments(segments);
+
+    // the point a chain is at before step k, or after its last step for k == length
+    auto step_start = [&](const Chains::Step& step) { return step.reversed ? segments[step.segment].second : segments[step.segment].first; };
+    auto step_end = [&](const Chains::Step& step) { return step.reversed ? segments[step.segment].first : segments[step.segment].second; };
+    auto point_at = [&](uint32_t c, uint32_t k) {
+        const uint32_t length = chains.length(c);
+        return k < length ? step_start(chains.steps[chains.starts[c] + k]) : step_end(chains.steps[chains.starts[c] + length - 1]);
+    };
+
+    std::vector<Entry> entries;
+    entries.reserve(segments.size() + chains.size());
+    for (uint32_t c = 0; c < chains.size(); ++c) {
+        const uint32_t length = chains.length(c);
+        const uint32_t last = chains.closed[c] ? length - 1 : length;
+        for (uint32_t k = 0; k <= last; k += chains.closed[c] ? 1 : length) {
+            const vec3_t p = point_at(c, k);
+            entries.push_back({p.x, p.y, c, k});
+        }
+    }
+    EntryTree tree(std::move(entries));
+
+    // each chain's entries in the tree, so taking a chain removes all of them
+    std::vector<uint32_t> starts(chains.size() + 1, 0), slots(tree.entries().size());
+    for (const auto& e : tree.entries()) starts[e.path + 1]++;
+    for (std::size_t c = 0; c < chains.size(); ++c) starts[c + 1] += starts[c];
+    {
+        auto fill = starts;
+        for (uint32_t i = 0; i < tree.entries().size(); ++i) slots[fill[tree.entries()[i].path]++] = i;
+    }
+
+    auto exit_index = [&](const Visit& v) {
+        return chains.closed[v.chain] ? v.entry : (v.entry == 0 ? chains.length(v.chain) : 0);
+    };
+    auto entry_point = [&](const Visit& v) { return point_at(v.chain, v.entry); };
+    auto exit_point = [&](const Visit& v) { return point_at(v.chain, exit_index(v)); };
+
+    // nearest neighbour
+    const vec3_t start = cursor;
+    std::vector<Visit> tour;
+    tour.reserve(chains.size());
+    vec3_t at = start;
+    while (tour.size() < chains.size()) {
+        const Entry& e = tree.entries()[tree.nearest(at)];
+        tour.push_back({e.path, e.vertex});
+        for (uint32_t s = starts[e.path]; s < starts[e.path + 1]; ++s) tree.remove(slots[s]);
+        at = exit_point(tour.back());
+    }
+
+    // windowed 2-opt: reversing tour[i + 1, j] walks each open chain there backwards
+    const long n = static_cast<long>(tour.size());
+    std::vector<vec3_t> in(tour.size()), out(tour.size());
+    for (std::size_t k = 0; k < tour.size(); ++k) {
+        in[k] = entry_point(tour[k]);
+        out[k] = exit_point(tour[k]);
+    }
+    for (int pass = 0; pass < kTwoOptPasses; ++pass) {
+        bool improved = false;
+        for (long i = -1; i + 1 < n; ++i) {
+            const vec3_t before = i < 0 ? start : out[static_cast<std::size_t>(i)];
+            double to_first = distance(before, in[static_cast<std::size_t>(i + 1)]);
+            const long window_end = std::min(n - 1, i + static_cast<long>(kPathOrderWindow));
+            for (long j = i + 1; j <= window_end; ++j) {
+                const auto a = static_cast<std::size_t>(i + 1), b = static_cast<std::size_t>(j);
+                double old_cost = to_first;
+                double new_cost = distance(before, out[b]);
+                if (new_cost >= old_cost + (j + 1 < n ? distance(out[b], in[b + 1]) : 0.0)) continue;
+                if (j + 1 < n) {
+                    old_cost += distance(out[b], in[b + 1]);
+                    new_cost += distance(in[a], in[b + 1]);
+                }
+                if (new_cost + 1e-9 >= old_cost) continue;
+                std::reverse(tour.begin() + i + 1, tour.begin() + j + 1);
+                std::reverse(in.begin() + i + 1, in.begin() + j + 1);
+                std::reverse(out.begin() + i + 1, out.begin() + j + 1);
+                for (std::size_t k = a; k <= b; ++k) {
+                    tour[k].entry = exit_index(tour[k]);
+                    std::swap(in[k], out[k]);
+                }
+                to_first = distance(before, in[a]);
+                improved = true;
+            }
+        }
+        if (!improved) break;
+    }
+
+    std::vector<OrderStep> ordered;
+    ordered.reserve(segments.size());
+    for (const auto& visit : tour) {
+        const uint32_t length = chains.length(visit.chain);
+        const Chains::Step* steps = chains.steps.data() + chains.starts[visit.chain];
+        auto emit = [&](const Chains::Step& step, bool backwards) { ordered.push_back({step.segment, step.reversed != backwards}); };
+        if (chains.closed[visit.chain]) {
+            for (uint32_t k = 0; k < length; ++k) emit(steps[(visit.entry + k) % length], false);
+        } else if (visit.entry == 0) {
+            for (uint32_t k = 0; k < length; ++k) emit(steps[k], false);
+        } else {
+            for (uint32_t k = length; k > 0; --k) emit(steps[k - 1], true);
+        }
+    }
+    cursor = exit_point(tour.back());
+    return ordered;
+}
+
+} // namespace
+
+
+std::vector<segment_t> order_paths(std::span<const segment_t> segments, vec3_t& cursor) {
+    std::vector<segment_t> ordered;
+    ordered.reserve(segments.size());
+    for (const auto& step : order_steps(segments, cursor)) {
+        const auto& seg = segments[step.segment];
+        ordered.push_back(step.reversed ? segment_t{seg.second, seg.first} : seg);
+    }
+    return ordered;
+}
+
+TravelStats order_layer_paths(PathSet& paths) {
+    TravelStats stats;
+    const PathRange walls = paths.find_run(is_wall);
+    const PathRange infill = paths.find_run([](PathRole role) { return role == PathRole::Infill; });
+    if (walls.first == walls.last && infill.first == infill.last) return stats;
+
+    // z plays no part in travel within a layer
+    const auto wall_segments = paths.segments(0.0f, walls);
+    const auto infill_segments = paths.segments(0.0f, infill);
+    std::vector<PathRole> wall_roles;
+    wall_roles.reserve(wall_segments.size());
+    for (std::size_t p = walls.first; p < walls.last; ++p) {
+        wall_roles.insert(wall_roles.end(), paths.path(p).segment_count(), paths.roles()[p]);
+    }
+    const vec3_t start = wall_segments.empty() ? infill_segments.front().first : wall_segments.front().first;
+    stats.before_mm = travel_distance(wall_segments, start) +
+                      travel_distance(infill_segments, wall_segments.empty() ? start : wall_segments.back().second);
+
+    vec3_t cursor = start;
+    const auto wall_order = order_steps(wall_segments, cursor);
+    const vec3_t walls_end = cursor;
+    const auto infill_order = order_steps(infill_segments, cursor);
+
+    // walls, then infill, then whatever else the set held, as it was
+    PathSet ordered;
+    auto append = [&](const std::vector<segment_t>& segments, const std::vector<OrderStep>& steps, auto role_of) {
+        std::vector<segment_t> printed;
+        printed.reserve(steps.size());
+        for (const auto& step : steps) {
+            const auto& seg = segments[step.segment];
+            printed.push_back(step.reversed ? segment_t{seg.second, seg.first} : seg);
+            ordered.append_segment(printed.back(), role_of(step.segment));
+        }
+        return printed;
+    };
+    const auto printed_walls = append(wall_segments, wall_order, [&](uint32_t s) { return wall_roles[s]; });
+    const auto printed_infill = append(infill_segments, infill_order, [](uint32_t) { return PathRole::Infill; });
+    stats.after_mm = travel_distance(printed_walls, start) + travel_distance(printed_infill, walls_end);
+
+    for (std::size_t p = 0; p < paths.path_count(); ++p) {
+        const auto path = paths.path(p);
+        if (!is_wall(path.role) && path.role != PathRole::Infill) ordered.add_polyline(path.points, path.role);
+    }
+    ordered.shrink_to_fit();
+    paths = std::move(ordered);
+    return stats;
+}
@@ -0,0 +1,453 @@
+#include "include/planning/polygon_offset.hpp"
+#include "include/planning/polygon_ops.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+namespace {
+
+using wide_t = __int128;
+
+struct FixedEdge {
+    FixedPoint a, b;
+    int mult = 1;  // coincident edges collapse into one entry carrying their net count
+};
+
+wide_t cross(const FixedPoint& o, const FixedPoint& a, const FixedPoint& b) {
+    return static_cast<wide_t>(a.x - o.x) * (b.y - o.y) - static_cast<wide_t>(a.y - o.y) * (b.x - o.x);
+}
+
+int sign(wide_t v) { return (v > 0) - (v < 0); }
+
+bool on_segment(const FixedPoint& a, const FixedPoint& b, const FixedPoint& p) {
+    return std::min(a.x, b.x) <= p.x && p.x <= std::max(a.x, b.x) &&
+           std::min(a.y, b.y) <= p.y && p.y <= std::max(a.y, b.y) && cross(a, b, p) == 0;
+}
+
+FixedPoint round_point(double x, double y) {
+    return {std::llround(x), std::llround(y)};
+}
+
+// Adds to `splits` every point where the two edges meet: the crossing point, or the endpoints
+// of one lying on the other (T-junctions and collinear overlaps). Returns true for a crossing.
+bool find_contacts(const FixedEdge& e, const FixedEdge& f, std::vector<FixedPoint>& e_splits,
+                   std::vector<FixedPoint>& f_splits) {
+    const int o1 = sign(cross(e.a, e.b, f.a));
+    const int o2 = sign(cross(e.a, e.b, f.b));
+    const int o3 = sign(cross(f.a, f.b, e.a));
+    const int o4 = sign(cross(f.a, f.b, e.b));
+    if (o1 * o2 < 0 && o3 * o4 < 0) {
+        const long double ex = e.b.x - e.a.x, ey = e.b.y - e.a.y;
+        const long double fx = f.b.x - f.a.x, fy = f.b.y - f.a.y;
+        const long double t = ((f.a.x - e.a.x) * fy - (f.a.y - e.a.y) * fx) / (ex * fy - ey * fx);
+        const FixedPoint p = round_point(static_cast<double>(e.a.x + t * ex), static_cast<double>(e.a.y + t * ey));
+        e_splits.push_back(p);
+        f_splits.push_back(p);
+        return true;
+    }
+    if (o1 == 0 && on_segment(e.a, e.b, f.a)) e_splits.push_back(f.a);
+    if (o2 == 0 && on_segment(e.a, e.b, f.b)) e_splits.push_back(f.b);
+    if (o3 == 0 && on_segment(f.a, f.b, e.a)) f_splits.push_back(e.a);
+    if (o4 == 0 && on_segment(f.a, f.b, e.b)) f_splits.push_back(e.b);
+    return false;
+}
+
+struct CellEntry {
+    uint64_t cell;
+    uint32_t edge;
+};
+
+// Every (cell, edge) pair for a sparse grid with cells about twice the mean edge size, sorted
+// by cell. Edges are walked column by column, so a long edge only lists the cells along it and
+// the entry count stays linear; two edges that touch always share a cell.
+std::vector<CellEntry> edge_cells(const std::vector<FixedEdge>& edges) {
+    double mean = 0.0;
+    for (const auto& e : edges) mean += static_cast<double>(std::max(std::abs(e.b.x - e.a.x), std::abs(e.b.y - e.a.y)));
+    const double cell = std::max(1.0, 2.0 * mean / static_cast<double>(std::max<std::size_t>(1, edges.size())));
+    auto cell_of = [&](double v) { return static_cast<int64_t>(std::floor(v / cell)); };
+    auto key = [](int64_t cx, int64_t cy) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+    };
+
+    std::vector<CellEntry> entries;
+    entries.reserve(edges.size() * 2);
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        const FixedEdge& e = edges[i];
+        const double ax = static_cast<double>(e.a.x), ay = static_cast<double>(e.a.y);
+        const double dx = static_cast<double>(e.b.x - e.a.x), dy = static_cast<double>(e.b.y - e.a.y);
+        const double min_x = std::min(ax, ax + dx), max_x = std::max(ax, ax + dx);
+        for (int64_t cx = cell_of(min_x); cx <= cell_of(max_x); ++cx) {
+            // the part of the edge inside this column, padded a unit against rounding
+            double lo_x = std::max(min_x, static_cast<double>(cx) * cell);
+            double hi_x = std::min(max_x, static_cast<double>(cx + 1) * cell);
+            double y0 = dx == 0.0 ? ay : ay + dy * (lo_x - ax) / dx;
+            double y1 = dx == 0.0 ? ay + dy : ay + dy * (hi_x - ax) / dx;
+            for (int64_t cy = cell_of(std::min(y0, y1) - 1.0); cy <= cell_of(std::max(y0, y1) + 1.0); ++cy) {
+                entries.push_back({key(cx, cy), static_cast<uint32_t>(i)});
+            }
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const CellEntry& l, const CellEntry& r) {
+        return l.cell < r.cell || (l.cell == r.cell && l.edge < r.edge);
+    });
+    return entries;
+}
+
+// Splits every edge at its contacts with the others. Crossing points are rounded to the grid,
+// which can tilt a piece across a neighbour, so `crossed` reports whether another pass is due.
+std::vector<FixedEdge> split_edges(const std::vector<FixedEdge>& edges, bool& crossed) {
+    crossed = false;
+    const auto entries = edge_cells(edges);
+    std::vector<std::vector<FixedPoint>> splits(edges.size());
+    for (std::size_t run = 0; run < entries.size();) {
+        std::size_t end = run + 1;
+        while (end < entries.size() && entries[end].cell == entries[run].cell) ++end;
+        for (std::size_t i = run; i < end; ++i) {
+            for (std::size_t j = i + 1; j < end; ++j) {
+                const uint32_t e = entries[i].edge, f = entries[j].edge;
+                if (find_contacts(edges[e], edges[f], splits[e], splits[f])) crossed = true;
+            }
+        }
+        run = end;
+    }
+
+    std::vector<FixedEdge> pieces;
+    pieces.reserve(edges.size());
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        const FixedEdge& e = edges[i];
+        auto& pts = splits[i];
+        if (pts.empty()) {
+            pieces.push_back(e);
+            continue;
+        }
+        pts.push_back(e.a);
+        pts.push_back(e.b);
+        auto along = [&](const FixedPoint& p) {
+            return static_cast<wide_t>(p.x - e.a.x) * (e.b.x - e.a.x) + static_cast<wide_t>(p.y - e.a.y) * (e.b.y - e.a.y);
+        };
+        std::sort(pts.begin(), pts.end(), [&](const FixedPoint& p, const FixedPoint& q) { return along(p) < along(q); });
+        pts.erase(std::unique(pts.begin(), pts.end()), pts.end());
+        for (std::size_t k = 0; k + 1 < pts.size(); ++k) pieces.push_back({pts[k], pts[k + 1], e.mult});
+    }
+    return pieces;
+}
+
+// Collapses coincident edges into one entry with their net multiplicity; opposite pairs cancel.
+std::vector<FixedEdge> merge_coincident(std::vector<FixedEdge> edges) {
+    for (auto& e : edges) {
+        if (e.b < e.a) {
+            std::swap(e.a, e.b);
+            e.mult = -e.mult;
+        }
+    }
+    std::sort(edges.begin(), edges.end(), [](const FixedEdge& l, const FixedEdge& r) {
+        return l.a < r.a || (l.a == r.a && l.b < r.b);
+    });
+    std::vector<FixedEdge> merged;
+    for (std::size_t i = 0; i < edges.size();) {
+        FixedEdge sum = edges[i];
+        std::size_t j = i + 1;
+        for (; j < edges.size() && edges[j].a == sum.a && edges[j].b == sum.b; ++j) sum.mult += edges[j].mult;
+        i = j;
+        if (sum.mult == 0) continue;
+        if (sum.mult < 0) {
+            std::swap(sum.a, sum.b);
+            sum.mult = -sum.mult;
+        }
+        merged.push_back(sum);
+    }
+    return merged;
+}
+
+// Horizontal bands over y holding the non-horizontal edges that span them, for winding numbers
+// by a ray cast towards +x. Coordinates are doubled so edge midpoints stay integral.
+class WindingBands
+{
+public:
+    explicit WindingBands(const std::vector<FixedEdge>& edges) : _edges(edges)
+    {
+        int64_t min_y = std::numeric_limits<int64_t>::max(), max_y = std::numeric_limits<int64_t>::lowest();
+        double total_span = 0.0;
+        std::size_t sloped = 0;
+        for (const auto& e : edges) {
+            if (e.a.y == e.b.y) continue;
+            min_y = std::min({min_y, e.a.y, e.b.y});
+            max_y = std::max({max_y, e.a.y, e.b.y});
+            total_span += static_cast<double>(std::abs(e.b.y - e.a.y));
+            sloped++;
+        }
+        if (sloped == 0) return;
+        _min_y = static_cast<double>(min_y);
+
+        // about one band per edge, widened until the band lists stay within ~16 entries per edge
+        const double height = std::max(1.0, static_cast<double>(max_y - min_y));
+        const double band = std::max(height / static_cast<double>(sloped), total_span / (16.0 * static_cast<double>(sloped)));
+        _inv_band = 1.0 / band;
+        _bands = static_cast<std::size_t>(height * _inv_band) + 1;
+
+        _starts.assign(_bands + 1, 0);
+        for (const auto& e : edges) {
+            if (e.a.y == e.b.y) continue;
+            for (std::size_t b = band_of(std::min(e.a.y, e.b.y)); b <= band_of(std::max(e.a.y, e.b.y)); ++b) _starts[b + 1]++;
+        }
+        for (std::size_t b = 1; b < _starts.size(); ++b) _starts[b] += _starts[b - 1];
+        _items.resize(_starts.back());
+        std::vector<uint32_t> cursor(_starts.begin(), _starts.end() - 1);
+        for (std::size_t i = 0; i < edges.size(); ++i) {
+            const auto& e = edges[i];
+            if (e.a.y == e.b.y) continue;
+            for (std::size_t b = band_of(std::min(e.a.y, e.b.y)); b <= band_of(std::max(e.a.y, e.b.y)); ++b) {
+                _items[cursor[b]++] = static_cast<uint32_t>(i);
+            }
+        }
+    }
+
+    // Winding number just left of edge `self`. The ray test runs from its midpoint M with the
+    // half-open rule, which scores the point as if it sat at M + (e^2, e) for an infinitesimal
+    // e; the edge's own crossing and side are resolved for that same point.
+    int winding_left_of(std::size_t self) const
+    {
+        const FixedEdge& s = _edges[self];
+        const int64_t dx = s.b.x - s.a.x, dy = s.b.y - s.a.y;
+        int winding = 0;
+        // the edge crosses the ray just above M when it leans right as it rises
+        if (dx != 0 && dy != 0 && (dx > 0) == (dy > 0)) winding += dy > 0 ? s.mult : -s.mult;
+        const bool point_on_left = dx != 0 ? dx > 0 : dy < 0;
+        if (!point_on_left) winding += s.mult;
+        if (_bands == 0) return winding;
+        // midpoint in doubled coordinates
+        const int64_t mx = s.a.x + s.b.x, my = s.a.y + s.b.y;
+        // the band lookup uses the floor of the true midpoint; bands are closed at both ends
+        const std::size_t b = band_of(my >= 0 ? my / 2 : (my - 1) / 2);
+        for (uint32_t i = _starts[b]; i < _starts[b + 1]; ++i) {
+            const uint32_t k = _items[i];
+            if (k == self) continue;
+            const FixedEdge& e = _edges[k];
+            const int64_t ay = 2 * e.a.y, by = 2 * e.b.y;
+            const wide_t side = static_cast<wide_t>(2 * e.b.x - 2 * e.a.x) * (my - ay) -
+                                static_cast<wide_t>(mx - 2 * e.a.x) * (by - ay);
+            if (ay <= my) {
+                if (by > my && side > 0) winding += e.mult;
+            } else if (by <= my && side < 0) {
+                winding -= e.mult;
+            }
+        }
+        return winding;
+    }
+
+private:
+    std::size_t band_of(int64_t y) const {
+        double scaled = (static_cast<double>(y) - _min_y) * _inv_band;
+        if (!(scaled > 0.0)) return 0;
+        return std::min(static_cast<std::size_t>(scaled), _bands - 1);
+    }
+
+    const std::vector<FixedEdge>& _edges;
+    double _min_y = 0.0;
+    double _inv_band = 0.0;
+    std::size_t _bands = 0;
+    std::vector<uint32_t> _starts;
+    std::vector<uint32_t> _items;
+};
+
+// Links boundary edges head to tail into loops.
+std::vector<FixedLoop> link_loops(std::vector<FixedEdge> edges) {
+    std::sort(edges.begin(), edges.end(), [](const FixedEdge& l, const FixedEdge& r) { return l.a < r.a; });
+    std::vector<bool> used(edges.size(), false);
+    auto next_from = [&](const FixedPoint& p) -> std::size_t {
+        auto it = std::lower_bound(edges.begin(), edges.end(), p, [](const FixedEdge& e, const FixedPoint& q) { return e.a < q; });
+        for (auto i = static_cast<std::size_t>(it - edges.begin()); i < edges.size() && edges[i].a == p; ++i) {
+            if (!used[i]) return i;
+        }
+        return edges.size();
+    };
+
+    std::vector<FixedLoop> loops;
+    for (std::size_t first = 0; first < edges.size(); ++first) {
+        if (used[first]) continue;
+        used[first] = true;
+        FixedLoop loop{edges[first].a};
+        FixedPoint at = edges[first].b;
+        bool closed = false;
+        while (true) {
+            if (at == loop.front()) {
+                closed = true;
+                break;
+            }
+            loop.push_back(at);
+            std::size_t next = next_from(at);
+            if (next == edges.size()) break;
+            used[next] = true;
+            at = edges[next].b;
+        }
+        if (closed) loops.push_back(std::move(loop));
+    }
+    return loops;
+}
+
+// Drops repeated and collinear points; returns false if nothing with area is left.
+bool tidy_loop(FixedLoop& loop) {
+    bool changed = true;
+    while (changed && loop.size() >= 3) {
+        changed = false;
+        FixedLoop kept;
+        kept.reserve(loop.size());
+        const std::size_t n = loop.size();
+        for (std::size_t i = 0; i < n; ++i) {
+            const FixedPoint& prev = kept.empty() ? loop[(i + n - 1) % n] : kept.back();
+            const FixedPoint& next = loop[(i + 1) % n];
+            if (loop[i] == prev || cross(prev, loop[i], next) == 0) {
+                changed = true;
+                continue;
+            }
+            kept.push_back(loop[i]);
+        }
+        loop.swap(kept);
+    }
+    if (loop.size() < 3) return false;
+    wide_t area2 = 0;
+    for (std::size_t i = 0; i < loop.size(); ++i) {
+        const auto& p = loop[i];
+        const auto& q = loop[(i + 1) % loop.size()];
+        area2 += static_cast<wide_t>(p.x) * q.y - static_cast<wide_t>(q.x) * p.y;
+    }
+    return area2 != 0;
+}
+
+// Offsets one loop edge by edge towards each edge's right side by `delta` (fixed units) and
+// joins the corners. The result self-intersects wherever the offset folds; union_loops cleans it.
+FixedLoop raw_offset(const FixedLoop& loop, double delta, const OffsetOptions& options) {
+    const std::size_t n = loop.size();
+    FixedLoop out;
+    out.reserve(n * 2);
+
+    const double abs_delta = std::abs(delta);
+    const double tolerance = std::clamp(static_cast<double>(options.arc_tolerance) * kOffsetScale, 0.25, abs_delta);
+    const double arc_step = 2.0 * std::acos(1.0 - tolerance / abs_delta);
+    const double miter_min = 2.0 / (options.miter_limit * options.miter_limit);
+
+    auto unit_normal = [&](const FixedPoint& a, const FixedPoint& b) {
+        double dx = static_cast<double>(b.x - a.x), dy = static_cast<double>(b.y - a.y);
+        double len = std::hypot(dx, dy);
+        return std::pair<double, double>{dy / len, -dx / len};
+    };
+
+    for (std::size_t i = 0; i < n; ++i) {
+        const FixedPoint& prev = loop[(i + n - 1) % n];
+        const FixedPoint& curr = loop[i];
+        const FixedPoint& next = loop[(i + 1) % n];
+        const auto [n1x, n1y] = unit_normal(prev, curr);
+        const auto [n2x, n2y] = unit_normal(curr, next);
+        const double cx = static_cast<double>(curr.x), cy = static_cast<double>(curr.y);
+        // the normals turn by the same angle as the edges
+        const double sin_turn = n1x * n2y - n1y * n2x;
+        const double cos_turn = n1x * n2x + n1y * n2y;
+        auto emit = [&](double nx, double ny) { out.push_back(round_point(cx + delta * nx, cy + delta * ny)); };
+
+        if (std::abs(sin_turn) < 1e-9 && cos_turn > 0.0) {
+            emit(n1x, n1y);
+            continue;
+        }
+        if (sin_turn * delta < 0.0 && std::abs(sin_turn) >= 1e-9) {
+            // the offset edges overlap here; route through the vertex and let the union trim it
+            emit(n1x, n1y);
+            out.push_back(curr);
+            emit(n2x, n2y);
+            continue;
+        }
+        if (options.join == JoinType::Round) {
+            const double turn = std::atan2(sin_turn, cos_turn);
+            const auto steps = std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(std::abs(turn) / arc_step)));
+            for (std::size_t k = 0; k <= steps; ++k) {
+                const double a = turn * static_cast<double>(k) / static_cast<double>(steps);
+                emit(n1x * std::cos(a) - n1y * std::sin(a), n1x * std::sin(a) + n1y * std::cos(a));
+            }
+        } else if (1.0 + cos_turn > miter_min) {
+            const double scale = 1.0 / (1.0 + cos_turn);
+            emit((n1x + n2x) * scale, (n1y + n2y) * scale);
+        } else {
+            emit(n1x, n1y);
+            emit(n2x, n2y);
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+
+FixedLoop to_fixed(const polygon_t& poly) {
+    FixedLoop loop;
+    if (poly.empty()) return loop;
+    const bool closed = poly.size() > 1 && poly.front() == poly.back();
+    const std::size_t limit = closed ? poly.size() - 1 : poly.size();
+    loop.reserve(limit);
+    for (std::size_t i = 0; i < limit; ++i) {
+        FixedPoint p = round_point(static_cast<double>(poly[i].x) * kOffsetScale, static_cast<double>(poly[i].y) * kOffsetScale);
+        if (loop.empty() || !(loop.back() == p)) loop.push_back(p);
+    }
+    while (loop.size() > 1 && loop.back() == loop.front()) loop.pop_back();
+    return loop;
+}
+
+polygon_t from_fixed(const FixedLoop& loop, float z) {
+    polygon_t poly;
+    poly.reserve(loop.size() + 1);
+    for (const auto& p : loop) {
+        poly.push_back({static_cast<float>(static_cast<double>(p.x) / kOffsetScale),
+                        static_cast<float>(static_cast<double>(p.y) / kOffsetScale), z});
+    }
+    if (!poly.empty()) poly.push_back(poly.front());
+    return poly;
+}
+
+std::vector<FixedLoop> union_loops(const std::vector<FixedLoop>& loops, int max_passes, bool* settled) {
+    std::vector<FixedEdge> edges;
+    for (const auto& loop : loops) {
+        for (std::size_t i = 0; i < loop.size(); ++i) {
+            const FixedPoint& a = loop[i];
+            const FixedPoint& b = loop[(i + 1) % loop.size()];
+            if (!(a == b)) edges.push_back({a, b, 1});
+        }
+    }
+    if (settled) *settled = true;
+    if (edges.empty()) return {};
+
+    // A pass without crossings leaves pieces that only meet at endpoints. Snapping is not bound
+    // to settle, so after max_passes the boundary is traced from the pieces as they stand: a
+    // leftover crossing can misjudge the winding near it, and link_loops drops any chain that
+    // fails to close.
+    bool crossed = true;
+    for (int pass = 0; crossed && pass < max_passes; ++pass) edges = merge_coincident(split_edges(edges, crossed));
+    if (settled) *settled = !crossed;
+    const WindingBands bands(edges);
+    std::vector<FixedEdge> boundary;
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        // positive fill rule: keep edges with filled space on the left and empty space on the right
+        const int left = bands.winding_left_of(i);
+        if (left >= 1 && left - edges[i].mult <= 0) boundary.push_back({edges[i].a, edges[i].b, 1});
+    }
+
+    auto result = link_loops(std::move(boundary));
+    result.erase(std::remove_if(result.begin(), result.end(), [](FixedLoop& loop) { return !tidy_loop(loop); }), result.end());
+    return result;
+}
+
+std::vector<polygon_t> offset_polygons(const std::vector<polygon_t>& polys, float delta, const OffsetOptions& options,
+                                       bool* settled) {
+    std::vector<FixedLoop> raw;
+    float z = 0.0f;
+    for (const auto& poly : polys) {
+        FixedLoop loop = to_fixed(poly);
+        if (loop.size() < 3) continue;
+        z = poly.front().z;
+        const double fixed_delta = static_cast<double>(delta) * kOffsetScale;
+        raw.push_back(std::abs(fixed_delta) < 0.5 ? std::move(loop) : raw_offset(loop, fixed_delta, options));
+    }
+
+    std::vector<polygon_t> result;
+    for (const auto& loop : union_loops(raw, kUnionPasses, settled)) result.push_back(from_fixed(loop, z));
+    return result;
+}
@@ -0,0 +1,289 @@
+#include "include/planning/polygon_ops.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+float signed_area(const polygon_t& poly) {
+    if (poly.size() < 3) return 0.0f;
+    const bool closed = poly.front() == poly.back();
+    const std::size_t limit = closed ? poly.size() - 1 : poly.size();
+    float area = 0.0f;
+    for (std::size_t i = 0; i < limit; ++i) {
+        const auto& p0 = poly[i];
+        const auto& p1 = poly[(i + 1) % limit];
+        area += p0.x * p1.y - p1.x * p0.y;
+    }
+    return 0.5f * area;
+}
+
+vec3_t polygon_centroid(const polygon_t& poly) {
+    if (poly.empty()) return vec3_t{0.0f, 0.0f, 0.0f};
+    const bool closed = poly.front() == poly.back();
+    const std::size_t limit = closed && poly.size() > 1 ? poly.size() - 1 : poly.size();
+    vec3_t accum{0.0f, 0.0f, 0.0f};
+    for (std::size_t i = 0; i < limit; ++i) {
+        accum.x += poly[i].x;
+        accum.y += poly[i].y;
+        accum.z += poly[i].z;
+    }
+    float inv_count = limit > 0 ? 1.0f / static_cast<float>(limit) : 0.0f;
+    return {accum.x * inv_count, accum.y * inv_count, accum.z * inv_count};
+}
+
+bool point_in_polygon(const polygon_t& poly, const vec3_t& p) {
+    if (poly.size() < 3) return false;
+    const bool closed = poly.front() == poly.back();
+    const std::size_t limit = closed ? poly.size() - 1 : poly.size();
+    bool inside = false;
+    for (std::size_t i = 0, j = limit - 1; i < limit; j = i++) {
+        const auto& pi = poly[i];
+        const auto& pj = poly[j];
+        bool intersects = ((pi.y > p.y) != (pj.y > p.y)) &&
+            (p.x < (pj.x - pi.x) * (p.y - pi.y) / (pj.y - pi.y + 1e-12f) + pi.x);
+        if (intersects) inside = !inside;
+    }
+    return inside;
+}
+
+polygon_t ensure_closed(polygon_t poly) {
+    if (poly.size() < 2) return poly;
+    if (!(poly.front() == poly.back())) {
+        poly.push_back(poly.front());
+    }
+    return poly;
+}
+
+std::optional<vec3_t> interior_point(const polygon_t& poly) {
+    if (poly.size() < 2) return std::nullopt;
+    polygon_t closed = ensure_closed(poly);
+    if (closed.size() < 3) return std::nullopt;
+    const auto& p0 = closed[0];
+    const auto& p1 = closed[1];
+    float dx = p1.x - p0.x;
+    float dy = p1.y - p0.y;
+    float len = std::sqrt(dx * dx + dy * dy);
+    if (len < kMinSpan) return std::nullopt;
+    float nx = -dy / len;
+    float ny = dx / len;
+    float step = std::max(1e-4f, kSnapEps * 2.0f);
+    float orient = signed_area(closed) >= 0.0f ? 1.0f : -1.0f;
+    vec3_t mid{(p0.x + p1.x) * 0.5f, (p0.y + p1.y) * 0.5f, p0.z};
+    return vec3_t{mid.x + orient * nx * step, mid.y + orient * ny * step, mid.z};
+}
+
+std::vector<segment_t> polygon_to_segments(const polygon_t& poly, float z) {
+    std::vector<segment_t> segments;
+    if (poly.size() < 2) return segments;
+    const bool closed = poly.front() == poly.back();
+    const std::size_t limit = closed && poly.size() > 1 ? poly.size() - 1 : poly.size();
+    segments.reserve(limit);
+    for (std::size_t i = 0; i < limit; ++i) {
+        vec3_t p0 = poly[i];
+        vec3_t p1 = poly[(i + 1) % limit];
+        p0.z = z;
+        p1.z = z;
+        segments.push_back({p0, p1});
+    }
+    return segments;
+}
+
+Bounds bounds_for_polygon(const polygon_t& poly) {
+    Bounds bounds;
+    if (poly.empty()) return bounds;
+    const bool closed = poly.front() == poly.back();
+    const std::size_t limit = closed && poly.size() > 1 ? poly.size() - 1 : poly.size();
+    for (std::size_t i = 0; i < limit; ++i) {
+        bounds.min_x = std::min(bounds.min_x, poly[i].x);
+        bounds.max_x = std::max(bounds.max_x, poly[i].x);
+        bounds.min_y = std::min(bounds.min_y, poly[i].y);
+        bounds.max_y = std::max(bounds.max_y, poly[i].y);
+    }
+    return bounds;
+}
+
+
+Bounds containment_bounds(const polygon_t& poly) {
+    Bounds bounds;
+    if (poly.size() < 3) return bounds;
+    bounds = bounds_for_polygon(poly);
+
+    constexpr float kInf = std::numeric_limits<float>::infinity();
+    const bool closed = poly.front() == poly.back();
+    const std::size_t limit = closed ? poly.size() - 1 : poly.size();
+    bool unbounded_x = false;
+    for (std::size_t i = 0, j = limit - 1; i < limit; j = i++) {
+        if (!std::isfinite(poly[i].x) || !std::isfinite(poly[i].y)) {
+            return {-kInf, kInf, -kInf, kInf};
+        }
+        // point_in_polygon divides by (dy + 1e-12); a tiny negative dy blows up the crossing x
+        float dy = poly[i].y - poly[j].y;
+        if (dy < 0.0f && dy > -1e-9f) unbounded_x = true;
+    }
+    if (unbounded_x) {
+        bounds.min_x = -kInf;
+        bounds.max_x = kInf;
+        return bounds;
+    }
+    // crossings land within the edge's x span up to rounding of the interpolation
+    float margin = 2e-3f * (bounds.max_x - bounds.min_x) +
+        1e-5f * std::max(std::abs(bounds.min_x), std::abs(bounds.max_x)) + 1e-6f;
+    bounds.min_x -= margin;
+    bounds.max_x += margin;
+    return bounds;
+}
+
+
+BoxGridIndex::BoxGridIndex(const std::vector<Bounds>& boxes) {
+    auto usable = [](const Bounds& b) { return b.min_x <= b.max_x && b.min_y <= b.max_y; };
+
+    std::size_t count = 0;
+    for (const auto& b : boxes) {
+        if (!usable(b)) continue;
+        count++;
+        auto grow = [](float& lo, float& hi, float v) {
+            if (std::isfinite(v)) {
+                lo = std::min(lo, v);
+                hi = std::max(hi, v);
+            }
+        };
+        grow(_extent.min_x, _extent.max_x, b.min_x);
+        grow(_extent.min_x, _extent.max_x, b.max_x);
+        grow(_extent.min_y, _extent.max_y, b.min_y);
+        grow(_extent.min_y, _extent.max_y, b.max_y);
+    }
+    if (count == 0) return;
+    if (_extent.empty()) _extent = {0.0f, 0.0f, 0.0f, 0.0f};
+
+    // about one cell per box, split along the extent's aspect ratio
+    const float width = std::max(_extent.max_x - _extent.min_x, kMinSpan);
+    const float height = std::max(_extent.max_y - _extent.min_y, kMinSpan);
+    const double aspect = static_cast<double>(width) / static_cast<double>(height);
+    const double cells = static_cast<double>(count);
+    _nx = static_cast<std::size_t>(std::clamp(std::sqrt(cells * aspect), 1.0, cells));
+    _ny = static_cast<std::size_t>(std::clamp(cells / static_cast<double>(_nx), 1.0, cells));
+    _inv_cell_w = static_cast<float>(_nx) / width;
+    _inv_cell_h = static_cast<float>(_ny) / height;
+
+    auto cells_spanned = [&](const Bounds& b) {
+        return (cell_x(b.max_x) - cell_x(b.min_x) + 1) * (cell_y(b.max_y) - cell_y(b.min_y) + 1);
+    };
+    std::vector<bool> listed(boxes.size(), false);
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        if (!usable(boxes[i])) continue;
+        if (cells_spanned(boxes[i]) > kMaxCellsPerBox) {
+            _wide.push_back(static_cast<uint32_t>(i));
+        } else {
+            listed[i] = true;
+        }
+    }
+    auto for_each_cell = [&](const Bounds& b, auto&& fn) {
+        const std::size_t x0 = cell_x(b.min_x), x1 = cell_x(b.max_x);
+        const std::size_t y0 = cell_y(b.min_y), y1 = cell_y(b.max_y);
+        for (std::size_t cy = y0; cy <= y1; ++cy) {
+            for (std::size_t cx = x0; cx <= x1; ++cx) fn(cy * _nx + cx);
+        }
+    };
+    // counting pass, then fill: CSR cell lists with boxes in ascending index order
+    _cell_starts.assign(_nx * _ny + 1, 0);
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        if (listed[i]) for_each_cell(boxes[i], [&](std::size_t cell) { _cell_starts[cell + 1]++; });
+    }
+    for (std::size_t c = 1; c < _cell_starts.size(); ++c) _cell_starts[c] += _cell_starts[c - 1];
+    _items.resize(_cell_starts.back());
+    std::vector<uint32_t> cursor(_cell_starts.begin(), _cell_starts.end() - 1);
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        if (listed[i]) {
+            for_each_cell(boxes[i], [&](std::size_t cell) { _items[cursor[cell]++] = static_cast<uint32_t>(i); });
+        }
+    }
+}
+
+
+std::vector<ClassifiedPolygon> classify_polygons(std::vector<polygon_t> polys) {
+    std::vector<polygon_t> closed;
+    closed.reserve(polys.size());
+    for (auto& poly : polys) {
+        closed.push_back(ensure_closed(std::move(poly)));
+    }
+
+    std::vector<ClassifiedPolygon> result;
+    result.reserve(closed.size());
+    std::vector<std::optional<vec3_t>> interior_pts(closed.size());
+    std::vector<Bounds> boxes(closed.size());
+    for (std::size_t i = 0; i < closed.size(); ++i) {
+        interior_pts[i] = interior_point(closed[i]);
+        if (!interior_pts[i].has_value()) {
+            interior_pts[i] = polygon_centroid(closed[i]);
+        }
+        boxes[i] = containment_bounds(closed[i]);
+    }
+    const BoxGridIndex index(boxes);
+
+    for (std::size_t i = 0; i < closed.size(); ++i) {
+        int depth = 0;
+        if (interior_pts[i].has_value()) {
+            const vec3_t& p = *interior_pts[i];
+            index.for_each_candidate(p, [&](uint32_t j) {
+                if (j != i && boxes[j].contains(p) && point_in_polygon(closed[j], p)) {
+                    depth++;
+                }
+            });
+        }
+        float area = signed_area(closed[i]);
+        bool is_hole = (depth % 2) == 1;
+        polygon_t oriented = closed[i];
+        if (is_hole && area > 0.0f) {
+            std::reverse(oriented.begin(), oriented.end());
+            area = -area;
+        } else if (!is_hole && area < 0.0f) {
+            std::reverse(oriented.begin(), oriented.end());
+            area = -area;
+        }
+        result.push_back({std::move(oriented), area, depth, is_hole});
+    }
+
+    std::sort(result.begin(), result.end(), [](const ClassifiedPolygon& a, const ClassifiedPolygon& b) {
+        return std::abs(a.area) > std::abs(b.area);
+    });
+    return result;
+}
+
+std::vector<Island> build_islands(const std::vector<ClassifiedPolygon>& polys) {
+    std::vector<Island> islands;
+    std::vector<bool> hole_used(polys.size(), false);
+
+    // holes are indexed by centroid; an outer only tests the holes whose centroid falls inside
+    // its containment bounds, in index order, so assignment matches the all-pairs scan
+    std::vector<vec3_t> centroids(polys.size());
+    std::vector<Bounds> hole_points(polys.size());
+    for (std::size_t h = 0; h < polys.size(); ++h) {
+        if (!polys[h].is_hole) continue;
+        centroids[h] = polygon_centroid(polys[h].poly);
+        hole_points[h] = {centroids[h].x, centroids[h].x, centroids[h].y, centroids[h].y};
+    }
+    const BoxGridIndex index(hole_points);
+
+    std::vector<uint32_t> candidates;
+    for (std::size_t i = 0; i < polys.size(); ++i) {
+        if (polys[i].is_hole) continue;
+        Island island;
+        island.outer = polys[i].poly;
+        const Bounds reach = containment_bounds(island.outer);
+        candidates.clear();
+        index.for_each_in_rect(reach, [&](uint32_t h) {
+            if (!hole_used[h] && reach.contains(centroids[h])) candidates.push_back(h);
+        });
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+        for (uint32_t h : candidates) {
+            if (point_in_polygon(island.outer, centroids[h])) {
+                island.holes.push_back(polys[h].poly);
+                hole_used[h] = true;
+            }
+        }
+        islands.push_back(std::move(island));
+    }
+
+    return islands;
+}
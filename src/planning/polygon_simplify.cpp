@@ -0,0 +1,229 @@
+#include "include/planning/polygon_simplify.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+
+namespace {
+
+double cross(const vec3_t& o, const vec3_t& a, const vec3_t& b) {
+    return (static_cast<double>(a.x) - o.x) * (static_cast<double>(b.y) - o.y) -
+           (static_cast<double>(a.y) - o.y) * (static_cast<double>(b.x) - o.x);
+}
+
+double segment_distance_sq(const vec3_t& p, const vec3_t& a, const vec3_t& b) {
+    const double dx = static_cast<double>(b.x) - a.x, dy = static_cast<double>(b.y) - a.y;
+    double px = static_cast<double>(p.x) - a.x, py = static_cast<double>(p.y) - a.y;
+    const double len_sq = dx * dx + dy * dy;
+    if (len_sq > 0.0) {
+        const double t = std::clamp((px * dx + py * dy) / len_sq, 0.0, 1.0);
+        px -= t * dx;
+        py -= t * dy;
+    }
+    return px * px + py * py;
+}
+
+std::size_t open_size(const polygon_t& loop) {
+    return loop.size() > 1 && loop.front() == loop.back() ? loop.size() - 1 : loop.size();
+}
+
+// For p collinear with ab: whether it lies on the segment.
+bool within(const vec3_t& a, const vec3_t& b, const vec3_t& p) {
+    return std::min(a.x, b.x) <= p.x && p.x <= std::max(a.x, b.x) && std::min(a.y, b.y) <= p.y && p.y <= std::max(a.y, b.y);
+}
+
+// Whether the closed segments ab and cd share a point: a crossing, a T or a collinear overlap.
+bool segments_touch(const vec3_t& a, const vec3_t& b, const vec3_t& c, const vec3_t& d) {
+    const double d1 = cross(a, b, c), d2 = cross(a, b, d), d3 = cross(c, d, a), d4 = cross(c, d, b);
+    if (((d1 > 0.0 && d2 < 0.0) || (d1 < 0.0 && d2 > 0.0)) && ((d3 > 0.0 && d4 < 0.0) || (d3 < 0.0 && d4 > 0.0))) return true;
+    return (d1 == 0.0 && within(a, b, c)) || (d2 == 0.0 && within(a, b, d)) || (d3 == 0.0 && within(c, d, a)) ||
+           (d4 == 0.0 && within(c, d, b));
+}
+
+// Whether edges meeting at `shared` and running out to p and q double back over each other.
+bool folds_back(const vec3_t& shared, const vec3_t& p, const vec3_t& q) {
+    if (cross(shared, p, q) != 0.0) return false;
+    return (static_cast<double>(p.x) - shared.x) * (static_cast<double>(q.x) - shared.x) +
+           (static_cast<double>(p.y) - shared.y) * (static_cast<double>(q.y) - shared.y) > 0.0;
+}
+
+struct LoopEdge {
+    uint32_t loop;
+    uint32_t index;  // runs from vertex index to index + 1, wrapping
+};
+
+} // namespace
+
+
+polygon_t simplify_loop(const polygon_t& loop, float tolerance) {
+    const std::size_t n = open_size(loop);
+    if (n < 4 || !(tolerance > 0.0f)) return loop;
+
+    // split at the first vertex and the one farthest from it, then simplify both chains
+    std::size_t far = 0;
+    float far_d2 = 0.0f;
+    for (std::size_t i = 1; i < n; ++i) {
+        const float d2 = dist2d_sq(loop[0], loop[i]);
+        if (d2 > far_d2) {
+            far_d2 = d2;
+            far = i;
+        }
+    }
+    if (far == 0) return loop;
+
+    const double tol_sq = static_cast<double>(tolerance) * tolerance;
+    auto at = [&](std::size_t i) -> const vec3_t& { return loop[i % n]; };
+    std::vector<uint8_t> keep(n + 1, 0);  // n stands for the first vertex again
+    keep[0] = keep[far] = keep[n] = 1;
+    std::vector<std::pair<std::size_t, std::size_t>> pending{{0, far}, {far, n}};
+    while (!pending.empty()) {
+        const auto [lo, hi] = pending.back();
+        pending.pop_back();
+        double worst = tol_sq;
+        std::size_t split = 0;
+        for (std::size_t i = lo + 1; i < hi; ++i) {
+            const double d2 = segment_distance_sq(at(i), at(lo), at(hi));
+            if (d2 > worst) {
+                worst = d2;
+                split = i;
+            }
+        }
+        if (split == 0) continue;
+        keep[split] = 1;
+        pending.push_back({lo, split});
+        pending.push_back({split, hi});
+    }
+
+    polygon_t out;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (keep[i]) out.push_back(loop[i]);
+    }
+    if (out.size() < 3) return loop;
+    out.push_back(out.front());
+    return out;
+}
+
+SimplifyStats simplify_islands(std::vector<Island>& islands, float tolerance) {
+    std::vector<polygon_t*> loops;
+    for (auto& island : islands) {
+        loops.push_back(&island.outer);
+        for (auto& hole : island.holes) loops.push_back(&hole);
+    }
+    SimplifyStats stats;
+    stats.loops = loops.size();
+    if (!(tolerance > 0.0f)) {
+        for (const auto* loop : loops) stats.vertices_before += open_size(*loop);
+        stats.vertices_after = stats.vertices_before;
+        return stats;
+    }
+
+    std::vector<polygon_t> original(loops.size());
+    std::vector<uint8_t> simplified(loops.size(), 0);
+    for (std::size_t l = 0; l < loops.size(); ++l) {
+        original[l] = *loops[l];
+        auto loop = simplify_loop(original[l], tolerance);
+        if (open_size(loop) == open_size(original[l])) continue;
+        simplified[l] = 1;
+        *loops[l] = std::move(loop);
+    }
+    const std::vector<uint8_t> reducible = simplified;
+
+    const double tol_sq = static_cast<double>(tolerance) * tolerance;
+    std::vector<LoopEdge> edges;
+    std::vector<Bounds> boxes;
+    std::vector<uint8_t> revert(loops.size());
+    std::vector<uint32_t> checked;
+    for (;;) {
+        edges.clear();
+        boxes.clear();
+        for (uint32_t l = 0; l < loops.size(); ++l) {
+            const auto& loop = *loops[l];
+            const std::size_t n = open_size(loop);
+            for (uint32_t k = 0; k < n; ++k) {
+                const vec3_t& a = loop[k];
+                const vec3_t& b = loop[(k + 1) % n];
+                edges.push_back({l, k});
+                boxes.push_back({std::min(a.x, b.x), std::max(a.x, b.x), std::min(a.y, b.y), std::max(a.y, b.y)});
+            }
+        }
+        if (edges.empty()) break;
+        BoxGridIndex grid(boxes);
+        auto endpoints = [&](const LoopEdge& e) {
+            const auto& loop = *loops[e.loop];
+            return std::pair<const vec3_t&, const vec3_t&>{loop[e.index], loop[(e.index + 1) % open_size(loop)]};
+        };
+        std::fill(revert.begin(), revert.end(), 0);
+        bool any = false;
+        auto put_back = [&](uint32_t l) {
+            if (simplified[l] && !revert[l]) {
+                revert[l] = 1;
+                any = true;
+            }
+        };
+
+        // crossings, with the loop itself or any other; loops still in their sliced form are
+        // taken to be clean against each other
+        for (uint32_t e = 0; e < edges.size(); ++e) {
+            const LoopEdge& edge = edges[e];
+            grid.for_each_in_rect(boxes[e], [&](uint32_t f) {
+                const LoopEdge& other = edges[f];
+                if (f <= e || (!simplified[edge.loop] && !simplified[other.loop])) return;
+                const auto [a, b] = endpoints(edge);
+                const auto [c, d] = endpoints(other);
+                bool conflict = false;
+                const std::size_t n = open_size(*loops[edge.loop]);
+                if (edge.loop == other.loop && (edge.index + 1) % n == other.index) {
+                    conflict = folds_back(b, a, d);
+                } else if (edge.loop == other.loop && (other.index + 1) % n == edge.index) {
+                    conflict = folds_back(a, b, c);
+                } else {
+                    conflict = segments_touch(a, b, c, d);
+                }
+                if (conflict) {
+                    put_back(edge.loop);
+                    put_back(other.loop);
+                }
+            });
+        }
+
+        // without crossings a loop keeps its side of another unless it sat in the sliver that
+        // other loop's simplified edges cut off, which lies within tolerance of those edges;
+        // the first vertex is always kept, so it is tested as sliced
+        for (uint32_t l = 0; l < loops.size(); ++l) {
+            const vec3_t& v = (*loops[l])[0];
+            checked.clear();
+            grid.for_each_in_rect({v.x - tolerance, v.x + tolerance, v.y - tolerance, v.y + tolerance}, [&](uint32_t f) {
+                const uint32_t m = edges[f].loop;
+                if (m == l || !simplified[m] || revert[m]) return;
+                if (std::find(checked.begin(), checked.end(), m) != checked.end()) return;
+                const auto [c, d] = endpoints(edges[f]);
+                if (segment_distance_sq(v, c, d) > tol_sq) return;
+                checked.push_back(m);
+                if (point_in_polygon(original[m], v) != point_in_polygon(*loops[m], v)) {
+                    put_back(m);
+                    put_back(l);
+                }
+            });
+        }
+
+        // a loop that changed orientation without crossing itself has collapsed onto a sliver
+        for (uint32_t l = 0; l < loops.size(); ++l) {
+            if (simplified[l] && (signed_area(*loops[l]) > 0.0f) != (signed_area(original[l]) > 0.0f)) put_back(l);
+        }
+
+        if (!any) break;
+        for (uint32_t l = 0; l < loops.size(); ++l) {
+            if (!revert[l]) continue;
+            *loops[l] = original[l];
+            simplified[l] = 0;
+        }
+    }
+
+    for (std::size_t l = 0; l < loops.size(); ++l) {
+        stats.vertices_before += open_size(original[l]);
+        stats.vertices_after += open_size(*loops[l]);
+        if (reducible[l] && !simplified[l]) stats.loops_kept++;
+    }
+    return stats;
+}
@@ -0,0 +1,115 @@
+#include "include/planning/scanline.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+uint32_t ScanlineEdgeTable::add_loop(const polygon_t& loop) {
+    const uint32_t index = _loop_count++;
+    _sorted = false;
+    if (loop.size() < 2) return index;
+    const bool closed = loop.front() == loop.back();
+    const std::size_t limit = closed ? loop.size() - 1 : loop.size();
+    for (std::size_t i = 0; i < limit; ++i) {
+        const auto& p0 = loop[i];
+        const auto& p1 = loop[(i + 1) % limit];
+        if (std::abs(p0.y - p1.y) < kMinSpan) continue;  // flat edges never cross a scanline
+        _edges.push_back({std::min(p0.y, p1.y), std::max(p0.y, p1.y), p0.x, p0.y, p1.x, p1.y, index,
+                          p1.y > p0.y ? 1 : -1});
+    }
+    return index;
+}
+
+void ScanlineEdgeTable::sort_edges() {
+    std::stable_sort(_edges.begin(), _edges.end(), [](const Edge& a, const Edge& b) { return a.y_lo < b.y_lo; });
+    _sorted = true;
+    _open.assign(_loop_count, 0);
+    _open_x.assign(_loop_count, 0.0f);
+}
+
+void ScanlineEdgeTable::advance(float y) {
+    if (!_sorted) sort_edges();
+    _y = y;
+
+    _active.erase(std::remove_if(_active.begin(), _active.end(),
+                                 [&](const Crossing& c) { return !(y < _edges[c.edge].y_hi); }),
+                  _active.end());
+    for (; _next < _edges.size() && _edges[_next].y_lo <= y; ++_next) {
+        if (y < _edges[_next].y_hi) _active.push_back({0.0f, static_cast<uint32_t>(_next)});
+    }
+
+    for (auto& c : _active) {
+        const Edge& e = _edges[c.edge];
+        float t = (y - e.y0) / (e.y1 - e.y0);
+        c.x = e.x0 + t * (e.x1 - e.x0);
+    }
+    // the previous line's order is nearly right: only crossing edges and new arrivals move
+    for (std::size_t i = 1; i < _active.size(); ++i) {
+        Crossing c = _active[i];
+        std::size_t j = i;
+        for (; j > 0 && c.x < _active[j - 1].x; --j) _active[j] = _active[j - 1];
+        _active[j] = c;
+    }
+}
+
+const std::vector<LoopSpan>& ScanlineEdgeTable::loop_spans() {
+    _loop_spans.clear();
+    for (const auto& c : _active) {
+        const uint32_t loop = _edges[c.edge].loop;
+        if (!_open[loop]) {
+            _open[loop] = 1;
+            _open_x[loop] = c.x;
+        } else {
+            _open[loop] = 0;
+            if (c.x - _open_x[loop] >= kMinSpan) _loop_spans.push_back({loop, _open_x[loop], c.x});
+        }
+    }
+    for (const auto& c : _active) _open[_edges[c.edge].loop] = 0;  // unpaired crossings
+    std::stable_sort(_loop_spans.begin(), _loop_spans.end(),
+                     [](const LoopSpan& a, const LoopSpan& b) { return a.loop < b.loop; });
+    return _loop_spans;
+}
+
+std::vector<Span> ScanlineEdgeTable::fill_spans(FillRule rule) const {
+    std::vector<Span> spans;
+    int winding = 0;
+    float start = 0.0f;
+    for (const auto& c : _active) {
+        const bool was_inside = rule == FillRule::EvenOdd ? (winding & 1) != 0 : winding != 0;
+        winding += rule == FillRule::EvenOdd ? 1 : _edges[c.edge].winding;
+        const bool inside = rule == FillRule::EvenOdd ? (winding & 1) != 0 : winding != 0;
+        if (!was_inside && inside) {
+            start = c.x;
+        } else if (was_inside && !inside && c.x - start >= kMinSpan) {
+            spans.emplace_back(start, c.x);
+        }
+    }
+    return spans;
+}
+
+std::vector<Span> subtract_spans(std::vector<Span> base, const std::vector<Span>& cuts) {
+    if (base.empty() || cuts.empty()) return base;
+    std::vector<Span> ordered_cuts = cuts;
+    std::sort(ordered_cuts.begin(), ordered_cuts.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    std::vector<Span> result;
+    for (const auto& span : base) {
+        float start = span.first;
+        float end = span.second;
+        float cursor = start;
+        for (const auto& cut : ordered_cuts) {
+            if (cut.second <= cursor || cut.first >= end) continue;
+            if (cut.first > cursor + kMinSpan) {
+                result.emplace_back(cursor, std::min(cut.first, end));
+            }
+            cursor = std::max(cursor, cut.second);
+            if (cursor >= end) break;
+        }
+        if (cursor < end - kMinSpan) {
+            result.emplace_back(cursor, end);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,218 @@
+#include "include/planning/sweep_slicer.hpp"
+#include "include/planning/intersect_kernel.hpp"
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+
+
+namespace {
+
+// Corners are copied in when a triangle enters, so the per-layer pass streams through the
+// active list instead of gathering scattered triangles and points on every layer.
+struct ActiveTriangle {
+    uint32_t order; // position in (mesh, triangle) order
+    int last_layer;
+    std::array<vec3_t, 3> corners;
+
+    bool operator<(const ActiveTriangle& other) const { return order < other.order; }
+};
+
+// planes farther than this from a triangle's z-range cannot touch it (intersection uses 1e-5)
+constexpr float kSweepRejectEps = 1e-4f;
+
+// The layers whose plane can actually reach the triangle. The margin is twice the reject
+// distance, so every plane the per-layer test accepts is inside; any layer kept here that
+// still misses is rejected per layer.
+std::pair<int, int> reachable_layers(float min_z, float max_z, const LayerSchedule& schedule) {
+    constexpr float kMargin = 2.0f * kSweepRejectEps;
+    return schedule.layers_within(min_z - kMargin, max_z + kMargin);
+}
+
+
+// Steps the plane through every layer. enter(l) returns the triangles whose first layer is l,
+// sorted by order; the active list is merged with them, so it always stays in order.
+template <typename EnterFn>
+void sweep_layers(const LayerSchedule& schedule, std::size_t expected_segments, EnterFn&& enter,
+                  LayerSegments& result) {
+    const std::size_t num_layers = schedule.layer_count();
+    // an upper bound when most (triangle, layer) pairs cut at most once; untouched pages stay unbacked
+    result.segments.reserve(expected_segments);
+
+    std::vector<ActiveTriangle> active;
+    std::vector<ActiveTriangle> merged;
+    TriangleBlockStorage block;
+    std::vector<segment_t> cuts(TriangleBlockStorage::kCapacity * kMaxTriangleSegments);
+    uint8_t counts[TriangleBlockStorage::kCapacity];
+    float z = 0.0f;
+
+    auto flush = [&] {
+        intersect_block(block.view(), z, cuts.data(), counts);
+        for (std::size_t i = 0; i < block.count; ++i) {
+            const segment_t* first = cuts.data() + i * kMaxTriangleSegments;
+            result.segments.insert(result.segments.end(), first, first + counts[i]);
+        }
+        block.count = 0;
+    };
+
+    for (std::size_t l = 0; l < num_layers; ++l) {
+        const int layer = static_cast<int>(l);
+        active.erase(std::remove_if(active.begin(), active.end(),
+                                    [layer](const ActiveTriangle& a) { return a.last_layer < layer; }),
+                     active.end());
+        std::span<const ActiveTriangle> entering = enter(l);
+        if (!entering.empty()) {
+            merged.clear();
+            std::merge(active.begin(), active.end(), entering.begin(), entering.end(), std::back_inserter(merged));
+            active.swap(merged);
+        }
+
+        z = schedule.z(l);
+        for (const auto& a : active) {
+            const auto& [v0, v1, v2] = a.corners;
+            // the rounded layer span covers planes just outside the triangle; those cut nothing
+            if (std::min({v0.z, v1.z, v2.z}) - z >= kSweepRejectEps || z - std::max({v0.z, v1.z, v2.z}) >= kSweepRejectEps) {
+                continue;
+            }
+            block.push(v0, v1, v2);
+            if (block.full()) flush();
+        }
+        if (block.count > 0) flush();
+        result.offsets[l + 1] = result.segments.size();
+    }
+}
+
+// Sorts (order << 32 | index) keys by order. Orders are unique, so an LSD radix sort over the
+// order bits in use is exact; tiny batches go through std::sort.
+void sort_entry_keys(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch, int order_bits) {
+    constexpr int kDigitBits = 11;
+    constexpr std::size_t kRadix = std::size_t{1} << kDigitBits;
+    if (keys.size() < 512) {
+        std::sort(keys.begin(), keys.end());
+        return;
+    }
+    scratch.resize(keys.size());
+    std::array<std::size_t, kRadix> counts;
+    for (int shift = 32; shift < 32 + order_bits; shift += kDigitBits) {
+        counts.fill(0);
+        for (uint64_t key : keys) counts[(key >> shift) & (kRadix - 1)]++;
+        std::size_t offset = 0;
+        for (auto& c : counts) {
+            std::size_t n = c;
+            c = offset;
+            offset += n;
+        }
+        for (uint64_t key : keys) scratch[counts[(key >> shift) & (kRadix - 1)]++] = key;
+        keys.swap(scratch);
+    }
+}
+
+} // namespace
+
+
+LayerSegments sweep_slice(const std::vector<Mesh>& meshes, const LayerSchedule& schedule) {
+    LayerSegments result;
+    const std::size_t num_layers = schedule.layer_count();
+    result.offsets.assign(num_layers + 1, 0);
+    if (num_layers == 0) return result;
+
+    auto triangle_layers = [&](const Mesh& mesh, const triangle_t& tri) {
+        float z0 = mesh.points[tri.vertices[0]].z;
+        float z1 = mesh.points[tri.vertices[1]].z;
+        float z2 = mesh.points[tri.vertices[2]].z;
+        return reachable_layers(std::min({z0, z1, z2}), std::max({z0, z1, z2}), schedule);
+    };
+
+    // events: counting sort by first layer, stable in (mesh, triangle) order
+    std::vector<std::size_t> enter_offsets(num_layers + 1, 0);
+    std::size_t expected_segments = 0;
+    for (const Mesh& mesh : meshes) {
+        for (const auto& tri : mesh.triangles) {
+            auto [first, last] = triangle_layers(mesh, tri);
+            if (first > last) continue;
+            enter_offsets[static_cast<std::size_t>(first) + 1]++;
+            expected_segments += static_cast<std::size_t>(last - first + 1);
+        }
+    }
+    for (std::size_t l = 0; l < num_layers; ++l) enter_offsets[l + 1] += enter_offsets[l];
+
+    std::vector<ActiveTriangle> entering(enter_offsets[num_layers]);
+    {
+        std::vector<std::size_t> cursor(enter_offsets.begin(), enter_offsets.end() - 1);
+        uint32_t order = 0;
+        for (const Mesh& mesh : meshes) {
+            for (const auto& tri : mesh.triangles) {
+                auto [first, last] = triangle_layers(mesh, tri);
+                if (first <= last) {
+                    entering[cursor[static_cast<std::size_t>(first)]++] = {
+                        order, last,
+                        {mesh.points[tri.vertices[0]], mesh.points[tri.vertices[1]], mesh.points[tri.vertices[2]]}
+                    };
+                }
+                order++;
+            }
+        }
+    }
+    sweep_layers(schedule, expected_segments, [&](std::size_t l) {
+        return std::span<const ActiveTriangle>(entering).subspan(enter_offsets[l], enter_offsets[l + 1] - enter_offsets[l]);
+    }, result);
+    return result;
+}
+
+
+LayerSegments sweep_slice(const std::vector<MeshSoA>& meshes, const LayerSchedule& schedule) {
+    LayerSegments result;
+    const std::size_t num_layers = schedule.layer_count();
+    result.offsets.assign(num_layers + 1, 0);
+    if (num_layers == 0) return result;
+
+    // triangles are in z_min order, so each mesh's entries form a forward scan; order is the
+    // (mesh, source triangle) rank, the same key the Mesh overload uses
+    std::vector<std::size_t> cursors(meshes.size(), 0);
+    std::vector<uint32_t> order_base(meshes.size(), 0);
+    std::size_t expected_segments = 0;
+    for (std::size_t m = 0; m < meshes.size(); ++m) {
+        if (m > 0) order_base[m] = order_base[m - 1] + static_cast<uint32_t>(meshes[m - 1].triangle_count());
+        const MeshSoA& mesh = meshes[m];
+        for (std::size_t i = 0; i < mesh.triangle_count(); ++i) {
+            auto [first, last] = reachable_layers(mesh.z_min[i], mesh.z_max[i], schedule);
+            if (first <= last) expected_segments += static_cast<std::size_t>(last - first + 1);
+        }
+    }
+
+    // each layer's entries are ranked on 8-byte (order, index) keys, then expanded in order from
+    // the band of triangles just scanned
+    std::vector<uint64_t> keys, scratch;
+    std::vector<ActiveTriangle> entering;
+    int order_bits = 0;
+    for (uint64_t total = order_base.empty() ? 0 : order_base.back() + meshes.back().triangle_count(); total > 0; total >>= 1) {
+        order_bits++;
+    }
+    sweep_layers(schedule, expected_segments, [&](std::size_t l) {
+        keys.clear();
+        for (std::size_t m = 0; m < meshes.size(); ++m) {
+            const MeshSoA& mesh = meshes[m];
+            std::size_t& i = cursors[m];
+            for (; i < mesh.triangle_count(); ++i) {
+                auto [first, last] = reachable_layers(mesh.z_min[i], mesh.z_max[i], schedule);
+                if (first > static_cast<int>(l)) break;
+                if (first > last) continue; // entirely below the plate or above the build volume
+                keys.push_back(static_cast<uint64_t>(order_base[m] + mesh.source_triangle[i]) << 32 | i);
+            }
+        }
+        sort_entry_keys(keys, scratch, order_bits);
+
+        entering.clear();
+        std::size_t m = 0;
+        for (uint64_t key : keys) {
+            const auto order = static_cast<uint32_t>(key >> 32);
+            const auto i = static_cast<std::size_t>(key & 0xffffffffu);
+            while (m + 1 < meshes.size() && order >= order_base[m + 1]) m++;
+            const MeshSoA& mesh = meshes[m];
+            entering.push_back({order, reachable_layers(mesh.z_min[i], mesh.z_max[i], schedule).second,
+                                {mesh.corner(i, 0), mesh.corner(i, 1), mesh.corner(i, 2)}});
+        }
+        return std::span<const ActiveTriangle>(entering);
+    }, result);
+    return result;
+}
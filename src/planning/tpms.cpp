@@ -0,0 +1,406 @@
+#include "include/planning/tpms.hpp"
+#include "include/planning/polygon_ops.hpp"
+#include "include/planning/scanline.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PRINTER_HAS_AVX2_KERNEL 1
+#endif
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define PRINTER_HAS_NEON_KERNEL 1
+#endif
+
+// The vector rows must round exactly like the scalar one, so no multiply-add fusion here.
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#endif
+
+
+namespace {
+
+constexpr double kTwoPi = 6.28318530717958647692;
+
+// period / spacing that gives each surface's layer curves the length per area of straight
+// lines `spacing` apart (1 / spacing), measured over a full period of z
+float period_per_spacing(TpmsSurface surface) {
+    switch (surface) {
+    case TpmsSurface::Gyroid: return 2.47f;
+    case TpmsSurface::SchwarzP: return 1.89f;
+    case TpmsSurface::SchwarzD: return 3.06f;
+    }
+    return 1.0f;
+}
+
+void combine_row_scalar(const float* a, const float* b, float p, float q, float r, float* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) out[i] = (a[i] * p + b[i] * q) + r;
+}
+
+#if defined(PRINTER_HAS_AVX2_KERNEL)
+__attribute__((target("avx2")))
+void combine_row_avx2(const float* a, const float* b, float p, float q, float r, float* out, std::size_t n) {
+    const __m256 vp = _mm256_set1_ps(p);
+    const __m256 vq = _mm256_set1_ps(q);
+    const __m256 vr = _mm256_set1_ps(r);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 ap = _mm256_mul_ps(_mm256_loadu_ps(a + i), vp);
+        __m256 bq = _mm256_mul_ps(_mm256_loadu_ps(b + i), vq);
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_add_ps(ap, bq), vr));
+    }
+    combine_row_scalar(a + i, b + i, p, q, r, out + i, n - i);
+}
+#endif
+
+#if defined(PRINTER_HAS_NEON_KERNEL)
+void combine_row_neon(const float* a, const float* b, float p, float q, float r, float* out, std::size_t n) {
+    const float32x4_t vp = vdupq_n_f32(p);
+    const float32x4_t vq = vdupq_n_f32(q);
+    const float32x4_t vr = vdupq_n_f32(r);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t ap = vmulq_f32(vld1q_f32(a + i), vp);
+        float32x4_t bq = vmulq_f32(vld1q_f32(b + i), vq);
+        vst1q_f32(out + i, vaddq_f32(vaddq_f32(ap, bq), vr));
+    }
+    combine_row_scalar(a + i, b + i, p, q, r, out + i, n - i);
+}
+#endif
+
+struct Edge2 {
+    float x0, y0, x1, y1;
+};
+
+double orient(double ax, double ay, double bx, double by, double cx, double cy) {
+    return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+}
+
+// Which side of e the point is on (true: left). A point on the edge's line counts as nudged
+// right and then up, the way the scanline breaks ties, so points are never on an edge and a
+// point on a grid row gets the side its row's spans give it.
+bool left_of(const Edge2& e, const vec3_t& p, double& side) {
+    side = orient(e.x0, e.y0, e.x1, e.y1, p.x, p.y);
+    if (side != 0.0) return side > 0.0;
+    if (e.y1 != e.y0) return e.y1 < e.y0;
+    return e.x1 > e.x0;
+}
+
+// Which side of the line p-q the vertex v is on, with p-q nudged the same way.
+bool vertex_left_of(const vec3_t& p, const vec3_t& q, float vx, float vy) {
+    const double side = orient(p.x, p.y, q.x, q.y, vx, vy);
+    if (side != 0.0) return side > 0.0;
+    if (q.y != p.y) return q.y > p.y;
+    return q.x < p.x;
+}
+
+// Whether p-q crosses edge e under the nudge. `side_p` and `side_q` are p's and q's signed
+// distances from e.
+bool crosses(const vec3_t& p, const vec3_t& q, const Edge2& e, double& side_p, double& side_q) {
+    if (vertex_left_of(p, q, e.x0, e.y0) == vertex_left_of(p, q, e.x1, e.y1)) return false;
+    return left_of(e, p, side_p) != left_of(e, q, side_q);
+}
+
+// Whether p is inside: the loop edges crossed by a ray from p towards -x, nudged like left_of.
+// `row_edges` must hold every edge that reaches p's height.
+bool inside_by_ray(const vec3_t& p, const std::vector<Edge2>& edges, const std::vector<uint32_t>& row_edges) {
+    bool inside = false;
+    for (uint32_t index : row_edges) {
+        const auto& e = edges[index];
+        if ((e.y0 <= p.y) == (e.y1 <= p.y)) continue;
+        const bool upwards = e.y1 > e.y0;
+        const double side = upwards ? orient(e.x0, e.y0, e.x1, e.y1, p.x, p.y) : orient(e.x1, e.y1, e.x0, e.y0, p.x, p.y);
+        if (side <= 0.0) inside = !inside;
+    }
+    return inside;
+}
+
+// Appends the parts of p-q inside the region, given whether p is inside and the loop edges
+// that may cross it.
+void clip_piece(const vec3_t& p, const vec3_t& q, bool p_inside, const std::vector<Edge2>& edges,
+                const std::pair<uint64_t, uint32_t>* first, const std::pair<uint64_t, uint32_t>* last,
+                std::vector<float>& cuts, std::vector<segment_t>& out) {
+    cuts.clear();
+    for (auto it = first; it != last; ++it) {
+        double side_p = 0.0, side_q = 0.0;
+        if (crosses(p, q, edges[it->second], side_p, side_q)) cuts.push_back(static_cast<float>(side_p / (side_p - side_q)));
+    }
+    std::sort(cuts.begin(), cuts.end());
+    cuts.push_back(1.0f);
+    bool inside = p_inside;
+    float from = 0.0f;
+    for (float to : cuts) {
+        if (inside) {
+            vec3_t a = p + (q - p) * from;
+            vec3_t b = p + (q - p) * to;
+            if ((b - a).norm() >= kMinSpan) out.push_back({a, b});
+        }
+        inside = !inside;
+        from = to;
+    }
+}
+
+} // namespace
+
+
+float tpms_period_for_spacing(TpmsSurface surface, float spacing) {
+    return period_per_spacing(surface) * spacing;
+}
+
+TpmsLayerField::TpmsLayerField(TpmsSurface surface, float period, float z, float x0, float step, std::size_t nx)
+    : _surface(surface), _k(static_cast<float>(kTwoPi / static_cast<double>(period))), _a(nx), _b(nx) {
+    const float zk = _k * z;
+    _sin_z = std::sin(zk);
+    _cos_z = std::cos(zk);
+    for (std::size_t i = 0; i < nx; ++i) {
+        const float xk = _k * (x0 + static_cast<float>(i) * step);
+        switch (_surface) {
+        case TpmsSurface::Gyroid:
+        case TpmsSurface::SchwarzD:
+            _a[i] = std::sin(xk);
+            _b[i] = std::cos(xk);
+            break;
+        case TpmsSurface::SchwarzP:
+            _a[i] = std::cos(xk);
+            _b[i] = 0.0f;
+            break;
+        }
+    }
+}
+
+void TpmsLayerField::row(float y, float* out) const {
+    row(active_intersect_kernel(), y, out);
+}
+
+void TpmsLayerField::row(IntersectKernel kernel, float y, float* out) const {
+    const float yk = _k * y;
+    float p = 1.0f, q = 0.0f, r = 0.0f;
+    switch (_surface) {
+    case TpmsSurface::Gyroid:
+        // sin x cos y + cos x sin z + sin y cos z
+        p = std::cos(yk);
+        q = _sin_z;
+        r = std::sin(yk) * _cos_z;
+        break;
+    case TpmsSurface::SchwarzP:
+        r = std::cos(yk) + _cos_z;
+        break;
+    case TpmsSurface::SchwarzD:
+        // sin x cos(y - z) + cos x sin(y + z)
+        p = std::cos(yk) * _cos_z + std::sin(yk) * _sin_z;
+        q = std::sin(yk) * _cos_z + std::cos(yk) * _sin_z;
+        break;
+    }
+
+    if (!intersect_kernel_supported(kernel)) {
+        throw std::runtime_error(std::string("Field kernel not supported on this CPU: ") + intersect_kernel_name(kernel));
+    }
+    switch (kernel) {
+    case IntersectKernel::Avx2:
+#if defined(PRINTER_HAS_AVX2_KERNEL)
+        combine_row_avx2(_a.data(), _b.data(), p, q, r, out, _a.size());
+        return;
+#else
+        break;
+#endif
+    case IntersectKernel::Neon:
+#if defined(PRINTER_HAS_NEON_KERNEL)
+        combine_row_neon(_a.data(), _b.data(), p, q, r, out, _a.size());
+        return;
+#else
+        break;
+#endif
+    case IntersectKernel::Scalar:
+        break;
+    }
+    combine_row_scalar(_a.data(), _b.data(), p, q, r, out, _a.size());
+}
+
+float TpmsLayerField::at(TpmsSurface surface, float period, const vec3_t& p) {
+    const double k = kTwoPi / static_cast<double>(period);
+    const double x = k * p.x, y = k * p.y, z = k * p.z;
+    switch (surface) {
+    case TpmsSurface::Gyroid:
+        return static_cast<float>(std::sin(x) * std::cos(y) + std::sin(y) * std::cos(z) + std::sin(z) * std::cos(x));
+    case TpmsSurface::SchwarzP:
+        return static_cast<float>(std::cos(x) + std::cos(y) + std::cos(z));
+    case TpmsSurface::SchwarzD:
+        return static_cast<float>(std::sin(x) * std::sin(y) * std::sin(z) + std::sin(x) * std::cos(y) * std::cos(z) +
+                                  std::cos(x) * std::sin(y) * std::cos(z) + std::cos(x) * std::cos(y) * std::sin(z));
+    }
+    return 0.0f;
+}
+
+std::vector<segment_t> tpms_infill(const polygon_t& outer, const std::vector<polygon_t>& holes, TpmsSurface surface,
+                                   float spacing, float z) {
+    std::vector<segment_t> infill;
+    if (outer.empty() || !(spacing > 0.0f)) return infill;
+    Bounds bounds = bounds_for_polygon(outer);
+    if (bounds.empty()) return infill;
+
+    // grid lines on multiples of step, with a cell of margin so the border vertices are outside
+    const float period = tpms_period_for_spacing(surface, spacing);
+    const float step = period / static_cast<float>(kTpmsSamplesPerPeriod);
+    const auto first_col = static_cast<long>(std::floor(bounds.min_x / step)) - 1;
+    const auto first_row = static_cast<long>(std::floor(bounds.min_y / step)) - 1;
+    const auto nx = static_cast<std::size_t>(static_cast<long>(std::ceil(bounds.max_x / step)) + 1 - first_col + 1);
+    const auto ny = static_cast<std::size_t>(static_cast<long>(std::ceil(bounds.max_y / step)) + 1 - first_row + 1);
+    const float x0 = static_cast<float>(first_col) * step;
+    const float y0 = static_cast<float>(first_row) * step;
+    auto grid_x = [&](std::size_t i) { return x0 + static_cast<float>(i) * step; };
+    auto grid_y = [&](std::size_t j) { return y0 + static_cast<float>(j) * step; };
+    const std::size_t cells_x = nx - 1;
+    const std::size_t cells_y = ny - 1;
+
+    // loop edges bucketed into every cell they may pass through, in cell order
+    std::vector<Edge2> edges;
+    ScanlineEdgeTable table;
+    auto add_loop = [&](const polygon_t& loop) {
+        table.add_loop(loop);
+        if (loop.size() < 2) return;
+        const std::size_t limit = loop.front() == loop.back() ? loop.size() - 1 : loop.size();
+        for (std::size_t i = 0; i < limit; ++i) {
+            const auto& a = loop[i];
+            const auto& b = loop[(i + 1) % limit];
+            edges.push_back({a.x, a.y, b.x, b.y});
+        }
+    };
+    add_loop(outer);
+    for (const auto& hole : holes) add_loop(hole);
+
+    constexpr float kCellSlack = 1e-3f;  // of a cell: an edge on a grid line goes to both sides
+    auto cell_range = [&](float lo, float hi, float origin, std::size_t cells) {
+        const auto first = static_cast<long>(std::floor((lo - origin) / step - kCellSlack));
+        const auto last = static_cast<long>(std::floor((hi - origin) / step + kCellSlack));
+        const auto max_cell = static_cast<long>(cells) - 1;
+        return std::pair<long, long>{std::clamp(first, 0L, max_cell), std::clamp(last, 0L, max_cell)};
+    };
+    std::vector<std::pair<uint64_t, uint32_t>> buckets;  // (cell, edge)
+    for (uint32_t e = 0; e < edges.size(); ++e) {
+        const auto& edge = edges[e];
+        const float lo_y = std::min(edge.y0, edge.y1), hi_y = std::max(edge.y0, edge.y1);
+        auto [row_lo, row_hi] = cell_range(lo_y, hi_y, y0, cells_y);
+        for (long row = row_lo; row <= row_hi; ++row) {
+            // the edge's x extent within this row's band
+            float x_lo = std::min(edge.x0, edge.x1), x_hi = std::max(edge.x0, edge.x1);
+            if (edge.y1 != edge.y0) {
+                auto x_at = [&](float y) {
+                    float t = (std::clamp(y, lo_y, hi_y) - edge.y0) / (edge.y1 - edge.y0);
+                    return edge.x0 + t * (edge.x1 - edge.x0);
+                };
+                const float xa = x_at(grid_y(static_cast<std::size_t>(row)));
+                const float xb = x_at(grid_y(static_cast<std::size_t>(row) + 1));
+                x_lo = std::min(xa, xb);
+                x_hi = std::max(xa, xb);
+            }
+            auto [col_lo, col_hi] = cell_range(x_lo, x_hi, x0, cells_x);
+            for (long col = col_lo; col <= col_hi; ++col) {
+                buckets.push_back({static_cast<uint64_t>(row) * cells_x + static_cast<uint64_t>(col), e});
+            }
+        }
+    }
+    std::sort(buckets.begin(), buckets.end());
+
+    // two rows of field values and vertex inside flags are live at a time; the flags come from
+    // the scanline and only decide cells no loop edge reaches
+    const TpmsLayerField field(surface, period, z, x0, step, nx);
+    std::vector<float> below(nx), above(nx);
+    std::vector<uint8_t> inside_below(nx), inside_above(nx);
+    auto inside_row = [&](std::size_t j, std::vector<uint8_t>& inside) {
+        table.advance(grid_y(j));
+        const auto spans = table.fill_spans(FillRule::EvenOdd);
+        std::size_t s = 0;
+        for (std::size_t i = 0; i < nx; ++i) {
+            const float x = grid_x(i);
+            while (s < spans.size() && spans[s].second <= x) s++;
+            inside[i] = s < spans.size() && spans[s].first <= x;
+        }
+    };
+    field.row(grid_y(0), below.data());
+    inside_row(0, inside_below);
+
+    std::size_t cursor = 0;
+    std::vector<uint32_t> row_edges;
+    std::vector<float> cuts;
+    for (std::size_t j = 0; j < cells_y; ++j) {
+        field.row(grid_y(j + 1), above.data());
+        inside_row(j + 1, inside_above);
+        const float ya = grid_y(j), yb = grid_y(j + 1);
+        row_edges.clear();
+        for (std::size_t b = cursor; b < buckets.size() && buckets[b].first < static_cast<uint64_t>(j + 1) * cells_x; ++b) {
+            row_edges.push_back(buckets[b].second);
+        }
+        std::sort(row_edges.begin(), row_edges.end());
+        row_edges.erase(std::unique(row_edges.begin(), row_edges.end()), row_edges.end());
+
+        for (std::size_t i = 0; i < cells_x; ++i) {
+            const uint64_t cell = static_cast<uint64_t>(j) * cells_x + i;
+            const std::size_t edges_begin = cursor;
+            while (cursor < buckets.size() && buckets[cursor].first == cell) cursor++;
+            const bool on_boundary = cursor != edges_begin;
+            if (!on_boundary && !inside_below[i]) continue;
+
+            const float v00 = below[i], v10 = below[i + 1], v11 = above[i + 1], v01 = above[i];
+            const int code = (v00 > 0.0f) | (v10 > 0.0f) << 1 | (v11 > 0.0f) << 2 | (v01 > 0.0f) << 3;
+            if (code == 0 || code == 15) continue;
+
+            // crossing points on the cell's sides, each interpolated from its lower to its higher
+            // grid index so neighbouring cells share them exactly
+            const float xa = grid_x(i), xb = grid_x(i + 1);
+            auto lerp = [](float a, float b, float va, float vb) { return a + (va / (va - vb)) * (b - a); };
+            auto side = [&](int s) -> vec3_t {
+                switch (s) {
+                case 0: return {lerp(xa, xb, v00, v10), ya, z};  // bottom
+                case 1: return {xb, lerp(ya, yb, v10, v11), z};  // right
+                case 2: return {lerp(xa, xb, v01, v11), yb, z};  // top
+                default: return {xa, lerp(ya, yb, v00, v01), z}; // left
+                }
+            };
+            std::pair<int, int> pieces[2];
+            int num_pieces = 0;
+            if (code == 5 || code == 10) {
+                // saddle: the centre decides which corners the curves cut off
+                const bool centre_positive = (v00 + v10 + v11 + v01) > 0.0f;
+                if ((code == 5) == centre_positive) {
+                    pieces[0] = {0, 1};
+                    pieces[1] = {2, 3};
+                } else {
+                    pieces[0] = {0, 3};
+                    pieces[1] = {1, 2};
+                }
+                num_pieces = 2;
+            } else {
+                const bool changes[4] = {(code & 1) != (code >> 1 & 1), (code >> 1 & 1) != (code >> 2 & 1),
+                                         (code >> 3 & 1) != (code >> 2 & 1), (code & 1) != (code >> 3 & 1)};
+                int found[2], n = 0;
+                for (int s = 0; s < 4; ++s) {
+                    if (changes[s]) found[n++] = s;
+                }
+                pieces[0] = {found[0], found[1]};
+                num_pieces = 1;
+            }
+
+            for (int k = 0; k < num_pieces; ++k) {
+                const vec3_t p = side(pieces[k].first);
+                const vec3_t q = side(pieces[k].second);
+                if (!on_boundary) {
+                    infill.push_back({p, q});
+                    continue;
+                }
+                // near the loops, inside is decided with the same predicate that cuts p-q
+                const bool p_inside = inside_by_ray(p, edges, row_edges);
+                clip_piece(p, q, p_inside, edges, buckets.data() + edges_begin, buckets.data() + cursor, cuts, infill);
+            }
+        }
+        std::swap(below, above);
+        std::swap(inside_below, inside_above);
+    }
+    return infill;
+}
@@ -0,0 +1,2032 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <stdexcept>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "include/containers/layer_spill_buffer.hpp"
+#include "include/containers/path_set.hpp"
+#include "include/containers/plan_file.hpp"
+#include "include/planning/contour_stitch.hpp"
+#include "include/planning/gcode_writer.hpp"
+#include "include/planning/infill.hpp"
+#include "include/planning/intersect_kernel.hpp"
+#include "include/planning/layer_schedule.hpp"
+#include "include/planning/motion_encoder.hpp"
+#include "include/planning/path_order.hpp"
+#include "include/planning/polygon_offset.hpp"
+#include "include/planning/polygon_ops.hpp"
+#include "include/planning/polygon_simplify.hpp"
+#include "include/planning/scanline.hpp"
+#include "include/planning/sweep_slicer.hpp"
+#include "include/planning/tpms.hpp"
+#include "include/planning/work_stealing.hpp"
+#include "include/stl_helpers.hpp"
+#include "include/workers/path_plan.hpp"
+
+namespace {
+
+// Layers a triangle spanning [min_z, max_z] can touch, clamped to [0, num_layers). The range is
+// empty when first > last.
+std::pair<int, int> layer_span(float min_z, float max_z, float layer_height, std::size_t num_layers) {
+    auto start_layer = static_cast<int>(std::floor(min_z / layer_height));
+    auto end_layer = static_cast<int>(std::ceil(max_z / layer_height));
+    return {std::max(0, start_layer), std::min(static_cast<int>(num_layers) - 1, end_layer)};
+}
+
+std::size_t layer_count_for(float layer_height) {
+    return static_cast<std::size_t>(MAX_PART_HEIGHT_MM / layer_height);
+}
+
+std::filesystem::path test_data_path(const std::string& filename) {
+    auto here = std::filesystem::path(__FILE__).parent_path();
+    return here / "data" / filename;
+}
+
+bool same_segments(const std::vector<segment_t>& a, const std::vector<segment_t>& b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (!(a[i].first == b[i].first) || !(a[i].second == b[i].second)) return false;
+    }
+    return true;
+}
+
+std::vector<PathPlanner::LayerPlan> slice_streaming(const std::filesystem::path& path, float layer_height_mm,
+                                                    float infill_spacing, std::size_t budget) {
+    PathPlanner planner;
+    std::vector<PathPlanner::LayerPlan> layers;
+    planner.slice_planar_streaming(path, layer_height_mm, infill_spacing, budget,
+                                   [&](const PathPlanner::LayerPlan& layer) { layers.push_back(layer); });
+    return layers;
+}
+
+std::vector<PathPlanner::LayerPlan> slice_streaming_with(const std::filesystem::path& path, float layer_height_mm,
+                                                         float infill_spacing, const InfillOptions& infill) {
+    PathPlanner planner;
+    planner.set_infill_options(infill);
+    std::vector<PathPlanner::LayerPlan> layers;
+    planner.slice_planar_streaming(path, layer_height_mm, infill_spacing, std::size_t{64} << 20,
+                                   [&](const PathPlanner::LayerPlan& layer) { layers.push_back(layer); });
+    return layers;
+}
+
+void expect_same_plan(const std::vector<PathPlanner::LayerPlan>& expected,
+                      const std::vector<PathPlanner::LayerPlan>& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (std::size_t l = 0; l < expected.size(); ++l) {
+        EXPECT_EQ(expected[l].z, actual[l].z) << "layer " << l;
+        EXPECT_EQ(expected[l].thickness, actual[l].thickness) << "layer " << l;
+        EXPECT_TRUE(same_segments(expected[l].contours(), actual[l].contours())) << "layer " << l;
+        EXPECT_TRUE(same_segments(expected[l].infill(), actual[l].infill())) << "layer " << l;
+        EXPECT_TRUE(same_segments(expected[l].open_chains(), actual[l].open_chains())) << "layer " << l;
+    }
+}
+
+// the per-triangle loop slice_planar used before the sweep
+std::vector<std::vector<segment_t>> slice_per_triangle(const std::vector<Mesh>& meshes, float layer_height) {
+    std::size_t num_layers = layer_count_for(layer_height);
+    std::vector<std::vector<segment_t>> layers(num_layers);
+    for (const auto& mesh : meshes) {
+        for (const auto& tri : mesh.triangles) {
+            float z0 = mesh.points[tri.vertices[0]].z;
+            float z1 = mesh.points[tri.vertices[1]].z;
+            float z2 = mesh.points[tri.vertices[2]].z;
+            auto [first, last] = layer_span(std::min({z0, z1, z2}), std::max({z0, z1, z2}), layer_height, num_layers);
+            for (int l = first; l <= last; ++l) {
+                auto segs = mesh.intersect_triangle_with_plane(tri, static_cast<float>(l) * layer_height);
+                layers[static_cast<std::size_t>(l)].insert(layers[static_cast<std::size_t>(l)].end(), segs.begin(), segs.end());
+            }
+        }
+    }
+    return layers;
+}
+
+struct SoaTriangles {
+    std::vector<float> coords[9];
+
+    void push(const vec3_t& v0, const vec3_t& v1, const vec3_t& v2) {
+        const vec3_t* corners[3] = {&v0, &v1, &v2};
+        for (int k = 0; k < 3; ++k) {
+            coords[k].push_back(corners[k]->x);
+            coords[3 + k].push_back(corners[k]->y);
+            coords[6 + k].push_back(corners[k]->z);
+        }
+    }
+
+    TriangleBlock view() const {
+        return {{coords[0].data(), coords[1].data(), coords[2].data()},
+                {coords[3].data(), coords[4].data(), coords[5].data()},
+                {coords[6].data(), coords[7].data(), coords[8].data()},
+                coords[0].size()};
+    }
+};
+
+// every supported kernel must reproduce intersect_triangle_into bit for bit
+void expect_kernels_match_scalar(const SoaTriangles& tris, float z_plane) {
+    const auto block = tris.view();
+    for (auto kernel : {IntersectKernel::Scalar, IntersectKernel::Avx2, IntersectKernel::Neon}) {
+        if (!intersect_kernel_supported(kernel)) continue;
+        std::vector<segment_t> out(block.count * kMaxTriangleSegments);
+        std::vector<uint8_t> counts(block.count);
+        intersect_block(kernel, block, z_plane, out.data(), counts.data());
+        for (std::size_t i = 0; i < block.count; ++i) {
+            segment_t expected[kMaxTriangleSegments];
+            std::size_t n = intersect_triangle_into({block.x[0][i], block.y[0][i], block.z[0][i]},
+                                                    {block.x[1][i], block.y[1][i], block.z[1][i]},
+                                                    {block.x[2][i], block.y[2][i], block.z[2][i]}, z_plane, expected);
+            ASSERT_EQ(counts[i], n) << intersect_kernel_name(kernel) << " triangle " << i << " z " << z_plane;
+            EXPECT_EQ(std::memcmp(expected, out.data() + i * kMaxTriangleSegments, n * sizeof(segment_t)), 0)
+                << intersect_kernel_name(kernel) << " triangle " << i << " z " << z_plane;
+        }
+    }
+}
+
+// the all-pairs nesting and hole assignment classify_polygons/build_islands used before the grid
+std::vector<int> nesting_depths_all_pairs(const std::vector<polygon_t>& polys) {
+    std::vector<int> depths(polys.size(), 0);
+    for (std::size_t i = 0; i < polys.size(); ++i) {
+        polygon_t closed_i = ensure_closed(polys[i]);
+        auto p = interior_point(closed_i);
+        if (!p) p = polygon_centroid(closed_i);
+        for (std::size_t j = 0; j < polys.size(); ++j) {
+            if (i != j && point_in_polygon(ensure_closed(polys[j]), *p)) depths[i]++;
+        }
+    }
+    return depths;
+}
+
+std::vector<std::vector<std::size_t>> island_holes_all_pairs(const std::vector<ClassifiedPolygon>& polys) {
+    std::vector<std::vector<std::size_t>> islands;
+    std::vector<bool> hole_used(polys.size(), false);
+    for (std::size_t i = 0; i < polys.size(); ++i) {
+        if (polys[i].is_hole) continue;
+        islands.emplace_back();
+        for (std::size_t h = 0; h < polys.size(); ++h) {
+            if (!polys[h].is_hole || hole_used[h]) continue;
+            if (point_in_polygon(polys[i].poly, polygon_centroid(polys[h].poly))) {
+                islands.back().push_back(h);
+                hole_used[h] = true;
+            }
+        }
+    }
+    return islands;
+}
+
+polygon_t square_loop(float cx, float cy, float half, bool ccw) {
+    polygon_t poly{{cx - half, cy - half, 0.0f}, {cx + half, cy - half, 0.0f},
+                   {cx + half, cy + half, 0.0f}, {cx - half, cy + half, 0.0f}};
+    if (!ccw) std::reverse(poly.begin(), poly.end());
+    return poly;
+}
+
+// the per-line scan clip_infill used before the edge table: every loop is intersected with
+// every scanline from scratch
+std::vector<Span> spans_per_line(const polygon_t& poly, float y_line) {
+    std::vector<float> intersections;
+    if (poly.size() < 2) return {};
+    const bool closed = poly.front() == poly.back();
+    const std::size_t limit = closed && poly.size() > 1 ? poly.size() - 1 : poly.size();
+    for (std::size_t i = 0; i < limit; ++i) {
+        const auto& p0 = poly[i];
+        const auto& p1 = poly[(i + 1) % limit];
+        if (std::abs(p0.y - p1.y) < kMinSpan) continue;
+        bool crosses = (p0.y <= y_line && p1.y > y_line) || (p1.y <= y_line && p0.y > y_line);
+        if (!crosses) continue;
+        float t = (y_line - p0.y) / (p1.y - p0.y);
+        intersections.push_back(p0.x + t * (p1.x - p0.x));
+    }
+    std::sort(intersections.begin(), intersections.end());
+    std::vector<Span> spans;
+    for (std::size_t i = 0; i + 1 < intersections.size(); i += 2) {
+        if (intersections[i + 1] - intersections[i] >= kMinSpan) spans.emplace_back(intersections[i], intersections[i + 1]);
+    }
+    return spans;
+}
+
+std::vector<segment_t> clip_infill_per_line(const polygon_t& outer, const std::vector<polygon_t>& holes, float spacing, float z) {
+    std::vector<segment_t> infill;
+    Bounds bounds = bounds_for_polygon(outer);
+    if (outer.empty() || spacing <= 0.0f || bounds.empty()) return infill;
+    for (float y = bounds.min_y; y <= bounds.max_y + kSnapEps; y += spacing) {
+        auto spans = spans_per_line(outer, y);
+        for (const auto& hole : holes) {
+            if (spans.empty()) break;
+            spans = subtract_spans(std::move(spans), spans_per_line(hole, y));
+        }
+        for (const auto& span : spans) infill.push_back({{span.first, y, z}, {span.second, y, z}});
+    }
+    return infill;
+}
+
+// a star-shaped loop with jittered radii; vertices snap to `grid` so many share a y
+polygon_t jagged_loop(std::mt19937& rng, float cx, float cy, float radius, std::size_t points, float grid, bool ccw) {
+    std::uniform_real_distribution<float> jitter(0.5f, 1.0f);
+    polygon_t poly;
+    for (std::size_t i = 0; i < points; ++i) {
+        float a = 6.2831853f * static_cast<float>(i) / static_cast<float>(points);
+        float r = radius * jitter(rng);
+        poly.push_back({std::round((cx + r * std::cos(a)) / grid) * grid, std::round((cy + r * std::sin(a)) / grid) * grid, 0.0f});
+    }
+    if (!ccw) std::reverse(poly.begin(), poly.end());
+    return poly;
+}
+
+float total_length(const std::vector<segment_t>& segments) {
+    float length = 0.0f;
+    for (const auto& seg : segments) length += (seg.second - seg.first).norm();
+    return length;
+}
+
+// line directions in degrees, folded into [0, 180) and rounded to whole degrees
+std::vector<int> line_directions(const std::vector<segment_t>& segments) {
+    std::vector<int> directions;
+    for (const auto& seg : segments) {
+        auto d = seg.second - seg.first;
+        int deg = static_cast<int>(std::lround(std::atan2(d.y, d.x) * 180.0 / 3.14159265358979));
+        deg = ((deg % 180) + 180) % 180;
+        if (std::find(directions.begin(), directions.end(), deg) == directions.end()) directions.push_back(deg);
+    }
+    std::sort(directions.begin(), directions.end());
+    return directions;
+}
+
+// segments as undirected pairs in a canonical order, to compare sets regardless of direction
+std::vector<std::array<float, 4>> undirected(const std::vector<segment_t>& segments) {
+    std::vector<std::array<float, 4>> keys;
+    for (const auto& seg : segments) {
+        std::array<float, 4> a{seg.first.x, seg.first.y, seg.second.x, seg.second.y};
+        std::array<float, 4> b{seg.second.x, seg.second.y, seg.first.x, seg.first.y};
+        keys.push_back(std::min(a, b));
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+float total_area(const std::vector<polygon_t>& loops) {
+    float area = 0.0f;
+    for (const auto& loop : loops) area += signed_area(loop);
+    return area;
+}
+
+// no two edges of the result cross or overlap; touching at shared endpoints is allowed
+bool loops_are_simple(const std::vector<polygon_t>& loops) {
+    std::vector<FixedLoop> fixed;
+    for (const auto& loop : loops) fixed.push_back(to_fixed(loop));
+    std::vector<std::pair<FixedPoint, FixedPoint>> edges;
+    for (const auto& loop : fixed) {
+        for (std::size_t i = 0; i < loop.size(); ++i) edges.push_back({loop[i], loop[(i + 1) % loop.size()]});
+    }
+    auto orient = [](const FixedPoint& o, const FixedPoint& a, const FixedPoint& b) {
+        auto v = (a.x - o.x) * (b.y - o.y) - (a.y - o.y) * (b.x - o.x);
+        return (v > 0) - (v < 0);
+    };
+    for (std::size_t i = 0; i < edges.size(); ++i) {
+        for (std::size_t j = i + 1; j < edges.size(); ++j) {
+            const auto& [a, b] = edges[i];
+            const auto& [c, d] = edges[j];
+            if (a == c || a == d || b == c || b == d) continue;
+            if (orient(a, b, c) * orient(a, b, d) <= 0 && orient(c, d, a) * orient(c, d, b) <= 0) return false;
+        }
+    }
+    return true;
+}
+
+void expect_nesting_matches_all_pairs(const std::vector<polygon_t>& polys) {
+    auto classified = classify_polygons(polys);
+    ASSERT_EQ(classified.size(), polys.size());
+
+    // classify sorts by |area|; compare depth multisets per area to stay independent of ties
+    auto depths = nesting_depths_all_pairs(polys);
+    auto area_key = [](float area) { return std::isnan(area) ? -1.0f : std::abs(area); };
+    std::vector<std::pair<float, int>> expected, actual;
+    for (std::size_t i = 0; i < polys.size(); ++i) {
+        expected.push_back({area_key(signed_area(ensure_closed(polys[i]))), depths[i]});
+        actual.push_back({area_key(classified[i].area), classified[i].depth});
+    }
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    EXPECT_EQ(expected, actual);
+
+    auto islands = build_islands(classified);
+    auto expected_islands = island_holes_all_pairs(classified);
+    ASSERT_EQ(islands.size(), expected_islands.size());
+    for (std::size_t i = 0; i < islands.size(); ++i) {
+        ASSERT_EQ(islands[i].holes.size(), expected_islands[i].size()) << "island " << i;
+        for (std::size_t k = 0; k < islands[i].holes.size(); ++k) {
+            EXPECT_EQ(islands[i].holes[k], classified[expected_islands[i][k]].poly) << "island " << i;
+        }
+    }
+}
+
+} // namespace
+
+TEST(LayerSpillBufferTest, TakeLayerPreservesAppendOrderAcrossSpills) {
+    // budget below one segment: every append spills
+    LayerSpillBuffer buffer(3, 1);
+    std::vector<segment_t> expected;
+    for (int i = 0; i < 10; ++i) {
+        segment_t seg{{static_cast<float>(i), 0.0f, 1.0f}, {static_cast<float>(i), 1.0f, 1.0f}};
+        expected.push_back(seg);
+        buffer.append(1, &seg, 1);
+        segment_t other{{-1.0f, -1.0f, 2.0f}, {-2.0f, -2.0f, 2.0f}};
+        buffer.append(2, &other, 1);
+    }
+    EXPECT_GT(buffer.spill_count(), 0u);
+    EXPECT_GT(buffer.spilled_bytes(), 0u);
+
+    EXPECT_TRUE(buffer.take_layer(0).empty());
+    EXPECT_TRUE(same_segments(expected, buffer.take_layer(1)));
+    EXPECT_EQ(buffer.take_layer(2).size(), 10u);
+    EXPECT_TRUE(buffer.take_layer(1).empty());
+}
+
+TEST(PathPlanStreamingTest, MatchesInMemorySlice) {
+    auto path = test_data_path("torus_ascii.stl");
+    PathPlanner planner;
+    planner.set_cad(path);
+    planner.slice_planar(1, 2.0f);
+    ASSERT_GT(planner.layer_count(), 0u);
+
+    expect_same_plan(planner.get_plan(), slice_streaming(path, 1, 2.0f, std::size_t{64} << 20));
+}
+
+TEST(PathPlanStreamingTest, SpillingDoesNotChangeLayers) {
+    auto path = test_data_path("torus_ascii.stl");
+    PathPlanner planner;
+    planner.set_cad(path);
+    planner.slice_planar(1, 2.0f);
+
+    // a budget of a few segments forces nearly every append out to the spill file
+    expect_same_plan(planner.get_plan(), slice_streaming(path, 1, 2.0f, 4 * sizeof(segment_t)));
+}
+
+TEST(SweepSlicerTest, MatchesPerTriangleSlicing) {
+    auto meshes = read_stl_ascii_mapped(test_data_path("torus_ascii.stl").string());
+    ASSERT_FALSE(meshes.empty());
+    // a second, shifted copy checks that meshes are concatenated per layer in order
+    Mesh shifted = meshes.front();
+    for (auto& pt : shifted.points) pt.z += 0.37f;
+    meshes.push_back(shifted);
+
+    for (float layer_height : {2.0f, 1.0f, 0.25f, 0.05f}) {
+        auto expected = slice_per_triangle(meshes, layer_height);
+        auto swept = sweep_slice(meshes, layer_height);
+        ASSERT_EQ(swept.layer_count(), expected.size());
+        std::size_t total = 0;
+        for (std::size_t l = 0; l < expected.size(); ++l) {
+            auto layer = swept.layer(l);
+            EXPECT_TRUE(same_segments(expected[l], std::vector<segment_t>(layer.begin(), layer.end())))
+                << "layer_height " << layer_height << " layer " << l;
+            total += expected[l].size();
+        }
+        EXPECT_GT(total, 0u);
+    }
+}
+
+TEST(SweepSlicerTest, SoaLayoutMatchesIndexedMeshes) {
+    auto meshes = read_stl_ascii_mapped(test_data_path("torus_ascii.stl").string());
+    Mesh shifted = meshes.front();
+    for (auto& pt : shifted.points) pt.z += 0.37f;
+    meshes.push_back(shifted);
+
+    std::vector<MeshSoA> soa(meshes.begin(), meshes.end());
+    for (float layer_height : {2.0f, 1.0f, 0.25f, 0.05f}) {
+        auto indexed = sweep_slice(meshes, layer_height);
+        auto swept = sweep_slice(soa, layer_height);
+        EXPECT_EQ(indexed.offsets, swept.offsets) << "layer_height " << layer_height;
+        EXPECT_TRUE(same_segments(indexed.segments, swept.segments)) << "layer_height " << layer_height;
+    }
+}
+
+TEST(SweepSlicerTest, NoMeshesGivesEmptyLayers) {
+    auto swept = sweep_slice(std::vector<Mesh>{}, 1.0f);
+    EXPECT_EQ(swept.layer_count(), layer_count_for(1.0f));
+    EXPECT_TRUE(swept.segments.empty());
+    EXPECT_EQ(sweep_slice(std::vector<Mesh>{}, 0.0f).layer_count(), 0u);
+    EXPECT_EQ(sweep_slice(std::vector<MeshSoA>{}, 1.0f).layer_count(), layer_count_for(1.0f));
+}
+
+TEST(IntersectKernelTest, MatchesScalarOnTorus) {
+    auto meshes = read_stl_ascii_mapped(test_data_path("torus_ascii.stl").string());
+    SoaTriangles tris;
+    float min_z = std::numeric_limits<float>::max();
+    float max_z = std::numeric_limits<float>::lowest();
+    std::vector<float> vertex_z;
+    for (const auto& mesh : meshes) {
+        for (const auto& tri : mesh.triangles) {
+            tris.push(mesh.points[tri.vertices[0]], mesh.points[tri.vertices[1]], mesh.points[tri.vertices[2]]);
+        }
+        for (const auto& pt : mesh.points) {
+            min_z = std::min(min_z, pt.z);
+            max_z = std::max(max_z, pt.z);
+            vertex_z.push_back(pt.z);
+        }
+    }
+    ASSERT_GT(tris.view().count, 0u);
+
+    for (int step = 0; step <= 40; ++step) {
+        expect_kernels_match_scalar(tris, min_z + (max_z - min_z) * static_cast<float>(step) / 40.0f);
+    }
+    // planes through vertices exercise the on-plane lanes
+    for (std::size_t i = 0; i < vertex_z.size(); i += std::max<std::size_t>(1, vertex_z.size() / 25)) {
+        expect_kernels_match_scalar(tris, vertex_z[i]);
+        expect_kernels_match_scalar(tris, vertex_z[i] + 0.5f * kPlaneEps);
+    }
+}
+
+TEST(IntersectKernelTest, MatchesScalarOnDegenerateTriangles) {
+    SoaTriangles tris;
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+    tris.push({0, 0, 1}, {1, 0, 1}, {0, 1, 1});             // coplanar with z = 1
+    tris.push({0, 0, 1}, {1, 0, 1}, {0, 1, 2});             // one edge on the plane
+    tris.push({0, 0, 1}, {1, 0, 0}, {0, 1, 2});             // one vertex on the plane
+    tris.push({0, 0, 0}, {1e-6f, 0, 2}, {0, 1e-6f, 2});    // crossing points closer than the weld
+    tris.push({0, 0, 0}, {1, 0, 0}, {0, 1, 0.5f});          // entirely below
+    tris.push({0, 0, nan}, {1, 0, 0}, {0, 1, 2});
+    tris.push({0, 0, inf}, {1, 0, 0}, {0, 1, 2});
+    tris.push({nan, 0, 0}, {1, 0, 2}, {0, 1, 2});
+    // pad past one vector width so the degenerate lanes share registers with ordinary ones
+    for (int i = 0; i < 13; ++i) {
+        float f = static_cast<float>(i);
+        tris.push({f, 0, 0}, {f + 1, 0, 2}, {f, 1, 2 - 0.1f * f});
+    }
+    expect_kernels_match_scalar(tris, 1.0f);
+    expect_kernels_match_scalar(tris, 0.0f);
+}
+
+TEST(IntersectKernelTest, ActiveKernelIsSupported) {
+    EXPECT_TRUE(intersect_kernel_supported(active_intersect_kernel()));
+    EXPECT_TRUE(intersect_kernel_supported(IntersectKernel::Scalar));
+}
+
+TEST(WorkStealingTest, VisitsEveryIndexOnce) {
+    for (std::size_t threads : {1u, 2u, 3u, 8u}) {
+        std::vector<std::atomic<int>> visits(1000);
+        // uneven cost so idle workers have to steal
+        for_each_stealing(visits.size(), threads, [&](std::size_t i) {
+            if (i < 100) std::this_thread::sleep_for(std::chrono::microseconds(200));
+            visits[i]++;
+        });
+        for (std::size_t i = 0; i < visits.size(); ++i) {
+            ASSERT_EQ(visits[i].load(), 1) << "threads " << threads << " index " << i;
+        }
+    }
+}
+
+TEST(WorkStealingTest, RethrowsWorkerException) {
+    EXPECT_THROW(for_each_stealing(64, 4, [](std::size_t i) {
+        if (i == 40) throw std::runtime_error("layer failed");
+    }), std::runtime_error);
+}
+
+TEST(PathPlanParallelTest, PlanIsIndependentOfThreadCount) {
+    auto path = test_data_path("torus_ascii.stl");
+    PathPlanner reference;
+    reference.set_thread_count(1);
+    reference.set_cad(path);
+    reference.slice_planar(1, 2.0f);
+    ASSERT_GT(reference.layer_count(), 0u);
+
+    for (std::size_t threads : {2u, 3u, 8u}) {
+        PathPlanner planner;
+        planner.set_thread_count(threads);
+        planner.set_cad(path);
+        planner.slice_planar(1, 2.0f);
+        expect_same_plan(reference.get_plan(), planner.get_plan());
+        ASSERT_EQ(reference.get_raw_layers().size(), planner.get_raw_layers().size());
+        for (std::size_t l = 0; l < reference.get_raw_layers().size(); ++l) {
+            EXPECT_EQ(reference.get_raw_layers()[l].size(), planner.get_raw_layers()[l].size()) << "layer " << l;
+        }
+    }
+}
+
+TEST(MeshSoATest, TrianglesSortedByZMinWithSourceMapping) {
+    auto meshes = read_stl_ascii_mapped(test_data_path("torus_ascii.stl").string());
+    const Mesh& mesh = meshes.front();
+    MeshSoA soa(mesh);
+    ASSERT_EQ(soa.triangle_count(), mesh.triangles.size());
+
+    std::vector<bool> seen(mesh.triangles.size(), false);
+    for (std::size_t i = 0; i < soa.triangle_count(); ++i) {
+        if (i > 0) {
+            EXPECT_LE(soa.z_min[i - 1], soa.z_min[i]);
+            if (soa.z_min[i - 1] == soa.z_min[i]) {
+                EXPECT_LT(soa.source_triangle[i - 1], soa.source_triangle[i]);
+            }
+        }
+        const auto& tri = mesh.triangles[soa.source_triangle[i]];
+        seen[soa.source_triangle[i]] = true;
+        for (int k = 0; k < 3; ++k) {
+            EXPECT_TRUE(soa.corner(i, k) == mesh.points[tri.vertices[k]]);
+        }
+        float z0 = mesh.points[tri.vertices[0]].z;
+        float z1 = mesh.points[tri.vertices[1]].z;
+        float z2 = mesh.points[tri.vertices[2]].z;
+        EXPECT_EQ(soa.z_min[i], std::min({z0, z1, z2}));
+        EXPECT_EQ(soa.z_max[i], std::max({z0, z1, z2}));
+    }
+    EXPECT_TRUE(std::all_of(seen.begin(), seen.end(), [](bool b) { return b; }));
+}
+
+TEST(PathPlanParallelTest, SoaLayoutGivesSamePlan) {
+    auto path = test_data_path("torus_ascii.stl");
+    PathPlanner indexed;
+    indexed.set_cad(path);
+    indexed.slice_planar(1, 2.0f);
+
+    PathPlanner soa;
+    soa.set_mesh_layout(PathPlanner::MeshLayout::StructureOfArrays);
+    soa.set_cad(path);
+    EXPECT_EQ(soa.get_soa_meshes().size(), soa.get_meshes().size());
+    soa.slice_planar(1, 2.0f);
+    expect_same_plan(indexed.get_plan(), soa.get_plan());
+}
+
+TEST(PolygonNestingTest, GridIndexMatchesAllPairsOnRandomSquares) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> centre(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> half(0.05f, 20.0f);
+    std::vector<polygon_t> polys;
+    for (int i = 0; i < 400; ++i) {
+        polys.push_back(square_loop(centre(rng), centre(rng), half(rng), i % 3 != 0));
+    }
+    expect_nesting_matches_all_pairs(polys);
+}
+
+TEST(PolygonNestingTest, GridIndexMatchesAllPairsOnNestedLattice) {
+    // a frame holding a lattice of rings, each ring holding a peg: depths 0..3
+    std::vector<polygon_t> polys{square_loop(0.0f, 0.0f, 100.0f, true)};
+    for (int gx = 0; gx < 12; ++gx) {
+        for (int gy = 0; gy < 12; ++gy) {
+            float cx = -88.0f + 16.0f * static_cast<float>(gx);
+            float cy = -88.0f + 16.0f * static_cast<float>(gy);
+            polys.push_back(square_loop(cx, cy, 6.0f, false));
+            polys.push_back(square_loop(cx, cy, 4.0f, true));
+            polys.push_back(square_loop(cx, cy, 1.0f, false));
+        }
+    }
+    // concentric squares that overflow the per-cell lists
+    for (int k = 0; k < 100; ++k) polys.push_back(square_loop(300.0f, 0.0f, 1.0f + 0.5f * static_cast<float>(k), true));
+    expect_nesting_matches_all_pairs(polys);
+}
+
+TEST(PolygonNestingTest, DegenerateLoopsMatchAllPairs) {
+    std::vector<polygon_t> polys{
+        square_loop(0.0f, 0.0f, 10.0f, true),
+        {{-1.0f, 0.0f, 0.0f}, {1.0f, -1e-12f, 0.0f}, {2.0f, 0.0f, 0.0f}},     // near-flat sliver
+        {{3.0f, 3.0f, 0.0f}, {3.0f, 3.0f, 0.0f}},                            // collapsed
+        {{0.0f, 0.0f, 0.0f}, {std::numeric_limits<float>::infinity(), 1.0f, 0.0f}, {0.0f, 2.0f, 0.0f}},
+        square_loop(0.0f, 0.0f, 2.0f, false),
+    };
+    expect_nesting_matches_all_pairs(polys);
+    EXPECT_TRUE(classify_polygons({}).empty());
+    EXPECT_TRUE(build_islands({}).empty());
+}
+
+TEST(ContourStitchTest, JoinsShuffledReversedAndRepeatedEdges) {
+    const vec3_t a{0.0f, 0.0f, 1.0f}, b{1.0f, 0.0f, 1.0f}, c{1.0f, 1.0f, 1.0f}, d{0.0f, 1.0f, 1.0f};
+    std::vector<segment_t> segments{{c, d}, {b, a}, {a, d}, {b, c}, {c, b}, {a, a}, {b, a}};
+    auto result = stitch_contours(segments, kSnapEps);
+    ASSERT_EQ(result.loops.size(), 1u);
+    EXPECT_TRUE(result.open_chains.empty());
+    EXPECT_EQ(result.loops[0], (polygon_t{c, d, a, b, c}));
+}
+
+TEST(ContourStitchTest, WeldsEndpointsAcrossCellBoundaries) {
+    // the two copies of each corner straddle an eps grid line but are within eps of each other
+    const float eps = 1e-3f;
+    const float lo = 2.0f * eps - 0.3f * eps, hi = 2.0f * eps + 0.3f * eps;
+    std::vector<segment_t> segments{
+        {{lo, lo, 0.0f}, {1.0f, lo, 0.0f}},
+        {{1.0f, hi, 0.0f}, {1.0f, 1.0f, 0.0f}},
+        {{1.0f, 1.0f, 0.0f}, {hi, 1.0f, 0.0f}},
+        {{lo, 1.0f, 0.0f}, {hi, hi, 0.0f}},
+    };
+    auto result = stitch_contours(segments, eps);
+    ASSERT_EQ(result.loops.size(), 1u);
+    EXPECT_EQ(result.loops[0].size(), 5u);
+    EXPECT_TRUE(result.open_chains.empty());
+}
+
+TEST(ContourStitchTest, ReportsOpenChainsEndToEnd) {
+    const vec3_t p0{0.0f, 0.0f, 0.0f}, p1{1.0f, 0.0f, 0.0f}, p2{2.0f, 0.0f, 0.0f}, p3{3.0f, 0.0f, 0.0f};
+    // starts in the middle of the chain, so both directions have to be walked
+    std::vector<segment_t> segments{{p1, p2}, {p2, p3}, {p0, p1}};
+    auto result = stitch_contours(segments, kSnapEps);
+    EXPECT_TRUE(result.loops.empty());
+    ASSERT_EQ(result.open_chains.size(), 1u);
+    EXPECT_EQ(result.open_chains[0], (polygon_t{p0, p1, p2, p3}));
+    EXPECT_TRUE(stitch_contours({}, kSnapEps).loops.empty());
+}
+
+TEST(ContourStitchTest, TorusLayersCloseWithoutOpenChains) {
+    PathPlanner planner;
+    planner.set_cad(test_data_path("torus_ascii.stl"));
+    planner.slice_planar(1, 0.5f);
+    ASSERT_GT(planner.layer_count(), 0u);
+    for (const auto& layer : planner.get_plan()) {
+        EXPECT_FALSE(layer.contours().empty()) << "z " << layer.z;
+        EXPECT_TRUE(layer.open_chains().empty()) << "z " << layer.z;
+    }
+}
+
+TEST(PolygonOffsetTest, SquareInsetAndRoundOutset) {
+    const polygon_t square = ensure_closed(square_loop(0.0f, 0.0f, 5.0f, true));
+    auto inset = offset_polygons({square}, -1.0f);
+    ASSERT_EQ(inset.size(), 1u);
+    EXPECT_NEAR(signed_area(inset[0]), 64.0f, 1e-3f);
+
+    auto mitered = offset_polygons({square}, 1.0f);
+    ASSERT_EQ(mitered.size(), 1u);
+    EXPECT_NEAR(signed_area(mitered[0]), 144.0f, 1e-3f);
+
+    OffsetOptions round{JoinType::Round, 2.0, 0.001f};
+    auto rounded = offset_polygons({square}, 1.0f, round);
+    ASSERT_EQ(rounded.size(), 1u);
+    EXPECT_NEAR(signed_area(rounded[0]), 100.0f + 40.0f + 3.14159265f, 0.02f);
+}
+
+TEST(PolygonOffsetTest, ConcaveCornersComeOutClean) {
+    // an L whose inner corner makes the naive miter fold over itself
+    polygon_t ell{{0, 0, 0}, {10, 0, 0}, {10, 2, 0}, {2, 2, 0}, {2, 10, 0}, {0, 10, 0}, {0, 0, 0}};
+    auto inset = offset_polygons({ell}, -0.5f);
+    ASSERT_EQ(inset.size(), 1u);
+    EXPECT_TRUE(loops_are_simple(inset));
+    // two 1 x 9 arms sharing a 1 x 1 corner
+    EXPECT_NEAR(total_area(inset), 17.0f, 1e-3f);
+    EXPECT_EQ(inset[0].size(), 7u);
+}
+
+TEST(PolygonOffsetTest, ThinWallsStopAndGrowingHolesMerge) {
+    // a 1 mm wide bar with a 6 mm wide block: a 0.75 mm inset only survives in the block
+    polygon_t part{{0, 0, 0}, {20, 0, 0}, {20, 1, 0}, {6, 1, 0}, {6, 6, 0}, {0, 6, 0}, {0, 0, 0}};
+    auto inset = offset_polygons({part}, -0.75f);
+    ASSERT_EQ(inset.size(), 1u);
+    EXPECT_NEAR(total_area(inset), 4.5f * 4.5f, 1e-3f);
+    EXPECT_TRUE(offset_polygons({part}, -3.5f).empty());
+
+    // two holes 1 mm apart: insetting the material by 0.6 mm joins them into one hole
+    std::vector<polygon_t> plate{ensure_closed(square_loop(0, 0, 10, true)),
+                                 ensure_closed(square_loop(-3, 0, 2.5f, false)),
+                                 ensure_closed(square_loop(3, 0, 2.5f, false))};
+    auto walls = offset_polygons(plate, -0.6f);
+    ASSERT_EQ(walls.size(), 2u);
+    EXPECT_TRUE(loops_are_simple(walls));
+    auto classified = classify_polygons(walls);
+    EXPECT_EQ(std::count_if(classified.begin(), classified.end(), [](const auto& c) { return c.is_hole; }), 1);
+}
+
+TEST(PolygonOffsetTest, UnionThatDoesNotSettleStillTracesLoops) {
+    // two overlapping squares: the first pass splits them where they cross
+    const std::vector<FixedLoop> loops{{{0, 0}, {10, 0}, {10, 10}, {0, 10}}, {{5, 5}, {15, 5}, {15, 15}, {5, 15}}};
+    auto area = [](const FixedLoop& loop) {
+        int64_t area2 = 0;
+        for (std::size_t i = 0; i < loop.size(); ++i) {
+            const auto& q = loop[(i + 1) % loop.size()];
+            area2 += loop[i].x * q.y - q.x * loop[i].y;
+        }
+        return area2 / 2;
+    };
+
+    bool settled = false;
+    auto merged = union_loops(loops, kUnionPasses, &settled);
+    EXPECT_TRUE(settled);
+    ASSERT_EQ(merged.size(), 1u);
+    EXPECT_EQ(area(merged[0]), 175);
+
+    // cut off before a pass comes back clean, the pieces split so far are traced as they stand
+    auto capped = union_loops(loops, 1, &settled);
+    EXPECT_FALSE(settled);
+    ASSERT_EQ(capped.size(), 1u);
+    EXPECT_EQ(area(capped[0]), 175);
+
+    // with no split at all the crossings stay in; the union comes back rather than failing
+    EXPECT_NO_THROW(union_loops(loops, 0, &settled));
+    EXPECT_FALSE(settled);
+}
+
+TEST(PathPlanPerimeterTest, MorePerimetersAddWallsInside) {
+    auto path = test_data_path("torus_ascii.stl");
+    std::size_t previous = 0;
+    for (int count : {1, 2, 4}) {
+        PathPlanner planner;
+        planner.set_cad(path);
+        planner.set_perimeter_count(count);
+        planner.slice_planar(1, 0.5f);
+        std::size_t contours = 0;
+        for (const auto& layer : planner.get_plan()) contours += layer.contours().size();
+        EXPECT_GT(contours, previous) << count << " perimeters";
+        EXPECT_EQ(planner.unsettled_insets(), 0u) << count << " perimeters";
+        previous = contours;
+    }
+    PathPlanner planner;
+    EXPECT_THROW(planner.set_perimeter_count(0), std::runtime_error);
+}
+
+TEST(SliceCacheTest, ReusesStagesAndMatchesFreshSlices) {
+    auto path = test_data_path("torus_ascii.stl");
+    auto fresh_plan = [&](int layer_height_mm, float infill_spacing, int perimeters) {
+        PathPlanner planner;
+        planner.set_cad(path);
+        planner.set_perimeter_count(perimeters);
+        planner.slice_planar(layer_height_mm, infill_spacing);
+        return planner.get_plan();
+    };
+
+    PathPlanner planner;
+    planner.set_cad(path);
+    planner.slice_planar(1, 0.5f);
+    planner.slice_planar(1, 0.5f);
+    EXPECT_EQ(planner.slice_cache_stats().plan_hits, 1u);
+    expect_same_plan(fresh_plan(1, 0.5f, 2), planner.get_plan());
+
+    // infill only: islands and walls come from the cache
+    planner.slice_planar(1, 0.8f);
+    EXPECT_EQ(planner.slice_cache_stats().island_hits, 2u);
+    EXPECT_EQ(planner.slice_cache_stats().wall_hits, 2u);
+    EXPECT_EQ(planner.slice_cache_stats().plan_hits, 1u);
+    expect_same_plan(fresh_plan(1, 0.8f, 2), planner.get_plan());
+
+    planner.set_perimeter_count(3);
+    planner.slice_planar(1, 0.8f);
+    EXPECT_EQ(planner.slice_cache_stats().island_hits, 3u);
+    EXPECT_EQ(planner.slice_cache_stats().wall_hits, 2u);
+    expect_same_plan(fresh_plan(1, 0.8f, 3), planner.get_plan());
+
+    // reloading the same file keeps the cache; a new layer height does not
+    const uint64_t hash = planner.mesh_hash();
+    planner.set_cad(path);
+    EXPECT_EQ(planner.mesh_hash(), hash);
+    planner.slice_planar(1, 0.8f);
+    EXPECT_EQ(planner.slice_cache_stats().plan_hits, 2u);
+    planner.slice_planar(2, 0.8f);
+    EXPECT_EQ(planner.slice_cache_stats().island_hits, 4u);
+    expect_same_plan(fresh_plan(2, 0.8f, 3), planner.get_plan());
+
+    EXPECT_EQ(planner.slice_cache_stats().slices, 6u);
+    EXPECT_DOUBLE_EQ(planner.slice_cache_stats().hit_rate(), 2.0 / 6.0);
+    planner.clear_slice_cache();
+    planner.slice_planar(2, 0.8f);
+    EXPECT_EQ(planner.slice_cache_stats().island_hits, 4u);
+}
+
+TEST(SliceCacheTest, FailedWallBuildIsNotReused) {
+    auto path = test_data_path("torus_ascii.stl");
+    auto fresh_plan = [&](float infill_spacing) {
+        PathPlanner planner;
+        planner.set_cad(path);
+        planner.slice_planar(1, infill_spacing);
+        return planner.get_plan();
+    };
+
+    PathPlanner planner;
+    planner.set_cad(path);
+    planner.slice_planar(1, 0.5f);
+
+    // the walls for three perimeters fail part way through
+    planner.set_perimeter_count(3);
+    planner.set_wall_hook([](std::size_t l) {
+        if (l == 3) throw std::runtime_error("wall build failed");
+    });
+    EXPECT_THROW(planner.slice_planar(1, 0.5f), std::runtime_error);
+    planner.set_wall_hook({});
+
+    // back on the old settings, neither the walls nor the plan come from the failed build
+    planner.set_perimeter_count(2);
+    planner.slice_planar(1, 0.5f);
+    EXPECT_EQ(planner.slice_cache_stats().wall_hits, 0u);
+    EXPECT_EQ(planner.slice_cache_stats().plan_hits, 0u);
+    expect_same_plan(fresh_plan(0.5f), planner.get_plan());
+
+    planner.slice_planar(1, 0.8f);
+    EXPECT_EQ(planner.slice_cache_stats().wall_hits, 1u);
+    expect_same_plan(fresh_plan(0.8f), planner.get_plan());
+}
+
+TEST(PlanFileTest, RoundTripsPlanThroughMappedFile) {
+    auto path = test_data_path("torus_ascii.stl");
+    auto plan_path = std::filesystem::temp_directory_path() / "printer_test_plan.bin";
+    PathPlanner sliced;
+    sliced.set_cad(path);
+    sliced.slice_planar(1, 0.5f);
+    sliced.save_plan(plan_path);
+
+    PathPlanner loaded;
+    loaded.load_plan(plan_path);
+    EXPECT_TRUE(loaded.plan_is_mapped());
+    EXPECT_TRUE(loaded.get_plan().empty());
+    ASSERT_EQ(loaded.layer_count(), sliced.layer_count());
+
+    // quantized to 1 um: each coordinate within half a unit plus float rounding
+    const float tolerance = 0.5f / static_cast<float>(kPlanUnitsPerMm) + 1e-4f;
+    auto expect_close = [&](const SegmentView& expected, const SegmentView& actual, std::size_t l) {
+        ASSERT_EQ(expected.size(), actual.size()) << "layer " << l;
+        EXPECT_TRUE(actual.is_mapped());
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            auto a = expected[i];
+            auto b = actual[i];
+            EXPECT_NEAR(a.first.x, b.first.x, tolerance);
+            EXPECT_NEAR(a.first.y, b.first.y, tolerance);
+            EXPECT_NEAR(a.second.x, b.second.x, tolerance);
+            EXPECT_NEAR(a.second.y, b.second.y, tolerance);
+            EXPECT_EQ(a.first.z, b.first.z);
+            EXPECT_EQ(a.second.z, b.second.z);
+        }
+    };
+    for (std::size_t l = 0; l < sliced.layer_count(); ++l) {
+        auto expected = sliced.get_layer(l);
+        auto actual = loaded.get_layer(l);
+        EXPECT_EQ(expected.z, actual.z);
+        EXPECT_EQ(expected.thickness, actual.thickness);
+        expect_close(expected.contours, actual.contours, l);
+        expect_close(expected.infill, actual.infill, l);
+        expect_close(expected.open_chains, actual.open_chains, l);
+    }
+    EXPECT_THROW(loaded.get_layer(loaded.layer_count()), std::out_of_range);
+
+    // saving a mapped plan over its own file is safe, and slicing replaces the mapping
+    loaded.save_plan(plan_path);
+    EXPECT_EQ(PlanFile(plan_path.string()).layer_count(), sliced.layer_count());
+    loaded.set_cad(path);
+    loaded.slice_planar(1, 0.5f);
+    EXPECT_FALSE(loaded.plan_is_mapped());
+    expect_same_plan(sliced.get_plan(), loaded.get_plan());
+    std::filesystem::remove(plan_path);
+}
+
+TEST(PlanFileTest, RejectsForeignTruncatedAndNewerFiles) {
+    auto plan_path = std::filesystem::temp_directory_path() / "printer_test_bad_plan.bin";
+    std::vector<segment_t> square = {{{0, 0, 2}, {1, 0, 2}}, {{1, 0, 2}, {1, 1, 2}}};
+    {
+        PlanFileWriter writer(plan_path);
+        writer.add_layer(2.0f, 0.5f, square, {}, {});
+        writer.finish();
+    }
+    auto bytes = [&] {
+        std::ifstream in(plan_path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(in), {});
+    }();
+    auto write_bytes = [&](const std::string& contents) {
+        std::ofstream(plan_path, std::ios::binary | std::ios::trunc) << contents;
+    };
+
+    PathPlanner planner;
+    planner.load_plan(plan_path);
+    ASSERT_EQ(planner.layer_count(), 1u);
+    EXPECT_EQ(planner.get_layer(0).thickness, 0.5f);
+    EXPECT_EQ(planner.get_layer(0).contours.to_vector().size(), 2u);
+
+    std::string foreign = bytes;
+    foreign[0] = 'X';
+    write_bytes(foreign);
+    EXPECT_THROW(PlanFile(plan_path.string()), std::runtime_error);
+
+    std::string newer = bytes;
+    newer[8] = static_cast<char>(kPlanFileVersion + 1);
+    write_bytes(newer);
+    EXPECT_THROW(PlanFile(plan_path.string()), std::runtime_error);
+
+    write_bytes(bytes.substr(0, bytes.size() - 1));
+    EXPECT_THROW(PlanFile(plan_path.string()), std::runtime_error);
+
+    // a failed load keeps the plan that was already mapped
+    EXPECT_THROW(planner.load_plan(plan_path), std::runtime_error);
+    EXPECT_EQ(planner.layer_count(), 1u);
+
+    std::vector<segment_t> far = {{{3e6f, 0, 0}, {0, 0, 0}}};
+    PlanFileWriter writer(plan_path);
+    EXPECT_THROW(writer.add_layer(0.0f, 0.2f, far, {}, {}), std::runtime_error);
+    EXPECT_THROW(writer.add_layer(0.0f, 0.0f, square, {}, {}), std::runtime_error);
+    std::filesystem::remove(plan_path);
+}
+
+TEST(LayerScheduleTest, LayersWithinMatchesLinearScan) {
+    PathPlanner planner;
+    planner.set_cad(test_data_path("torus_ascii.stl"));
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> z_dist(-1.0f, 40.0f);
+    for (const auto& schedule : {LayerSchedule::uniform(0.3f), LayerSchedule::uniform(1.0f),
+                                 LayerSchedule::uniform(0.3f, 7.1f, 19.0f), LayerSchedule::adaptive(planner.get_meshes())}) {
+        ASSERT_FALSE(schedule.empty());
+        for (int trial = 0; trial < 500; ++trial) {
+            float lo = z_dist(rng);
+            float hi = trial % 5 == 0 ? lo : lo + z_dist(rng) * 0.05f;
+            int first = 0;
+            while (first < static_cast<int>(schedule.layer_count()) && schedule.z(first) < lo) first++;
+            int last = static_cast<int>(schedule.layer_count()) - 1;
+            while (last >= 0 && schedule.z(last) > hi) last--;
+            EXPECT_EQ(schedule.layers_within(lo, hi), std::make_pair(first, last)) << lo << " " << hi;
+        }
+    }
+    auto uniform = LayerSchedule::uniform(0.25f);
+    EXPECT_EQ(uniform.layer_count(), layer_count_for(0.25f));
+    EXPECT_EQ(uniform.z(3), 0.75f);
+    EXPECT_TRUE(LayerSchedule::uniform(0.0f).empty());
+}
+
+TEST(LayerScheduleTest, AdaptiveLayersBoundCuspWithFewerLayers) {
+    PathPlanner planner;
+    planner.set_cad(test_data_path("torus_ascii.stl"));
+    const auto& meshes = planner.get_meshes();
+    AdaptiveLayerOptions options{0.05f, 0.4f, 0.02f};
+    auto schedule = LayerSchedule::adaptive(meshes, options);
+
+    const auto& bounds = planner.get_bounds();
+    ASSERT_GT(schedule.layer_count(), 1u);
+    EXPECT_EQ(schedule.z(0), bounds.min.z);
+    EXPECT_GE(schedule.z(schedule.layer_count() - 1), bounds.max.z);
+    EXPECT_LT(schedule.layer_count(), static_cast<std::size_t>((bounds.max.z - bounds.min.z) / options.min_height));
+
+    bool thin = false, thick = false;
+    for (std::size_t l = 1; l < schedule.layer_count(); ++l) {
+        const float thickness = schedule.thickness(l);
+        EXPECT_GE(thickness, options.min_height * 0.999f);
+        EXPECT_LE(thickness, options.max_height * 1.001f);
+        thin |= thickness < 0.06f;
+        thick |= thickness > 0.1f;
+        if (thickness <= options.min_height * 1.001f) continue;
+        // every sloped facet the layer crosses stays within the cusp bound
+        for (const auto& tri : meshes.front().triangles) {
+            const auto& a = meshes.front().points[tri.vertices[0]];
+            const auto& b = meshes.front().points[tri.vertices[1]];
+            const auto& c = meshes.front().points[tri.vertices[2]];
+            if (std::max({a.z, b.z, c.z}) < schedule.z(l - 1) || std::min({a.z, b.z, c.z}) > schedule.z(l)) continue;
+            vec3_t n = (b - a).cross(c - a);
+            float nz = std::abs(n.z) / n.norm();
+            if (nz > 0.9998f) continue;
+            EXPECT_LE(thickness * nz, options.max_cusp * 1.001f) << "layer " << l;
+        }
+    }
+    EXPECT_TRUE(thin);
+    EXPECT_TRUE(thick);
+    EXPECT_THROW(LayerSchedule::adaptive(meshes, {0.2f, 0.1f, 0.02f}), std::runtime_error);
+}
+
+TEST(LayerScheduleTest, SlicesAtSubMillimeterAndAdaptiveHeights) {
+    PathPlanner planner;
+    planner.set_cad(test_data_path("torus_ascii.stl"));
+    planner.slice_planar(1, 0.8f);
+    const std::size_t whole_mm_layers = planner.layer_count();
+    planner.slice_planar(0.5f, 0.8f);
+    EXPECT_GT(planner.layer_count(), whole_mm_layers);
+    const auto& bounds = planner.get_bounds();
+    EXPECT_EQ(planner.layer_schedule(), LayerSchedule::uniform(0.5f, bounds.min.z, bounds.max.z));
+
+    planner.slice_planar_adaptive({0.1f, 0.5f, 0.05f}, 0.8f);
+    const auto& schedule = planner.layer_schedule();
+    EXPECT_FALSE(schedule.is_uniform());
+    ASSERT_GT(planner.layer_count(), 0u);
+    EXPECT_EQ(planner.get_raw_layers().size(), schedule.layer_count());
+    for (const auto& layer : planner.get_plan()) {
+        auto heights = schedule.heights();
+        EXPECT_TRUE(std::binary_search(heights.begin(), heights.end(), layer.z)) << layer.z;
+        for (const auto& seg : layer.contours()) EXPECT_EQ(seg.first.z, layer.z);
+    }
+}
+
+TEST(PartBoundsTest, ReadersAndPlacementKeepMeshBounds) {
+    PathPlanner planner;
+    planner.set_cad(test_data_path("torus_ascii.stl"));
+    bbox_t scanned;
+    for (const auto& mesh : planner.get_meshes()) {
+        bbox_t bounds = mesh.bounds;
+        Mesh copy = mesh;
+        copy.update_bounds();
+        EXPECT_EQ(bounds.min, copy.bounds.min);
+        EXPECT_EQ(bounds.max, copy.bounds.max);
+        scanned.expand(copy.bounds);
+    }
+    EXPECT_EQ(planner.get_bounds().min, scanned.min);
+    EXPECT_EQ(planner.get_bounds().max, scanned.max);
+    EXPECT_GE(scanned.min.z, 0.0f);
+
+    Mesh mesh = planner.get_meshes().front();
+    mesh.translate({-1.0f, 2.0f, -3.0f});
+    bbox_t moved = mesh.bounds;
+    mesh.update_bounds();
+    EXPECT_EQ(moved.min, mesh.bounds.min);
+    EXPECT_EQ(moved.max, mesh.bounds.max);
+    EXPECT_TRUE(bbox_t{}.empty());
+}
+
+TEST(PartBoundsTest, BoundedLayersMatchBuildVolumeSlice) {
+    auto path = test_data_path("torus_ascii.stl");
+    PathPlanner planner;
+    planner.set_cad(path);
+    const auto& bounds = planner.get_bounds();
+    for (float layer_height : {1.0f, 0.25f}) {
+        PathPlanner volume;
+        volume.set_cad(path);
+        volume.slice_planar(LayerSchedule::uniform(layer_height), 0.8f);
+        planner.slice_planar(layer_height, 0.8f);
+
+        // only the planes over the part are allocated, and they give the same plan
+        EXPECT_LE(planner.get_raw_layers().size(), static_cast<std::size_t>((bounds.max.z - bounds.min.z) / layer_height) + 3);
+        EXPECT_EQ(volume.get_raw_layers().size(), layer_count_for(layer_height));
+        expect_same_plan(volume.get_plan(), planner.get_plan());
+    }
+    expect_same_plan(planner.get_plan(), slice_streaming(path, 0.25f, 0.8f, std::size_t{64} << 20));
+}
+
+TEST(ScanlineInfillTest, EdgeTableMatchesPerLineScan) {
+    std::mt19937 rng(17);
+    for (int trial = 0; trial < 20; ++trial) {
+        const float grid = trial % 2 ? 0.25f : 0.001f;
+        polygon_t outer = ensure_closed(jagged_loop(rng, 0.0f, 0.0f, 40.0f, 64 + trial * 16, grid, true));
+        std::vector<polygon_t> holes;
+        for (int h = 0; h < trial % 6; ++h) {
+            // holes may overlap each other and poke out of the outer loop
+            holes.push_back(jagged_loop(rng, -15.0f + 10.0f * h, 5.0f * (h % 3) - 5.0f, 6.0f, 24, grid, h % 2 == 0));
+        }
+        for (float spacing : {0.25f, 0.8f, 3.0f}) {
+            EXPECT_TRUE(same_segments(clip_infill_per_line(outer, holes, spacing, 1.0f), clip_infill(outer, holes, spacing, 1.0f)))
+                << "trial " << trial << " spacing " << spacing;
+        }
+    }
+    // a square's scanlines land exactly on its horizontal edges and vertices
+    polygon_t square = square_loop(0.0f, 0.0f, 5.0f, true);
+    std::vector<polygon_t> hole{square_loop(0.0f, 0.0f, 2.0f, false)};
+    EXPECT_TRUE(same_segments(clip_infill_per_line(square, hole, 1.0f, 0.0f), clip_infill(square, hole, 1.0f, 0.0f)));
+    EXPECT_TRUE(clip_infill({}, {}, 1.0f, 0.0f).empty());
+}
+
+TEST(ScanlineInfillTest, EdgeTableMatchesPerLineScanOnTorusIslands) {
+    PathPlanner planner;
+    planner.set_cad(test_data_path("torus_ascii.stl"));
+    auto layers = sweep_slice(planner.get_meshes(), LayerSchedule::uniform(0.5f, planner.get_bounds().min.z, planner.get_bounds().max.z));
+    std::size_t islands_seen = 0;
+    for (std::size_t l = 0; l < layers.layer_count(); ++l) {
+        auto stitched = stitch_contours(layers.layer(l), kSnapEps);
+        for (const auto& island : build_islands(classify_polygons(std::move(stitched.loops)))) {
+            islands_seen++;
+            EXPECT_TRUE(same_segments(clip_infill_per_line(island.outer, island.holes, 0.4f, 0.0f),
+                                      clip_infill(island.outer, island.holes, 0.4f, 0.0f)))
+                << "layer " << l;
+        }
+    }
+    EXPECT_GT(islands_seen, 0u);
+}
+
+TEST(ScanlineInfillTest, FillRulesOnOverlappingLoops) {
+    ScanlineEdgeTable table;
+    EXPECT_EQ(table.add_loop(square_loop(0.0f, 0.0f, 2.0f, true)), 0u);   // x -2..2
+    EXPECT_EQ(table.add_loop(square_loop(2.0f, 0.0f, 2.0f, true)), 1u);   // x 0..4, same winding
+    EXPECT_EQ(table.add_loop(square_loop(10.0f, 0.0f, 2.0f, true)), 2u);  // x 8..12
+    EXPECT_EQ(table.add_loop(square_loop(10.0f, 0.0f, 1.0f, false)), 3u); // x 9..11, a hole in it
+    table.advance(0.5f);
+
+    EXPECT_EQ(table.fill_spans(FillRule::EvenOdd),
+              (std::vector<Span>{{-2.0f, 0.0f}, {2.0f, 4.0f}, {8.0f, 9.0f}, {11.0f, 12.0f}}));
+    EXPECT_EQ(table.fill_spans(FillRule::NonZero),
+              (std::vector<Span>{{-2.0f, 4.0f}, {8.0f, 9.0f}, {11.0f, 12.0f}}));
+
+    const auto& loop_spans = table.loop_spans();
+    ASSERT_EQ(loop_spans.size(), 4u);
+    for (uint32_t i = 0; i < 4; ++i) EXPECT_EQ(loop_spans[i].loop, i);
+    EXPECT_EQ(loop_spans[1].x0, 0.0f);
+    EXPECT_EQ(loop_spans[1].x1, 4.0f);
+
+    // past the top edges every edge has retired
+    table.advance(2.0f);
+    EXPECT_TRUE(table.fill_spans(FillRule::NonZero).empty());
+    EXPECT_TRUE(table.done());
+}
+
+TEST(InfillPatternTest, RotatedLinesStayInsideTheIsland) {
+    std::mt19937 rng(23);
+    const polygon_t outer = ensure_closed(jagged_loop(rng, 0.0f, 0.0f, 30.0f, 90, 0.001f, true));
+    const std::vector<polygon_t> holes{ensure_closed(jagged_loop(rng, 4.0f, -3.0f, 8.0f, 20, 0.001f, false))};
+    EXPECT_TRUE(same_segments(clip_infill(outer, holes, 0.7f, 0.0f, LineAnchor::Island, 2.0f), clip_infill(outer, holes, 0.7f, 2.0f)));
+
+    for (float angle : {30.0f, 45.0f, 90.0f, -45.0f, 137.0f}) {
+        for (auto anchor : {LineAnchor::Island, LineAnchor::Lattice}) {
+            auto lines = clip_infill(outer, holes, 0.7f, angle, anchor, 2.0f);
+            ASSERT_FALSE(lines.empty()) << angle;
+            EXPECT_EQ(line_directions(lines), (std::vector<int>{static_cast<int>(((static_cast<int>(angle) % 180) + 180) % 180)}));
+            for (const auto& seg : lines) {
+                vec3_t mid = (seg.first + seg.second) * 0.5f;
+                EXPECT_EQ(seg.first.z, 2.0f);
+                EXPECT_TRUE(point_in_polygon(outer, mid)) << angle;
+                EXPECT_FALSE(point_in_polygon(holes[0], mid)) << angle;
+            }
+        }
+    }
+
+    // a square turned with the lines gets the axis-aligned fill, give or take the line that
+    // grazes an edge after rounding
+    const float turn = 30.0f * 3.14159265f / 180.0f;
+    polygon_t square = square_loop(0.0f, 0.0f, 10.0f, true), turned;
+    for (const auto& p : square) turned.push_back({p.x * std::cos(turn) - p.y * std::sin(turn), p.x * std::sin(turn) + p.y * std::cos(turn), 0.0f});
+    auto axis = clip_infill(square, {}, 0.5f, 0.0f);
+    auto rotated = clip_infill(turned, {}, 0.5f, 30.0f, LineAnchor::Island, 0.0f);
+    EXPECT_LE(std::max(axis.size(), rotated.size()) - std::min(axis.size(), rotated.size()), 1u);
+    EXPECT_NEAR(total_length(axis), total_length(rotated), 20.0f + 1e-2f);
+    for (const auto& seg : rotated) EXPECT_NEAR((seg.second - seg.first).norm(), 20.0f, 1e-3f);
+}
+
+TEST(InfillPatternTest, PatternsPickDirectionsPerLayerAtEqualDensity) {
+    InfillOptions crosshatch{InfillPattern::Crosshatch, 45.0f};
+    EXPECT_EQ(infill_angles(crosshatch, 4), (std::vector<float>{45.0f}));
+    EXPECT_EQ(infill_angles(crosshatch, 7), (std::vector<float>{135.0f}));
+    EXPECT_EQ(infill_angles({InfillPattern::Grid, 0.0f}, 3), (std::vector<float>{0.0f, 90.0f}));
+    EXPECT_EQ(infill_angles({InfillPattern::Triangles, 15.0f}, 0), (std::vector<float>{15.0f, 75.0f, 135.0f}));
+
+    const polygon_t square = ensure_closed(square_loop(0.0f, 0.0f, 20.0f, true));
+    const float reference = total_length(pattern_infill(square, {}, 1.0f, {}, 0, 0.0f));
+    for (auto pattern : {InfillPattern::Crosshatch, InfillPattern::Grid, InfillPattern::Triangles}) {
+        auto lines = pattern_infill(square, {}, 1.0f, {pattern, 45.0f}, 1, 0.0f);
+        EXPECT_NEAR(total_length(lines), reference, 0.06f * reference) << static_cast<int>(pattern);
+    }
+    EXPECT_EQ(line_directions(pattern_infill(square, {}, 1.0f, {InfillPattern::Triangles, 0.0f}, 0, 0.0f)),
+              (std::vector<int>{0, 60, 120}));
+
+    // triangle families share the lattice: every crossing of the 0 and 120 degree lines lies on a 60 degree line
+    auto families = [&](float angle) { return clip_infill(square, {}, 3.0f, angle, LineAnchor::Lattice, 0.0f); };
+    auto flat = families(0.0f), steep = families(120.0f);
+    const float n60x = -std::sin(60.0f * 3.14159265f / 180.0f), n60y = std::cos(60.0f * 3.14159265f / 180.0f);
+    std::size_t crossings = 0;
+    for (const auto& a : flat) {
+        for (const auto& b : steep) {
+            // b's line: x = x0 + t * dx at y = a's y
+            vec3_t d = b.second - b.first;
+            float t = (a.first.y - b.first.y) / d.y;
+            if (t < 0.0f || t > 1.0f) continue;
+            float x = b.first.x + t * d.x;
+            if (x < a.first.x || x > a.second.x) continue;
+            float offset = (x * n60x + a.first.y * n60y) / 3.0f;
+            EXPECT_NEAR(offset, std::round(offset), 1e-3f);
+            crossings++;
+        }
+    }
+    EXPECT_GT(crossings, 50u);
+}
+
+TEST(InfillPatternTest, PlannerAlternatesCrosshatchAndCachesOnOptions) {
+    auto path = test_data_path("torus_ascii.stl");
+    PathPlanner planner;
+    planner.set_cad(path);
+    planner.slice_planar(0.5f, 1.0f);
+    auto rectilinear = planner.get_plan();
+
+    planner.set_infill_options({InfillPattern::Crosshatch, 45.0f});
+    planner.slice_planar(0.5f, 1.0f);
+    EXPECT_EQ(planner.slice_cache_stats().plan_hits, 0u);
+    EXPECT_EQ(planner.slice_cache_stats().wall_hits, 1u);
+    const auto& schedule = planner.layer_schedule();
+    for (const auto& layer : planner.get_plan()) {
+        if (layer.infill().empty()) continue;
+        auto [l, last] = schedule.layers_within(layer.z, layer.z);
+        ASSERT_EQ(l, last);
+        const int expected = schedule.plane(static_cast<std::size_t>(l)) % 2 == 0 ? 45 : 135;
+        EXPECT_EQ(line_directions(layer.infill()), (std::vector<int>{expected})) << "z " << layer.z;
+    }
+    expect_same_plan(planner.get_plan(), slice_streaming_with(path, 0.5f, 1.0f, {InfillPattern::Crosshatch, 45.0f}));
+
+    planner.slice_planar(0.5f, 1.0f);
+    EXPECT_EQ(planner.slice_cache_stats().plan_hits, 1u);
+    planner.set_infill_options({});
+    planner.slice_planar(0.5f, 1.0f);
+    expect_same_plan(rectilinear, planner.get_plan());
+}
+
+TEST(TpmsInfillTest, FieldRowsMatchScalarAndPointField) {
+    for (auto surface : {TpmsSurface::Gyroid, TpmsSurface::SchwarzP, TpmsSurface::SchwarzD}) {
+        const float period = 5.0f, z = 3.7f, x0 = -12.3f, step = 0.31f;
+        TpmsLayerField field(surface, period, z, x0, step, 101);  // odd length exercises the tails
+        std::vector<float> expected(field.size()), actual(field.size());
+        for (float y : {-4.0f, 0.0f, 2.9f, 40.1f}) {
+            field.row(IntersectKernel::Scalar, y, expected.data());
+            for (std::size_t i = 0; i < field.size(); ++i) {
+                vec3_t p{x0 + static_cast<float>(i) * step, y, z};
+                EXPECT_NEAR(expected[i], TpmsLayerField::at(surface, period, p), 1e-4f) << static_cast<int>(surface);
+            }
+            for (auto kernel : {IntersectKernel::Avx2, IntersectKernel::Neon}) {
+                if (!intersect_kernel_supported(kernel)) continue;
+                field.row(kernel, y, actual.data());
+                EXPECT_EQ(std::memcmp(expected.data(), actual.data(), expected.size() * sizeof(float)), 0)
+                    << intersect_kernel_name(kernel);
+            }
+        }
+    }
+}
+
+TEST(TpmsInfillTest, CurvesFollowTheSurfaceInsideTheIsland) {
+    const polygon_t outer = ensure_closed(square_loop(20.0f, 20.0f, 20.0f, true));
+    const std::vector<polygon_t> holes{ensure_closed(square_loop(23.0f, 18.0f, 6.5f, false))};
+    const float island_area = 40.0f * 40.0f - 13.0f * 13.0f;
+    const float spacing = 2.0f;
+    for (auto surface : {TpmsSurface::Gyroid, TpmsSurface::SchwarzP, TpmsSurface::SchwarzD}) {
+        const float period = tpms_period_for_spacing(surface, spacing);
+        double length = 0.0;
+        const int layers = 8;
+        for (int l = 0; l < layers; ++l) {
+            const float z = period * static_cast<float>(l) / static_cast<float>(layers);
+            auto curves = tpms_infill(outer, holes, surface, spacing, z);
+            ASSERT_FALSE(curves.empty());
+            for (const auto& seg : curves) {
+                EXPECT_EQ(seg.first.z, z);
+                EXPECT_NEAR(TpmsLayerField::at(surface, period, seg.first), 0.0f, 0.05f);
+                vec3_t mid = (seg.first + seg.second) * 0.5f;
+                EXPECT_TRUE(point_in_polygon(outer, mid));
+                EXPECT_FALSE(point_in_polygon(holes[0], mid));
+            }
+            length += total_length(curves);
+        }
+        // about the length per area of straight lines `spacing` apart
+        EXPECT_NEAR(length / layers / island_area, 1.0 / spacing, 0.1 / spacing) << static_cast<int>(surface);
+    }
+    EXPECT_TRUE(tpms_infill({}, {}, TpmsSurface::Gyroid, 1.0f, 0.0f).empty());
+}
+
+TEST(TpmsInfillTest, PlannerFillsTorusWithGyroid) {
+    auto path = test_data_path("torus_ascii.stl");
+    PathPlanner planner;
+    planner.set_cad(path);
+    planner.set_infill_options({InfillPattern::Gyroid, 0.0f});
+    planner.slice_planar(0.5f, 1.0f);
+    std::size_t filled = 0;
+    for (const auto& layer : planner.get_plan()) filled += layer.infill().empty() ? 0 : 1;
+    EXPECT_GT(filled, planner.get_plan().size() / 2);
+    expect_same_plan(planner.get_plan(), slice_streaming_with(path, 0.5f, 1.0f, {InfillPattern::Gyroid, 0.0f}));
+}
+
+TEST(HoneycombInfillTest, EdgesFormHexagonsInsideTheIsland) {
+    // off the lattice lines, so no edge runs along the loops
+    const polygon_t outer = ensure_closed(square_loop(20.3f, 20.7f, 20.0f, true));
+    const std::vector<polygon_t> holes{ensure_closed(square_loop(23.3f, 18.7f, 6.5f, false))};
+    const float island_area = 40.0f * 40.0f - 13.0f * 13.0f;
+    const float spacing = 2.0f;
+    const float side = 2.0f * spacing / std::sqrt(3.0f);
+    auto edges = pattern_infill(outer, holes, spacing, {InfillPattern::Honeycomb, 0.0f}, 0, 1.5f);
+    ASSERT_FALSE(edges.empty());
+    EXPECT_EQ(line_directions(edges), (std::vector<int>{30, 90, 150}));
+    for (const auto& seg : edges) {
+        EXPECT_EQ(seg.first.z, 1.5f);
+        EXPECT_LE((seg.second - seg.first).norm(), side + 1e-4f);
+        vec3_t mid = (seg.first + seg.second) * 0.5f;
+        EXPECT_TRUE(point_in_polygon(outer, mid));
+        EXPECT_FALSE(point_in_polygon(holes[0], mid));
+    }
+    // away from the loops every corner joins three edges
+    const Bounds hole_box{15.8f, 30.8f, 11.2f, 26.2f};
+    for (const auto& seg : edges) {
+        for (const auto& p : {seg.first, seg.second}) {
+            if (p.x < 1.3f || p.x > 39.3f || p.y < 1.7f || p.y > 39.7f || hole_box.contains(p)) continue;
+            int joined = 0;
+            for (const auto& other : edges) joined += (close2d(p, other.first, 1e-3f) ? 1 : 0) + (close2d(p, other.second, 1e-3f) ? 1 : 0);
+            EXPECT_EQ(joined, 3) << p.x << ", " << p.y;
+        }
+    }
+    // the length per area of straight lines `spacing` apart
+    EXPECT_NEAR(total_length(edges) / island_area, 1.0f / spacing, 0.1f / spacing);
+    EXPECT_TRUE(pattern_infill({}, {}, spacing, {InfillPattern::Honeycomb, 0.0f}, 0, 0.0f).empty());
+}
+
+TEST(HoneycombInfillTest, CachedLatticeMatchesPerIslandLattice) {
+    std::mt19937 rng(20);
+    const InfillOptions options{InfillPattern::Honeycomb, 15.0f};
+    const HoneycombLattice lattice(0.8f, options.angle_deg, Bounds{-60.0f, 120.0f, -60.0f, 120.0f});
+    EXPECT_GT(lattice.segment_count(), 0u);
+    for (int i = 0; i < 6; ++i) {
+        const float cx = 10.0f * static_cast<float>(i), cy = 40.0f - 7.0f * static_cast<float>(i);
+        const polygon_t outer = ensure_closed(jagged_loop(rng, cx, cy, 25.0f, 40, 0.01f, true));
+        const std::vector<polygon_t> holes{ensure_closed(jagged_loop(rng, cx, cy, 8.0f, 16, 0.01f, false))};
+        ASSERT_TRUE(lattice.covers(bounds_for_polygon(outer)));
+        auto cached = lattice.clip(outer, holes, 0.2f);
+        EXPECT_FALSE(cached.empty());
+        EXPECT_TRUE(same_segments(pattern_infill(outer, holes, 0.8f, options, static_cast<std::size_t>(i), 0.2f), cached));
+    }
+    EXPECT_FALSE(lattice.covers(Bounds{-70.0f, 0.0f, 0.0f, 10.0f}));
+}
+
+TEST(HoneycombInfillTest, PlannerKeepsOneLatticeAndReportsLayers) {
+    auto path = test_data_path("torus_ascii.stl");
+    PathPlanner planner;
+    planner.set_cad(path);
+    planner.set_infill_options({InfillPattern::Honeycomb, 0.0f});
+    planner.slice_planar(0.5f, 1.0f);
+    const auto& metrics = planner.infill_metrics();
+    EXPECT_EQ(metrics.lattice_builds, 1u);
+    EXPECT_GT(metrics.lattice_segments, 0u);
+    ASSERT_EQ(metrics.layers.size(), planner.get_plan().size());
+    std::size_t filled = 0;
+    for (std::size_t l = 0; l < metrics.layers.size(); ++l) {
+        EXPECT_EQ(metrics.layers[l].segments, planner.get_plan()[l].infill().size());
+        filled += planner.get_plan()[l].infill().empty() ? 0 : 1;
+    }
+    EXPECT_GT(filled, planner.get_plan().size() / 2);
+    expect_same_plan(planner.get_plan(), slice_streaming_with(path, 0.5f, 1.0f, {InfillPattern::Honeycomb, 0.0f}));
+
+    // new layers reuse the lattice; a new spacing lays out another
+    planner.slice_planar(0.25f, 1.0f);
+    EXPECT_EQ(planner.infill_metrics().lattice_builds, 1u);
+    EXPECT_EQ(planner.infill_metrics().layers.size(), planner.get_plan().size());
+    planner.slice_planar(0.25f, 1.5f);
+    EXPECT_EQ(planner.infill_metrics().lattice_builds, 2u);
+}
+
+TEST(PathOrderTest, SerpentinesInfillAndKeepsEverySegment) {
+    std::mt19937 rng(21);
+    const polygon_t outer = ensure_closed(square_loop(20.3f, 20.7f, 20.0f, true));
+    auto lines = clip_infill(outer, {}, 0.5f, 0.5f);
+    std::shuffle(lines.begin(), lines.end(), rng);
+    vec3_t cursor = lines.front().first;
+    const double before = travel_distance(lines, cursor);
+    auto ordered = order_paths(lines, cursor);
+    EXPECT_EQ(undirected(ordered), undirected(lines));
+    EXPECT_EQ(cursor, ordered.back().second);
+    // one spacing between neighbouring lines, plus the way back from the first line picked
+    const double after = travel_distance(ordered, lines.front().first);
+    EXPECT_LT(after, 0.5 * static_cast<double>(lines.size()) + 40.0);
+    EXPECT_LT(after * 20.0, before);
+
+    // a few jagged islands with holes, every pattern
+    for (auto pattern : {InfillPattern::Rectilinear, InfillPattern::Triangles, InfillPattern::Gyroid, InfillPattern::Honeycomb}) {
+        std::vector<segment_t> infill;
+        for (int i = 0; i < 4; ++i) {
+            const float cx = 60.0f * static_cast<float>(i % 2), cy = 60.0f * static_cast<float>(i / 2);
+            const polygon_t island = ensure_closed(jagged_loop(rng, cx, cy, 25.0f, 40, 0.01f, true));
+            const std::vector<polygon_t> holes{ensure_closed(jagged_loop(rng, cx, cy, 8.0f, 16, 0.01f, false))};
+            auto part = pattern_infill(island, holes, 1.0f, {pattern, 0.0f}, 0, 0.0f);
+            infill.insert(infill.end(), part.begin(), part.end());
+        }
+        std::shuffle(infill.begin(), infill.end(), rng);
+        vec3_t at = infill.front().first;
+        auto result = order_paths(infill, at);
+        EXPECT_EQ(undirected(result), undirected(infill)) << static_cast<int>(pattern);
+        EXPECT_LT(travel_distance(result, infill.front().first), travel_distance(infill, infill.front().first) / 10.0)
+            << static_cast<int>(pattern);
+    }
+    EXPECT_TRUE(order_paths({}, cursor).empty());
+}
+
+TEST(PathOrderTest, WallLoopsStayWholeAndKeepTheirDirection) {
+    std::mt19937 rng(22);
+    std::vector<segment_t> walls;
+    const int loops = 12;
+    for (int i = 0; i < loops; ++i) {
+        const float cx = 30.0f * static_cast<float>(i % 4), cy = 25.0f * static_cast<float>(i / 4);
+        auto loop = polygon_to_segments(ensure_closed(square_loop(cx, cy, 5.0f + static_cast<float>(i % 3), i % 2 == 0)), 0.0f);
+        walls.insert(walls.end(), loop.begin(), loop.end());
+    }
+    std::vector<segment_t> shuffled = walls;
+    std::shuffle(shuffled.begin(), shuffled.end(), rng);
+    PathSet paths;
+    paths.append_segments(shuffled, PathRole::OuterWall);
+    const auto stats = order_layer_paths(paths);
+    EXPECT_LT(stats.after_mm, stats.before_mm);
+    EXPECT_EQ(paths.path_count(), static_cast<std::size_t>(loops));
+
+    const auto contours = paths.segments(0.0f);
+    ASSERT_EQ(contours.size(), walls.size());
+    int moves = 0;
+    for (std::size_t k = 0; k < contours.size(); ++k) {
+        EXPECT_NE(std::find(walls.begin(), walls.end(), contours[k]), walls.end()) << "segment " << k << " turned around";
+        if (k > 0 && !(contours[k].first == contours[k - 1].second)) ++moves;
+    }
+    EXPECT_EQ(moves, loops - 1);
+    EXPECT_NEAR(stats.after_mm, travel_distance(contours, contours.front().first), 1e-9);
+}
+
+TEST(PathOrderTest, PlannerOrdersLayersAndReportsTravel) {
+    auto path = test_data_path("torus_ascii.stl");
+    PathPlanner planner;
+    planner.set_cad(path);
+    planner.set_path_ordering(false);
+    planner.slice_planar(0.5f, 1.0f);
+    EXPECT_EQ(planner.path_order_stats().travel_before_mm, 0.0);
+    auto unordered = planner.get_plan();
+
+    planner.set_path_ordering(true);
+    planner.slice_planar(0.5f, 1.0f);
+    EXPECT_EQ(planner.slice_cache_stats().plan_hits, 0u);
+    const auto& stats = planner.path_order_stats();
+    EXPECT_GT(stats.travel_before_mm, 0.0);
+    EXPECT_LT(stats.travel_after_mm, stats.travel_before_mm / 4.0);
+    double travel = 0.0;
+    ASSERT_EQ(planner.get_plan().size(), unordered.size());
+    for (std::size_t l = 0; l < unordered.size(); ++l) {
+        const auto& layer = planner.get_plan()[l];
+        const auto walls = layer.contours(), infill = layer.infill();
+        EXPECT_EQ(undirected(walls), undirected(unordered[l].contours())) << "layer " << l;
+        EXPECT_EQ(undirected(infill), undirected(unordered[l].infill())) << "layer " << l;
+        if (walls.empty()) continue;
+        travel += travel_distance(walls, walls.front().first) + travel_distance(infill, walls.back().second);
+    }
+    EXPECT_NEAR(travel, stats.travel_after_mm, 1e-6 * stats.travel_before_mm);
+    expect_same_plan(planner.get_plan(), slice_streaming(path, 0.5f, 1.0f, std::size_t{64} << 20));
+}
+
+TEST(PathSetTest, ChainsSegmentsAndGivesThemBackExactly) {
+    const std::vector<segment_t> chain{{{0, 0, 1}, {1, 0, 1}}, {{1, 0, 1}, {1, 1, 1}}, {{1, 1, 1}, {0, 0, 1}}};
+    // meets the chain's end only within vec3_t's tolerance, so it starts a path of its own
+    const std::vector<segment_t> loose{{{0, 1e-7f, 1}, {5, 5, 1}}, {{6, 6, 1}, {7, 6, 1}}};
+    PathSet paths;
+    paths.append_segments(chain, PathRole::OuterWall);
+    paths.append_segments(loose, PathRole::OuterWall);
+    paths.append_segment({{7, 6, 1}, {8, 6, 1}}, PathRole::Infill);
+    paths.add_loop(square_loop(20, 20, 2, true), PathRole::InnerWall);
+
+    ASSERT_EQ(paths.path_count(), 5u);
+    EXPECT_EQ(paths.segment_count(), 10u);
+    EXPECT_EQ(paths.vertex_count(), 15u);
+    EXPECT_TRUE(paths.path(0).closed());
+    EXPECT_EQ(paths.path(3).role, PathRole::Infill);
+    EXPECT_EQ(paths.path(4).segment_count(), 4u);
+    EXPECT_THROW(paths.path(5), std::out_of_range);
+
+    std::vector<segment_t> expected = chain;
+    expected.insert(expected.end(), loose.begin(), loose.end());
+    expected.push_back({{7, 6, 1}, {8, 6, 1}});
+    auto loop = polygon_to_segments(square_loop(20, 20, 2, true), 1.0f);
+    expected.insert(expected.end(), loop.begin(), loop.end());
+    auto actual = paths.segments(1.0f);
+    ASSERT_EQ(actual.size(), expected.size());
+    for (std::size_t k = 0; k < expected.size(); ++k) {
+        EXPECT_EQ(std::memcmp(&actual[k], &expected[k], sizeof(segment_t)), 0) << "segment " << k;
+    }
+
+    const PathRange walls = paths.find_run(is_wall);
+    EXPECT_EQ(walls.first, 0u);
+    EXPECT_EQ(walls.last, 3u);
+    EXPECT_EQ(paths.segment_count(walls), 5u);
+    EXPECT_EQ(paths.find_run([](PathRole role) { return role == PathRole::OpenChain; }).first, paths.path_count());
+}
+
+TEST(PathSetTest, SegmentViewIndexesAcrossPaths) {
+    std::mt19937 rng(23);
+    std::uniform_int_distribution<int> length(1, 9);
+    PathSet paths;
+    for (int p = 0; p < 40; ++p) {
+        std::vector<vec2_t> points(static_cast<std::size_t>(length(rng)) + 1);
+        for (std::size_t k = 0; k < points.size(); ++k) points[k] = {static_cast<float>(p), static_cast<float>(k)};
+        paths.add_polyline(points, p < 25 ? PathRole::InnerWall : PathRole::Infill);
+    }
+    for (PathRange range : {PathRange{0, 40}, PathRange{0, 25}, PathRange{25, 40}, PathRange{7, 8}, PathRange{3, 3}}) {
+        SegmentView view(paths, range, 2.5f);
+        auto expected = paths.segments(2.5f, range);
+        ASSERT_EQ(view.size(), expected.size());
+        EXPECT_FALSE(view.is_mapped());
+        for (std::size_t k = 0; k < expected.size(); ++k) {
+            const segment_t seg = view[k];
+            EXPECT_EQ(std::memcmp(&seg, &expected[k], sizeof(segment_t)), 0) << "segment " << k;
+        }
+        EXPECT_EQ(view.to_vector().size(), expected.size());
+    }
+}
+
+TEST(PathSetTest, PlannerLayersAreRoleTaggedPolylines) {
+    PathPlanner planner;
+    planner.set_cad(test_data_path("torus_ascii.stl"));
+    planner.slice_planar(0.5f, 1.0f);
+    ASSERT_GT(planner.layer_count(), 0u);
+    std::size_t path_bytes = 0, segment_bytes = 0;
+    for (std::size_t l = 0; l < planner.layer_count(); ++l) {
+        const auto& layer = planner.get_plan()[l];
+        const auto roles = layer.paths.roles();
+        ASSERT_FALSE(roles.empty());
+        EXPECT_EQ(roles.front(), PathRole::OuterWall) << "layer " << l;
+        EXPECT_TRUE(std::is_sorted(roles.begin(), roles.end(), [](PathRole a, PathRole b) {
+            return (is_wall(a) ? 0 : static_cast<int>(a)) < (is_wall(b) ? 0 : static_cast<int>(b));
+        })) << "layer " << l;
+        EXPECT_LT(layer.paths.path_count(), layer.paths.segment_count()) << "layer " << l;
+
+        auto view = planner.get_layer(l);
+        EXPECT_EQ(view.paths, &layer.paths);
+        auto walls = layer.contours();
+        ASSERT_EQ(view.contours.size(), walls.size());
+        for (std::size_t k = 0; k < walls.size(); ++k) {
+            const segment_t seg = view.contours[k];
+            EXPECT_EQ(std::memcmp(&seg, &walls[k], sizeof(segment_t)), 0) << "layer " << l << " segment " << k;
+        }
+        path_bytes += layer.paths.memory_bytes();
+        segment_bytes += layer.paths.segment_count() * sizeof(segment_t);
+    }
+    EXPECT_LT(path_bytes, segment_bytes * 3 / 4);
+}
+
+TEST(PolygonSimplifyTest, DropsVerticesWithinTolerance) {
+    // a finely tessellated circle with sub-tolerance ripple on it
+    polygon_t circle;
+    const std::size_t points = 4000;
+    for (std::size_t i = 0; i < points; ++i) {
+        const float a = 6.2831853f * static_cast<float>(i) / static_cast<float>(points);
+        const float r = 10.0f + 0.002f * static_cast<float>(i % 3);
+        circle.push_back({20.0f + r * std::cos(a), 20.0f + r * std::sin(a), 1.5f});
+    }
+    circle.push_back(circle.front());
+    const float tolerance = 0.01f;
+    auto simple = simplify_loop(circle, tolerance);
+    ASSERT_GE(simple.size(), 4u);
+    EXPECT_LT(simple.size(), points / 10);
+    EXPECT_TRUE(simple.front() == circle.front());
+    EXPECT_TRUE(simple.back() == simple.front());
+    EXPECT_EQ(simple.front().z, 1.5f);
+    EXPECT_NEAR(signed_area(simple), signed_area(circle), 2.0f * tolerance * 63.0f);
+
+    // every sliced vertex stays within tolerance of the simplified outline
+    float worst = 0.0f;
+    for (const auto& p : circle) {
+        float nearest = std::numeric_limits<float>::max();
+        for (std::size_t k = 0; k + 1 < simple.size(); ++k) {
+            const vec3_t a = simple[k], b = simple[k + 1];
+            const float dx = b.x - a.x, dy = b.y - a.y;
+            const float t = std::clamp(((p.x - a.x) * dx + (p.y - a.y) * dy) / (dx * dx + dy * dy), 0.0f, 1.0f);
+            nearest = std::min(nearest, std::hypot(p.x - a.x - t * dx, p.y - a.y - t * dy));
+        }
+        worst = std::max(worst, nearest);
+    }
+    EXPECT_LE(worst, tolerance * 1.001f);
+
+    // too little to simplify, or nothing to simplify to
+    EXPECT_EQ(simplify_loop(ensure_closed(square_loop(0, 0, 1, true)), tolerance).size(), 5u);
+    EXPECT_EQ(simplify_loop(circle, 0.0f).size(), circle.size());
+    EXPECT_EQ(simplify_loop(circle, 100.0f).size(), circle.size());
+}
+
+TEST(PolygonSimplifyTest, KeepsLoopsThatWouldCrossOrSwapSides) {
+    // an outer whose bottom edge has a 0.04 mm bump below it; the bump goes at 0.05 mm
+    const polygon_t outer{{0, 0, 0}, {4.9f, 0, 0}, {4.9f, -0.04f, 0}, {5.1f, -0.04f, 0}, {5.1f, 0, 0},
+                          {10, 0, 0}, {10, 10, 0}, {0, 10, 0}, {0, 0, 0}};
+    const polygon_t straddling{{4.95f, -0.03f, 0}, {4.95f, 0.02f, 0}, {5.05f, 0.02f, 0}, {5.05f, -0.03f, 0}, {4.95f, -0.03f, 0}};
+    const polygon_t inside_bump{{4.95f, -0.03f, 0}, {4.95f, -0.01f, 0}, {5.05f, -0.01f, 0}, {5.05f, -0.03f, 0}, {4.95f, -0.03f, 0}};
+    polygon_t far_circle;
+    for (int i = 0; i < 400; ++i) {
+        const float a = 6.2831853f * static_cast<float>(i) / 400.0f;
+        far_circle.push_back({40.0f + 5.0f * std::cos(a), 5.0f + 5.0f * std::sin(a), 0.0f});
+    }
+    far_circle.push_back(far_circle.front());
+
+    for (const auto& hole : {straddling, inside_bump}) {
+        std::vector<Island> islands{{outer, {hole}}, {far_circle, {}}};
+        auto stats = simplify_islands(islands, 0.05f);
+        EXPECT_EQ(stats.loops, 3u);
+        EXPECT_EQ(stats.loops_kept, 1u);
+        EXPECT_EQ(islands[0].outer, outer);
+        EXPECT_EQ(islands[0].holes[0], hole);
+        EXPECT_LT(islands[1].outer.size(), far_circle.size() / 4);
+        EXPECT_EQ(stats.vertices_before, 8u + 4u + 400u);
+        EXPECT_EQ(stats.vertices_after, 8u + 4u + islands[1].outer.size() - 1);
+    }
+
+    // with the hole clear of the bump, the outer loses it
+    std::vector<Island> islands{{outer, {square_loop(5, 5, 1, false)}}};
+    auto stats = simplify_islands(islands, 0.05f);
+    EXPECT_EQ(stats.loops_kept, 0u);
+    EXPECT_EQ(islands[0].outer.size(), 5u);
+}
+
+TEST(PolygonSimplifyTest, PlannerSimplifiesBeforeWallsAndCachesOnTolerance) {
+    auto path = test_data_path("torus_ascii.stl");
+    PathPlanner reference;
+    reference.set_cad(path);
+    reference.slice_planar(0.5f, 1.0f);
+
+    PathPlanner planner;
+    planner.set_cad(path);
+    EXPECT_THROW(planner.set_contour_tolerance(-0.1f), std::runtime_error);
+    planner.set_contour_tolerance(0.2f);
+    planner.slice_planar(0.5f, 1.0f);
+    const auto stats = planner.simplify_stats();
+    EXPECT_GT(stats.loops, 0u);
+    EXPECT_LT(stats.vertices_after, stats.vertices_before);
+    ASSERT_EQ(planner.get_plan().size(), reference.get_plan().size());
+    std::size_t simplified_walls = 0, sliced_walls = 0;
+    for (std::size_t l = 0; l < planner.get_plan().size(); ++l) {
+        simplified_walls += planner.get_plan()[l].contours().size();
+        sliced_walls += reference.get_plan()[l].contours().size();
+        auto outlines = [](const PathPlanner::LayerPlan& layer) {
+            return std::count(layer.paths.roles().begin(), layer.paths.roles().end(), PathRole::OuterWall);
+        };
+        EXPECT_EQ(outlines(planner.get_plan()[l]), outlines(reference.get_plan()[l])) << "layer " << l;
+    }
+    EXPECT_LT(simplified_walls, sliced_walls);
+
+    // the tolerance keys the walls: the islands are reused, and 0 gives back the sliced plan
+    planner.set_contour_tolerance(0.0f);
+    planner.slice_planar(0.5f, 1.0f);
+    EXPECT_EQ(planner.slice_cache_stats().island_hits, 1u);
+    EXPECT_EQ(planner.slice_cache_stats().wall_hits, 0u);
+    expect_same_plan(reference.get_plan(), planner.get_plan());
+}
+
+namespace {
+
+std::string read_text(const std::filesystem::path& path) {
+    std::ifstream in(path);
+    return std::string(std::istreambuf_iterator<char>(in), {});
+}
+
+std::vector<std::string> lines_starting(const std::string& text, const std::string& prefix) {
+    std::vector<std::string> out;
+    std::size_t begin = 0;
+    while (begin < text.size()) {
+        std::size_t end = text.find('\n', begin);
+        if (end == std::string::npos) end = text.size();
+        if (text.compare(begin, prefix.size(), prefix) == 0) out.push_back(text.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return out;
+}
+
+double axis_value(const std::string& line, char axis) {
+    const std::string key = std::string(" ") + axis;
+    const std::size_t at = line.find(key);
+    if (at == std::string::npos) return std::numeric_limits<double>::quiet_NaN();
+    return std::strtod(line.c_str() + at + 2, nullptr);
+}
+
+// E over path length for one layer's extrusions, from where each one starts to where it ends.
+double layer_e_per_mm(const std::string& text, std::size_t l) {
+    const std::size_t begin = text.find(";LAYER:" + std::to_string(l) + "\n");
+    const std::size_t end = text.find(";LAYER:" + std::to_string(l + 1) + "\n");
+    const std::string layer = text.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+    double x = 0.0, y = 0.0, e = 0.0, length = 0.0, filament = 0.0;
+    for (const auto& line : lines_starting(layer, "G")) {
+        if (line.find(" X") == std::string::npos) {
+            if (line.find(" E") != std::string::npos) e = axis_value(line, 'E');  // retraction
+            continue;
+        }
+        const double nx = axis_value(line, 'X'), ny = axis_value(line, 'Y');
+        if (line.rfind("G1", 0) == 0) {
+            length += std::hypot(nx - x, ny - y);
+            filament += axis_value(line, 'E') - e;
+            e = axis_value(line, 'E');
+        }
+        x = nx;
+        y = ny;
+    }
+    return length > 0.0 ? filament / length : 0.0;
+}
+
+} // namespace
+
+TEST(GcodeWriterTest, ExtrudesForPathLengthHeightAndWidth) {
+    auto gcode_path = std::filesystem::temp_directory_path() / "printer_test_square.gcode";
+    GcodeOptions options;
+    const double per_mm = extrusion_per_mm(options, 0.2f);
+    // 0.45 mm bead on a 0.2 mm layer: (0.45 - 0.2) * 0.2 + pi * 0.2^2 / 4 over a 1.75 mm filament
+    EXPECT_NEAR(per_mm, (0.25 * 0.2 + M_PI * 0.01) / (M_PI * 1.75 * 1.75 / 4.0), 1e-9);
+    EXPECT_EQ(extrusion_per_mm(options, 0.0f), 0.0);
+
+    PathSet paths;
+    paths.add_loop({{0, 0, 0}, {10, 0, 0}, {10, 10, 0}, {0, 10, 0}}, PathRole::OuterWall);
+    GcodeStats stats;
+    {
+        GcodeWriter writer(gcode_path, options);
+        writer.add_layer(0.2f, 0.2f, paths);
+        writer.finish();
+        stats = writer.stats();
+    }
+    const auto text = read_text(gcode_path);
+    EXPECT_EQ(stats.bytes, text.size());
+    EXPECT_EQ(stats.layers, 1u);
+    EXPECT_EQ(stats.extrusions, 4u);
+    EXPECT_NEAR(stats.extruded_mm, 40.0, 1e-9);
+    EXPECT_NEAR(stats.filament_mm, 40.0 * per_mm, 1e-9);
+
+    auto travels = lines_starting(text, "G0");
+    ASSERT_EQ(travels.size(), 1u);
+    EXPECT_EQ(travels[0], "G0 F9000 X0 Y0 Z0.2");
+    auto moves = lines_starting(text, "G1");
+    ASSERT_EQ(moves.size(), 4u);
+    EXPECT_EQ(moves[0].substr(0, 16), "G1 F2400 X10 Y0 ");
+    for (std::size_t k = 0; k < moves.size(); ++k) {
+        EXPECT_NEAR(axis_value(moves[k], 'E'), 10.0 * (k + 1) * per_mm, 5e-6) << moves[k];
+    }
+    EXPECT_EQ(lines_starting(text, "G92 E0").size(), 2u);  // setup, then the layer
+    std::filesystem::remove(gcode_path);
+
+    options.line_width = 0.0f;
+    EXPECT_THROW(GcodeWriter(gcode_path, options), std::runtime_error);
+    options.line_width = 0.45f;
+    options.retract_length = -1.0f;
+    EXPECT_THROW(GcodeWriter(gcode_path, options), std::runtime_error);
+    EXPECT_THROW(GcodeWriter(gcode_path.parent_path() / "missing_dir" / "x.gcode"), std::runtime_error);
+}
+
+TEST(GcodeWriterTest, MergesCollinearMovesAndRetractsOnLongTravel) {
+    auto gcode_path = std::filesystem::temp_directory_path() / "printer_test_merge.gcode";
+    PathSet paths;
+    // a line cut into pieces, one of them 1 um off the line, then a turn back along it
+    const std::vector<vec2_t> line = {{0, 0}, {1, 0}, {2, 0.001f}, {5, 0}, {5, 0}, {3, 0}};
+    paths.add_polyline(line, PathRole::Infill);
+    const std::vector<vec2_t> near = {{4, 1}, {6, 1}};   // 1.4 mm from the last end: no retraction
+    paths.add_polyline(near, PathRole::Infill);
+    const std::vector<vec2_t> far = {{20, 1}, {20, 5}};  // 14 mm away: retracted
+    paths.add_polyline(far, PathRole::Infill);
+    const std::vector<vec2_t> chain = {{50, 50}, {60, 60}};
+    paths.add_polyline(chain, PathRole::OpenChain);
+
+    GcodeStats stats;
+    {
+        GcodeWriter writer(gcode_path);
+        writer.add_layer(0.3f, 0.3f, paths);
+        writer.add_layer(0.6f, 0.3f, paths);
+        writer.finish();
+        stats = writer.stats();
+    }
+    const auto text = read_text(gcode_path);
+    EXPECT_EQ(stats.layers, 2u);
+    // per layer: 0,0 -> 5,0 in one move, back to 3,0, then the two lines; the repeat is dropped
+    EXPECT_EQ(stats.extrusions, 8u);
+    EXPECT_EQ(stats.merged, 4u);
+    EXPECT_EQ(stats.travels, 6u);
+    // the far travel in each layer and the change to the second layer
+    EXPECT_EQ(stats.retractions, 3u);
+    EXPECT_EQ(lines_starting(text, "G1 F2100 E-0.8").size(), 1u);  // retracted from the reset E
+    EXPECT_EQ(lines_starting(text, ";LAYER:").size(), 2u);
+    EXPECT_EQ(lines_starting(text, "G0 F9000 X0 Y0 Z0.6").size(), 1u);
+    EXPECT_EQ(text.find("X60"), std::string::npos);
+    const auto moves = lines_starting(text, "G1 F2400 X");
+    ASSERT_FALSE(moves.empty());
+    EXPECT_EQ(axis_value(moves[0], 'X'), 5.0);
+
+    // with no tolerance only exactly collinear moves merge, so the kinked piece stays apart
+    GcodeOptions exact;
+    exact.merge_tolerance = 0.0f;
+    const std::vector<vec2_t> straight = {{0, 3}, {1, 3}, {2, 3}};
+    paths.add_polyline(straight, PathRole::Infill);
+    {
+        GcodeWriter writer(gcode_path, exact);
+        writer.add_layer(0.3f, 0.3f, paths);
+        writer.finish();
+        EXPECT_EQ(writer.stats().merged, 1u);
+        EXPECT_EQ(writer.stats().extrusions, 7u);
+    }
+    std::filesystem::remove(gcode_path);
+}
+
+TEST(GcodeWriterTest, PlannerWritesSlicedAndMappedPlans) {
+    auto path = test_data_path("torus_ascii.stl");
+    auto gcode_path = std::filesystem::temp_directory_path() / "printer_test_plan.gcode";
+    auto plan_path = std::filesystem::temp_directory_path() / "printer_test_gcode_plan.bin";
+    PathPlanner sliced;
+    sliced.set_cad(path);
+    sliced.slice_planar(1, 0.5f);
+    const auto stats = sliced.save_gcode(gcode_path);
+    const auto text = read_text(gcode_path);
+    EXPECT_FALSE(std::filesystem::exists(gcode_path.string() + ".tmp"));
+    EXPECT_EQ(stats.bytes, text.size());
+    EXPECT_EQ(stats.layers, sliced.layer_count());
+    EXPECT_EQ(lines_starting(text, ";LAYER:").size(), sliced.layer_count());
+
+    double printed_mm = 0.0;
+    std::size_t segments = 0;
+    for (const auto& layer : sliced.get_plan()) {
+        for (const auto& segments_of : {layer.contours(), layer.infill()}) {
+            for (const auto& seg : segments_of) printed_mm += std::hypot(seg.second.x - seg.first.x, seg.second.y - seg.first.y);
+            segments += segments_of.size();
+        }
+    }
+    EXPECT_NEAR(stats.extruded_mm, printed_mm, 1e-6 * printed_mm);
+    EXPECT_EQ(stats.extrusions + stats.merged, segments);
+    // every layer, the first (at z = 40, not on the plate) included, is 1 mm thick
+    EXPECT_NEAR(stats.filament_mm, printed_mm * extrusion_per_mm({}, 1.0f), 1e-6 * stats.filament_mm);
+    EXPECT_NEAR(layer_e_per_mm(text, 0), extrusion_per_mm({}, 1.0f), 1e-3);
+
+    // a mapped plan writes the same layers from its 1 um coordinates
+    sliced.save_plan(plan_path);
+    PathPlanner loaded;
+    loaded.load_plan(plan_path);
+    const auto mapped = loaded.save_gcode(gcode_path);
+    EXPECT_EQ(mapped.layers, stats.layers);
+    EXPECT_NEAR(mapped.extruded_mm, stats.extruded_mm, 1e-3 * stats.extruded_mm);
+    EXPECT_NEAR(mapped.filament_mm, stats.filament_mm, 1e-3 * stats.filament_mm);
+    EXPECT_NEAR(layer_e_per_mm(read_text(gcode_path), 0), extrusion_per_mm({}, 1.0f), 1e-3);
+
+    // stored thicknesses hold across a gap in z, and for a plan of one layer
+    const auto contours = sliced.get_plan()[0].contours();
+    PlanFileWriter gapped(plan_path);
+    gapped.add_layer(0.1f, 0.1f, contours, {}, {});
+    gapped.add_layer(5.0f, 0.3f, contours, {}, {});
+    gapped.finish();
+    loaded.load_plan(plan_path);
+    loaded.save_gcode(gcode_path);
+    EXPECT_NEAR(layer_e_per_mm(read_text(gcode_path), 0), extrusion_per_mm({}, 0.1f), 1e-4);
+    EXPECT_NEAR(layer_e_per_mm(read_text(gcode_path), 1), extrusion_per_mm({}, 0.3f), 1e-4);
+
+    PlanFileWriter single(plan_path);
+    single.add_layer(1.0f, 0.2f, contours, {}, {});
+    single.finish();
+    loaded.load_plan(plan_path);
+    EXPECT_EQ(loaded.save_gcode(gcode_path).layers, 1u);
+    EXPECT_NEAR(layer_e_per_mm(read_text(gcode_path), 0), extrusion_per_mm({}, 0.2f), 1e-4);
+
+    // a layer G-code cannot print fails the save without leaving the staging file behind
+    const auto written = read_text(gcode_path);
+    PlanFileWriter too_high(plan_path);
+    too_high.add_layer(1.0f, 0.2f, contours, {}, {});
+    too_high.add_layer(1e14f, 0.2f, contours, {}, {});
+    too_high.finish();
+    loaded.load_plan(plan_path);
+    EXPECT_THROW(loaded.save_gcode(gcode_path), std::runtime_error);
+    EXPECT_FALSE(std::filesystem::exists(gcode_path.string() + ".tmp"));
+    EXPECT_EQ(read_text(gcode_path), written);
+    std::filesystem::remove(gcode_path);
+    std::filesystem::remove(plan_path);
+}
+
+namespace {
+
+std::vector<uint8_t> encode_motion(const std::function<void(MotionEncoder&)>& fill, MotionStats* stats = nullptr,
+                                   const GcodeOptions& options = {}) {
+    std::vector<uint8_t> stream;
+    MotionEncoder encoder([&](std::span<const uint8_t> frame) { stream.insert(stream.end(), frame.begin(), frame.end()); },
+                          options);
+    fill(encoder);
+    encoder.finish();
+    if (stats) *stats = encoder.stats();
+    return stream;
+}
+
+std::vector<motion_cmd_t> decode_motion(std::span<const uint8_t> stream, motion_decoder_t& dec) {
+    std::vector<motion_cmd_t> out;
+    motion_cmd_t cmd;
+    for (uint8_t byte : stream) {
+        if (!motion_decoder_push(&dec, byte)) continue;
+        while (motion_decoder_next(&dec, &cmd) == 1) out.push_back(cmd);
+    }
+    return out;
+}
+
+} // namespace
+
+TEST(MotionCodecTest, LoopsBackEveryCommandWidth) {
+    PathSet paths;
+    // 100 um (8-bit), 20 mm (16-bit) and 40 m (32-bit) moves, then a 60 m travel back
+    const std::vector<vec2_t> line = {{1.0f, 1.0f}, {1.1f, 1.0f}, {21.1f, 1.0f}, {21.1f, 40001.0f}};
+    paths.add_polyline(line, PathRole::OuterWall);
+    const std::vector<vec2_t> back = {{2.0f, 2.0f}, {2.0f, 2.0f}, {2.0f, 3.0f}};
+    paths.add_polyline(back, PathRole::Infill);
+    MotionStats stats;
+    const auto stream = encode_motion([&](MotionEncoder& encoder) {
+        encoder.add_layer(0.2f, 0.2f, paths);
+        encoder.add_layer(0.4f, 0.2f, paths);
+    }, &stats);
+    EXPECT_EQ(stats.bytes, stream.size());
+    EXPECT_EQ(stats.layers, 2u);
+    EXPECT_EQ(stats.moves, 8u);  // the repeated vertex is dropped
+    EXPECT_EQ(stats.travels, 4u);
+    EXPECT_EQ(stats.retractions, 3u);  // 40 km back in each layer, and the second layer's change
+    EXPECT_EQ(stats.feed_entries, 3u);
+
+    motion_decoder_t dec;
+    motion_decoder_init(&dec);
+    const auto cmds = decode_motion(stream, dec);
+    EXPECT_EQ(dec.frames, stats.frames);
+    EXPECT_EQ(dec.crc_errors + dec.sequence_errors + dec.format_errors, 0u);
+    ASSERT_FALSE(cmds.empty());
+    EXPECT_EQ(cmds.back().kind, MOTION_CMD_END);
+
+    const GcodeOptions options;
+    const double per_mm = extrusion_per_mm(options, 0.2f);
+    std::vector<std::array<int, 2>> visited;
+    double e_mm = 0.0;
+    int z = -1, last_e = 0;
+    for (const auto& cmd : cmds) {
+        switch (cmd.kind) {
+        case MOTION_CMD_RESET_E:
+            EXPECT_EQ(cmd.e, 0);
+            e_mm = 0.0;
+            break;
+        case MOTION_CMD_Z:
+            z = cmd.z;
+            EXPECT_EQ(cmd.feed, 9000u);
+            break;
+        case MOTION_CMD_TRAVEL:
+            EXPECT_EQ(cmd.feed, 9000u);
+            visited.push_back({cmd.x, cmd.y});
+            break;
+        case MOTION_CMD_EXTRUDER:
+            EXPECT_EQ(cmd.feed, 2100u);
+            EXPECT_EQ(std::abs(cmd.e - last_e), 8000);  // 0.8 mm out, then back
+            break;
+        case MOTION_CMD_MOVE: {
+            EXPECT_EQ(cmd.feed, 2400u);
+            e_mm += std::hypot(cmd.x - visited.back()[0], cmd.y - visited.back()[1]) / 1000.0 * per_mm;
+            EXPECT_NEAR(cmd.e, e_mm * static_cast<double>(MOTION_E_PER_MM), 0.5) << "at " << cmd.x << ", " << cmd.y;
+            visited.push_back({cmd.x, cmd.y});
+            break;
+        }
+        default:
+            break;
+        }
+        last_e = cmd.e;
+    }
+    EXPECT_EQ(z, 400);
+    const std::vector<std::array<int, 2>> expected = {{1000, 1000}, {1100, 1000}, {21100, 1000}, {21100, 40001000},
+                                                      {2000, 2000}, {2000, 3000}};
+    ASSERT_EQ(visited.size(), 2 * expected.size());
+    for (std::size_t i = 0; i < visited.size(); ++i) EXPECT_EQ(visited[i], expected[i % expected.size()]) << i;
+}
+
+TEST(MotionCodecTest, DropsCorruptAndOutOfSequenceFrames) {
+    auto path = test_data_path("torus_ascii.stl");
+    PathPlanner planner;
+    planner.set_cad(path);
+    planner.slice_planar(1, 0.5f);
+    std::vector<std::vector<uint8_t>> frames;
+    MotionEncoder encoder([&](std::span<const uint8_t> frame) { frames.emplace_back(frame.begin(), frame.end()); });
+    for (const auto& layer : planner.get_plan()) encoder.add_layer(layer.z, 1.0f, layer.paths);
+    encoder.finish();
+    ASSERT_GE(frames.size(), 4u);
+    frames.resize(std::min<std::size_t>(frames.size(), 100));  // well inside the 8-bit sequence
+    for (const auto& frame : frames) {
+        ASSERT_LE(frame.size(), static_cast<std::size_t>(MOTION_FRAME_OVERHEAD + MOTION_MAX_PAYLOAD));
+        EXPECT_EQ(frame[0], MOTION_SYNC);
+    }
+
+    auto accepted = [](const std::vector<std::vector<uint8_t>>& sent, motion_decoder_t& dec) {
+        motion_decoder_init(&dec);
+        std::size_t count = 0;
+        for (const auto& frame : sent) count += decode_motion(frame, dec).size();
+        return count;
+    };
+    motion_decoder_t clean;
+    const std::size_t all = accepted(frames, clean);
+    EXPECT_EQ(clean.frames, frames.size());
+
+    // a flipped payload bit fails the CRC, and every frame after it is refused until it is resent
+    auto corrupted = frames;
+    corrupted[1][5] ^= 0x10;
+    motion_decoder_t dec;
+    EXPECT_LT(accepted(corrupted, dec), all);
+    EXPECT_EQ(dec.frames, 1u);
+    EXPECT_EQ(dec.crc_errors, 1u);
+    EXPECT_EQ(dec.sequence_errors, frames.size() - 2);
+    EXPECT_EQ(dec.sequence, 1u);
+
+    auto resent = corrupted;
+    resent.insert(resent.end(), frames.begin() + 1, frames.end());
+    EXPECT_EQ(accepted(resent, dec), all);
+    EXPECT_EQ(dec.frames, frames.size());
+
+    // line noise that looks like a frame header swallows the frames after it until its CRC
+    // fails, and they are found again by rescanning its bytes
+    std::vector<std::vector<uint8_t>> noisy = {{0x00, 0x13, MOTION_SYNC, 0x00, 0xFF}};
+    noisy.insert(noisy.end(), frames.begin(), frames.end());
+    EXPECT_EQ(accepted(noisy, dec), all);
+    EXPECT_EQ(dec.frames, frames.size());
+    EXPECT_EQ(dec.crc_errors, 1u);
+
+    // a frame whose payload ends mid-command is dropped as malformed
+    std::vector<uint8_t> cut = {MOTION_SYNC, 0, 2, static_cast<uint8_t>(MOTION_OP_MOVE16 << 5), 0x01};
+    const uint16_t crc = motion_crc16(0xFFFF, cut.data() + 1, 4);
+    cut.push_back(static_cast<uint8_t>(crc & 0xFF));
+    cut.push_back(static_cast<uint8_t>(crc >> 8));
+    EXPECT_EQ(accepted({cut}, dec), 0u);
+    EXPECT_EQ(dec.format_errors, 1u);
+}
+
+TEST(MotionCodecTest, PlanLoopbackMatchesGcodeInAFractionOfTheBytes) {
+    auto path = test_data_path("torus_ascii.stl");
+    auto gcode_path = std::filesystem::temp_directory_path() / "printer_test_motion.gcode";
+    PathPlanner planner;
+    planner.set_cad(path);
+    planner.slice_planar(1, 0.5f);
+    GcodeOptions options;
+    options.merge_tolerance = 0.0f;
+    const auto gcode = planner.save_gcode(gcode_path, options);
+    std::filesystem::remove(gcode_path);
+
+    MotionStats stats;
+    const auto stream = encode_motion([&](MotionEncoder& encoder) {
+        for (const auto& layer : planner.get_plan()) encoder.add_layer(layer.z, 1.0f, layer.paths);  // uniform 1 mm
+    }, &stats, options);
+    EXPECT_EQ(stats.layers, gcode.layers);
+    // the same moves, less the few sub-micron ones that quantize away
+    EXPECT_LE(stats.moves, gcode.extrusions + gcode.merged);
+    EXPECT_GT(stats.moves, (gcode.extrusions + gcode.merged) * 99 / 100);
+    EXPECT_EQ(stats.retractions, gcode.retractions);
+    EXPECT_LT(stats.bytes * 3, gcode.bytes);
+
+    motion_decoder_t dec;
+    motion_decoder_init(&dec);
+    const auto cmds = decode_motion(stream, dec);
+    double extruded_mm = 0.0, filament_mm = 0.0;
+    int x = 0, y = 0, e = 0;
+    std::size_t moves = 0;
+    for (const auto& cmd : cmds) {
+        if (cmd.kind == MOTION_CMD_MOVE) {
+            extruded_mm += std::hypot(cmd.x - x, cmd.y - y) / 1000.0;
+            filament_mm += (cmd.e - e) / static_cast<double>(MOTION_E_PER_MM);
+            moves++;
+        }
+        x = cmd.x;
+        y = cmd.y;
+        e = cmd.e;
+    }
+    EXPECT_EQ(moves, stats.moves);
+    EXPECT_NEAR(extruded_mm, gcode.extruded_mm, 1e-3 * gcode.extruded_mm);
+    EXPECT_NEAR(filament_mm, gcode.filament_mm, 1e-3 * gcode.filament_mm);
+}
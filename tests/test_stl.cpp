@@ -5,6 +5,9 @@
 #include <vector>
 #include <chrono>
 #include <atomic>
+#include <set>
+#include <tuple>
+#include <limits>
 
 #include "include/stl_helpers.hpp"
 
@@ -191,3 +194,223 @@ TEST_F(StlReaderTest, ThrowsOnTruncatedBinaryFile) {
 
     EXPECT_THROW(read_stl_binary(path.string()), std::runtime_error);
 }
+
+TEST_F(StlReaderTest, MappedBinaryMatchesStreamReader) {
+    std::vector<BinaryTriangle> tris = {
+        {{0.0f, 0.0f, 1.0f}, {{{0.0f, 0.0f, 0.0f}, {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}}}, 0},
+        {{0.0f, 0.0f, 1.0f}, {{{0.0f, 1.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}}}, 0}, // flipped
+        {{0.0f, 0.0f, -1.0f}, {{{-0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}}}, 3},
+        {{1.0f, 0.0f, 0.0f}, {{{1.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 2.5f}}}, 0},
+    };
+    auto path = write_binary_file(tris);
+    auto expected = read_stl_binary(path.string());
+    auto mapped = read_stl_binary_mapped(path.string());
+
+    ASSERT_EQ(mapped.points.size(), expected.points.size());
+    for (std::size_t i = 0; i < expected.points.size(); ++i) {
+        EXPECT_EQ(mapped.points[i], expected.points[i]) << "point " << i;
+    }
+    ASSERT_EQ(mapped.triangles.size(), expected.triangles.size());
+    for (std::size_t i = 0; i < expected.triangles.size(); ++i) {
+        EXPECT_EQ(mapped.triangles[i].vertices, expected.triangles[i].vertices) << "triangle " << i;
+        EXPECT_EQ(mapped.triangles[i].normal_vec, expected.triangles[i].normal_vec);
+        EXPECT_EQ(mapped.triangles[i].centroid, expected.triangles[i].centroid);
+    }
+}
+
+TEST_F(StlReaderTest, MappedBinaryThrowsOnTruncatedFile) {
+    auto path = temp_stl_path(".truncated.stl");
+    {
+        std::ofstream out(path, std::ios::binary);
+        char header[80] = {0};
+        out.write(header, sizeof(header));
+        uint32_t tri_count = 2;
+        out.write(reinterpret_cast<const char*>(&tri_count), sizeof(tri_count));
+        char partial[50] = {0};
+        out.write(partial, sizeof(partial)); // only one of two records
+    }
+    EXPECT_THROW(read_stl_binary_mapped(path.string()), std::runtime_error);
+}
+
+TEST_F(StlReaderTest, ParallelBinaryIsIndependentOfThreadCount) {
+    // strip of quads sharing edges, enough triangles to give every thread a chunk
+    std::vector<BinaryTriangle> tris;
+    for (int i = 0; i < 64; ++i) {
+        float x0 = static_cast<float>(i);
+        float x1 = x0 + 1.0f;
+        tris.push_back({{0.0f, 0.0f, 1.0f}, {{{x0, 0.0f, 0.0f}, {x1, 0.0f, 0.0f}, {x1, 1.0f, 0.0f}}}, 0});
+        tris.push_back({{0.0f, 0.0f, 1.0f}, {{{x0, 0.0f, 0.0f}, {x0, 1.0f, 0.0f}, {x1, 1.0f, 0.0f}}}, 0}); // flipped
+    }
+    auto path = write_binary_file(tris);
+    auto expected = read_stl_binary(path.string());
+    ASSERT_EQ(expected.points.size(), 130u);
+
+    for (std::size_t threads : {1u, 2u, 3u, 7u, 16u}) {
+        auto mesh = read_stl_binary_parallel(path.string(), threads);
+        ASSERT_EQ(mesh.points.size(), expected.points.size()) << threads << " threads";
+        for (std::size_t i = 0; i < expected.points.size(); ++i) {
+            EXPECT_EQ(mesh.points[i], expected.points[i]) << threads << " threads, point " << i;
+        }
+        ASSERT_EQ(mesh.triangles.size(), expected.triangles.size());
+        for (std::size_t i = 0; i < expected.triangles.size(); ++i) {
+            EXPECT_EQ(mesh.triangles[i].vertices, expected.triangles[i].vertices) << threads << " threads, triangle " << i;
+            EXPECT_EQ(mesh.triangles[i].centroid, expected.triangles[i].centroid);
+        }
+    }
+}
+
+TEST_F(StlReaderTest, MappedAsciiMatchesStreamReader) {
+    for (const char* name : {"ascii_example.stl", "torus_ascii.stl"}) {
+        auto path = test_data_path(name);
+        auto expected = read_stl_ascii(path.string());
+        auto parsed = read_stl_ascii_mapped(path.string());
+
+        ASSERT_EQ(parsed.size(), expected.size()) << name;
+        for (std::size_t s = 0; s < expected.size(); ++s) {
+            ASSERT_EQ(parsed[s].points.size(), expected[s].points.size()) << name;
+            for (std::size_t i = 0; i < expected[s].points.size(); ++i) {
+                EXPECT_EQ(parsed[s].points[i], expected[s].points[i]) << name << " point " << i;
+            }
+            ASSERT_EQ(parsed[s].triangles.size(), expected[s].triangles.size()) << name;
+            for (std::size_t i = 0; i < expected[s].triangles.size(); ++i) {
+                EXPECT_EQ(parsed[s].triangles[i].vertices, expected[s].triangles[i].vertices) << name << " triangle " << i;
+                EXPECT_EQ(parsed[s].triangles[i].normal_vec, expected[s].triangles[i].normal_vec);
+            }
+        }
+    }
+}
+
+TEST_F(StlReaderTest, MappedAsciiHandlesCrlfAndSignedNumbers) {
+    const std::string ascii_stl =
+        "solid crlf\r\n"
+        "  facet normal +0 -0 +1\r\n"
+        "    outer loop\r\n"
+        "      vertex 0 0 0\r\n"
+        "      vertex 0 +1.0 0\r\n"
+        "      vertex 1e0 0 -0\r\n"
+        "    endloop\r\n"
+        "  endfacet\r\n"
+        "endsolid crlf\r\n";
+    auto path = write_ascii_file(ascii_stl);
+    auto solids = read_stl_ascii_mapped(path.string());
+    ASSERT_EQ(solids.size(), 1u);
+    ASSERT_EQ(solids[0].triangles.size(), 1u);
+    EXPECT_EQ(solids[0].points.size(), 3u);
+    // flipped winding gets corrected: (0,0,0) -> (1,0,0) -> (0,1,0)
+    EXPECT_EQ(solids[0].triangles[0].vertices, (std::array<uint32_t, 3>{0, 2, 1}));
+}
+
+TEST_F(StlReaderTest, MappedAsciiThrowsOnUnknownKeyword) {
+    const std::string bad_ascii = R"(
+solid bad
+  foo 0 0 0
+endsolid bad
+)";
+    auto path = write_ascii_file(bad_ascii);
+    EXPECT_THROW(read_stl_ascii_mapped(path.string()), std::runtime_error);
+}
+
+
+class VertexWeldTest : public testing::Test {
+protected:
+    // brute-force reference: one point per distinct quantized cell, in first-occurrence order
+    static std::vector<uint32_t> reference_weld(const std::vector<vec3_t>& pts, double tolerance) {
+        std::vector<QuantizedVertex> cells;
+        std::vector<uint32_t> indices;
+        for (const auto& p : pts) {
+            auto q = quantize_vertex(p, 1.0 / tolerance);
+            auto found = std::find(cells.begin(), cells.end(), q);
+            indices.push_back(static_cast<uint32_t>(found - cells.begin()));
+            if (found == cells.end()) cells.push_back(q);
+        }
+        return indices;
+    }
+
+    static std::vector<uint32_t> table_weld(const std::vector<vec3_t>& pts, double tolerance) {
+        VertexWeldTable table(tolerance);
+        std::vector<uint32_t> indices;
+        uint32_t next = 0;
+        for (const auto& p : pts) {
+            auto [idx, is_new] = table.insert(p, next);
+            if (is_new) next++;
+            indices.push_back(idx);
+        }
+        return indices;
+    }
+
+    // coordinates chosen to collide under weak hash combiners: permutations and sign flips of a
+    // few values, +-0, neighbouring floats, powers of two and values one weld cell apart
+    static std::vector<vec3_t> adversarial_points() {
+        const float values[] = {
+            0.0f, -0.0f, 1.0f, -1.0f, 2.0f, 0.5f, 1024.0f, 1e-7f, -1e-7f, 3e-6f,
+            std::nextafter(1.0f, 2.0f), std::nextafter(1.0f, 0.0f), 123.456f, -123.456f
+        };
+        std::vector<vec3_t> pts;
+        for (float x : values) {
+            for (float y : values) {
+                for (float z : values) {
+                    pts.push_back({x, y, z});
+                }
+            }
+        }
+        // every point again in reverse order so the duplicates hit populated slots
+        for (std::size_t i = pts.size(); i-- > 0;) pts.push_back(pts[i]);
+        return pts;
+    }
+};
+
+TEST_F(VertexWeldTest, MatchesBruteForceOnAdversarialCoordinates) {
+    auto pts = adversarial_points();
+    auto expected = reference_weld(pts, PT_EQUAL_THRESH);
+    EXPECT_EQ(table_weld(pts, PT_EQUAL_THRESH), expected);
+
+    std::vector<vec3_t> welded;
+    EXPECT_EQ(stl_detail::weld_vertices_bulk(pts, welded), expected);
+    EXPECT_EQ(welded.size(), static_cast<std::size_t>(*std::max_element(expected.begin(), expected.end())) + 1);
+}
+
+TEST_F(VertexWeldTest, WeldsWithinToleranceOnly) {
+    VertexWeldTable table(0.01);
+    EXPECT_EQ(table.insert({1.0f, 2.0f, 3.0f}, 0), std::make_pair(0u, true));
+    EXPECT_EQ(table.insert({1.004f, 1.996f, 3.0f}, 1), std::make_pair(0u, false)); // same cell
+    EXPECT_EQ(table.insert({1.03f, 2.0f, 3.0f}, 1), std::make_pair(1u, true));     // 3 cells away
+    EXPECT_EQ(table.insert({-0.0f, 0.0f, 0.0f}, 2), std::make_pair(2u, true));
+    EXPECT_EQ(table.insert({0.0f, -0.0f, 0.004f}, 3), std::make_pair(2u, false));
+    EXPECT_EQ(table.size(), 3u);
+
+    table.clear();
+    EXPECT_EQ(table.size(), 0u);
+    EXPECT_EQ(table.insert({1.0f, 2.0f, 3.0f}, 7), std::make_pair(7u, true));
+}
+
+TEST_F(VertexWeldTest, DenseGridStressSurvivesRehash) {
+    // tightly packed grid one weld cell apart, each point inserted twice with sub-cell jitter
+    std::vector<vec3_t> pts;
+    const float cell = 1e-5f;
+    for (int i = 0; i < 24; ++i) {
+        for (int j = 0; j < 24; ++j) {
+            for (int k = 0; k < 12; ++k) {
+                vec3_t p{10.0f + i * cell, -10.0f + j * cell, k * cell};
+                pts.push_back(p);
+                pts.push_back({p.x, p.y, p.z + 1e-7f});
+            }
+        }
+    }
+    auto expected = reference_weld(pts, 1e-5);
+    EXPECT_EQ(table_weld(pts, 1e-5), expected);
+
+    std::vector<vec3_t> welded;
+    EXPECT_EQ(stl_detail::weld_vertices_bulk(pts, welded, 4, 1e-5), expected);
+}
+
+TEST_F(VertexWeldTest, NonFiniteCoordinatesStayDistinct) {
+    const float inf = std::numeric_limits<float>::infinity();
+    std::vector<vec3_t> pts = {
+        {inf, 0.0f, 0.0f}, {-inf, 0.0f, 0.0f}, {3.0e30f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}, {inf, 0.0f, 0.0f}
+    };
+    auto indices = table_weld(pts, PT_EQUAL_THRESH);
+    EXPECT_EQ(indices, (std::vector<uint32_t>{0, 1, 2, 3, 0}));
+
+    std::vector<vec3_t> welded;
+    EXPECT_EQ(stl_detail::weld_vertices_bulk(pts, welded), indices);
+}
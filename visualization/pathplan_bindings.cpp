@@ -31,22 +31,206 @@ PYBIND11_MODULE(pathplan_bindings, m) {
         .def_readwrite("points", &Mesh::points)
         .def_readwrite("triangles", &Mesh::triangles);
 
+    py::class_<MeshSoA>(m, "MeshSoA")
+        .def(py::init<>())
+        .def(py::init<const Mesh&>(), py::arg("mesh"))
+        .def("triangle_count", &MeshSoA::triangle_count)
+        .def_readonly("x", &MeshSoA::x)
+        .def_readonly("y", &MeshSoA::y)
+        .def_readonly("z", &MeshSoA::z)
+        .def_readonly("z_min", &MeshSoA::z_min)
+        .def_readonly("z_max", &MeshSoA::z_max)
+        .def_readonly("source_triangle", &MeshSoA::source_triangle);
+
+    py::enum_<PathPlanner::MeshLayout>(m, "MeshLayout")
+        .value("Indexed", PathPlanner::MeshLayout::Indexed)
+        .value("StructureOfArrays", PathPlanner::MeshLayout::StructureOfArrays);
+
+    py::enum_<JoinType>(m, "JoinType")
+        .value("Miter", JoinType::Miter)
+        .value("Round", JoinType::Round);
+
+    py::enum_<InfillPattern>(m, "InfillPattern")
+        .value("Rectilinear", InfillPattern::Rectilinear)
+        .value("Crosshatch", InfillPattern::Crosshatch)
+        .value("Grid", InfillPattern::Grid)
+        .value("Triangles", InfillPattern::Triangles)
+        .value("Gyroid", InfillPattern::Gyroid)
+        .value("SchwarzP", InfillPattern::SchwarzP)
+        .value("SchwarzD", InfillPattern::SchwarzD)
+        .value("Honeycomb", InfillPattern::Honeycomb);
+
+    py::class_<InfillOptions>(m, "InfillOptions")
+        .def(py::init<>())
+        .def_readwrite("pattern", &InfillOptions::pattern)
+        .def_readwrite("angle_deg", &InfillOptions::angle_deg);
+
+    py::class_<AdaptiveLayerOptions>(m, "AdaptiveLayerOptions")
+        .def(py::init<>())
+        .def_readwrite("min_height", &AdaptiveLayerOptions::min_height)
+        .def_readwrite("max_height", &AdaptiveLayerOptions::max_height)
+        .def_readwrite("max_cusp", &AdaptiveLayerOptions::max_cusp);
+
+    py::class_<LayerSchedule>(m, "LayerSchedule")
+        .def(py::init<>())
+        .def_static("uniform", py::overload_cast<float>(&LayerSchedule::uniform), py::arg("layer_height"))
+        .def_static("uniform", py::overload_cast<float, float, float>(&LayerSchedule::uniform),
+                    py::arg("layer_height"), py::arg("min_z"), py::arg("max_z"))
+        .def_static("adaptive", &LayerSchedule::adaptive, py::arg("meshes"), py::arg("options") = AdaptiveLayerOptions{})
+        .def("layer_count", &LayerSchedule::layer_count)
+        .def("z", &LayerSchedule::z, py::arg("layer"))
+        .def("plane", &LayerSchedule::plane, py::arg("layer"))
+        .def("thickness", &LayerSchedule::thickness, py::arg("layer"))
+        .def("nominal_height", &LayerSchedule::nominal_height)
+        .def("is_uniform", &LayerSchedule::is_uniform)
+        .def("heights", [](const LayerSchedule& s) { return std::vector<float>(s.heights().begin(), s.heights().end()); });
+
+    py::enum_<PathRole>(m, "PathRole")
+        .value("OuterWall", PathRole::OuterWall)
+        .value("InnerWall", PathRole::InnerWall)
+        .value("Infill", PathRole::Infill)
+        .value("OpenChain", PathRole::OpenChain);
+
+    // paths come out as (role, [(x, y), ...]); the flat arrays are copied into lists on access
+    py::class_<PathSet>(m, "PathSet")
+        .def(py::init<>())
+        .def("path_count", &PathSet::path_count)
+        .def("vertex_count", &PathSet::vertex_count)
+        .def("segment_count", py::overload_cast<>(&PathSet::segment_count, py::const_))
+        .def("memory_bytes", &PathSet::memory_bytes)
+        .def("path", [](const PathSet& paths, std::size_t idx) {
+            auto path = paths.path(idx);
+            std::vector<std::pair<float, float>> points;
+            points.reserve(path.points.size());
+            for (const auto& p : path.points) points.emplace_back(p.x, p.y);
+            return std::make_pair(path.role, std::move(points));
+        }, py::arg("idx"))
+        .def_property_readonly("offsets", [](const PathSet& paths) {
+            return std::vector<uint32_t>(paths.offsets().begin(), paths.offsets().end());
+        })
+        .def_property_readonly("roles", [](const PathSet& paths) {
+            return std::vector<PathRole>(paths.roles().begin(), paths.roles().end());
+        })
+        .def("segments", [](const PathSet& paths, float z) { return paths.segments(z); }, py::arg("z"));
+
     py::class_<PathPlanner::LayerPlan>(m, "LayerPlan")
         .def(py::init<>())
         .def_readwrite("z", &PathPlanner::LayerPlan::z)
-        .def_readwrite("contours", &PathPlanner::LayerPlan::contours)
-        .def_readwrite("infill", &PathPlanner::LayerPlan::infill);
+        .def_readwrite("thickness", &PathPlanner::LayerPlan::thickness)
+        .def_readonly("paths", &PathPlanner::LayerPlan::paths)
+        .def_property_readonly("contours", &PathPlanner::LayerPlan::contours)
+        .def_property_readonly("infill", &PathPlanner::LayerPlan::infill)
+        .def_property_readonly("open_chains", &PathPlanner::LayerPlan::open_chains);
+
+    // segments are decoded into lists on access; the view itself keeps the planner alive
+    py::class_<LayerView>(m, "LayerView")
+        .def_readonly("z", &LayerView::z)
+        .def_readonly("thickness", &LayerView::thickness)
+        .def_property_readonly("contours", [](const LayerView& v) { return v.contours.to_vector(); })
+        .def_property_readonly("infill", [](const LayerView& v) { return v.infill.to_vector(); })
+        .def_property_readonly("open_chains", [](const LayerView& v) { return v.open_chains.to_vector(); });
+
+    py::class_<PathPlanner::SliceCacheStats>(m, "SliceCacheStats")
+        .def_readonly("slices", &PathPlanner::SliceCacheStats::slices)
+        .def_readonly("island_hits", &PathPlanner::SliceCacheStats::island_hits)
+        .def_readonly("wall_hits", &PathPlanner::SliceCacheStats::wall_hits)
+        .def_readonly("plan_hits", &PathPlanner::SliceCacheStats::plan_hits)
+        .def_readonly("island_ms", &PathPlanner::SliceCacheStats::island_ms)
+        .def_readonly("wall_ms", &PathPlanner::SliceCacheStats::wall_ms)
+        .def_readonly("infill_ms", &PathPlanner::SliceCacheStats::infill_ms)
+        .def("hit_rate", &PathPlanner::SliceCacheStats::hit_rate);
+
+    py::class_<PathPlanner::InfillLayerMetrics>(m, "InfillLayerMetrics")
+        .def_readonly("segments", &PathPlanner::InfillLayerMetrics::segments)
+        .def_readonly("ms", &PathPlanner::InfillLayerMetrics::ms);
+
+    py::class_<PathPlanner::InfillMetrics>(m, "InfillMetrics")
+        .def_readonly("lattice_builds", &PathPlanner::InfillMetrics::lattice_builds)
+        .def_readonly("lattice_ms", &PathPlanner::InfillMetrics::lattice_ms)
+        .def_readonly("lattice_segments", &PathPlanner::InfillMetrics::lattice_segments)
+        .def_readonly("layers", &PathPlanner::InfillMetrics::layers);
+
+    py::class_<SimplifyStats>(m, "SimplifyStats")
+        .def_readonly("loops", &SimplifyStats::loops)
+        .def_readonly("vertices_before", &SimplifyStats::vertices_before)
+        .def_readonly("vertices_after", &SimplifyStats::vertices_after)
+        .def_readonly("loops_kept", &SimplifyStats::loops_kept)
+        .def("reduction", &SimplifyStats::reduction);
+
+    py::class_<GcodeOptions>(m, "GcodeOptions")
+        .def(py::init<>())
+        .def_readwrite("line_width", &GcodeOptions::line_width)
+        .def_readwrite("filament_diameter", &GcodeOptions::filament_diameter)
+        .def_readwrite("extrusion_multiplier", &GcodeOptions::extrusion_multiplier)
+        .def_readwrite("print_speed", &GcodeOptions::print_speed)
+        .def_readwrite("travel_speed", &GcodeOptions::travel_speed)
+        .def_readwrite("retract_length", &GcodeOptions::retract_length)
+        .def_readwrite("retract_speed", &GcodeOptions::retract_speed)
+        .def_readwrite("retract_min_travel", &GcodeOptions::retract_min_travel)
+        .def_readwrite("merge_tolerance", &GcodeOptions::merge_tolerance)
+        .def_readwrite("start_gcode", &GcodeOptions::start_gcode)
+        .def_readwrite("end_gcode", &GcodeOptions::end_gcode);
+
+    py::class_<GcodeStats>(m, "GcodeStats")
+        .def_readonly("layers", &GcodeStats::layers)
+        .def_readonly("lines", &GcodeStats::lines)
+        .def_readonly("bytes", &GcodeStats::bytes)
+        .def_readonly("extrusions", &GcodeStats::extrusions)
+        .def_readonly("merged", &GcodeStats::merged)
+        .def_readonly("travels", &GcodeStats::travels)
+        .def_readonly("retractions", &GcodeStats::retractions)
+        .def_readonly("extruded_mm", &GcodeStats::extruded_mm)
+        .def_readonly("travel_mm", &GcodeStats::travel_mm)
+        .def_readonly("filament_mm", &GcodeStats::filament_mm);
+
+    m.def("extrusion_per_mm", &extrusion_per_mm, py::arg("options"), py::arg("height"));
+
+    py::class_<PathPlanner::PathOrderStats>(m, "PathOrderStats")
+        .def_readonly("travel_before_mm", &PathPlanner::PathOrderStats::travel_before_mm)
+        .def_readonly("travel_after_mm", &PathPlanner::PathOrderStats::travel_after_mm)
+        .def_readonly("ms", &PathPlanner::PathOrderStats::ms);
 
     py::class_<PathPlanner, std::shared_ptr<PathPlanner>>(m, "PathPlanner")
         .def(py::init<>())
         .def("set_cad", &PathPlanner::set_cad, py::arg("cad_file"))
-        .def("slice_planar", &PathPlanner::slice_planar, py::arg("layer_height_mm"), py::arg("infill_spacing"))
+        .def("slice_planar", py::overload_cast<float, float>(&PathPlanner::slice_planar),
+             py::arg("layer_height_mm"), py::arg("infill_spacing"))
+        .def("slice_planar", py::overload_cast<const LayerSchedule&, float>(&PathPlanner::slice_planar),
+             py::arg("schedule"), py::arg("infill_spacing"))
+        .def("slice_planar_adaptive", &PathPlanner::slice_planar_adaptive, py::arg("options"), py::arg("infill_spacing"))
+        .def("layer_schedule", &PathPlanner::layer_schedule, py::return_value_policy::reference_internal)
+        .def("set_thread_count", &PathPlanner::set_thread_count, py::arg("num_threads"))
+        .def("thread_count", &PathPlanner::thread_count)
+        .def("set_perimeter_count", &PathPlanner::set_perimeter_count, py::arg("count"))
+        .def("perimeter_count", &PathPlanner::perimeter_count)
+        .def("set_perimeter_join", &PathPlanner::set_perimeter_join, py::arg("join"))
+        .def("perimeter_join", &PathPlanner::perimeter_join)
+        .def("unsettled_insets", &PathPlanner::unsettled_insets)
+        .def("set_contour_tolerance", &PathPlanner::set_contour_tolerance, py::arg("mm"))
+        .def("contour_tolerance", &PathPlanner::contour_tolerance)
+        .def("simplify_stats", &PathPlanner::simplify_stats, py::return_value_policy::reference_internal)
+        .def("set_infill_options", &PathPlanner::set_infill_options, py::arg("options"))
+        .def("infill_options", &PathPlanner::infill_options)
+        .def("set_mesh_layout", &PathPlanner::set_mesh_layout, py::arg("layout"))
+        .def("mesh_layout", &PathPlanner::mesh_layout)
+        .def("slice_cache_stats", &PathPlanner::slice_cache_stats, py::return_value_policy::reference_internal)
+        .def("infill_metrics", &PathPlanner::infill_metrics, py::return_value_policy::reference_internal)
+        .def("set_path_ordering", &PathPlanner::set_path_ordering)
+        .def("path_ordering", &PathPlanner::path_ordering)
+        .def("path_order_stats", &PathPlanner::path_order_stats, py::return_value_policy::reference_internal)
+        .def("clear_slice_cache", &PathPlanner::clear_slice_cache)
+        .def("mesh_hash", &PathPlanner::mesh_hash)
         .def("layer_count", &PathPlanner::layer_count)
-        .def("get_layer", &PathPlanner::get_layer, py::return_value_policy::reference_internal)
+        .def("save_plan", &PathPlanner::save_plan, py::arg("path"))
+        .def("save_gcode", &PathPlanner::save_gcode, py::arg("path"), py::arg("options") = GcodeOptions{})
+        .def("load_plan", &PathPlanner::load_plan, py::arg("path"))
+        .def("plan_is_mapped", &PathPlanner::plan_is_mapped)
+        .def("get_layer", &PathPlanner::get_layer, py::keep_alive<0, 1>())
         .def("get_layer_contours", &PathPlanner::get_layer_contours)
         .def("get_layer_infill", &PathPlanner::get_layer_infill)
         .def("get_plan", &PathPlanner::get_plan, py::return_value_policy::reference_internal)
         .def("get_meshes", &PathPlanner::get_meshes, py::return_value_policy::reference_internal)
+        .def("get_soa_meshes", &PathPlanner::get_soa_meshes, py::return_value_policy::reference_internal)
         .def("get_raw_layers", &PathPlanner::get_raw_layers, py::return_value_policy::reference_internal)
         .def("get_raw_layer_points", &PathPlanner::get_raw_layer_points);
 
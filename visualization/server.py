@@ -11,7 +11,9 @@ for the PNG image and a few metadata fields.
 
 import argparse
 import base64
+import hashlib
 import tempfile
+import threading
 from io import BytesIO
 from pathlib import Path
 from typing import Optional
@@ -29,6 +31,7 @@ from visualize_path import (
     plot_layer_paths,
     plot_mesh,
     plot_raw_intersections,
+    raw_layer_index,
     triangles_intersecting_layer,
 )
 
@@ -47,11 +50,22 @@ def plot_triangles(ax, mesh, tris, cmap):
         ax.add_collection3d(collection)
 
 
+# One planner per process: its slice cache makes repeat requests for the same STL and slicing
+# parameters (a different layer or display toggle) skip re-slicing. The STL is only reloaded when
+# the upload's SHA-256 differs from the one loaded last. The lock serializes users.
+_planner = None
+_planner_digest = None
+_planner_lock = threading.Lock()
+
+
 def render_visualization(
     stl_path: Path,
+    stl_digest: Optional[str] = None,
     module_path: Optional[Path] = None,
-    layer_height: int = 1,
+    layer_height: float = 1.0,
     infill_spacing: float = 1.0,
+    infill_pattern: str = "Rectilinear",
+    infill_angle: float = 0.0,
     layer_idx: int = 0,
     show_mesh: bool = True,
     show_contours: bool = True,
@@ -66,17 +80,47 @@ def render_visualization(
     except ImportError as exc:  # pragma: no cover - depends on local build
         raise RuntimeError(f"Failed to import pathplan_bindings: {exc}")
 
-    planner = pp.PathPlanner()
-    planner.set_cad(str(stl_path))
-    planner.slice_planar(layer_height, infill_spacing)
-
+    global _planner, _planner_digest
+    with _planner_lock:
+        if _planner is None:
+            _planner = pp.PathPlanner()
+        planner = _planner
+        if stl_digest is None or stl_digest != _planner_digest:
+            _planner_digest = None  # a failed load leaves no mesh to match
+            planner.set_cad(str(stl_path))
+            _planner_digest = stl_digest
+        infill = pp.InfillOptions()
+        infill.pattern = getattr(pp.InfillPattern, infill_pattern)
+        infill.angle_deg = infill_angle
+        planner.set_infill_options(infill)
+        planner.slice_planar(layer_height, infill_spacing)
+        return _render_layer(
+            planner,
+            layer_idx,
+            show_mesh,
+            show_contours,
+            show_infill,
+            show_raw_intersections,
+            color_intersecting_tris,
+        )
+
+
+def _render_layer(
+    planner,
+    layer_idx: int,
+    show_mesh: bool,
+    show_contours: bool,
+    show_infill: bool,
+    show_raw_intersections: bool,
+    color_intersecting_tris: bool,
+) -> dict:
     if planner.layer_count() == 0:
         raise RuntimeError("No layers generated; check STL or slicing parameters.")
 
     layer_idx = max(0, min(layer_idx, planner.layer_count() - 1))
     layer = planner.get_layer(layer_idx)
     raw_layers = planner.get_raw_layers()
-    raw_idx = int(round(layer.z / max(1, layer_height)))
+    raw_idx = raw_layer_index(planner, layer.z)
     raw_pts = raw_layers[raw_idx] if raw_idx < len(raw_layers) else []
 
     fig = plt.figure(figsize=(8, 6))
@@ -106,9 +150,24 @@ def render_visualization(
     plt.close(fig)
     buf.seek(0)
     encoded = base64.b64encode(buf.read()).decode("ascii")
+    stats = planner.slice_cache_stats()
     return {
         "image": f"data:image/png;base64,{encoded}",
-        "meta": {"layers": planner.layer_count(), "selectedLayer": layer_idx, "zHeight": layer.z},
+        "meta": {
+            "layers": planner.layer_count(),
+            "selectedLayer": layer_idx,
+            "zHeight": layer.z,
+            "sliceCache": {
+                "slices": stats.slices,
+                "planHits": stats.plan_hits,
+                "islandHits": stats.island_hits,
+                "wallHits": stats.wall_hits,
+                "hitRate": stats.hit_rate(),
+                "islandMs": stats.island_ms,
+                "wallMs": stats.wall_ms,
+                "infillMs": stats.infill_ms,
+            },
+        },
     }
 
 
@@ -134,8 +193,10 @@ def build_app(module_path: Optional[Path]):
 
         params = request.form
         try:
-            layer_height = int(params.get("layerHeight", 1))
+            layer_height = float(params.get("layerHeight", 1.0))
             infill_spacing = float(params.get("infillSpacing", 1.0))
+            infill_pattern = params.get("infillPattern", "Rectilinear")
+            infill_angle = float(params.get("infillAngle", 0.0))
             layer_idx = int(params.get("layer", 0))
             show_mesh = params.get("showMesh", "true") == "true"
             show_contours = params.get("showContours", "true") == "true"
@@ -144,17 +205,23 @@ def build_app(module_path: Optional[Path]):
             color_tris = params.get("colorIntersections", "false") == "true"
         except ValueError:
             return jsonify({"error": "Invalid numeric parameter."}), 400
+        if infill_pattern not in ("Rectilinear", "Crosshatch", "Grid", "Triangles", "Gyroid", "SchwarzP", "SchwarzD", "Honeycomb"):
+            return jsonify({"error": f"Unknown infill pattern `{infill_pattern}`."}), 400
 
+        data = upload.read()
         with tempfile.NamedTemporaryFile(delete=False, suffix=".stl") as tmp:
-            upload.save(tmp.name)
+            tmp.write(data)
             stl_path = Path(tmp.name)
 
         try:
             result = render_visualization(
                 stl_path=stl_path,
+                stl_digest=hashlib.sha256(data).hexdigest(),
                 module_path=module_path,
                 layer_height=layer_height,
                 infill_spacing=infill_spacing,
+                infill_pattern=infill_pattern,
+                infill_angle=infill_angle,
                 layer_idx=layer_idx,
                 show_mesh=show_mesh,
                 show_contours=show_contours,
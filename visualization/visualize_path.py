@@ -1,4 +1,5 @@
 import argparse
+import bisect
 import sys
 from pathlib import Path
 from typing import Iterable, Tuple
@@ -16,8 +17,12 @@ def add_module_path(extra_path: Path):
 def parse_args():
     parser = argparse.ArgumentParser(description="Visualize STL and planar slice path using PathPlanner bindings.")
     parser.add_argument("stl", type=Path, help="Path to STL file.")
-    parser.add_argument("--layer-height", type=int, default=1, help="Layer height in mm.")
+    parser.add_argument("--layer-height", type=float, default=1.0, help="Layer height in mm.")
     parser.add_argument("--infill-spacing", type=float, default=1.0, help="Grid infill spacing.")
+    parser.add_argument("--infill-pattern", choices=["Rectilinear", "Crosshatch", "Grid", "Triangles", "Gyroid", "SchwarzP", "SchwarzD", "Honeycomb"], default="Rectilinear", help="Infill pattern.")
+    parser.add_argument("--infill-angle", type=float, default=0.0, help="Direction of the first infill lines in degrees.")
+    parser.add_argument("--contour-tolerance", type=float, default=0.0, help="Simplify sliced loops to within this many mm before walls (0 keeps every vertex).")
+    parser.add_argument("--gcode", type=Path, default=None, help="Also write the sliced plan as G-code to this path.")
     parser.add_argument("--layer", type=int, default=0, help="Layer index to visualize from the sliced plan.")
     parser.add_argument("--module-path", type=Path, default=None, help="Optional path to built pathplan_bindings module (e.g., build directory).")
     parser.add_argument("--show-mesh", action="store_true", help="Display STL mesh.")
@@ -29,6 +34,11 @@ def parse_args():
     return parser.parse_args()
 
 
+def raw_layer_index(planner, z: float) -> int:
+    """Index into get_raw_layers() of the schedule plane a plan layer was cut at."""
+    return bisect.bisect_left(planner.layer_schedule().heights(), z)
+
+
 def plot_mesh(ax, meshes):
     for mesh in meshes:
         faces = []
@@ -96,15 +106,24 @@ def main():
 
     planner = pp.PathPlanner()
     planner.set_cad(str(args.stl))
+    infill = pp.InfillOptions()
+    infill.pattern = getattr(pp.InfillPattern, args.infill_pattern)
+    infill.angle_deg = args.infill_angle
+    planner.set_infill_options(infill)
+    planner.set_contour_tolerance(args.contour_tolerance)
     planner.slice_planar(args.layer_height, args.infill_spacing)
 
     if planner.layer_count() == 0:
         sys.exit("No layers generated; check STL or slicing parameters.")
+    if args.gcode is not None:
+        stats = planner.save_gcode(str(args.gcode))
+        print(f"Wrote {stats.lines} lines ({stats.bytes / 1e6:.1f} MB) of G-code to {args.gcode}; "
+              f"{stats.filament_mm:.0f} mm of filament")
 
     layer_idx = max(0, min(args.layer, planner.layer_count() - 1))
     layer = planner.get_layer(layer_idx)
     raw_layers = planner.get_raw_layers()
-    raw_idx = int(round(layer.z / max(1, args.layer_height)))
+    raw_idx = raw_layer_index(planner, layer.z)
     raw_pts = raw_layers[raw_idx] if raw_idx < len(raw_layers) else []
 
     fig = plt.figure(figsize=(8, 6))